@@ -0,0 +1,84 @@
+//
+// Created on 2026/10/18
+//
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+bool MappedFile::open( std::filesystem::path const& path )
+{
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileW( path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( f == INVALID_HANDLE_VALUE )
+        return false;
+    LARGE_INTEGER sz;
+    if ( GetFileSizeEx( f, &sz ) && sz.QuadPart > 0 )
+    {
+        HANDLE m = CreateFileMappingW( f, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        if ( m )
+        {
+            m_data = static_cast<const char*>( MapViewOfFile( m, FILE_MAP_READ, 0, 0, 0 ) );
+            CloseHandle( m );
+            if ( m_data )
+                m_size = size_t( sz.QuadPart );
+        }
+    }
+    CloseHandle( f );
+#else
+    int fd = ::open( path.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return false;
+    struct stat st;
+    if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+    {
+        void* p = mmap( nullptr, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( p != MAP_FAILED )
+        {
+            m_data = static_cast<const char*>( p );
+            m_size = size_t( st.st_size );
+        }
+    }
+    ::close( fd );
+#endif
+    return m_data != nullptr;
+}
+
+void MappedFile::close()
+{
+    if ( !m_data )
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile( m_data );
+#else
+    munmap( const_cast<char*>( m_data ), m_size );
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
@@ -0,0 +1,50 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Read-only memory mapping of a whole file
+///
+/// The platform code (mmap, MapViewOfFile) is in MappedFile.cpp, so the
+/// headers that use it do not bring <windows.h> and its macros along.
+class MappedFile
+{
+public:
+    MappedFile() {}
+
+    explicit MappedFile( std::filesystem::path const& path ) { open( path ); }
+
+    ~MappedFile() { close(); }
+
+    MappedFile( MappedFile const& ) = delete;
+    MappedFile& operator=( MappedFile const& ) = delete;
+
+    bool open( std::filesystem::path const& path );
+
+    void close();
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+protected:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // MAPPEDFILE_H
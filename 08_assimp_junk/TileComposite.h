@@ -0,0 +1,326 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILECOMPOSITE_H
+#define TILECOMPOSITE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "TileContent.h"
+#include "TileFormat.h"
+#include "TilesetImage.h"
+#include "TilesetTree.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Composite (cmpt) tiles: the zero-copy reader and the packer
+///
+/// The inner tiles are spans into the mapped file (or the caller's bytes),
+/// each one goes to TileContent::parse (or to another TileComposite when
+/// nested):
+///
+///     TileComposite cmpt;
+///     if ( cmpt.open( "tile.cmpt" ) )
+///         for ( size_t i = 0; i != cmpt.size(); ++i )
+///             if ( cmpt.content( i, inner ) )
+///                 ...
+///
+/// The composite header and the header of every inner tile are parsed with
+/// TileHeader (TileFormat.h); nothing else is needed to split a cmpt.
+///
+/// See also https://github.com/CesiumGS/3d-tiles/tree/main/specification/TileFormats/Composite
+class TileComposite
+{
+public:
+    typedef TileContent::span_t span_t;
+    typedef TileTree::index_t index_t;
+
+    TileComposite() {}
+
+    TileComposite( TileComposite const& ) = delete;
+    TileComposite& operator=( TileComposite const& ) = delete;
+
+    /// @brief Map and parse the file
+    bool open( std::filesystem::path const& filename )
+    {
+        m_file = std::make_unique<MappedFile>();
+        if ( !m_file->open( filename ) )
+        {
+            m_error = "cannot open " + filename.u8string();
+            return false;
+        }
+        return parse( m_file->data(), m_file->size() );
+    }
+
+    /// @brief Parse composite bytes owned by the caller
+    bool parse( const char* data, size_t size )
+    {
+        m_data = span_t{ data, size };
+        m_tiles.clear();
+        if ( !m_header.parse( std::string_view( data, size ), size, m_error ) )
+            return false;
+        if ( m_header.format != TileHeader::CMPT )
+            return false_because( "not a cmpt" );
+
+        size_t pos = m_header.header_size();
+        m_tiles.reserve( m_header.tilesLength );
+        for ( uint32_t k = 0; k != m_header.tilesLength; ++k )
+        {
+            if ( size - pos < 12 )
+                return false_because( "tile " + std::to_string( k ) + ": truncated" );
+            uint32_t length;
+            std::memcpy( &length, data + pos + 8, sizeof( length ) );
+            if ( length < 12 || length > size - pos )
+                return false_because( "tile " + std::to_string( k ) + ": byteLength " + std::to_string( length ) + " is out of the cmpt" );
+            TileHeader inner;
+            if ( !inner.parse( std::string_view( data + pos, length ), length, m_error ) )
+                return false_because( "tile " + std::to_string( k ) + ": " + m_error );
+            m_tiles.push_back( span_t{ data + pos, length } );
+            pos += length;
+        }
+        if ( pos != size )
+            return false_because( std::to_string( size - pos ) + " bytes after the last tile" );
+        return true;
+    }
+
+    TileHeader const& header() const { return m_header; }
+
+    /// @brief The reason of the last failure
+    std::string const& error() const { return m_error; }
+
+    /// @brief The whole composite
+    span_t data() const { return m_data; }
+
+    size_t size() const { return m_tiles.size(); }
+    span_t operator[]( size_t i ) const { return m_tiles[i]; }
+    std::vector<span_t> const& tiles() const { return m_tiles; }
+
+    /// @brief Parse an inner tile (a view, the composite must outlive it)
+    bool content( size_t i, TileContent& tile ) const { return tile.parse( m_tiles[i].data, m_tiles[i].size ); }
+
+    /// @brief Pack the tiles into a composite
+    ///
+    /// The inner tiles are padded to 8 bytes (their byteLength is updated).
+    static std::string pack( std::vector<std::string_view> const& tiles )
+    {
+        size_t length = 16;
+        for ( auto const& t : tiles )
+            length += ( t.size() + 7 ) & ~size_t( 7 );
+
+        std::string r;
+        r.reserve( length );
+        r.append( "cmpt" );
+        append_u32( r, 1 );
+        append_u32( r, uint32_t( length ) );
+        append_u32( r, uint32_t( tiles.size() ) );
+        for ( auto const& t : tiles )
+        {
+            if ( t.size() < 12 )
+                throw std::runtime_error( "not a tile" );
+            size_t at = r.size();
+            r.append( t.data(), t.size() );
+            r.resize( ( r.size() + 7 ) & ~size_t( 7 ), '\0' );
+            uint32_t padded = uint32_t( r.size() - at );
+            std::memcpy( &r[at + 8], &padded, sizeof( padded ) );
+        }
+        return r;
+    }
+
+#pragma region grouping
+    /// @brief The result of group()
+    struct group_t
+    {
+        TileTree tree;
+        size_t composites = 0;  // cmpt files written
+        size_t packed = 0;      // tiles moved into them
+    };
+
+    /// @brief Pack sibling leaf tiles into cmpt files up to a target size
+    ///
+    /// The leaves of a parent with the same geometric error and refine, box
+    /// volumes, no transform and a b3dm, i3dm, pnts or cmpt content are
+    /// grouped in their order; a group becomes one tile with the union of
+    /// the boxes. Groups of one tile are left alone.
+    /// @param dir the directory of the tileset.json (the content uris are relative to it)
+    /// @param target_bytes the maximum size of a cmpt (a bigger tile stays as is)
+    /// @param remove_inner delete the packed files
+    static group_t group( TileTree const& tree, std::filesystem::path const& dir, size_t target_bytes, bool remove_inner = true )
+    {
+        group_t g;
+        g.tree.asset = tree.asset;
+        g.tree.geometricError = tree.geometricError;
+        g.tree.reserve( tree.size() );
+        if ( tree.empty() )
+            return g;
+
+        struct item_t
+        {
+            index_t src, dst;
+        };
+        std::vector<item_t> stack{ { tree.root(), g.tree.append_copy( tree, tree.root(), TileTree::npos ) } };
+        std::vector<index_t> children;
+        std::vector<uint64_t> sizes;
+        while ( !stack.empty() )
+        {
+            item_t it = stack.back();
+            stack.pop_back();
+
+            children.clear();
+            sizes.clear();
+            tree.for_each_child( it.src, [&]( index_t c ) {
+                children.push_back( c );
+                sizes.push_back( packable_size( tree, c, dir ) );
+            } );
+
+            for ( size_t k = 0; k != children.size(); )
+            {
+                // the run of compatible leaves up to target_bytes
+                size_t end = k + 1;
+                uint64_t total = sizes[k];
+                if ( sizes[k] )
+                    while ( end != children.size() && sizes[end] && total + sizes[end] <= target_bytes
+                            && compatible( tree, children[k], children[end] ) )
+                        total += sizes[end++];
+
+                if ( end - k < 2 )
+                {
+                    index_t dst = g.tree.append_copy( tree, children[k], it.dst );
+                    if ( tree[children[k]].first_child != TileTree::npos )
+                        stack.push_back( { children[k], dst } );
+                    ++k;
+                    continue;
+                }
+
+                write_group( tree, children.data() + k, end - k, dir, remove_inner, g, it.dst );
+                k = end;
+            }
+        }
+        return g;
+    }
+#pragma endregion
+
+protected:
+    /// @brief The content size of a leaf that can be packed, 0 otherwise
+    static uint64_t packable_size( TileTree const& tree, index_t i, std::filesystem::path const& dir )
+    {
+        auto const& t = tree[i];
+        if ( t.first_child != TileTree::npos || t.uri == TileTree::npos || t.transform != TileTree::npos
+             || !std::get_if<TileTree::box_t>( &t.boundingVolume ) )
+            return 0;
+        std::string_view uri = tree.uri( i );
+        if ( uri.find( "://" ) != std::string_view::npos || uri.find_first_of( "?#" ) != std::string_view::npos )
+            return 0;
+
+        TileHeader h;
+        std::string error;
+        if ( !h.read( dir / std::filesystem::u8path( uri ), error ) )
+            return 0;
+        switch ( h.format )
+        {
+        case TileHeader::B3DM:
+        case TileHeader::I3DM:
+        case TileHeader::PNTS:
+        case TileHeader::CMPT: return h.byteLength;
+        default: return 0;
+        }
+    }
+
+    static bool compatible( TileTree const& tree, index_t a, index_t b )
+    {
+        return tree[a].geometricError == tree[b].geometricError && tree[a].refine == tree[b].refine;
+    }
+
+    /// @brief Write the cmpt of the tiles and add its tile
+    static void write_group( TileTree const& tree, index_t const* tiles, size_t n, std::filesystem::path const& dir,
+                             bool remove_inner, group_t& g, index_t parent )
+    {
+        std::vector<std::unique_ptr<MappedFile>> files;
+        std::vector<std::string_view> bytes;
+        double lo[3], hi[3];
+        std::fill( lo, lo + 3, std::numeric_limits<double>::max() );
+        std::fill( hi, hi + 3, -std::numeric_limits<double>::max() );
+        for ( size_t k = 0; k != n; ++k )
+        {
+            auto path = dir / std::filesystem::u8path( tree.uri( tiles[k] ) );
+            files.push_back( std::make_unique<MappedFile>() );
+            if ( !files.back()->open( path ) )
+                throw std::runtime_error( "cannot open " + path.u8string() );
+            bytes.emplace_back( files.back()->data(), files.back()->size() );
+
+            double const* b = std::get<TileTree::box_t>( tree[tiles[k]].boundingVolume ).box;
+            for ( int a = 0; a != 3; ++a )
+            {
+                double e = std::abs( b[3 + a] ) + std::abs( b[6 + a] ) + std::abs( b[9 + a] );
+                lo[a] = std::min( lo[a], b[a] - e );
+                hi[a] = std::max( hi[a], b[a] + e );
+            }
+        }
+
+        // next to the first tile, named after it
+        std::filesystem::path first = std::filesystem::u8path( tree.uri( tiles[0] ) );
+        std::filesystem::path uri = first.parent_path() / ( first.stem().u8string() + "_" + std::to_string( n ) + ".cmpt" );
+        std::string cmpt = pack( bytes );
+        {
+            std::ofstream os( dir / uri, std::ios::binary );
+            if ( !os.write( cmpt.data(), std::streamsize( cmpt.size() ) ) )
+                throw std::runtime_error( "cannot write " + ( dir / uri ).u8string() );
+        }
+        files.clear();
+        if ( remove_inner )
+        {
+            std::error_code ec;
+            for ( size_t k = 0; k != n; ++k )
+                std::filesystem::remove( dir / std::filesystem::u8path( tree.uri( tiles[k] ) ), ec );
+        }
+
+        index_t r = g.tree.append_copy( tree, tiles[0], parent );
+        TileTree::box_t box{};
+        for ( int a = 0; a != 3; ++a )
+        {
+            box.box[a] = ( lo[a] + hi[a] ) / 2;
+            box.box[3 + 4 * a] = ( hi[a] - lo[a] ) / 2;
+        }
+        g.tree[r].boundingVolume = box;
+        g.tree.set_uri( r, uri.generic_u8string() );
+        g.composites += 1;
+        g.packed += n;
+    }
+
+    bool false_because( std::string s )
+    {
+        m_error = std::move( s );
+        m_tiles.clear();
+        return false;
+    }
+
+    static void append_u32( std::string& s, uint32_t v ) { s.append( reinterpret_cast<const char*>( &v ), sizeof( v ) ); }
+
+    std::unique_ptr<MappedFile> m_file;
+    span_t m_data;
+    TileHeader m_header;
+    std::vector<span_t> m_tiles;
+    std::string m_error;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILECOMPOSITE_H
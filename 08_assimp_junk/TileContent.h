@@ -0,0 +1,200 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILECONTENT_H
+#define TILECONTENT_H
+
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "TileFormat.h"
+#include "TilesetImage.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Zero-copy view of a b3dm, i3dm, pnts or glb tile
+///
+/// The file is memory mapped (or the caller keeps the bytes alive), the
+/// tables and the embedded glTF are views into it. The glTF goes to the
+/// importers straight from the mapping:
+///
+///     TileContent b3dm;
+///     if ( b3dm.open( "tile.b3dm" ) )
+///         scene = b3dm.import_glb( importer, aiProcess_Triangulate );
+class TileContent
+{
+public:
+    /// @brief A piece of the tile
+    struct span_t
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+
+        bool empty() const { return size == 0; }
+        const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>( data ); }
+        std::string_view str() const { return std::string_view( data, size ); }
+    };
+
+    TileContent() {}
+
+    TileContent( TileContent const& ) = delete;
+    TileContent& operator=( TileContent const& ) = delete;
+
+    /// @brief Map and parse the file
+    bool open( std::filesystem::path const& filename )
+    {
+        m_file = std::make_unique<MappedFile>();
+        if ( !m_file->open( filename ) )
+        {
+            m_error = "cannot open " + filename.u8string();
+            return false;
+        }
+        return parse( m_file->data(), m_file->size() );
+    }
+
+    /// @brief Parse tile bytes owned by the caller (e.g. an inner tile of a cmpt)
+    bool parse( const char* data, size_t size )
+    {
+        m_data = span_t{ data, size };
+        m_sections = sections_t{};
+        if ( !m_header.parse( std::string_view( data, size ), size, m_error ) )
+            return false;
+
+        size_t pos = m_header.header_size();
+        auto take = [&]( uint32_t n ) {
+            span_t s{ data + pos, n };
+            pos += n;
+            return s;
+        };
+        switch ( m_header.format )
+        {
+        case TileHeader::B3DM:
+        case TileHeader::I3DM:
+        case TileHeader::PNTS:
+            m_sections.feature_table_json = take( m_header.featureTableJSONByteLength );
+            m_sections.feature_table_binary = take( m_header.featureTableBinaryByteLength );
+            m_sections.batch_table_json = take( m_header.batchTableJSONByteLength );
+            m_sections.batch_table_binary = take( m_header.batchTableBinaryByteLength );
+            m_sections.body = span_t{ data + pos, size - pos };
+            break;
+        case TileHeader::GLB:
+            m_sections.body = m_data;
+            break;
+        default:
+            m_error = std::string( TileHeader::format_name( m_header.format ) ) + " is not a single tile";
+            return false;
+        }
+        return true;
+    }
+
+    TileHeader const& header() const { return m_header; }
+    TileHeader::format_t format() const { return m_header.format; }
+
+    /// @brief The reason of the last failure
+    std::string const& error() const { return m_error; }
+
+    /// @brief The whole tile
+    span_t data() const { return m_data; }
+
+    span_t feature_table_json() const { return trim( m_sections.feature_table_json ); }
+    span_t feature_table_binary() const { return m_sections.feature_table_binary; }
+    span_t batch_table_json() const { return trim( m_sections.batch_table_json ); }
+    span_t batch_table_binary() const { return m_sections.batch_table_binary; }
+
+    /// @brief The binary glTF (b3dm, i3dm with gltfFormat 1, glb), empty otherwise
+    span_t glb() const
+    {
+        bool embedded = m_header.format == TileHeader::B3DM || m_header.format == TileHeader::GLB
+            || ( m_header.format == TileHeader::I3DM && m_header.gltfFormat == 1 );
+        return embedded ? glb_length( m_sections.body ) : span_t{};
+    }
+
+    /// @brief The glTF uri of an i3dm with gltfFormat 0
+    std::string_view gltf_uri() const
+    {
+        if ( m_header.format != TileHeader::I3DM || m_header.gltfFormat != 0 )
+            return std::string_view();
+        return trim( m_sections.body ).str();
+    }
+
+    /// @brief The point data of a pnts (the feature table binary)
+    span_t points() const
+    {
+        return m_header.format == TileHeader::PNTS ? m_sections.feature_table_binary : span_t{};
+    }
+
+    /// @brief Import the glTF with Assimp::Importer::ReadFileFromMemory
+    /// @return the scene owned by the importer or nullptr
+    template <typename Importer>
+    auto import_glb( Importer& importer, unsigned flags ) const
+    {
+        auto g = glb();
+        return importer.ReadFileFromMemory( g.data, g.size, flags, "glb" );
+    }
+
+    /// @brief Load the glTF with tinygltf::TinyGLTF::LoadBinaryFromMemory
+    template <typename Loader, typename Model>
+    bool load_glb( Loader& loader, Model& model, std::string* err, std::string* warn, std::string const& base_dir = std::string() ) const
+    {
+        auto g = glb();
+        if ( g.empty() )
+        {
+            if ( err )
+                *err = "no embedded glTF";
+            return false;
+        }
+        return loader.LoadBinaryFromMemory( &model, err, warn, g.bytes(), unsigned( g.size ), base_dir );
+    }
+
+protected:
+    struct sections_t
+    {
+        span_t feature_table_json;
+        span_t feature_table_binary;
+        span_t batch_table_json;
+        span_t batch_table_binary;
+        span_t body;
+    };
+
+    /// @brief Without the trailing padding spaces (and zeros)
+    static span_t trim( span_t s )
+    {
+        while ( s.size && ( s.data[s.size - 1] == ' ' || s.data[s.size - 1] == '\0' ) )
+            --s.size;
+        return s;
+    }
+
+    /// @brief The glb without the padding after it (its own length)
+    static span_t glb_length( span_t s )
+    {
+        if ( s.size >= 12 && std::memcmp( s.data, "glTF", 4 ) == 0 )
+        {
+            uint32_t length;
+            std::memcpy( &length, s.data + 8, sizeof( length ) );
+            if ( length <= s.size )
+                s.size = length;
+        }
+        return s;
+    }
+
+    std::unique_ptr<MappedFile> m_file;
+    span_t m_data;
+    TileHeader m_header;
+    sections_t m_sections;
+    std::string m_error;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILECONTENT_H
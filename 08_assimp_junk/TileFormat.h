@@ -0,0 +1,183 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILEFORMAT_H
+#define TILEFORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief The header of a tile content file (b3dm, i3dm, pnts, cmpt, glb)
+///
+/// The b3dm and pnts layouts are the header_t of Batched3DModel::read and
+/// PointCloud::read (GM13206_test.cpp), which still read them by hand.
+///
+/// See also https://github.com/CesiumGS/3d-tiles/tree/main/specification/TileFormats
+struct TileHeader
+{
+    enum format_t : uint8_t
+    {
+        UNKNOWN,
+        B3DM,   // Batched 3D Model
+        I3DM,   // Instanced 3D Model
+        PNTS,   // Point Cloud
+        CMPT,   // Composite
+        GLB,    // binary glTF
+        JSON    // external tileset
+    };
+
+    format_t format = UNKNOWN;
+    uint32_t version = 0;
+    uint32_t byteLength = 0;
+    uint32_t featureTableJSONByteLength = 0;
+    uint32_t featureTableBinaryByteLength = 0;
+    uint32_t batchTableJSONByteLength = 0;
+    uint32_t batchTableBinaryByteLength = 0;
+    uint32_t gltfFormat = 0;    // i3dm: 0 - uri, 1 - embedded glb
+    uint32_t tilesLength = 0;   // cmpt: number of inner tiles
+
+    /// @brief Size of the header (the first section offset)
+    size_t header_size() const
+    {
+        switch ( format )
+        {
+        case B3DM:
+        case PNTS: return 28;
+        case I3DM: return 32;
+        case CMPT: return 16;
+        case GLB: return 12;
+        default: return 0;
+        }
+    }
+
+    /// @brief Offset of the payload after the tables (glb, glb uri or point data)
+    size_t body_offset() const
+    {
+        return header_size() + size_t( featureTableJSONByteLength ) + featureTableBinaryByteLength
+            + batchTableJSONByteLength + batchTableBinaryByteLength;
+    }
+
+    static const char* format_name( format_t f )
+    {
+        static const char* names[] = { "unknown", "b3dm", "i3dm", "pnts", "cmpt", "glb", "json" };
+        return names[f];
+    }
+
+    static format_t format_of( std::string_view magic )
+    {
+        if ( magic.size() < 4 )
+            return UNKNOWN;
+        magic = magic.substr( 0, 4 );
+        if ( magic == "b3dm" ) return B3DM;
+        if ( magic == "i3dm" ) return I3DM;
+        if ( magic == "pnts" ) return PNTS;
+        if ( magic == "cmpt" ) return CMPT;
+        if ( magic == "glTF" ) return GLB;
+        return UNKNOWN;
+    }
+
+    /// @brief Parse and check the header
+    /// @param data the beginning of the file (at least header_size() bytes to succeed)
+    /// @param file_size the size of the whole file
+    /// @param error the reason of the failure
+    bool parse( std::string_view data, uint64_t file_size, std::string& error )
+    {
+        *this = TileHeader{};
+        size_t skip = data.find_first_not_of( " \t\r\n" );
+        if ( skip != std::string_view::npos && data[skip] == '{' )
+        {
+            format = JSON;
+            byteLength = uint32_t( file_size );
+            return true;
+        }
+
+        format = format_of( data );
+        if ( format == UNKNOWN )
+            return false_because( error, "unknown magic" );
+        if ( data.size() < header_size() )
+            return false_because( error, "truncated header" );
+
+        uint32_t const* u = reinterpret_cast<uint32_t const*>( data.data() + 4 );
+        auto field = [&]( int k ) {
+            uint32_t v;
+            std::memcpy( &v, u + k, sizeof( v ) );
+            return v;
+        };
+        version = field( 0 );
+        byteLength = field( 1 );
+
+        switch ( format )
+        {
+        case B3DM:
+        case PNTS:
+        case I3DM:
+            featureTableJSONByteLength = field( 2 );
+            featureTableBinaryByteLength = field( 3 );
+            batchTableJSONByteLength = field( 4 );
+            batchTableBinaryByteLength = field( 5 );
+            if ( format == I3DM )
+                gltfFormat = field( 6 );
+            break;
+        case CMPT:
+            tilesLength = field( 2 );
+            break;
+        default:
+            break;
+        }
+
+        if ( format == GLB ? version != 2 : version != 1 )
+            return false_because( error, std::string( format_name( format ) ) + " version " + std::to_string( version ) + " is not supported" );
+        if ( byteLength != file_size )
+            return false_because( error, "byteLength " + std::to_string( byteLength ) + " != file size " + std::to_string( file_size ) );
+        if ( format == B3DM && ( batchTableJSONByteLength >= 570425344 || batchTableBinaryByteLength >= 570425344 ) )
+            return false_because( error, "legacy b3dm header" );
+        if ( body_offset() > byteLength )
+            return false_because( error, "the tables are longer than the file" );
+        if ( format == B3DM && body_offset() == byteLength )
+            return false_because( error, "no glTF" );
+        if ( format == I3DM && gltfFormat > 1 )
+            return false_because( error, "gltfFormat must be 0 or 1" );
+        return true;
+    }
+
+    /// @brief Read the header of a file
+    bool read( std::filesystem::path const& filename, std::string& error )
+    {
+        std::error_code ec;
+        auto size = std::filesystem::file_size( filename, ec );
+        if ( ec )
+            return false_because( error, "cannot open: " + ec.message() );
+        std::ifstream is( filename, std::ios::binary );
+        if ( !is )
+            return false_because( error, "cannot open" );
+        char buffer[64];
+        is.read( buffer, sizeof( buffer ) );
+        return parse( std::string_view( buffer, size_t( is.gcount() ) ), size, error );
+    }
+
+protected:
+    static bool false_because( std::string& error, std::string s )
+    {
+        error = std::move( s );
+        return false;
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILEFORMAT_H
@@ -0,0 +1,361 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILEINSTANCES_H
+#define TILEINSTANCES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <json-c/json.h>
+
+#include "TileContent.h"
+#include "TilesetWriter.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief The per-instance arrays of an i3dm feature table
+///
+/// The glTF model is placed by position (relative to rtc_center), rotation
+/// (NORMAL_UP, NORMAL_RIGHT), non-uniform scale and batch id. The arrays
+/// that hold only the defaults are not written.
+///
+/// See also https://github.com/CesiumGS/3d-tiles/tree/main/specification/TileFormats/Instanced3DModel
+class TileInstances
+{
+public:
+    typedef std::array<float, 3> float3_t;
+
+    std::vector<float3_t> positions;
+    std::vector<float3_t> normal_up;        // Y of the instance frame
+    std::vector<float3_t> normal_right;     // X of the instance frame
+    std::vector<float3_t> scales;
+    std::vector<uint32_t> batch_ids;
+    std::array<double, 3> rtc_center{ 0.0, 0.0, 0.0 };
+    bool east_north_up = false;
+
+    size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+
+    void reserve( size_t n )
+    {
+        positions.reserve( n );
+        normal_up.reserve( n );
+        normal_right.reserve( n );
+        scales.reserve( n );
+        batch_ids.reserve( n );
+    }
+
+    /// @brief Append an instance
+    /// @param batch_id the feature, npos: the instance index
+    void add( float3_t const& position, float3_t const& scale = { 1, 1, 1 }, float3_t const& up = { 0, 1, 0 },
+              float3_t const& right = { 1, 0, 0 }, uint32_t batch_id = npos )
+    {
+        batch_ids.push_back( batch_id == npos ? uint32_t( positions.size() ) : batch_id );
+        positions.push_back( position );
+        scales.push_back( scale );
+        normal_up.push_back( up );
+        normal_right.push_back( right );
+    }
+
+    /// @brief BATCH_LENGTH
+    uint32_t batch_length() const
+    {
+        return batch_ids.empty() ? 0 : *std::max_element( batch_ids.begin(), batch_ids.end() ) + 1;
+    }
+
+    /// @brief Column-major transform of the instance (rtc_center included)
+    std::array<double, 16> matrix( size_t i ) const
+    {
+        float3_t const& r = normal_right[i];
+        float3_t const& u = normal_up[i];
+        float3_t const& s = scales[i];
+        double f[3] = { double( r[1] ) * u[2] - double( r[2] ) * u[1], double( r[2] ) * u[0] - double( r[0] ) * u[2],
+                        double( r[0] ) * u[1] - double( r[1] ) * u[0] };
+        std::array<double, 16> m{};
+        for ( int a = 0; a != 3; ++a )
+        {
+            m[a] = r[a] * s[0];
+            m[4 + a] = u[a] * s[1];
+            m[8 + a] = f[a] * s[2];
+            m[12 + a] = positions[i][a] + rtc_center[a];
+        }
+        m[15] = 1;
+        return m;
+    }
+
+    /// @brief Axis aligned bounds of the placed model
+    /// @param lo, hi the model bounds (in the tile frame, i.e. after the glTF Y-up rotation)
+    void bounds( double const* lo, double const* hi, double* out_lo, double* out_hi ) const
+    {
+        std::fill( out_lo, out_lo + 3, std::numeric_limits<double>::max() );
+        std::fill( out_hi, out_hi + 3, -std::numeric_limits<double>::max() );
+        for ( size_t i = 0; i != size(); ++i )
+        {
+            auto m = matrix( i );
+            for ( int k = 0; k != 8; ++k )
+            {
+                double c[3] = { k & 1 ? hi[0] : lo[0], k & 2 ? hi[1] : lo[1], k & 4 ? hi[2] : lo[2] };
+                for ( int a = 0; a != 3; ++a )
+                {
+                    double p = m[a] * c[0] + m[4 + a] * c[1] + m[8 + a] * c[2] + m[12 + a];
+                    out_lo[a] = std::min( out_lo[a], p );
+                    out_hi[a] = std::max( out_hi[a], p );
+                }
+            }
+        }
+    }
+
+#pragma region feature table
+    /// @brief Encode the feature table
+    /// @param offset the file offset of the feature table, the JSON is padded to 8 from there
+    void write_feature_table( std::string& json, std::string& binary, size_t offset ) const
+    {
+        auto float3_array = [&]( JsonWriter& w, const char* name, std::vector<float3_t> const& v ) {
+            w.key( name );
+            w.begin_object();
+            w.key( "byteOffset" );
+            w.value( double( binary.size() ) );
+            w.end_object();
+            binary.append( reinterpret_cast<const char*>( v.data() ), v.size() * sizeof( float3_t ) );
+        };
+        auto all = []( std::vector<float3_t> const& v, float3_t const& d ) {
+            return std::all_of( v.begin(), v.end(), [&]( float3_t const& x ) { return x == d; } );
+        };
+
+        JsonWriter w( json );
+        w.begin_object();
+        w.key( "INSTANCES_LENGTH" );
+        w.value( double( size() ) );
+        if ( rtc_center != std::array<double, 3>{ 0.0, 0.0, 0.0 } )
+        {
+            w.key( "RTC_CENTER" );
+            w.numbers( rtc_center.data(), 3 );
+        }
+        if ( east_north_up )
+        {
+            w.key( "EAST_NORTH_UP" );
+            w.value( true );
+        }
+        float3_array( w, "POSITION", positions );
+        if ( !all( normal_up, { 0, 1, 0 } ) || !all( normal_right, { 1, 0, 0 } ) )
+        {
+            float3_array( w, "NORMAL_UP", normal_up );
+            float3_array( w, "NORMAL_RIGHT", normal_right );
+        }
+        if ( !all( scales, { 1, 1, 1 } ) )
+            float3_array( w, "SCALE_NON_UNIFORM", scales );
+
+        bool identity = true;
+        for ( size_t i = 0; i != batch_ids.size() && identity; ++i )
+            identity = batch_ids[i] == i;
+        if ( !identity )
+        {
+            uint32_t n = batch_length();
+            const char* type = n <= 0xFF ? "UNSIGNED_BYTE" : n <= 0xFFFF ? "UNSIGNED_SHORT" : "UNSIGNED_INT";
+            size_t component = n <= 0xFF ? 1 : n <= 0xFFFF ? 2 : 4;
+            binary.resize( ( binary.size() + component - 1 ) / component * component, '\0' );
+            w.key( "BATCH_ID" );
+            w.begin_object();
+            w.key( "byteOffset" );
+            w.value( double( binary.size() ) );
+            w.key( "componentType" );
+            w.value( type );
+            w.end_object();
+            for ( uint32_t id : batch_ids )
+                binary.append( reinterpret_cast<const char*>( &id ), component ); // little endian
+        }
+        w.end_object();
+        w.flush();
+
+        json.append( ( 8 - ( offset + json.size() ) % 8 ) % 8, ' ' );
+        binary.append( ( 8 - binary.size() % 8 ) % 8, '\0' );
+    }
+
+    /// @brief Decode the feature table of an i3dm
+    ///
+    /// Reads POSITION or POSITION_QUANTIZED, NORMAL_UP/NORMAL_RIGHT or the
+    /// oct-encoded _OCT32P pair, SCALE or SCALE_NON_UNIFORM and BATCH_ID.
+    bool parse( TileContent const& tile, std::string& error )
+    {
+        *this = TileInstances();
+        if ( tile.format() != TileHeader::I3DM )
+            return false_because( error, "not an i3dm" );
+
+        std::string text( tile.feature_table_json().str() );
+        std::unique_ptr<json_object, int ( * )( json_object* )> root( json_tokener_parse( text.c_str() ), &json_object_put );
+        if ( !root || json_object_get_type( root.get() ) != json_type_object )
+            return false_because( error, "invalid feature table JSON" );
+        TileContent::span_t bin = tile.feature_table_binary();
+        json_object* o = root.get();
+
+        json_object* length = nullptr;
+        if ( !json_object_object_get_ex( o, "INSTANCES_LENGTH", &length ) )
+            return false_because( error, "no INSTANCES_LENGTH" );
+        size_t n = size_t( json_object_get_int64( length ) );
+
+        // a binary property: byteOffset and the checked pointer to count values of size bytes
+        auto property = [&]( const char* name, size_t size, const char** p ) {
+            json_object* prop = nullptr;
+            json_object* offset = nullptr;
+            if ( !json_object_object_get_ex( o, name, &prop ) )
+                return false;
+            if ( !json_object_object_get_ex( prop, "byteOffset", &offset ) )
+                throw std::runtime_error( std::string( name ) + ": no byteOffset" );
+            size_t at = size_t( json_object_get_int64( offset ) );
+            if ( at > bin.size || n * size > bin.size - at )
+                throw std::runtime_error( std::string( name ) + " is out of the feature table" );
+            *p = bin.data + at;
+            return true;
+        };
+        auto global3 = [&]( const char* name, double* v ) {
+            json_object* a = nullptr;
+            if ( !json_object_object_get_ex( o, name, &a ) || json_object_array_length( a ) != 3 )
+                return false;
+            for ( size_t k = 0; k != 3; ++k )
+                v[k] = json_object_get_double( json_object_array_get_idx( a, k ) );
+            return true;
+        };
+
+        try
+        {
+            global3( "RTC_CENTER", rtc_center.data() );
+            json_object* enu = nullptr;
+            east_north_up = json_object_object_get_ex( o, "EAST_NORTH_UP", &enu ) && json_object_get_boolean( enu );
+
+            const char* p = nullptr;
+            positions.resize( n );
+            if ( property( "POSITION", sizeof( float3_t ), &p ) )
+            {
+                std::memcpy( positions.data(), p, n * sizeof( float3_t ) );
+            }
+            else if ( property( "POSITION_QUANTIZED", 6, &p ) )
+            {
+                double offset[3], scale[3];
+                if ( !global3( "QUANTIZED_VOLUME_OFFSET", offset ) || !global3( "QUANTIZED_VOLUME_SCALE", scale ) )
+                    return false_because( error, "POSITION_QUANTIZED without the quantized volume" );
+                for ( size_t i = 0; i != n; ++i )
+                    for ( int a = 0; a != 3; ++a )
+                        positions[i][a] = float( offset[a] + u16( p, 3 * i + a ) / 65535.0 * scale[a] );
+            }
+            else
+            {
+                return false_because( error, "no POSITION" );
+            }
+
+            normal_up.assign( n, float3_t{ 0, 1, 0 } );
+            normal_right.assign( n, float3_t{ 1, 0, 0 } );
+            const char* q = nullptr;
+            if ( property( "NORMAL_UP", sizeof( float3_t ), &p ) && property( "NORMAL_RIGHT", sizeof( float3_t ), &q ) )
+            {
+                std::memcpy( normal_up.data(), p, n * sizeof( float3_t ) );
+                std::memcpy( normal_right.data(), q, n * sizeof( float3_t ) );
+            }
+            else if ( property( "NORMAL_UP_OCT32P", 4, &p ) && property( "NORMAL_RIGHT_OCT32P", 4, &q ) )
+            {
+                for ( size_t i = 0; i != n; ++i )
+                {
+                    normal_up[i] = oct_decode( u16( p, 2 * i ), u16( p, 2 * i + 1 ) );
+                    normal_right[i] = oct_decode( u16( q, 2 * i ), u16( q, 2 * i + 1 ) );
+                }
+            }
+
+            scales.assign( n, float3_t{ 1, 1, 1 } );
+            if ( property( "SCALE_NON_UNIFORM", sizeof( float3_t ), &p ) )
+            {
+                std::memcpy( scales.data(), p, n * sizeof( float3_t ) );
+            }
+            else if ( property( "SCALE", sizeof( float ), &p ) )
+            {
+                for ( size_t i = 0; i != n; ++i )
+                {
+                    float s;
+                    std::memcpy( &s, p + i * sizeof( float ), sizeof( s ) );
+                    scales[i] = float3_t{ s, s, s };
+                }
+            }
+
+            batch_ids.resize( n );
+            std::string type = "UNSIGNED_SHORT";
+            json_object* prop = nullptr;
+            if ( json_object_object_get_ex( o, "BATCH_ID", &prop ) )
+            {
+                json_object* ct = nullptr;
+                if ( json_object_object_get_ex( prop, "componentType", &ct ) )
+                    type = json_object_get_string( ct );
+                size_t component = type == "UNSIGNED_BYTE" ? 1 : type == "UNSIGNED_SHORT" ? 2 : type == "UNSIGNED_INT" ? 4 : 0;
+                if ( !component )
+                    return false_because( error, "BATCH_ID: componentType " + type );
+                property( "BATCH_ID", component, &p );
+                for ( size_t i = 0; i != n; ++i )
+                {
+                    uint32_t id = 0;
+                    std::memcpy( &id, p + i * component, component ); // little endian
+                    batch_ids[i] = id;
+                }
+            }
+            else
+            {
+                for ( size_t i = 0; i != n; ++i )
+                    batch_ids[i] = uint32_t( i );
+            }
+        }
+        catch ( std::exception& e )
+        {
+            return false_because( error, e.what() );
+        }
+        return true;
+    }
+#pragma endregion
+
+protected:
+    static constexpr uint32_t npos = ~uint32_t( 0 );
+
+    static uint16_t u16( const char* p, size_t i )
+    {
+        uint16_t v;
+        std::memcpy( &v, p + 2 * i, sizeof( v ) );
+        return v;
+    }
+
+    /// @brief Oct-encoded unit vector (16 bits per component)
+    static float3_t oct_decode( uint16_t x, uint16_t y )
+    {
+        double u = x / 65535.0 * 2 - 1;
+        double v = y / 65535.0 * 2 - 1;
+        double z = 1 - std::abs( u ) - std::abs( v );
+        if ( z < 0 )
+        {
+            double t = u;
+            u = ( 1 - std::abs( v ) ) * ( t >= 0 ? 1 : -1 );
+            v = ( 1 - std::abs( t ) ) * ( v >= 0 ? 1 : -1 );
+        }
+        double l = std::sqrt( u * u + v * v + z * z );
+        return float3_t{ float( u / l ), float( v / l ), float( z / l ) };
+    }
+
+    bool false_because( std::string& error, std::string s )
+    {
+        error = std::move( s );
+        return false;
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILEINSTANCES_H
@@ -0,0 +1,408 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESPHERE_H
+#define TILESPHERE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define TILESPHERE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Bounding spheres of point sets in linear time
+///
+/// FAST and BALANCED are EPOS (Larsson 2008): the minimal sphere of the
+/// extreme points along 3 or 13 directions, grown over all the points as
+/// in Ritter's algorithm. EXACT is Welzl's randomized incremental minimal
+/// sphere (expected linear). The points are moved next to the center of
+/// their box first (float inner loops, SSE2 when available), the result is
+/// checked against the input in double, so it always contains every point.
+///
+///     auto s = TileSphere::of_points( &mesh->mVertices[0].x, mesh->mNumVertices );
+///     tile.boundingVolume = TileTree::sphere_t{ { s[0], s[1], s[2], s[3] } };
+class TileSphere
+{
+public:
+    enum quality_t
+    {
+        FAST,     // EPOS-6, usually within 10-20 % of the minimal radius
+        BALANCED, // EPOS-26, usually within a few %
+        EXACT     // the minimal sphere, a few times slower
+    };
+
+    typedef std::array<double, 4> sphere_t; // center and radius, as boundingVolume.sphere
+
+    /// @brief The bounding sphere of the points
+    /// @param xyz the first coordinate of the first point
+    /// @param stride the bytes from one point to the next
+    static sphere_t of_points( float const* xyz, size_t count, size_t stride = 3 * sizeof( float ),
+                               quality_t quality = BALANCED )
+    {
+        if ( !count )
+            return { 0, 0, 0, 0 };
+
+        points_t points( xyz, count, stride );
+        ball_t ball;
+        if ( quality == EXACT )
+        {
+            std::vector<uint32_t> order( count );
+            std::iota( order.begin(), order.end(), 0u );
+            std::shuffle( order.begin(), order.end(), std::mt19937( 20261018 ) );
+            ball = minimal( points, order );
+        }
+        else
+        {
+            ball = minimal( points, points.extremes( quality == FAST ? 3 : 13 ) );
+            points.grow( ball );
+        }
+
+        // every input point inside, in double
+        sphere_t r{ points.origin[0] + ball.c[0], points.origin[1] + ball.c[1], points.origin[2] + ball.c[2], 0 };
+        double r2 = ball.r2;
+        for ( size_t i = 0; i != count; ++i )
+        {
+            float const* p = point( xyz, stride, i );
+            double dx = p[0] - r[0], dy = p[1] - r[1], dz = p[2] - r[2];
+            r2 = std::max( r2, dx * dx + dy * dy + dz * dz );
+        }
+        r[3] = std::sqrt( r2 );
+        return r;
+    }
+
+private:
+    static float const* point( float const* xyz, size_t stride, size_t i )
+    {
+        return reinterpret_cast<float const*>( reinterpret_cast<uint8_t const*>( xyz ) + i * stride );
+    }
+
+    struct ball_t
+    {
+        double c[3] = { 0, 0, 0 };
+        double r2 = -1;
+
+        bool outside( double const* p ) const
+        {
+            double dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2];
+            return dx * dx + dy * dy + dz * dz > r2 * ( 1 + 1e-10 );
+        }
+    };
+
+    /// @brief The points relative to the center of their box, in columns
+    /// (padded to 4 with the first point)
+    struct points_t
+    {
+        double origin[3];
+        size_t count;
+        std::vector<float> x, y, z;
+
+        points_t( float const* xyz, size_t n, size_t stride )
+            : count( n )
+        {
+            double lo[3], hi[3];
+            std::copy( xyz, xyz + 3, lo );
+            std::copy( xyz, xyz + 3, hi );
+            for ( size_t i = 1; i != n; ++i )
+            {
+                float const* p = point( xyz, stride, i );
+                for ( int a = 0; a != 3; ++a )
+                {
+                    lo[a] = std::min( lo[a], double( p[a] ) );
+                    hi[a] = std::max( hi[a], double( p[a] ) );
+                }
+            }
+            for ( int a = 0; a != 3; ++a )
+                origin[a] = 0.5 * ( lo[a] + hi[a] );
+
+            size_t padded = ( n + 3 ) & ~size_t( 3 );
+            x.resize( padded );
+            y.resize( padded );
+            z.resize( padded );
+            for ( size_t i = 0; i != padded; ++i )
+            {
+                float const* p = point( xyz, stride, i < n ? i : 0 );
+                x[i] = float( p[0] - origin[0] );
+                y[i] = float( p[1] - origin[1] );
+                z[i] = float( p[2] - origin[2] );
+            }
+        }
+
+        void get( uint32_t i, double* p ) const
+        {
+            p[0] = x[i];
+            p[1] = y[i];
+            p[2] = z[i];
+        }
+
+        /// @brief The points with the smallest and the largest projections
+        /// on the first k EPOS directions
+        std::vector<uint32_t> extremes( int k ) const
+        {
+            static float const directions[13][3] = {
+                { 1, 0, 0 }, { 0, 1, 0 },  { 0, 0, 1 },  { 1, 1, 1 },  { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 },
+                { 1, 1, 0 }, { 1, -1, 0 }, { 1, 0, 1 }, { 1, 0, -1 }, { 0, 1, 1 },  { 0, 1, -1 }
+            };
+            float lo[13], hi[13];
+            uint32_t ilo[13], ihi[13];
+            std::fill( lo, lo + 13, std::numeric_limits<float>::max() );
+            std::fill( hi, hi + 13, -std::numeric_limits<float>::max() );
+            std::fill( ilo, ilo + 13, 0u );
+            std::fill( ihi, ihi + 13, 0u );
+#ifdef TILESPHERE_SSE2
+            __m128 vlo[13], vhi[13];
+            __m128i vilo[13], vihi[13];
+            for ( int d = 0; d != k; ++d )
+            {
+                vlo[d] = _mm_set1_ps( lo[d] );
+                vhi[d] = _mm_set1_ps( hi[d] );
+                vilo[d] = vihi[d] = _mm_setzero_si128();
+            }
+            __m128i index = _mm_set_epi32( 3, 2, 1, 0 ), four = _mm_set1_epi32( 4 );
+            for ( size_t i = 0; i != x.size(); i += 4 )
+            {
+                __m128 px = _mm_loadu_ps( &x[i] ), py = _mm_loadu_ps( &y[i] ), pz = _mm_loadu_ps( &z[i] );
+                for ( int d = 0; d != k; ++d )
+                {
+                    float const* u = directions[d];
+                    __m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( px, _mm_set1_ps( u[0] ) ),
+                                                         _mm_mul_ps( py, _mm_set1_ps( u[1] ) ) ),
+                                             _mm_mul_ps( pz, _mm_set1_ps( u[2] ) ) );
+                    __m128i less = _mm_castps_si128( _mm_cmplt_ps( dot, vlo[d] ) );
+                    __m128i more = _mm_castps_si128( _mm_cmpgt_ps( dot, vhi[d] ) );
+                    vlo[d] = _mm_min_ps( dot, vlo[d] );
+                    vhi[d] = _mm_max_ps( dot, vhi[d] );
+                    vilo[d] = _mm_or_si128( _mm_and_si128( less, index ), _mm_andnot_si128( less, vilo[d] ) );
+                    vihi[d] = _mm_or_si128( _mm_and_si128( more, index ), _mm_andnot_si128( more, vihi[d] ) );
+                }
+                index = _mm_add_epi32( index, four );
+            }
+            for ( int d = 0; d != k; ++d )
+            {
+                float l[4], h[4];
+                uint32_t il[4], ih[4];
+                _mm_storeu_ps( l, vlo[d] );
+                _mm_storeu_ps( h, vhi[d] );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( il ), vilo[d] );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( ih ), vihi[d] );
+                for ( int j = 0; j != 4; ++j )
+                {
+                    if ( l[j] < lo[d] )
+                        lo[d] = l[j], ilo[d] = il[j];
+                    if ( h[j] > hi[d] )
+                        hi[d] = h[j], ihi[d] = ih[j];
+                }
+            }
+#else
+            for ( uint32_t i = 0; i != x.size(); ++i )
+                for ( int d = 0; d != k; ++d )
+                {
+                    float const* u = directions[d];
+                    float dot = x[i] * u[0] + y[i] * u[1] + z[i] * u[2];
+                    if ( dot < lo[d] )
+                        lo[d] = dot, ilo[d] = i;
+                    if ( dot > hi[d] )
+                        hi[d] = dot, ihi[d] = i;
+                }
+#endif
+            std::vector<uint32_t> r( ilo, ilo + k );
+            r.insert( r.end(), ihi, ihi + k );
+            std::sort( r.begin(), r.end() );
+            r.erase( std::unique( r.begin(), r.end() ), r.end() );
+            return r;
+        }
+
+        /// @brief Ritter's growth: the ball moves toward each point outside
+        void grow( ball_t& ball ) const
+        {
+            double r = std::sqrt( std::max( ball.r2, 0.0 ) );
+            auto add = [&]( uint32_t i )
+            {
+                double p[3];
+                get( i, p );
+                double dx = p[0] - ball.c[0], dy = p[1] - ball.c[1], dz = p[2] - ball.c[2];
+                double d = std::sqrt( dx * dx + dy * dy + dz * dz );
+                if ( d <= r )
+                    return;
+                double grown = 0.5 * ( r + d ), t = ( grown - r ) / d;
+                ball.c[0] += dx * t;
+                ball.c[1] += dy * t;
+                ball.c[2] += dz * t;
+                r = grown;
+            };
+#ifdef TILESPHERE_SSE2
+            // the blocks of 4 inside the ball are skipped
+            for ( size_t i = 0; i != x.size(); i += 4 )
+            {
+                __m128 dx = _mm_sub_ps( _mm_loadu_ps( &x[i] ), _mm_set1_ps( float( ball.c[0] ) ) );
+                __m128 dy = _mm_sub_ps( _mm_loadu_ps( &y[i] ), _mm_set1_ps( float( ball.c[1] ) ) );
+                __m128 dz = _mm_sub_ps( _mm_loadu_ps( &z[i] ), _mm_set1_ps( float( ball.c[2] ) ) );
+                __m128 d2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) );
+                int outside = _mm_movemask_ps( _mm_cmpgt_ps( d2, _mm_set1_ps( float( r * r ) ) ) );
+                for ( int j = 0; outside; ++j, outside >>= 1 )
+                    if ( outside & 1 )
+                        add( uint32_t( i + j ) );
+            }
+#else
+            for ( uint32_t i = 0; i != x.size(); ++i )
+                add( i );
+#endif
+            ball.r2 = r * r;
+        }
+    };
+
+    /// @brief The minimal ball of the points (Welzl, iterative: the support
+    /// points are fixed one at a time over the prefixes)
+    static ball_t minimal( points_t const& points, std::vector<uint32_t> const& order )
+    {
+        std::vector<std::array<double, 3>> p( order.size() );
+        for ( size_t i = 0; i != order.size(); ++i )
+            points.get( order[i], p[i].data() );
+
+        ball_t b;
+        for ( size_t i = 0; i != p.size(); ++i )
+        {
+            if ( !b.outside( p[i].data() ) )
+                continue;
+            b = ball( { &p[i] } );
+            for ( size_t j = 0; j != i; ++j )
+            {
+                if ( !b.outside( p[j].data() ) )
+                    continue;
+                b = ball( { &p[i], &p[j] } );
+                for ( size_t k = 0; k != j; ++k )
+                {
+                    if ( !b.outside( p[k].data() ) )
+                        continue;
+                    b = ball( { &p[i], &p[j], &p[k] } );
+                    for ( size_t l = 0; l != k; ++l )
+                        if ( b.outside( p[l].data() ) )
+                            b = ball( { &p[i], &p[j], &p[k], &p[l] } );
+                }
+            }
+        }
+        return b;
+    }
+
+    /// @brief The smallest ball with 1 to 4 points on its surface
+    ///
+    /// Degenerate sets (collinear, coplanar) give the smallest ball of a
+    /// subset that contains all of them.
+    static ball_t ball( std::initializer_list<std::array<double, 3> const*> points )
+    {
+        std::array<double, 3> const* const* q = points.begin();
+        size_t n = points.size();
+        ball_t b;
+        if ( n == 1 )
+        {
+            std::copy( q[0]->begin(), q[0]->end(), b.c );
+            b.r2 = 0;
+            return b;
+        }
+
+        double const* a = q[0]->data();
+        double u[3][3], l2[3];
+        for ( size_t k = 1; k != n; ++k )
+        {
+            for ( int j = 0; j != 3; ++j )
+                u[k - 1][j] = ( *q[k] )[j] - a[j];
+            l2[k - 1] = u[k - 1][0] * u[k - 1][0] + u[k - 1][1] * u[k - 1][1] + u[k - 1][2] * u[k - 1][2];
+        }
+        auto cross = []( double const* x, double const* y, double* r )
+        {
+            r[0] = x[1] * y[2] - x[2] * y[1];
+            r[1] = x[2] * y[0] - x[0] * y[2];
+            r[2] = x[0] * y[1] - x[1] * y[0];
+        };
+        auto dot = []( double const* x, double const* y ) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+        auto set = [&]( double const* o )
+        {
+            for ( int j = 0; j != 3; ++j )
+                b.c[j] = a[j] + o[j];
+            b.r2 = dot( o, o );
+        };
+
+        if ( n == 2 )
+        {
+            double o[3] = { u[0][0] / 2, u[0][1] / 2, u[0][2] / 2 };
+            set( o );
+            return b;
+        }
+
+        if ( n == 3 )
+        {
+            // the circumcenter in the plane of the triangle
+            double w[3], s[3], o[3];
+            cross( u[0], u[1], w );
+            double w2 = dot( w, w );
+            if ( w2 <= 1e-24 * l2[0] * l2[1] )
+                return smallest_containing( q, n, 2 );
+            for ( int j = 0; j != 3; ++j )
+                s[j] = l2[0] * u[1][j] - l2[1] * u[0][j];
+            cross( s, w, o );
+            for ( double& v : o )
+                v /= 2 * w2;
+            set( o );
+            return b;
+        }
+
+        // the circumcenter: 2 u.o = |u|^2 for the three edges
+        double c01[3], c12[3], c20[3];
+        cross( u[0], u[1], c01 );
+        cross( u[1], u[2], c12 );
+        cross( u[2], u[0], c20 );
+        double det = 2 * dot( u[0], c12 );
+        if ( std::abs( det ) <= 1e-12 * std::sqrt( l2[0] * l2[1] * l2[2] ) )
+            return smallest_containing( q, n, 3 );
+        double o[3];
+        for ( int j = 0; j != 3; ++j )
+            o[j] = ( l2[0] * c12[j] + l2[1] * c20[j] + l2[2] * c01[j] ) / det;
+        set( o );
+        return b;
+    }
+
+    /// @brief The smallest ball through m of the n points that contains them all
+    static ball_t smallest_containing( std::array<double, 3> const* const* q, size_t n, size_t m )
+    {
+        ball_t best;
+        for ( uint32_t mask = 0; mask != ( 1u << n ); ++mask )
+        {
+            std::array<double, 3> const* s[4];
+            size_t j = 0;
+            for ( size_t k = 0; k != n; ++k )
+                if ( mask >> k & 1 )
+                    s[j++] = q[k];
+            if ( j != m )
+                continue;
+            ball_t b = m == 2 ? ball( { s[0], s[1] } ) : ball( { s[0], s[1], s[2] } );
+            bool all = true;
+            for ( size_t k = 0; k != n && all; ++k )
+                all = !b.outside( q[k]->data() );
+            if ( all && ( best.r2 < 0 || b.r2 < best.r2 ) )
+                best = b;
+        }
+        return best;
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESPHERE_H
@@ -0,0 +1,572 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETDIFF_H
+#define TILESETDIFF_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "TilesetImage.h"
+#include "TilesetTree.h"
+#include "TilesetWriter.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Differences between two versions of a tile tree and their merge
+///
+/// The roots are paired, the children of paired tiles are paired by content
+/// uri and bounding volume, then by uri, then by bounding volume. Paired
+/// subtrees with the same hash (tile properties, content file hashes and
+/// the hashes of the children) are not visited.
+class TilesetDiff
+{
+public:
+    typedef TileTree::index_t index_t;
+    static constexpr index_t npos = TileTree::npos;
+
+    enum kind_t : uint8_t
+    {
+        ADDED,      // a subtree only in b
+        REMOVED,    // a subtree only in a
+        CHANGED     // a tile in both, with different properties
+    };
+
+    /// @brief What differs in a CHANGED tile
+    enum what_t : uint8_t
+    {
+        GEOMETRIC_ERROR = 1,
+        VOLUME = 2,
+        TRANSFORM = 4,
+        REFINE = 8,
+        URI = 16,
+        CONTENT = 32    // the content files differ
+    };
+
+    struct change_t
+    {
+        kind_t kind;
+        uint8_t what;   // CHANGED: what_t flags
+        index_t a;      // npos if ADDED
+        index_t b;      // npos if REMOVED
+        size_t tiles;   // the tiles in the added or removed subtree
+    };
+
+    struct options_t
+    {
+        bool compare_content = false;   // hash the content files
+        std::filesystem::path dir_a;    // the content uris of a are relative to it
+        std::filesystem::path dir_b;
+        unsigned threads = 0;           // content hashing, 0: std::thread::hardware_concurrency()
+    };
+
+    struct result_t
+    {
+        std::vector<change_t> changes;  // in the traversal order
+        std::vector<index_t> a_to_b;    // the paired tile of b or npos
+        std::vector<index_t> b_to_a;
+        std::vector<uint8_t> same;      // per tile of a: the subtree is identical
+        size_t unchanged = 0;           // tiles in identical subtrees
+        size_t added = 0;               // tiles
+        size_t removed = 0;
+        size_t changed = 0;
+
+        bool identical() const { return changes.empty(); }
+    };
+
+    static result_t diff( TileTree const& a, TileTree const& b )
+    {
+        return diff( a, b, options_t() );
+    }
+
+    static result_t diff( TileTree const& a, TileTree const& b, options_t const& options )
+    {
+        result_t r;
+        r.a_to_b.assign( a.size(), npos );
+        r.b_to_a.assign( b.size(), npos );
+        r.same.assign( a.size(), 0 );
+        if ( a.empty() || b.empty() )
+        {
+            if ( !a.empty() )
+                add_change( r, a, b, REMOVED, a.root(), npos );
+            if ( !b.empty() )
+                add_change( r, a, b, ADDED, npos, b.root() );
+            return r;
+        }
+
+        unsigned threads = options.threads ? options.threads : std::max( 1u, std::thread::hardware_concurrency() );
+        hashes_t ha, hb;
+        if ( options.compare_content )
+        {
+            ha.content = hash_contents( a, options.dir_a, threads );
+            hb.content = hash_contents( b, options.dir_b, threads );
+        }
+        subtree_hashes( a, ha );
+        subtree_hashes( b, hb );
+
+        std::vector<std::pair<index_t, index_t>> stack{ { a.root(), b.root() } };
+        std::vector<index_t> ca, cb;
+        while ( !stack.empty() )
+        {
+            auto [ia, ib] = stack.back();
+            stack.pop_back();
+            r.a_to_b[ia] = ib;
+            r.b_to_a[ib] = ia;
+
+            if ( ha.subtree[ia] == hb.subtree[ib] )
+            {
+                pair_identical( r, a, b, ia, ib );
+                continue;
+            }
+
+            uint8_t what = compare( a, b, ia, ib, ha, hb );
+            if ( what )
+            {
+                r.changes.push_back( change_t{ CHANGED, what, ia, ib, 1 } );
+                ++r.changed;
+            }
+
+            // pair the children
+            ca.clear();
+            cb.clear();
+            a.for_each_child( ia, [&]( index_t c ) { ca.push_back( c ); } );
+            b.for_each_child( ib, [&]( index_t c ) { cb.push_back( c ); } );
+            std::vector<std::pair<index_t, index_t>> pairs;
+            for ( int round = 0; round != 3; ++round )
+                pair_children( a, b, ca, cb, round, pairs );
+
+            for ( index_t c : ca )
+                if ( c != npos )
+                    add_change( r, a, b, REMOVED, c, npos );
+            for ( index_t c : cb )
+                if ( c != npos )
+                    add_change( r, a, b, ADDED, npos, c );
+            // visited in the order of a
+            std::sort( pairs.begin(), pairs.end() );
+            for ( auto it = pairs.rbegin(); it != pairs.rend(); ++it )
+                stack.push_back( *it );
+        }
+        return r;
+    }
+
+    enum merge_mode_t
+    {
+        MERGE_OVERLAY,  // keep the tiles only in the base (splice a regional update)
+        MERGE_MIRROR    // the result has the structure of the update
+    };
+
+    struct merge_t
+    {
+        TileTree tree;
+        std::vector<index_t> rewritten; // the tiles not copied from an identical subtree of the base
+    };
+
+    /// @brief Apply the changes of update to base
+    /// @param d diff( base, update )
+    /// @param uri_prefix prepended to the content uris taken from the update
+    static merge_t merge( TileTree const& base, TileTree const& update, result_t const& d, merge_mode_t mode, std::string const& uri_prefix = std::string() )
+    {
+        merge_t m;
+        m.tree.asset = update.asset;
+        m.tree.geometricError = update.geometricError;
+        m.tree.reserve( mode == MERGE_MIRROR ? update.size() : base.size() + d.added );
+
+        struct item_t
+        {
+            index_t a, b, parent;
+        };
+        std::vector<item_t> stack;
+        if ( !base.empty() )
+            stack.push_back( { base.root(), d.a_to_b[base.root()], npos } );
+        else if ( !update.empty() )
+            stack.push_back( { npos, update.root(), npos } );
+
+        auto take_update = [&]( index_t ib, index_t parent ) {
+            index_t t = m.tree.append_copy( update, ib, parent );
+            if ( update[ib].uri != npos && !uri_prefix.empty() )
+                m.tree.set_uri( t, uri_prefix + std::string( update.uri( ib ) ) );
+            m.rewritten.push_back( t );
+            return t;
+        };
+        std::unordered_map<index_t, uint8_t> changed;
+        for ( auto const& c : d.changes )
+            if ( c.kind == CHANGED )
+                changed[c.a] = c.what;
+
+        std::vector<item_t> children;
+        while ( !stack.empty() )
+        {
+            item_t it = stack.back();
+            stack.pop_back();
+            if ( it.b == npos )
+            {
+                // only in the base
+                if ( mode == MERGE_OVERLAY )
+                    copy_subtree( base, it.a, m.tree, it.parent, nullptr, std::string() );
+                continue;
+            }
+            if ( it.a == npos )
+            {
+                copy_subtree( update, it.b, m.tree, it.parent, &m.rewritten, uri_prefix );
+                continue;
+            }
+            if ( d.same[it.a] )
+            {
+                copy_subtree( base, it.a, m.tree, it.parent, nullptr, std::string() );
+                continue;
+            }
+
+            // the tile itself: from the update if it changed, the base uri if the content is the same
+            index_t t;
+            auto c = changed.find( it.a );
+            if ( c != changed.end() && ( c->second & ( URI | CONTENT ) ) )
+            {
+                t = take_update( it.b, it.parent );
+            }
+            else
+            {
+                t = c != changed.end() ? m.tree.append_copy( update, it.b, it.parent ) : m.tree.append_copy( base, it.a, it.parent );
+                m.rewritten.push_back( t );
+            }
+
+            children.clear();
+            base.for_each_child( it.a, [&]( index_t ca ) { children.push_back( { ca, d.a_to_b[ca], t } ); } );
+            update.for_each_child( it.b, [&]( index_t cb ) {
+                if ( d.b_to_a[cb] == npos )
+                    children.push_back( { npos, cb, t } );
+            } );
+            stack.insert( stack.end(), children.rbegin(), children.rend() );
+        }
+        return m;
+    }
+
+    /// @brief The content uris of b to publish: in the added subtrees and the changed tiles
+    static std::vector<std::string> changed_content( result_t const& d, TileTree const& b )
+    {
+        std::vector<std::string> r;
+        for ( auto const& c : d.changes )
+        {
+            if ( c.kind == CHANGED && ( c.what & ( URI | CONTENT ) ) && b[c.b].uri != npos )
+                r.emplace_back( b.uri( c.b ) );
+            if ( c.kind == ADDED )
+                for_subtree( b, c.b, [&]( index_t i ) {
+                    if ( b[i].uri != npos )
+                        r.emplace_back( b.uri( i ) );
+                } );
+        }
+        std::sort( r.begin(), r.end() );
+        r.erase( std::unique( r.begin(), r.end() ), r.end() );
+        return r;
+    }
+
+    /// @brief Machine readable report
+    static void write_report( result_t const& d, TileTree const& a, TileTree const& b, JsonWriter& w )
+    {
+        static const char* kinds[] = { "added", "removed", "changed" };
+        static const std::pair<what_t, const char*> whats[] = {
+            { GEOMETRIC_ERROR, "geometricError" }, { VOLUME, "boundingVolume" }, { TRANSFORM, "transform" },
+            { REFINE, "refine" }, { URI, "uri" }, { CONTENT, "content" } };
+
+        w.begin_object();
+        w.key( "unchanged" );
+        w.value( double( d.unchanged ) );
+        w.key( "added" );
+        w.value( double( d.added ) );
+        w.key( "removed" );
+        w.value( double( d.removed ) );
+        w.key( "changed" );
+        w.value( double( d.changed ) );
+        w.key( "changes" );
+        w.begin_array();
+        for ( auto const& c : d.changes )
+        {
+            w.begin_object();
+            w.key( "kind" );
+            w.value( kinds[c.kind] );
+            if ( c.a != npos )
+            {
+                w.key( "a" );
+                w.value( a.json_pointer( c.a ) );
+            }
+            if ( c.b != npos )
+            {
+                w.key( "b" );
+                w.value( b.json_pointer( c.b ) );
+            }
+            if ( c.kind == CHANGED )
+            {
+                w.key( "what" );
+                w.begin_array( true );
+                for ( auto const& [flag, name] : whats )
+                    if ( c.what & flag )
+                        w.value( name );
+                w.end_array();
+            }
+            else
+            {
+                w.key( "tiles" );
+                w.value( double( c.tiles ) );
+            }
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+    }
+
+    static std::string report_to_string( result_t const& d, TileTree const& a, TileTree const& b, bool pretty = false )
+    {
+        std::string r;
+        {
+            JsonWriter w( r, pretty );
+            write_report( d, a, b, w );
+        }
+        return r;
+    }
+
+protected:
+    struct hashes_t
+    {
+        std::vector<uint64_t> content;  // per string id, empty if not compared
+        std::vector<uint64_t> tile;     // the tile properties
+        std::vector<uint64_t> subtree;
+    };
+
+    static uint64_t fnv( uint64_t h, void const* data, size_t n )
+    {
+        auto p = static_cast<unsigned char const*>( data );
+        for ( size_t i = 0; i != n; ++i )
+            h = ( h ^ p[i] ) * 1099511628211ull;
+        return h;
+    }
+
+    template <typename F>
+    static void for_subtree( TileTree const& tree, index_t r, F&& f )
+    {
+        std::vector<index_t> stack{ r };
+        while ( !stack.empty() )
+        {
+            index_t i = stack.back();
+            stack.pop_back();
+            f( i );
+            tree.for_each_child( i, [&]( index_t c ) { stack.push_back( c ); } );
+        }
+    }
+
+    /// @brief Hashes of the content files, by string id
+    static std::vector<uint64_t> hash_contents( TileTree const& tree, std::filesystem::path const& dir, unsigned threads )
+    {
+        std::vector<uint64_t> r( tree.strings().size(), 0 );
+        std::vector<index_t> ids;
+        std::vector<char> seen( r.size(), 0 );
+        for ( auto const& t : tree.tiles() )
+            if ( t.uri != npos && !seen[t.uri] )
+            {
+                seen[t.uri] = 1;
+                ids.push_back( t.uri );
+            }
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]() {
+            for ( size_t k; ( k = next++ ) < ids.size(); )
+            {
+                std::string_view uri = tree.strings().str( ids[k] );
+                uri = uri.substr( 0, uri.find_first_of( "?#" ) );
+                if ( uri.find( "://" ) == std::string_view::npos )
+                    r[ids[k]] = TilesetImage::hash_file( dir / std::filesystem::u8path( uri ) );
+            }
+        };
+        threads = std::min<unsigned>( threads, unsigned( ids.size() ) );
+        std::vector<std::thread> pool;
+        for ( unsigned t = 1; t < threads; ++t )
+            pool.emplace_back( worker );
+        worker();
+        for ( auto& th : pool )
+            th.join();
+        return r;
+    }
+
+    /// @brief Tile and subtree hashes, the parents precede the children
+    static void subtree_hashes( TileTree const& tree, hashes_t& h )
+    {
+        size_t n = tree.size();
+        h.tile.resize( n );
+        h.subtree.resize( n );
+        for ( index_t i = 0; i != n; ++i )
+        {
+            auto const& t = tree[i];
+            uint64_t x = 14695981039346656037ull;
+            x = fnv( x, &t.geometricError, sizeof( double ) );
+            uint8_t kind = uint8_t( t.boundingVolume.index() );
+            x = fnv( x, &kind, 1 );
+            std::visit( [&]( auto const& v ) {
+                if constexpr ( !std::is_same_v<std::decay_t<decltype( v )>, std::monostate> )
+                    x = fnv( x, &v, sizeof( v ) );
+            }, t.boundingVolume );
+            if ( auto tr = tree.transform( i ) )
+                x = fnv( x, tr->matrix4x4, sizeof( tr->matrix4x4 ) );
+            uint8_t refine = i == tree.root() ? tree.effective_refine( i ) : t.refine;
+            x = fnv( x, &refine, 1 );
+            if ( t.uri != npos )
+            {
+                auto uri = tree.uri( i );
+                x = fnv( x, uri.data(), uri.size() );
+                if ( !h.content.empty() )
+                    x = fnv( x, &h.content[t.uri], sizeof( uint64_t ) );
+            }
+            h.tile[i] = x;
+        }
+        for ( index_t i = index_t( n ); i-- != 0; )
+        {
+            uint64_t x = h.tile[i];
+            tree.for_each_child( i, [&]( index_t c ) { x = fnv( x, &h.subtree[c], sizeof( uint64_t ) ); } );
+            h.subtree[i] = x;
+        }
+    }
+
+    static uint8_t compare( TileTree const& a, TileTree const& b, index_t ia, index_t ib, hashes_t const& ha, hashes_t const& hb )
+    {
+        auto const& ta = a[ia];
+        auto const& tb = b[ib];
+        uint8_t what = 0;
+        if ( ta.geometricError != tb.geometricError )
+            what |= GEOMETRIC_ERROR;
+        if ( volume_key( ta.boundingVolume ) != volume_key( tb.boundingVolume ) )
+            what |= VOLUME;
+        auto tra = a.transform( ia );
+        auto trb = b.transform( ib );
+        if ( ( tra == nullptr ) != ( trb == nullptr )
+             || ( tra && std::memcmp( tra->matrix4x4, trb->matrix4x4, sizeof( tra->matrix4x4 ) ) != 0 ) )
+            what |= TRANSFORM;
+        bool root = ia == a.root();
+        if ( ( root ? a.effective_refine( ia ) : ta.refine ) != ( root ? b.effective_refine( ib ) : tb.refine ) )
+            what |= REFINE;
+        if ( ( ta.uri == npos ) != ( tb.uri == npos ) || ( ta.uri != npos && a.uri( ia ) != b.uri( ib ) ) )
+            what |= URI;
+        if ( !ha.content.empty() && ta.uri != npos && tb.uri != npos && ha.content[ta.uri] != hb.content[tb.uri] )
+            what |= CONTENT;
+        return what;
+    }
+
+    static std::string volume_key( TileTree::volume_t const& v )
+    {
+        std::string k( 1, char( v.index() ) );
+        std::visit( [&]( auto const& x ) {
+            if constexpr ( !std::is_same_v<std::decay_t<decltype( x )>, std::monostate> )
+                k.append( reinterpret_cast<const char*>( &x ), sizeof( x ) );
+        }, v );
+        return k;
+    }
+
+    /// @brief Pair the children left in ca and cb (the paired ones are set to npos)
+    /// @param round 0: uri and volume, 1: uri, 2: volume
+    static void pair_children( TileTree const& a, TileTree const& b, std::vector<index_t>& ca, std::vector<index_t>& cb,
+                               int round, std::vector<std::pair<index_t, index_t>>& pairs )
+    {
+        auto key = [&]( TileTree const& t, index_t i ) {
+            std::string k;
+            if ( round != 2 )
+            {
+                if ( t[i].uri == npos )
+                    return k;
+                k = t.uri( i );
+                k.push_back( '\0' );
+            }
+            if ( round != 1 )
+                k += volume_key( t[i].boundingVolume );
+            return k;
+        };
+
+        std::unordered_map<std::string, std::vector<size_t>> by_key;
+        for ( size_t k = cb.size(); k-- != 0; )
+            if ( cb[k] != npos )
+            {
+                auto s = key( b, cb[k] );
+                if ( !s.empty() )
+                    by_key[s].push_back( k );
+            }
+        for ( auto& i : ca )
+        {
+            if ( i == npos )
+                continue;
+            auto s = key( a, i );
+            if ( s.empty() )
+                continue;
+            auto it = by_key.find( s );
+            if ( it == by_key.end() || it->second.empty() )
+                continue;
+            // the first one in the document order
+            size_t k = it->second.back();
+            it->second.pop_back();
+            pairs.emplace_back( i, cb[k] );
+            i = npos;
+            cb[k] = npos;
+        }
+    }
+
+    static void add_change( result_t& r, TileTree const& a, TileTree const& b, kind_t kind, index_t ia, index_t ib )
+    {
+        size_t n = 0;
+        for_subtree( kind == ADDED ? b : a, kind == ADDED ? ib : ia, [&]( index_t ) { ++n; } );
+        r.changes.push_back( change_t{ kind, 0, ia, ib, n } );
+        ( kind == ADDED ? r.added : r.removed ) += n;
+    }
+
+    /// @brief Pair the identical subtrees tile by tile
+    static void pair_identical( result_t& r, TileTree const& a, TileTree const& b, index_t ia, index_t ib )
+    {
+        std::vector<std::pair<index_t, index_t>> stack{ { ia, ib } };
+        while ( !stack.empty() )
+        {
+            auto [x, y] = stack.back();
+            stack.pop_back();
+            r.a_to_b[x] = y;
+            r.b_to_a[y] = x;
+            r.same[x] = 1;
+            ++r.unchanged;
+            for ( index_t cx = a[x].first_child, cy = b[y].first_child; cx != npos && cy != npos;
+                  cx = a[cx].next_sibling, cy = b[cy].next_sibling )
+                stack.emplace_back( cx, cy );
+        }
+    }
+
+    /// @brief Copy the subtree under parent
+    /// @param rewritten if not null, receives the new tiles
+    static void copy_subtree( TileTree const& src, index_t r, TileTree& dst, index_t parent,
+                              std::vector<index_t>* rewritten, std::string const& uri_prefix )
+    {
+        std::vector<std::pair<index_t, index_t>> stack{ { r, parent } };
+        std::vector<std::pair<index_t, index_t>> children;
+        while ( !stack.empty() )
+        {
+            auto [i, p] = stack.back();
+            stack.pop_back();
+            index_t t = dst.append_copy( src, i, p );
+            if ( src[i].uri != npos && !uri_prefix.empty() )
+                dst.set_uri( t, uri_prefix + std::string( src.uri( i ) ) );
+            if ( rewritten )
+                rewritten->push_back( t );
+            children.clear();
+            src.for_each_child( i, [&]( index_t c ) { children.emplace_back( c, t ); } );
+            stack.insert( stack.end(), children.rbegin(), children.rend() );
+        }
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETDIFF_H
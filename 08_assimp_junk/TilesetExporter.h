@@ -0,0 +1,749 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETEXPORTER_H
+#define TILESETEXPORTER_H
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <assimp/Exporter.hpp>
+#include <assimp/scene.h>
+
+#include <json-c/json.h>
+
+#include "TileComposite.h"
+#include "TileInstances.h"
+#include "TilesetTree.h"
+#include "TilesetWriter.h"
+#include "meshreorder.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Writes aiScene tiles as b3dm files and the tileset.json
+///
+/// The tree is built while the tiles are added, the scenes go to a pool of
+/// threads that encode the glb (Assimp "glb2" exporter), add the _BATCHID
+/// vertex attribute and write the b3dm with a binary batch table. finish()
+/// waits for the pool, fills the missing bounding volumes and writes the
+/// tileset.json. A tile added with TileInstances is written as an i3dm:
+/// the model once and the per-instance arrays.
+///
+///     TilesetExporter exporter( "out" );
+///     auto root = exporter.add_tile( TilesetExporter::npos, 100.0 );
+///     exporter.add_tile( root, 0.0, std::move( scene ), batch );
+///     exporter.finish();
+class TilesetExporter
+{
+public:
+    typedef TileTree::index_t index_t;
+    typedef meshtoolbox::scene_ptr scene_ptr; // a std::unique_ptr<aiScene> converts
+    static constexpr index_t npos = TileTree::npos;
+
+    /// @brief The features of a tile and their properties
+    struct batch_t
+    {
+        std::vector<uint32_t> mesh_batch_ids;    // the feature of each aiMesh, empty: the mesh index
+        std::vector<std::pair<std::string, std::vector<std::string>>> strings;  // batch table JSON
+        std::vector<std::pair<std::string, std::vector<double>>> numbers;       // batch table binary, DOUBLE
+
+        /// @brief BATCH_LENGTH
+        uint32_t length( unsigned num_meshes ) const
+        {
+            if ( mesh_batch_ids.empty() )
+                return num_meshes;
+            return *std::max_element( mesh_batch_ids.begin(), mesh_batch_ids.end() ) + 1;
+        }
+    };
+
+    struct options_t
+    {
+        unsigned threads = 0;           // 0: std::thread::hardware_concurrency()
+        unsigned max_pending = 0;       // scenes waiting for the pool, 0: threads * 4
+        unsigned export_flags = 0;      // aiProcess_* for the exporter, must not split or join meshes
+        std::string content_dir = "tiles";  // relative to the output directory
+        bool y_up = true;               // glTF content, the volumes are rotated to Z-up
+        bool pretty = false;            // indent the tileset.json
+        size_t composite_bytes = 0;     // pack sibling leaves into cmpt files up to this size, 0: no
+        bool reorder = false;           // the vertex cache and fetch order of the meshes (reorder_mesh())
+    };
+
+    explicit TilesetExporter( std::filesystem::path const& dir )
+        : TilesetExporter( dir, options_t() )
+    {
+    }
+
+    TilesetExporter( std::filesystem::path const& dir, options_t const& options )
+        : m_dir( dir )
+        , m_options( options )
+    {
+        std::filesystem::create_directories( m_dir / std::filesystem::u8path( m_options.content_dir ) );
+        unsigned threads = m_options.threads ? m_options.threads : std::max( 1u, std::thread::hardware_concurrency() );
+        if ( !m_options.max_pending )
+            m_options.max_pending = threads * 4;
+        for ( unsigned t = 0; t != threads; ++t )
+            m_pool.emplace_back( [this]() { worker(); } );
+    }
+
+    ~TilesetExporter() { stop(); }
+
+    TilesetExporter( TilesetExporter const& ) = delete;
+    TilesetExporter& operator=( TilesetExporter const& ) = delete;
+
+    /// @brief The tree being built (transforms, refine, asset)
+    TileTree& tree() { return m_tree; }
+
+    /// @brief Add a tile without content
+    /// @param volume empty: the union of the children volumes
+    index_t add_tile( index_t parent, double geometricError, TileTree::volume_t const& volume = TileTree::volume_t() )
+    {
+        index_t i = m_tree.add_tile( parent );
+        m_tree[i].geometricError = geometricError;
+        m_tree[i].boundingVolume = volume;
+        m_derived.push_back( volume.index() == 0 );
+        return i;
+    }
+
+    /// @brief Add a tile with the scene as its b3dm content
+    ///
+    /// Blocks while max_pending scenes wait for the pool.
+    /// @param volume empty: the bounding box of the scene
+    index_t add_tile( index_t parent, double geometricError, scene_ptr scene, batch_t batch = batch_t(),
+                      TileTree::volume_t const& volume = TileTree::volume_t() )
+    {
+        return add_content( parent, geometricError, std::move( scene ), nullptr, std::move( batch ), volume );
+    }
+
+    /// @brief Add a tile with the model placed by the instances as its i3dm content
+    /// @param batch the batch table, by the instance batch ids (mesh_batch_ids are not used)
+    /// @param volume empty: the bounding box of the placed models
+    index_t add_tile( index_t parent, double geometricError, scene_ptr model, TileInstances instances,
+                      batch_t batch = batch_t(), TileTree::volume_t const& volume = TileTree::volume_t() )
+    {
+        if ( instances.empty() )
+            throw std::runtime_error( "no instances" );
+        return add_content( parent, geometricError, std::move( model ),
+                            std::make_unique<TileInstances>( std::move( instances ) ), std::move( batch ), volume );
+    }
+
+    /// @brief Wait for the pool and write the tileset.json
+    ///
+    /// With composite_bytes the tree is regrouped (the tile indices change).
+    /// @return the tileset.json path
+    std::filesystem::path finish()
+    {
+        stop();
+        if ( !m_error.empty() )
+            throw std::runtime_error( m_error );
+
+        for ( auto& kv : m_boxes )
+            m_tree[kv.first].boundingVolume = kv.second;
+        derive_volumes();
+        if ( m_options.composite_bytes )
+            m_tree = TileComposite::group( m_tree, m_dir, m_options.composite_bytes ).tree;
+        if ( m_tree.geometricError == 0 && !m_tree.empty() )
+            m_tree.geometricError = m_tree[m_tree.root()].geometricError;
+
+        auto filename = m_dir / "tileset.json";
+        if ( !TilesetWriter::save_as( m_tree, filename.u8string(), m_options.pretty ) )
+            throw std::runtime_error( "cannot write " + filename.u8string() );
+        return filename;
+    }
+
+    /// @brief The number of content files written so far
+    size_t written() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_boxes.size() + m_written_with_volume;
+    }
+
+#pragma region encoding
+    /// @brief Encode the scene as binary glTF
+    ///
+    /// Nodes with several meshes get a child node per extra mesh, so that
+    /// the exporter keeps one glTF mesh per aiMesh.
+    static std::string encode_glb( aiScene* scene, unsigned flags = 0 )
+    {
+        split_meshes( scene->mRootNode );
+        Assimp::Exporter exporter;
+        aiExportDataBlob const* blob = exporter.ExportToBlob( scene, "glb2", flags );
+        if ( !blob )
+            throw std::runtime_error( std::string( "glb2 export failed: " ) + exporter.GetErrorString() );
+        return std::string( static_cast<const char*>( blob->data ), blob->size );
+    }
+
+    /// @brief Add the _BATCHID attribute to the primitives of a glb
+    /// @param glb binary glTF, the result is padded to 8 bytes
+    /// @param mesh_batch_ids the feature of each glTF mesh
+    static void add_batch_ids( std::string& glb, std::vector<uint32_t> const& mesh_batch_ids )
+    {
+        uint32_t header[5];
+        if ( glb.size() < sizeof( header ) )
+            throw std::runtime_error( "truncated glb" );
+        std::memcpy( header, glb.data(), sizeof( header ) );
+        if ( header[0] != GLB_MAGIC || header[3] % 4 || 20 + size_t( header[3] ) > glb.size() || header[4] != CHUNK_JSON )
+            throw std::runtime_error( "not a glb" );
+
+        std::string bin;
+        size_t bin_offset = 20 + size_t( header[3] );
+        if ( bin_offset + 8 <= glb.size() )
+        {
+            uint32_t chunk[2];
+            std::memcpy( chunk, glb.data() + bin_offset, sizeof( chunk ) );
+            if ( chunk[1] != CHUNK_BIN || bin_offset + 8 + chunk[0] > glb.size() )
+                throw std::runtime_error( "glb: BIN chunk expected" );
+            bin.assign( glb, bin_offset + 8, chunk[0] );
+        }
+
+        std::unique_ptr<json_object, int ( * )( json_object* )> root(
+            json_tokener_parse( glb.substr( 20, header[3] ).c_str() ), &json_object_put );
+        if ( !root )
+            throw std::runtime_error( "glb: invalid JSON chunk" );
+
+        json_object* meshes = member_array( root.get(), "meshes" );
+        json_object* accessors = member_array( root.get(), "accessors" );
+        json_object* views = member_array( root.get(), "bufferViews" );
+        json_object* buffers = member_array( root.get(), "buffers" );
+        if ( json_object_array_length( meshes ) != mesh_batch_ids.size() )
+            throw std::runtime_error( "glb: " + std::to_string( json_object_array_length( meshes ) ) + " meshes, "
+                                      + std::to_string( mesh_batch_ids.size() ) + " expected" );
+
+        // all the ids in one buffer view, an accessor per primitive
+        bin.resize( ( bin.size() + 3 ) & ~size_t( 3 ), '\0' );
+        size_t view_offset = bin.size();
+        index_t view = index_t( json_object_array_length( views ) );
+        for ( size_t m = 0; m != mesh_batch_ids.size(); ++m )
+        {
+            json_object* primitives = member_array( json_object_array_get_idx( meshes, m ), "primitives" );
+            for ( size_t p = 0, n = json_object_array_length( primitives ); p != n; ++p )
+            {
+                json_object* attributes = nullptr;
+                json_object* position = nullptr;
+                json_object_object_get_ex( json_object_array_get_idx( primitives, p ), "attributes", &attributes );
+                if ( !attributes || !json_object_object_get_ex( attributes, "POSITION", &position ) )
+                    continue;
+                json_object* count = nullptr;
+                json_object_object_get_ex( json_object_array_get_idx( accessors, json_object_get_int( position ) ), "count", &count );
+                int64_t vertices = count ? json_object_get_int64( count ) : 0;
+
+                auto accessor = json_object_new_object();
+                json_object_object_add( accessor, "bufferView", json_object_new_int( int32_t( view ) ) );
+                json_object_object_add( accessor, "byteOffset", json_object_new_int64( int64_t( bin.size() - view_offset ) ) );
+                json_object_object_add( accessor, "componentType", json_object_new_int( 5126 ) ); // FLOAT
+                json_object_object_add( accessor, "count", json_object_new_int64( vertices ) );
+                json_object_object_add( accessor, "type", json_object_new_string( "SCALAR" ) );
+                json_object_object_add( attributes, "_BATCHID", json_object_new_int( int32_t( json_object_array_length( accessors ) ) ) );
+                json_object_array_add( accessors, accessor );
+
+                float id = float( mesh_batch_ids[m] );
+                for ( int64_t v = 0; v != vertices; ++v )
+                    bin.append( reinterpret_cast<const char*>( &id ), sizeof( id ) );
+            }
+        }
+
+        auto buffer_view = json_object_new_object();
+        json_object_object_add( buffer_view, "buffer", json_object_new_int( 0 ) );
+        json_object_object_add( buffer_view, "byteOffset", json_object_new_int64( int64_t( view_offset ) ) );
+        json_object_object_add( buffer_view, "byteLength", json_object_new_int64( int64_t( bin.size() - view_offset ) ) );
+        json_object_object_add( buffer_view, "target", json_object_new_int( 34962 ) ); // ARRAY_BUFFER
+        json_object_array_add( views, buffer_view );
+
+        // the BIN chunk is padded to 4 bytes, the JSON chunk so that the glb ends on 8 (b3dm)
+        bin.resize( ( bin.size() + 3 ) & ~size_t( 3 ), '\0' );
+        if ( json_object_array_length( buffers ) == 0 )
+            json_object_array_add( buffers, json_object_new_object() );
+        json_object_object_add( json_object_array_get_idx( buffers, 0 ), "byteLength", json_object_new_int64( int64_t( bin.size() ) ) );
+        std::string json = json_object_to_json_string_ext( root.get(), JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE );
+        json.resize( ( json.size() + 3 ) & ~size_t( 3 ), ' ' );
+        if ( ( 12 + 8 + json.size() + 8 + bin.size() ) % 8 )
+            json.append( 4, ' ' );
+
+        glb.clear();
+        glb.reserve( 12 + 8 + json.size() + 8 + bin.size() );
+        append_u32( glb, GLB_MAGIC );
+        append_u32( glb, 2 );
+        append_u32( glb, uint32_t( 12 + 8 + json.size() + 8 + bin.size() ) );
+        append_u32( glb, uint32_t( json.size() ) );
+        append_u32( glb, CHUNK_JSON );
+        glb += json;
+        append_u32( glb, uint32_t( bin.size() ) );
+        append_u32( glb, CHUNK_BIN );
+        glb += bin;
+    }
+
+    /// @brief Wrap a glb into a b3dm
+    /// @param batch_length BATCH_LENGTH, the size of each batch table property
+    static std::string make_b3dm( std::string_view glb, uint32_t batch_length, batch_t const& batch = batch_t() )
+    {
+        std::string feature_table = "{\"BATCH_LENGTH\":" + std::to_string( batch_length ) + "}";
+        pad( feature_table, HEADER_SIZE, ' ' );
+
+        std::string batch_table;
+        std::string batch_binary;
+        write_batch_table( batch, batch_length, HEADER_SIZE + feature_table.size(), batch_table, batch_binary );
+
+        std::string r;
+        size_t length = HEADER_SIZE + feature_table.size() + batch_table.size() + batch_binary.size() + glb.size();
+        length += ( 8 - length % 8 ) % 8;
+        r.reserve( length );
+        r.append( "b3dm" );
+        append_u32( r, 1 );
+        append_u32( r, uint32_t( length ) );
+        append_u32( r, uint32_t( feature_table.size() ) );
+        append_u32( r, 0 );
+        append_u32( r, uint32_t( batch_table.size() ) );
+        append_u32( r, uint32_t( batch_binary.size() ) );
+        r += feature_table;
+        r += batch_table;
+        r += batch_binary;
+        r.append( glb.data(), glb.size() );
+        r.resize( length, '\0' );
+        return r;
+    }
+
+    /// @brief Wrap a glb and the instances into an i3dm
+    static std::string make_i3dm( std::string_view glb, TileInstances const& instances, batch_t const& batch = batch_t() )
+    {
+        std::string feature_table;
+        std::string feature_binary;
+        instances.write_feature_table( feature_table, feature_binary, I3DM_HEADER_SIZE );
+
+        std::string batch_table;
+        std::string batch_binary;
+        write_batch_table( batch, instances.batch_length(), I3DM_HEADER_SIZE + feature_table.size() + feature_binary.size(),
+                           batch_table, batch_binary );
+
+        std::string r;
+        size_t length = I3DM_HEADER_SIZE + feature_table.size() + feature_binary.size() + batch_table.size()
+            + batch_binary.size() + glb.size();
+        length += ( 8 - length % 8 ) % 8;
+        r.reserve( length );
+        r.append( "i3dm" );
+        append_u32( r, 1 );
+        append_u32( r, uint32_t( length ) );
+        append_u32( r, uint32_t( feature_table.size() ) );
+        append_u32( r, uint32_t( feature_binary.size() ) );
+        append_u32( r, uint32_t( batch_table.size() ) );
+        append_u32( r, uint32_t( batch_binary.size() ) );
+        append_u32( r, 1 ); // gltfFormat: embedded glb
+        r += feature_table;
+        r += feature_binary;
+        r += batch_table;
+        r += batch_binary;
+        r.append( glb.data(), glb.size() );
+        r.resize( length, '\0' );
+        return r;
+    }
+
+    /// @brief Axis aligned bounding box of the scene in the tile frame
+    /// @param y_up the scene is Y-up glTF, the box is rotated to Z-up
+    static TileTree::box_t scene_box( aiScene const* scene, bool y_up )
+    {
+        double lo[3], hi[3];
+        scene_bounds( scene, y_up, lo, hi );
+        return aabb( lo, hi );
+    }
+
+    static void scene_bounds( aiScene const* scene, bool y_up, double* lo, double* hi )
+    {
+        std::fill( lo, lo + 3, std::numeric_limits<double>::max() );
+        std::fill( hi, hi + 3, -std::numeric_limits<double>::max() );
+        std::vector<std::pair<aiNode const*, aiMatrix4x4>> stack;
+        if ( scene->mRootNode )
+            stack.emplace_back( scene->mRootNode, scene->mRootNode->mTransformation );
+        while ( !stack.empty() )
+        {
+            auto [node, m] = stack.back();
+            stack.pop_back();
+            for ( unsigned k = 0; k != node->mNumMeshes; ++k )
+            {
+                aiMesh const* mesh = scene->mMeshes[node->mMeshes[k]];
+                for ( unsigned v = 0; v != mesh->mNumVertices; ++v )
+                {
+                    aiVector3D p = m * mesh->mVertices[v];
+                    double q[3] = { p.x, p.y, p.z };
+                    if ( y_up )
+                    {
+                        q[1] = -p.z;
+                        q[2] = p.y;
+                    }
+                    for ( int a = 0; a != 3; ++a )
+                    {
+                        lo[a] = std::min( lo[a], q[a] );
+                        hi[a] = std::max( hi[a], q[a] );
+                    }
+                }
+            }
+            for ( unsigned c = 0; c != node->mNumChildren; ++c )
+                stack.emplace_back( node->mChildren[c], m * node->mChildren[c]->mTransformation );
+        }
+        if ( lo[0] > hi[0] )
+        {
+            std::fill( lo, lo + 3, 0.0 );
+            std::fill( hi, hi + 3, 0.0 );
+        }
+    }
+#pragma endregion
+
+protected:
+    enum : uint32_t
+    {
+        GLB_MAGIC = 0x46546C67,  // "glTF"
+        CHUNK_JSON = 0x4E4F534A, // "JSON"
+        CHUNK_BIN = 0x004E4942,  // "BIN\0"
+        HEADER_SIZE = 28,
+        I3DM_HEADER_SIZE = 32
+    };
+
+    struct job_t
+    {
+        index_t tile;
+        std::filesystem::path filename;
+        scene_ptr scene;
+        std::unique_ptr<TileInstances> instances;   // i3dm
+        batch_t batch;
+        bool need_volume;
+    };
+
+    index_t add_content( index_t parent, double geometricError, scene_ptr scene,
+                         std::unique_ptr<TileInstances> instances, batch_t batch, TileTree::volume_t const& volume )
+    {
+        if ( !scene )
+            throw std::runtime_error( "no scene" );
+        index_t i = add_tile( parent, geometricError, volume );
+        std::string name = std::to_string( i ) + ( instances ? ".i3dm" : ".b3dm" );
+        std::string uri = m_options.content_dir.empty() ? name : m_options.content_dir + "/" + name;
+        m_tree.set_uri( i, uri );
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+        if ( m_closed )
+            throw std::runtime_error( "the export is finished" );
+        m_space.wait( lock, [&]() { return m_queue.size() < m_options.max_pending || !m_error.empty(); } );
+        if ( !m_error.empty() )
+            throw std::runtime_error( m_error );
+        m_queue.push_back( job_t{ i, m_dir / std::filesystem::u8path( uri ), std::move( scene ), std::move( instances ),
+                                  std::move( batch ), volume.index() == 0 } );
+        lock.unlock();
+        m_ready.notify_one();
+        return i;
+    }
+
+    void worker()
+    {
+        for ( ;; )
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_ready.wait( lock, [&]() { return !m_queue.empty() || m_closed; } );
+            if ( m_queue.empty() )
+                return;
+            job_t job = std::move( m_queue.front() );
+            m_queue.pop_front();
+            bool failed = !m_error.empty();
+            lock.unlock();
+            m_space.notify_one();
+            if ( failed )
+                continue;
+
+            try
+            {
+                TileTree::box_t box = job.need_volume ? content_box( job ) : TileTree::box_t();
+                if ( job.instances )
+                    write_i3dm( job );
+                else
+                    write_b3dm( job );
+                job.scene.reset();
+
+                lock.lock();
+                if ( job.need_volume )
+                    m_boxes.emplace( job.tile, box );
+                else
+                    ++m_written_with_volume;
+            }
+            catch ( std::exception& e )
+            {
+                lock.lock();
+                if ( m_error.empty() )
+                    m_error = job.filename.u8string() + ": " + e.what();
+                lock.unlock();
+                m_space.notify_all();
+            }
+        }
+    }
+
+    void write_b3dm( job_t& job ) const
+    {
+        aiScene* scene = job.scene.get();
+        std::vector<uint32_t> ids = job.batch.mesh_batch_ids;
+        if ( ids.empty() )
+            for ( unsigned m = 0; m != scene->mNumMeshes; ++m )
+                ids.push_back( m );
+        else if ( ids.size() != scene->mNumMeshes )
+            throw std::runtime_error( "mesh_batch_ids: " + std::to_string( ids.size() ) + " ids, "
+                                      + std::to_string( scene->mNumMeshes ) + " meshes" );
+
+        reorder( scene );
+        std::string glb = encode_glb( scene, m_options.export_flags );
+        add_batch_ids( glb, ids );
+        std::string b3dm = make_b3dm( glb, job.batch.length( scene->mNumMeshes ), job.batch );
+
+        write_file( job.filename, b3dm );
+    }
+
+    void write_i3dm( job_t& job ) const
+    {
+        reorder( job.scene.get() );
+        std::string glb = encode_glb( job.scene.get(), m_options.export_flags );
+        write_file( job.filename, make_i3dm( glb, *job.instances, job.batch ) );
+    }
+
+    /// @brief The meshes in the vertex cache order (the tiles already run in parallel)
+    void reorder( aiScene* scene ) const
+    {
+        if ( !m_options.reorder )
+            return;
+        meshtoolbox::reorder_options_t options;
+        options.threads = 1;
+        meshtoolbox::reorder_scene( scene, options );
+    }
+
+    static void write_file( std::filesystem::path const& filename, std::string const& bytes )
+    {
+        std::ofstream os( filename, std::ios::binary );
+        if ( !os.write( bytes.data(), std::streamsize( bytes.size() ) ) )
+            throw std::runtime_error( "cannot write" );
+    }
+
+    TileTree::box_t content_box( job_t const& job ) const
+    {
+        double lo[3], hi[3];
+        scene_bounds( job.scene.get(), m_options.y_up, lo, hi );
+        if ( !job.instances )
+            return aabb( lo, hi );
+        double placed_lo[3], placed_hi[3];
+        job.instances->bounds( lo, hi, placed_lo, placed_hi );
+        return aabb( placed_lo, placed_hi );
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_closed = true;
+        }
+        m_ready.notify_all();
+        for ( auto& t : m_pool )
+            t.join();
+        m_pool.clear();
+    }
+
+    /// @brief The volumes of the tiles added without one: the union of the children
+    void derive_volumes()
+    {
+        std::vector<std::pair<bool, std::array<double, 6>>> bounds( m_tree.size() );
+        for ( index_t i = index_t( m_tree.size() ); i-- > 0; )
+        {
+            auto& t = m_tree[i];
+            if ( m_derived[i] && t.boundingVolume.index() == 0 )
+            {
+                if ( !bounds[i].first )
+                    throw std::runtime_error( m_tree.json_pointer( i ) + ": no bounding volume" );
+                t.boundingVolume = aabb( bounds[i].second.data(), bounds[i].second.data() + 3 );
+            }
+            if ( t.parent == npos || !m_derived[t.parent] )
+                continue;
+
+            double lo[3], hi[3];
+            child_bounds( i, lo, hi );
+            auto& b = bounds[t.parent];
+            for ( int a = 0; a != 3; ++a )
+            {
+                b.second[a] = b.first ? std::min( b.second[a], lo[a] ) : lo[a];
+                b.second[3 + a] = b.first ? std::max( b.second[3 + a], hi[a] ) : hi[a];
+            }
+            b.first = true;
+        }
+    }
+
+    /// @brief The axis aligned bounds of a tile volume in the parent frame
+    void child_bounds( index_t i, double* lo, double* hi ) const
+    {
+        double corners[8][3];
+        if ( auto box = std::get_if<TileTree::box_t>( &m_tree[i].boundingVolume ) )
+        {
+            double const* b = box->box;
+            for ( int k = 0; k != 8; ++k )
+                for ( int a = 0; a != 3; ++a )
+                    corners[k][a] = b[a] + ( k & 1 ? b[3 + a] : -b[3 + a] ) + ( k & 2 ? b[6 + a] : -b[6 + a] )
+                        + ( k & 4 ? b[9 + a] : -b[9 + a] );
+        }
+        else if ( auto sphere = std::get_if<TileTree::sphere_t>( &m_tree[i].boundingVolume ) )
+        {
+            double const* s = sphere->sphere;
+            for ( int k = 0; k != 8; ++k )
+                for ( int a = 0; a != 3; ++a )
+                    corners[k][a] = s[a] + ( k & ( 1 << a ) ? s[3] : -s[3] );
+        }
+        else
+        {
+            throw std::runtime_error( m_tree.json_pointer( m_tree[i].parent ) + ": the parent of a region needs a bounding volume" );
+        }
+
+        std::fill( lo, lo + 3, std::numeric_limits<double>::max() );
+        std::fill( hi, hi + 3, -std::numeric_limits<double>::max() );
+        auto tr = m_tree.transform( i );
+        for ( auto const& c : corners )
+        {
+            double p[3] = { c[0], c[1], c[2] };
+            if ( tr )
+            {
+                double const* m = tr->matrix4x4; // column-major
+                for ( int a = 0; a != 3; ++a )
+                    p[a] = m[a] * c[0] + m[4 + a] * c[1] + m[8 + a] * c[2] + m[12 + a];
+            }
+            for ( int a = 0; a != 3; ++a )
+            {
+                lo[a] = std::min( lo[a], p[a] );
+                hi[a] = std::max( hi[a], p[a] );
+            }
+        }
+    }
+
+    static TileTree::box_t aabb( double const* lo, double const* hi )
+    {
+        TileTree::box_t r{};
+        for ( int a = 0; a != 3; ++a )
+        {
+            r.box[a] = ( lo[a] + hi[a] ) / 2;
+            r.box[3 + 4 * a] = ( hi[a] - lo[a] ) / 2;
+        }
+        return r;
+    }
+
+    /// @brief Give each extra mesh of a node its own child node
+    static void split_meshes( aiNode* node )
+    {
+        if ( !node )
+            return;
+        for ( unsigned c = 0; c != node->mNumChildren; ++c )
+            split_meshes( node->mChildren[c] );
+        if ( node->mNumMeshes < 2 )
+            return;
+
+        unsigned extra = node->mNumMeshes - 1;
+        aiNode** children = new aiNode*[node->mNumChildren + extra];
+        std::copy( node->mChildren, node->mChildren + node->mNumChildren, children );
+        for ( unsigned k = 0; k != extra; ++k )
+        {
+            aiNode* child = new aiNode( std::string( node->mName.C_Str() ) + "_" + std::to_string( k + 1 ) );
+            child->mParent = node;
+            child->mNumMeshes = 1;
+            child->mMeshes = new unsigned[1]{ node->mMeshes[k + 1] };
+            children[node->mNumChildren + k] = child;
+        }
+        delete[] node->mChildren;
+        node->mChildren = children;
+        node->mNumChildren += extra;
+        node->mNumMeshes = 1;
+    }
+
+    /// @brief Encode the batch table (JSON padded to 8 from offset)
+    static void write_batch_table( batch_t const& batch, uint32_t batch_length, size_t offset, std::string& batch_table,
+                                   std::string& batch_binary )
+    {
+        if ( !batch.strings.empty() || !batch.numbers.empty() )
+        {
+            JsonWriter w( batch_table );
+            w.begin_object();
+            for ( auto const& p : batch.strings )
+            {
+                check_length( p.first, p.second.size(), batch_length );
+                w.key( p.first );
+                w.begin_array();
+                for ( auto const& s : p.second )
+                    w.value( s );
+                w.end_array();
+            }
+            for ( auto const& p : batch.numbers )
+            {
+                check_length( p.first, p.second.size(), batch_length );
+                w.key( p.first );
+                w.begin_object();
+                w.key( "byteOffset" );
+                w.value( double( batch_binary.size() ) );
+                w.key( "componentType" );
+                w.value( "DOUBLE" );
+                w.key( "type" );
+                w.value( "SCALAR" );
+                w.end_object();
+                batch_binary.append( reinterpret_cast<const char*>( p.second.data() ), p.second.size() * sizeof( double ) );
+            }
+            w.end_object();
+        }
+        pad( batch_table, offset, ' ' );
+    }
+
+    static json_object* member_array( json_object* o, const char* key )
+    {
+        json_object* r = nullptr;
+        if ( !json_object_object_get_ex( o, key, &r ) || json_object_get_type( r ) != json_type_array )
+        {
+            r = json_object_new_array();
+            json_object_object_add( o, key, r );
+        }
+        return r;
+    }
+
+    static void check_length( std::string const& name, size_t n, uint32_t batch_length )
+    {
+        if ( n != batch_length )
+            throw std::runtime_error( "batch table property " + name + ": " + std::to_string( n ) + " values, BATCH_LENGTH "
+                                      + std::to_string( batch_length ) );
+    }
+
+    /// @brief Pad s so that offset + s.size() is a multiple of 8
+    static void pad( std::string& s, size_t offset, char c ) { s.append( ( 8 - ( offset + s.size() ) % 8 ) % 8, c ); }
+
+    static void append_u32( std::string& s, uint32_t v ) { s.append( reinterpret_cast<const char*>( &v ), sizeof( v ) ); }
+
+    std::filesystem::path m_dir;
+    options_t m_options;
+    TileTree m_tree;
+    std::vector<bool> m_derived;    // added without a bounding volume
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_space;
+    std::deque<job_t> m_queue;
+    bool m_closed = false;
+    std::string m_error;
+    std::unordered_map<index_t, TileTree::box_t> m_boxes;
+    size_t m_written_with_volume = 0;
+    std::vector<std::thread> m_pool;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETEXPORTER_H
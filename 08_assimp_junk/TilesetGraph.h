@@ -0,0 +1,414 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETGRAPH_H
+#define TILESETGRAPH_H
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "TilesetReader.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Thread-safe LRU cache of loaded tilesets
+///
+/// The size is bounded by TileTree::memory_usage() of the cached trees.
+/// A tree evicted from the cache stays alive while somebody holds it.
+/// Concurrent requests for the same file load it once.
+class TilesetCache
+{
+public:
+    typedef std::shared_ptr<const TileTree> tree_ptr;
+    typedef std::function<TileTree( std::filesystem::path const& )> loader_t;
+
+    struct stats_t
+    {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t bytes;   // memory used by the cached trees
+        size_t entries;
+    };
+
+    /// @param capacity the memory limit in bytes
+    explicit TilesetCache( size_t capacity, loader_t loader = &TilesetCache::default_loader )
+        : m_capacity( capacity )
+        , m_loader( std::move( loader ) )
+    {
+    }
+
+    ~TilesetCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+            m_prefetch_queue.clear();
+        }
+        m_prefetch_cv.notify_all();
+        if ( m_prefetch_thread.joinable() )
+            m_prefetch_thread.join();
+    }
+
+    TilesetCache( TilesetCache const& ) = delete;
+    TilesetCache& operator=( TilesetCache const& ) = delete;
+
+    static TileTree default_loader( std::filesystem::path const& path )
+    {
+        return TilesetReader::load( path.string() );
+    }
+
+    /// @brief Get the tileset, load it on the first request
+    tree_ptr get( std::filesystem::path const& path )
+    {
+        std::string key = make_key( path );
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        auto pos = m_entries.find( key );
+        if ( pos != m_entries.end() )
+        {
+            ++m_stats.hits;
+            m_lru.splice( m_lru.begin(), m_lru, pos->second.lru );
+            auto f = pos->second.tree;
+            lock.unlock();
+            return f.get();
+        }
+
+        ++m_stats.misses;
+        std::promise<tree_ptr> promise;
+        m_lru.push_front( key );
+        m_entries.emplace( key, entry_t{ promise.get_future().share(), 0, m_lru.begin() } );
+        lock.unlock();
+
+        tree_ptr tree;
+        try
+        {
+            tree = std::make_shared<const TileTree>( m_loader( path ) );
+        }
+        catch ( ... )
+        {
+            promise.set_exception( std::current_exception() );
+            lock.lock();
+            remove( key );
+            throw;
+        }
+        promise.set_value( tree );
+
+        lock.lock();
+        pos = m_entries.find( key );
+        if ( pos != m_entries.end() )
+        {
+            pos->second.bytes = tree->memory_usage();
+            m_stats.bytes += pos->second.bytes;
+        }
+        evict();
+        return tree;
+    }
+
+    /// @brief Load the tileset in the background (if not cached yet)
+    void prefetch( std::filesystem::path const& path )
+    {
+        std::string key = make_key( path );
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( m_stop || m_entries.count( key ) )
+                return;
+            m_prefetch_queue.push_back( path );
+            if ( !m_prefetch_thread.joinable() )
+                m_prefetch_thread = std::thread( &TilesetCache::prefetch_worker, this );
+        }
+        m_prefetch_cv.notify_one();
+    }
+
+    /// @brief Wait until the prefetch queue is empty
+    void wait_prefetch()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_idle_cv.wait( lock, [this] { return m_prefetch_queue.empty() && !m_prefetch_busy; } );
+    }
+
+    bool contains( std::filesystem::path const& path ) const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_entries.count( make_key( path ) ) != 0;
+    }
+
+    stats_t stats() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        stats_t r = m_stats;
+        r.entries = m_entries.size();
+        return r;
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+protected:
+    struct entry_t
+    {
+        std::shared_future<tree_ptr> tree;
+        size_t bytes;   // 0 while loading
+        std::list<std::string>::iterator lru;
+    };
+
+    static std::string make_key( std::filesystem::path const& path )
+    {
+        return std::filesystem::absolute( path ).lexically_normal().string();
+    }
+
+    void remove( std::string const& key )
+    {
+        auto pos = m_entries.find( key );
+        if ( pos == m_entries.end() )
+            return;
+        m_stats.bytes -= pos->second.bytes;
+        m_lru.erase( pos->second.lru );
+        m_entries.erase( pos );
+    }
+
+    /// @brief Drop the least recently used trees (the lock is held)
+    void evict()
+    {
+        auto it = m_lru.end();
+        while ( m_stats.bytes > m_capacity && it != m_lru.begin() )
+        {
+            --it;
+            auto pos = m_entries.find( *it );
+            if ( pos->second.bytes == 0 )
+                continue; // still loading
+            auto key = *it++;
+            remove( key );
+            ++m_stats.evictions;
+        }
+    }
+
+    void prefetch_worker()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for ( ;; )
+        {
+            m_prefetch_cv.wait( lock, [this] { return m_stop || !m_prefetch_queue.empty(); } );
+            if ( m_stop )
+                break;
+            auto path = std::move( m_prefetch_queue.front() );
+            m_prefetch_queue.pop_front();
+            m_prefetch_busy = true;
+            lock.unlock();
+            try
+            {
+                get( path );
+            }
+            catch ( std::exception const& )
+            {
+                // reported again to the one who really needs the tileset
+            }
+            lock.lock();
+            m_prefetch_busy = false;
+            if ( m_prefetch_queue.empty() )
+                m_idle_cv.notify_all();
+        }
+        m_idle_cv.notify_all();
+    }
+
+    size_t m_capacity;
+    loader_t m_loader;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, entry_t> m_entries;
+    std::list<std::string> m_lru; // most recently used first
+    stats_t m_stats{};
+
+    std::thread m_prefetch_thread;
+    std::condition_variable m_prefetch_cv;
+    std::condition_variable m_idle_cv;
+    std::deque<std::filesystem::path> m_prefetch_queue;
+    bool m_prefetch_busy = false;
+    bool m_stop = false;
+};
+
+/// @brief Tileset with lazily resolved external tilesets
+///
+/// A tile whose content.uri refers to a .json file is a link: the root of
+/// the external tileset is the only child of that tile. External tilesets
+/// are loaded through the (shareable) cache when they are reached for the
+/// first time.
+class TilesetGraph
+{
+public:
+    /// @brief A tile in one of the loaded tilesets
+    struct node_t
+    {
+        TilesetCache::tree_ptr tree;
+        TileTree::index_t tile = TileTree::npos;
+        std::filesystem::path base; // the directory of the tileset file
+
+        bool valid() const { return tree && tile != TileTree::npos; }
+        TileTree::tile_t const& operator*() const { return ( *tree )[tile]; }
+        TileTree::tile_t const* operator->() const { return &( *tree )[tile]; }
+        std::string_view uri() const { return tree->uri( tile ); }
+    };
+
+    TilesetGraph( std::filesystem::path const& tileset, std::shared_ptr<TilesetCache> cache )
+        : m_tileset( tileset )
+        , m_cache( std::move( cache ) )
+    {
+    }
+
+    /// @brief Enable loading external siblings in the background
+    void set_prefetch( bool on ) { m_prefetch = on; }
+
+    TilesetCache& cache() { return *m_cache; }
+
+    node_t root() const
+    {
+        node_t r;
+        r.tree = m_cache->get( m_tileset );
+        r.tile = r.tree->root();
+        r.base = m_tileset.parent_path();
+        return r;
+    }
+
+    static bool is_external( std::string_view uri )
+    {
+        auto q = uri.find_first_of( "?#" );
+        if ( q != std::string_view::npos )
+            uri = uri.substr( 0, q );
+        if ( uri.size() < 5 )
+            return false;
+        auto ext = uri.substr( uri.size() - 5 );
+        return ( ext[0] == '.' ) && ( ext[1] | 0x20 ) == 'j' && ( ext[2] | 0x20 ) == 's' && ( ext[3] | 0x20 ) == 'o'
+            && ( ext[4] | 0x20 ) == 'n';
+    }
+
+    bool is_external( node_t const& n ) const { return is_external( n.uri() ); }
+
+    /// @brief The file referenced by the tile content
+    static std::filesystem::path content_path( node_t const& n )
+    {
+        std::string_view uri = n.uri();
+        auto q = uri.find_first_of( "?#" );
+        if ( q != std::string_view::npos )
+            uri = uri.substr( 0, q );
+        return ( n.base / std::filesystem::u8path( uri ) ).lexically_normal();
+    }
+
+    /// @brief Visit the children of the tile
+    ///
+    /// For a link tile the child is the root of the external tileset, which
+    /// is loaded here if needed.
+    template <typename F>
+    void for_each_child( node_t const& n, F&& f ) const
+    {
+        if ( is_external( n ) )
+        {
+            f( resolve( n ) );
+            return;
+        }
+        if ( m_prefetch )
+        {
+            n.tree->for_each_child( n.tile, [&]( TileTree::index_t c ) {
+                node_t ch{ n.tree, c, n.base };
+                if ( is_external( ch ) )
+                    m_cache->prefetch( content_path( ch ) );
+            } );
+        }
+        n.tree->for_each_child( n.tile, [&]( TileTree::index_t c ) { f( node_t{ n.tree, c, n.base } ); } );
+    }
+
+    /// @brief The root of the external tileset referenced by the tile
+    node_t resolve( node_t const& n ) const
+    {
+        auto path = content_path( n );
+        node_t r;
+        r.tree = m_cache->get( path );
+        r.tile = r.tree->root();
+        r.base = path.parent_path();
+        return r;
+    }
+
+    /// @brief Depth-first traversal across the tileset boundaries
+    /// @param f called as f(node, depth), returns false to skip the children
+    ///
+    /// A link to a tileset that is already open on the current path (a
+    /// tileset referencing itself or one of its ancestors) is visited, but
+    /// not descended into. Reaching the same tileset along separate paths is
+    /// not a cycle.
+    template <typename F>
+    void traverse( F&& f ) const
+    {
+        struct open_t // the tilesets from the root down to the node
+        {
+            std::filesystem::path path;
+            std::shared_ptr<const open_t> up;
+        };
+        typedef std::shared_ptr<const open_t> open_ptr;
+        auto is_open = []( open_t const* o, std::filesystem::path const& path ) {
+            for ( ; o; o = o->up.get() )
+                if ( o->path == path )
+                    return true;
+            return false;
+        };
+
+        struct item_t
+        {
+            node_t node;
+            unsigned depth;
+            open_ptr open;
+        };
+        std::vector<item_t> stack{ { root(), 0, std::make_shared<open_t>( open_t{ canonical( m_tileset ), {} } ) } };
+        std::vector<node_t> kids;
+        while ( !stack.empty() )
+        {
+            auto [n, d, open] = std::move( stack.back() );
+            stack.pop_back();
+            if ( !f( n, d ) )
+                continue;
+            if ( is_external( n ) )
+            {
+                auto path = canonical( content_path( n ) );
+                if ( is_open( open.get(), path ) )
+                    continue;
+                stack.push_back( { resolve( n ), d + 1, std::make_shared<open_t>( open_t{ std::move( path ), open } ) } );
+                continue;
+            }
+            kids.clear();
+            for_each_child( n, [&]( node_t ch ) { kids.push_back( std::move( ch ) ); } );
+            for ( auto it = kids.rbegin(); it != kids.rend(); ++it )
+                stack.push_back( { std::move( *it ), d + 1, open } );
+        }
+    }
+
+protected:
+    /// @brief The path with symbolic links resolved, as far as it exists
+    static std::filesystem::path canonical( std::filesystem::path const& p )
+    {
+        std::error_code ec;
+        auto c = std::filesystem::weakly_canonical( p, ec );
+        return ec ? p.lexically_normal() : c;
+    }
+
+    std::filesystem::path m_tileset;
+    std::shared_ptr<TilesetCache> m_cache;
+    bool m_prefetch = false;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETGRAPH_H
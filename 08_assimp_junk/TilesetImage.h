@@ -0,0 +1,335 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETIMAGE_H
+#define TILESETIMAGE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Binary image of a tileset, stored next to tileset.json
+///
+/// The file is a header followed by fixed size tile records, transforms
+/// and the content URIs. It is used in place (memory mapped), without any
+/// parsing. The image is valid for a JSON file with the recorded size and
+/// modification time, or with the recorded hash if the time differs
+/// (e.g. the file was copied).
+class TilesetImage
+{
+public:
+    enum : uint32_t
+    {
+        FORMAT_VERSION = 1,
+        BYTE_ORDER_MARK = 0x01020304,
+        NONE = ~uint32_t( 0 )   // no transform, no uri, no tile
+    };
+
+    enum volume_kind_t : uint8_t
+    {
+        VOLUME_NONE,
+        VOLUME_BOX,     // 12 numbers
+        VOLUME_REGION,  // 6 numbers
+        VOLUME_SPHERE   // 4 numbers
+    };
+
+    /// @brief The same values as TileTree::refine_t
+    enum refine_t : uint8_t
+    {
+        REFINE_UNDEFINED,
+        REFINE_ADD,
+        REFINE_REPLACE
+    };
+
+    enum flags_t : uint32_t
+    {
+        HAS_GEOREFERENCED = 1,
+        GEOREFERENCED = 2
+    };
+
+    struct header_t
+    {
+        char magic[8];          // "3DTIDX\0\0"
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t file_size;
+
+        // the source tileset.json
+        uint64_t json_size;
+        int64_t json_mtime;
+        uint64_t json_hash;
+
+        uint32_t tile_count;
+        uint32_t transform_count;
+        uint32_t string_count;
+        uint32_t flags;         // flags_t
+        uint64_t tiles_offset;
+        uint64_t transforms_offset;
+        uint64_t strings_offset; // string_count + 1 offsets into the characters
+        uint64_t chars_offset;
+
+        double geometric_error;
+        uint32_t asset_version;  // string id
+        uint32_t reserved;
+    };
+
+    struct tile_t
+    {
+        double geometric_error;
+        double volume[12];
+        uint32_t transform;     // index or NONE
+        uint32_t uri;           // string id or NONE
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t last_child;
+        uint32_t next_sibling;
+        uint8_t volume_kind;    // volume_kind_t
+        uint8_t refine;         // TileTree::refine_t
+        uint8_t reserved[6];
+    };
+
+    static_assert( sizeof( header_t ) == 112, "header_t layout" );
+    static_assert( sizeof( tile_t ) == 136, "tile_t layout" );
+
+    /// @brief The image file of a tileset.json
+    static std::filesystem::path sidecar_path( std::filesystem::path const& json )
+    {
+        auto r = json;
+        r += ".tidx";
+        return r;
+    }
+
+    /// @brief Open and validate the image of the tileset.json
+    /// @param verify_hash check the hash even if the size and time match
+    /// @return nullptr if there is no valid image
+    static std::unique_ptr<TilesetImage> open( std::filesystem::path const& json, bool verify_hash = false )
+    {
+        std::unique_ptr<TilesetImage> r( new TilesetImage );
+        if ( !r->m_file.open( sidecar_path( json ) ) || !r->check_layout() )
+            return nullptr;
+
+        std::error_code ec;
+        auto size = std::filesystem::file_size( json, ec );
+        if ( ec || size != r->header().json_size )
+            return nullptr;
+        auto mtime = std::filesystem::last_write_time( json, ec );
+        if ( ec )
+            return nullptr;
+        bool same_time = int64_t( mtime.time_since_epoch().count() ) == r->header().json_mtime;
+        if ( ( !same_time || verify_hash ) && hash_file( json ) != r->header().json_hash )
+            return nullptr;
+        return r;
+    }
+
+    header_t const& header() const { return *reinterpret_cast<header_t const*>( m_file.data() ); }
+
+    size_t size() const { return header().tile_count; }
+
+    tile_t const& tile( uint32_t i ) const { return tiles()[i]; }
+
+    tile_t const* tiles() const
+    {
+        return reinterpret_cast<tile_t const*>( m_file.data() + header().tiles_offset );
+    }
+
+    /// @brief 16 numbers, column major
+    double const* transform( uint32_t i ) const
+    {
+        return reinterpret_cast<double const*>( m_file.data() + header().transforms_offset ) + i * 16;
+    }
+
+    std::string_view str( uint32_t id ) const
+    {
+        if ( id == NONE )
+            return {};
+        auto offsets = reinterpret_cast<uint64_t const*>( m_file.data() + header().strings_offset );
+        const char* chars = m_file.data() + header().chars_offset;
+        return std::string_view( chars + offsets[id], size_t( offsets[id + 1] - offsets[id] ) );
+    }
+
+    /// @brief 64-bit FNV-1a of the file content
+    static uint64_t hash_file( std::filesystem::path const& path )
+    {
+        uint64_t h = 14695981039346656037ull;
+        std::unique_ptr<std::FILE, int ( * )( std::FILE* )> f( std::fopen( path.string().c_str(), "rb" ), &std::fclose );
+        if ( !f )
+            return 0;
+        std::vector<unsigned char> buf( 64 * 1024 );
+        size_t n;
+        while ( ( n = std::fread( buf.data(), 1, buf.size(), f.get() ) ) != 0 )
+            for ( size_t i = 0; i != n; ++i )
+                h = ( h ^ buf[i] ) * 1099511628211ull;
+        return h;
+    }
+
+    /// @brief Writes an image file
+    ///
+    /// Fill the header fields describing the tileset (geometric_error,
+    /// flags, asset_version), the tiles, the transforms and the strings,
+    /// then call write().
+    struct writer_t
+    {
+        header_t header{};
+        std::vector<tile_t> tiles;
+        std::vector<double> transforms; // 16 per transform
+        std::vector<std::string_view> strings;
+
+        /// @brief Write the image of the tileset.json
+        bool write( std::filesystem::path const& json )
+        {
+            std::error_code ec;
+            auto size = std::filesystem::file_size( json, ec );
+            if ( ec )
+                return false;
+            auto mtime = std::filesystem::last_write_time( json, ec );
+            if ( ec )
+                return false;
+
+            std::memcpy( header.magic, "3DTIDX\0\0", 8 );
+            header.version = FORMAT_VERSION;
+            header.byte_order = BYTE_ORDER_MARK;
+            header.json_size = size;
+            header.json_mtime = int64_t( mtime.time_since_epoch().count() );
+            header.json_hash = hash_file( json );
+            header.tile_count = uint32_t( tiles.size() );
+            header.transform_count = uint32_t( transforms.size() / 16 );
+            header.string_count = uint32_t( strings.size() );
+
+            std::vector<uint64_t> offsets{ 0 };
+            for ( auto s : strings )
+                offsets.push_back( offsets.back() + s.size() );
+
+            uint64_t pos = sizeof( header_t );
+            header.tiles_offset = pos;
+            pos += tiles.size() * sizeof( tile_t );
+            header.transforms_offset = pos;
+            pos += transforms.size() * sizeof( double );
+            header.strings_offset = pos;
+            pos += offsets.size() * sizeof( uint64_t );
+            header.chars_offset = pos;
+            pos += offsets.back();
+            header.file_size = pos;
+
+            // write to a temporary file first, a reader never sees a partial image
+            auto path = sidecar_path( json );
+            auto tmp = path;
+            tmp += ".tmp";
+            {
+                std::unique_ptr<std::FILE, int ( * )( std::FILE* )> f( std::fopen( tmp.string().c_str(), "wb" ),
+                                                                      &std::fclose );
+                if ( !f )
+                    return false;
+                bool ok = std::fwrite( &header, sizeof( header ), 1, f.get() ) == 1;
+                ok = ok && ( tiles.empty() || std::fwrite( tiles.data(), sizeof( tile_t ), tiles.size(), f.get() ) == tiles.size() );
+                ok = ok && ( transforms.empty() || std::fwrite( transforms.data(), sizeof( double ), transforms.size(), f.get() ) == transforms.size() );
+                ok = ok && std::fwrite( offsets.data(), sizeof( uint64_t ), offsets.size(), f.get() ) == offsets.size();
+                for ( auto s : strings )
+                    ok = ok && ( s.empty() || std::fwrite( s.data(), 1, s.size(), f.get() ) == s.size() );
+                if ( std::fclose( f.release() ) != 0 || !ok )
+                {
+                    std::filesystem::remove( tmp, ec );
+                    return false;
+                }
+            }
+            std::filesystem::rename( tmp, path, ec );
+            if ( ec )
+            {
+                std::filesystem::remove( tmp, ec );
+                return false;
+            }
+            return true;
+        }
+    };
+
+protected:
+    TilesetImage() {}
+
+    /// @brief The offsets, counts and links are consistent
+    bool check_layout() const
+    {
+        if ( m_file.size() < sizeof( header_t ) )
+            return false;
+        auto const& h = header();
+        if ( std::memcmp( h.magic, "3DTIDX\0\0", 8 ) != 0 || h.version != FORMAT_VERSION
+             || h.byte_order != BYTE_ORDER_MARK || h.file_size != m_file.size() )
+            return false;
+
+        uint64_t pos = sizeof( header_t );
+        if ( h.tiles_offset != pos )
+            return false;
+        pos += uint64_t( h.tile_count ) * sizeof( tile_t );
+        if ( h.transforms_offset != pos )
+            return false;
+        pos += uint64_t( h.transform_count ) * 16 * sizeof( double );
+        if ( h.strings_offset != pos )
+            return false;
+        pos += ( uint64_t( h.string_count ) + 1 ) * sizeof( uint64_t );
+        if ( h.chars_offset != pos || pos > h.file_size )
+            return false;
+
+        auto offsets = reinterpret_cast<uint64_t const*>( m_file.data() + h.strings_offset );
+        if ( offsets[0] != 0 || h.chars_offset + offsets[h.string_count] != h.file_size )
+            return false;
+        for ( uint32_t i = 0; i != h.string_count; ++i )
+            if ( offsets[i] > offsets[i + 1] )
+                return false;
+        if ( h.asset_version != NONE && h.asset_version >= h.string_count )
+            return false;
+
+        auto in_range = []( uint32_t v, uint32_t n ) { return v == NONE || v < n; };
+        for ( uint32_t i = 0; i != h.tile_count; ++i )
+        {
+            tile_t const& t = tiles()[i];
+            if ( !in_range( t.transform, h.transform_count ) || !in_range( t.uri, h.string_count )
+                 || !in_range( t.first_child, h.tile_count ) || !in_range( t.last_child, h.tile_count )
+                 || !in_range( t.next_sibling, h.tile_count ) || t.volume_kind > VOLUME_SPHERE )
+                return false;
+            // the parents precede the children
+            if ( i == 0 ? t.parent != NONE : t.parent >= i )
+                return false;
+        }
+
+        // every tile but the root is reached once, from its own parent: no
+        // cycle for child_from_image() or depth_first() to loop on
+        std::vector<uint8_t> reached( h.tile_count, 0 );
+        for ( uint32_t i = 0; i != h.tile_count; ++i )
+        {
+            uint32_t last = NONE;
+            for ( uint32_t c = tiles()[i].first_child; c != NONE; c = tiles()[c].next_sibling )
+            {
+                if ( c <= i || tiles()[c].parent != i || reached[c] )
+                    return false;
+                reached[c] = 1;
+                last = c;
+            }
+            if ( last != tiles()[i].last_child )
+                return false;
+        }
+        return std::count( reached.begin(), reached.end(), uint8_t( 1 ) ) + ( h.tile_count ? 1 : 0 )
+               == std::ptrdiff_t( h.tile_count );
+    }
+
+    MappedFile m_file;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETIMAGE_H
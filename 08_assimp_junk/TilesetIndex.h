@@ -0,0 +1,361 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETINDEX_H
+#define TILESETINDEX_H
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+#include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "TilesetTree.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Packed R-tree over the bounding volumes of a TileTree
+///
+/// Every tile volume is converted to an axis aligned box in the tileset
+/// (ECEF) frame: oriented boxes and spheres with the accumulated tile
+/// transforms applied, regions via WGS84. The tree is bulk loaded, queries
+/// descend only into the nodes intersecting the query.
+class TilesetIndex
+{
+public:
+    typedef TileTree::index_t index_t;
+    typedef std::array<double, 3> vec3_t;
+
+    typedef boost::geometry::model::point<double, 3, boost::geometry::cs::cartesian> point_t;
+    typedef boost::geometry::model::box<point_t> box_t;
+    typedef boost::geometry::model::d2::point_xy<double> point2d_t;
+    typedef boost::geometry::model::polygon<point2d_t> polygon_t;
+    typedef std::pair<box_t, index_t> value_t;
+    typedef boost::geometry::index::rtree<value_t, boost::geometry::index::rstar<16>> rtree_t;
+
+    /// @brief Plane n.p + d = 0, the inside is n.p + d >= 0
+    struct plane_t
+    {
+        vec3_t n;
+        double d;
+    };
+
+    /// @brief View frustum: left, right, bottom, top, near, far planes
+    struct frustum_t
+    {
+        std::array<plane_t, 6> planes;
+
+        enum
+        {
+            LEFT,
+            RIGHT,
+            BOTTOM,
+            TOP,
+            NEAR_PLANE,
+            FAR_PLANE
+        };
+
+        /// @brief Perspective frustum
+        /// @param fovy vertical field of view (radians)
+        static frustum_t perspective(
+            vec3_t const& eye, vec3_t const& direction, vec3_t const& up,
+            double fovy, double aspect, double znear, double zfar )
+        {
+            vec3_t f = normalize( direction );
+            vec3_t r = normalize( cross( f, up ) );
+            vec3_t u = cross( r, f );
+
+            double ty = std::tan( fovy / 2 );
+            double tx = ty * aspect;
+
+            frustum_t fr;
+            // side planes contain the eye
+            auto side = [&]( vec3_t const& n ) { return plane_t{ n, -dot( n, eye ) }; };
+            fr.planes[LEFT] = side( normalize( add( f, scale( r, 1 / tx ) ) ) );
+            fr.planes[RIGHT] = side( normalize( sub( f, scale( r, 1 / tx ) ) ) );
+            fr.planes[BOTTOM] = side( normalize( add( f, scale( u, 1 / ty ) ) ) );
+            fr.planes[TOP] = side( normalize( sub( f, scale( u, 1 / ty ) ) ) );
+            fr.planes[NEAR_PLANE] = plane_t{ f, -dot( f, eye ) - znear };
+            fr.planes[FAR_PLANE] = plane_t{ scale( f, -1 ), dot( f, eye ) + zfar };
+            return fr;
+        }
+
+        /// @brief The box is (at least partially) inside
+        bool intersects( box_t const& b ) const
+        {
+            for ( auto const& p : planes )
+            {
+                // the box corner farthest along the plane normal
+                vec3_t v{
+                    p.n[0] >= 0 ? b.max_corner().get<0>() : b.min_corner().get<0>(),
+                    p.n[1] >= 0 ? b.max_corner().get<1>() : b.min_corner().get<1>(),
+                    p.n[2] >= 0 ? b.max_corner().get<2>() : b.min_corner().get<2>() };
+                if ( dot( p.n, v ) + p.d < 0 )
+                    return false;
+            }
+            return true;
+        }
+
+        /// @brief Axis aligned box around the frustum corners
+        box_t bounds() const
+        {
+            box_t r;
+            boost::geometry::assign_inverse( r );
+            for ( int lr : { LEFT, RIGHT } )
+                for ( int bt : { BOTTOM, TOP } )
+                    for ( int nf : { NEAR_PLANE, FAR_PLANE } )
+                    {
+                        vec3_t c = intersect( planes[lr], planes[bt], planes[nf] );
+                        boost::geometry::expand( r, point_t( c[0], c[1], c[2] ) );
+                    }
+            return r;
+        }
+    };
+
+    TilesetIndex() {}
+
+    explicit TilesetIndex( TileTree const& tree ) { build( tree ); }
+
+    /// @brief (Re)build the index
+    void build( TileTree const& tree )
+    {
+        m_bounds.assign( tree.size(), box_t{} );
+        std::vector<value_t> values;
+        values.reserve( tree.size() );
+
+        // accumulated transforms along the current path
+        std::vector<matrix_t> path;
+        tree.depth_first( [&]( index_t i, unsigned depth ) {
+            path.resize( depth + 1 );
+            matrix_t m = depth ? path[depth - 1] : identity();
+            if ( auto t = tree.transform( i ) )
+                m = multiply( m, t->matrix4x4 );
+            path[depth] = m;
+
+            if ( volume_bounds( tree[i].boundingVolume, m, m_bounds[i] ) )
+                values.emplace_back( m_bounds[i], i );
+        } );
+
+        // the range constructor uses the packing algorithm
+        m_rtree = rtree_t( values.begin(), values.end() );
+    }
+
+    size_t size() const { return m_rtree.size(); }
+    bool empty() const { return m_rtree.empty(); }
+    rtree_t const& rtree() const { return m_rtree; }
+
+    /// @brief The box of the tile volume (in the tileset frame)
+    box_t const& bounds( index_t i ) const { return m_bounds[i]; }
+
+    std::vector<index_t> query_box( box_t const& b ) const
+    {
+        std::vector<index_t> r;
+        for ( auto it = m_rtree.qbegin( boost::geometry::index::intersects( b ) ); it != m_rtree.qend(); ++it )
+            r.push_back( it->second );
+        return r;
+    }
+
+    std::vector<index_t> query_sphere( vec3_t const& center, double radius ) const
+    {
+        namespace bgi = boost::geometry::index;
+        box_t b( point_t( center[0] - radius, center[1] - radius, center[2] - radius ),
+                 point_t( center[0] + radius, center[1] + radius, center[2] + radius ) );
+        double r2 = radius * radius;
+        std::vector<index_t> r;
+        auto touches = [&]( value_t const& v ) { return distance2( v.first, center ) <= r2; };
+        for ( auto it = m_rtree.qbegin( bgi::intersects( b ) && bgi::satisfies( touches ) ); it != m_rtree.qend(); ++it )
+            r.push_back( it->second );
+        return r;
+    }
+
+    /// @brief Tiles intersecting the vertical prism over the polygon
+    /// @param polygon the footprint in the XY plane of the tileset frame
+    std::vector<index_t> query_polygon( polygon_t const& polygon, double zmin = -HUGE_VAL, double zmax = HUGE_VAL ) const
+    {
+        namespace bg = boost::geometry;
+        namespace bgi = boost::geometry::index;
+        auto env = bg::return_envelope<bg::model::box<point2d_t>>( polygon );
+        box_t b( point_t( env.min_corner().x(), env.min_corner().y(), zmin ),
+                 point_t( env.max_corner().x(), env.max_corner().y(), zmax ) );
+        auto touches = [&]( value_t const& v ) {
+            bg::model::box<point2d_t> b2(
+                point2d_t( v.first.min_corner().get<0>(), v.first.min_corner().get<1>() ),
+                point2d_t( v.first.max_corner().get<0>(), v.first.max_corner().get<1>() ) );
+            return bg::intersects( polygon, b2 );
+        };
+        std::vector<index_t> r;
+        for ( auto it = m_rtree.qbegin( bgi::intersects( b ) && bgi::satisfies( touches ) ); it != m_rtree.qend(); ++it )
+            r.push_back( it->second );
+        return r;
+    }
+
+    std::vector<index_t> query_frustum( frustum_t const& f ) const
+    {
+        namespace bgi = boost::geometry::index;
+        auto inside = [&]( value_t const& v ) { return f.intersects( v.first ); };
+        std::vector<index_t> r;
+        for ( auto it = m_rtree.qbegin( bgi::intersects( f.bounds() ) && bgi::satisfies( inside ) ); it != m_rtree.qend(); ++it )
+            r.push_back( it->second );
+        return r;
+    }
+
+#pragma region geometry
+    typedef std::array<double, 16> matrix_t; // column major
+
+    static matrix_t identity() { return { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 }; }
+
+    static matrix_t multiply( matrix_t const& a, double const* b )
+    {
+        matrix_t r;
+        for ( int c = 0; c != 4; ++c )
+            for ( int row = 0; row != 4; ++row )
+            {
+                double s = 0;
+                for ( int k = 0; k != 4; ++k )
+                    s += a[k * 4 + row] * b[c * 4 + k];
+                r[c * 4 + row] = s;
+            }
+        return r;
+    }
+
+    static vec3_t transform_point( matrix_t const& m, vec3_t const& p )
+    {
+        return { m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+                 m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+                 m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14] };
+    }
+
+    static vec3_t transform_vector( matrix_t const& m, vec3_t const& v )
+    {
+        return { m[0] * v[0] + m[4] * v[1] + m[8] * v[2],
+                 m[1] * v[0] + m[5] * v[1] + m[9] * v[2],
+                 m[2] * v[0] + m[6] * v[1] + m[10] * v[2] };
+    }
+
+    /// @brief WGS84 geodetic (radians, meters) to ECEF
+    static vec3_t cartographic_to_ecef( double lon, double lat, double h )
+    {
+        const double a = 6378137.0;
+        const double e2 = 6.69437999014e-3;
+        double s = std::sin( lat );
+        double n = a / std::sqrt( 1 - e2 * s * s );
+        return { ( n + h ) * std::cos( lat ) * std::cos( lon ),
+                 ( n + h ) * std::cos( lat ) * std::sin( lon ),
+                 ( n * ( 1 - e2 ) + h ) * s };
+    }
+
+    /// @brief Axis aligned box of a tile volume
+    /// @return false if the tile has no bounding volume
+    static bool volume_bounds( TileTree::volume_t const& v, matrix_t const& m, box_t& out )
+    {
+        namespace bg = boost::geometry;
+        bg::assign_inverse( out );
+        auto expand = [&]( vec3_t const& p ) { bg::expand( out, point_t( p[0], p[1], p[2] ) ); };
+
+        if ( auto box = std::get_if<TileTree::box_t>( &v ) )
+        {
+            // the extent along each world axis is the sum of the projected half axes
+            vec3_t c = transform_point( m, { box->box[0], box->box[1], box->box[2] } );
+            vec3_t ext{ 0, 0, 0 };
+            for ( int a = 0; a != 3; ++a )
+            {
+                vec3_t h = transform_vector( m, { box->box[3 + a * 3], box->box[4 + a * 3], box->box[5 + a * 3] } );
+                for ( int k = 0; k != 3; ++k )
+                    ext[k] += std::abs( h[k] );
+            }
+            expand( sub( c, ext ) );
+            expand( add( c, ext ) );
+            return true;
+        }
+        if ( auto sphere = std::get_if<TileTree::sphere_t>( &v ) )
+        {
+            vec3_t c = transform_point( m, { sphere->sphere[0], sphere->sphere[1], sphere->sphere[2] } );
+            double s = 0;
+            for ( int col = 0; col != 3; ++col )
+                s = std::max( s, length( { m[col * 4], m[col * 4 + 1], m[col * 4 + 2] } ) );
+            double r = sphere->sphere[3] * s;
+            expand( sub( c, { r, r, r } ) );
+            expand( add( c, { r, r, r } ) );
+            return true;
+        }
+        if ( auto region = std::get_if<TileTree::region_t>( &v ) )
+        {
+            // the extremes are at the region borders, at the equator or at
+            // the longitudes of the axes (the region ignores transforms)
+            double w = region->region[0], s = region->region[1], e = region->region[2], n = region->region[3];
+            if ( e < w )
+                e += 2 * M_PI; // crosses the antimeridian
+            std::vector<double> lons{ w, e }, lats{ s, n };
+            for ( int k = -4; k <= 8; ++k )
+                if ( k * M_PI / 2 > w && k * M_PI / 2 < e )
+                    lons.push_back( k * M_PI / 2 );
+            if ( s < 0 && n > 0 )
+                lats.push_back( 0 );
+            for ( double lon : lons )
+                for ( double lat : lats )
+                    for ( double h : { region->region[4], region->region[5] } )
+                        expand( cartographic_to_ecef( lon, lat, h ) );
+            return true;
+        }
+        return false;
+    }
+
+    static double dot( vec3_t const& a, vec3_t const& b ) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+    static vec3_t add( vec3_t const& a, vec3_t const& b ) { return { a[0] + b[0], a[1] + b[1], a[2] + b[2] }; }
+    static vec3_t sub( vec3_t const& a, vec3_t const& b ) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+    static vec3_t scale( vec3_t const& a, double s ) { return { a[0] * s, a[1] * s, a[2] * s }; }
+    static double length( vec3_t const& a ) { return std::sqrt( dot( a, a ) ); }
+    static vec3_t normalize( vec3_t const& a ) { return scale( a, 1 / length( a ) ); }
+    static vec3_t cross( vec3_t const& a, vec3_t const& b )
+    {
+        return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    }
+
+    /// @brief The point common to three planes
+    static vec3_t intersect( plane_t const& p0, plane_t const& p1, plane_t const& p2 )
+    {
+        vec3_t c12 = cross( p1.n, p2.n ), c20 = cross( p2.n, p0.n ), c01 = cross( p0.n, p1.n );
+        double det = dot( p0.n, c12 );
+        return scale( add( add( scale( c12, -p0.d ), scale( c20, -p1.d ) ), scale( c01, -p2.d ) ), 1 / det );
+    }
+
+    /// @brief Squared distance from the point to the box
+    static double distance2( box_t const& b, vec3_t const& p )
+    {
+        double lo[3] = { b.min_corner().get<0>(), b.min_corner().get<1>(), b.min_corner().get<2>() };
+        double hi[3] = { b.max_corner().get<0>(), b.max_corner().get<1>(), b.max_corner().get<2>() };
+        double r = 0;
+        for ( int k = 0; k != 3; ++k )
+        {
+            double d = p[k] < lo[k] ? lo[k] - p[k] : p[k] > hi[k] ? p[k] - hi[k] : 0;
+            r += d * d;
+        }
+        return r;
+    }
+#pragma endregion
+
+protected:
+    rtree_t m_rtree;
+    std::vector<box_t> m_bounds;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETINDEX_H
@@ -5,12 +5,20 @@
 #ifndef TILESETJSON_H
 #define TILESETJSON_H
 
+#include <algorithm>
+#include <functional>
 #include <optional>
+#include <stdexcept>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <json-c/json.h>
 #include <json-c/printbuf.h>
 
+#include "meshbuilder.h"
+
 #define SIZE(x) (sizeof(x) / sizeof(*x))
 #ifndef ASSERT
 # define ASSERT(exp) ((void) 0)
@@ -136,6 +144,29 @@ public:
         }
     };
 
+    /// <summary>
+    /// Sphere
+    /// The boundingVolume.sphere property is an array of four numbers that define a bounding sphere.
+    /// The first three elements define the x, y, and z values for the center of the sphere
+    /// in a right-handed 3-axis (x, y, z) Cartesian coordinate system where the z-axis is up.
+    /// The last element (with index 3) defines the radius in meters.
+    /// </summary>
+    class boundingVolumeSphere_t : public boundingVolume_t
+    {
+    public:
+        double sphere[4];
+        boundingVolumeSphere_t()
+        {
+            std::fill( sphere, sphere + SIZE( sphere ), 0.0 );
+        }
+
+        boundingVolumeSphere_t( std::initializer_list<double> const& l )
+        {
+            ASSERT( l.size() == SIZE( sphere ) );
+            std::copy( l.begin(), l.end(), sphere );
+        }
+    };
+
     struct transform_t
     {
         double matrix4x4[16];
@@ -201,17 +232,34 @@ public:
         {
         }
     };
+
+    /// @brief Tiles kept outside of the document, e.g. the binary image
+    /// of TilesetJsonImage.h. The tiles are read-only, the document is
+    /// parsed on the first modification.
+    class source_t
+    {
+    public:
+        virtual ~source_t() {}
+        virtual asset_t asset() const = 0;
+        virtual double geometricError() const = 0;
+        virtual root_tile_t root() const = 0;
+    };
 #pragma endregion
 public:
     /// <summary>
     /// Construct the tileset object from existing json file
+    /// If a source is given (e.g. TilesetJsonImage::open( filename )),
+    /// the tiles are taken from it and the json is parsed only on demand.
     /// </summary>
     /// <param name="filename"></param>
-    TilesetJson( std::string const& filename )
+    /// <param name="source">nullptr to parse the file</param>
+    TilesetJson( std::string const& filename, std::unique_ptr<source_t> source = nullptr )
+        : m_root( nullptr )
+        , m_filename( filename )
+        , m_source( std::move( source ) )
     {
-        m_root = json_object_from_file( filename.c_str() );
-        if ( !m_root )
-            throw std::runtime_error( "Document root is not valid" );
+        if ( !m_source )
+            dom();
     }
 
     /// <summary>
@@ -222,6 +270,12 @@ public:
         m_root = json_object_new_object();
     }
 
+    TilesetJson( TilesetJson const& ) = delete;
+    TilesetJson& operator=( TilesetJson const& ) = delete;
+
+    /// @brief The tiles come from the source, not from the document
+    bool has_image() const { return m_source != nullptr; }
+
     virtual ~TilesetJson()
     {
         if ( m_root )
@@ -231,6 +285,8 @@ public:
     asset_t asset()
     {
         asset_t r{};
+        if ( m_source )
+            return m_source->asset();
         json_object* asset_obj = 0;
         //    m_root.GetObj( "asset" );
         //r.version = asset_obj.GetInteger( "version", -1 );
@@ -269,17 +325,19 @@ public:
             json_object_object_add( o, "extras", extras_o );
         }
 
-        json_object_object_add( m_root, "asset", o );
+        json_object_object_add( dom(), "asset", o );
     }
 
     double geometricError()
     {
+        if ( m_source )
+            return m_source->geometricError();
         return geometricError( m_root );
     }
 
     void geometricError( double d )
     {
-        json_object_object_add( m_root, "geometricError", json_object_new_double_g18( d ) );
+        json_object_object_add( dom(), "geometricError", json_object_new_double_g18( d ) );
     }
 
     content_t content( json_object* o )
@@ -327,6 +385,9 @@ public:
 
         root_tile_t tile{};
 
+        if ( m_source )
+            return m_source->root();
+
         if ( json_object_object_get_ex( m_root, "root", &root_obj ) )
         {
             child_from_obj( root_obj, tile );
@@ -345,7 +406,7 @@ public:
     {
         auto ro = child_to_obj( tile );
         json_object_object_add( ro, "refine", json_object_new_string( tile.refine.c_str() ) );
-        json_object_object_add( m_root, "root", ro );
+        json_object_object_add( dom(), "root", ro );
     }
 
     json_object* transform_to_obj( transform_t const &tr )
@@ -389,6 +450,15 @@ public:
                     json_object_object_add( bvo, "region", box_o );
                     json_object_object_add( ro, "boundingVolume", bvo );
             }
+            else if ( auto bounding_sphere = dynamic_cast<boundingVolumeSphere_t*>( tile.boundingVolume.get() ) )
+            {
+                auto bvo = json_object_new_object();
+                auto sphere_o = json_object_new_array();
+                for ( auto d : bounding_sphere->sphere )
+                    json_object_array_add( sphere_o, json_object_new_double_g18( d ) );
+                json_object_object_add( bvo, "sphere", sphere_o );
+                json_object_object_add( ro, "boundingVolume", bvo );
+            }
         }
         if ( !tile.content.uri.empty() )
             json_object_object_add( ro, "content", content_to_obj( tile.content ) );
@@ -462,6 +532,53 @@ public:
         return model.release();
     }
 
+    /// @brief The 8 corners of a box: the bottom rectangle, then the top one
+    static void box_corners( double const* box, aiVector3D* vertices )
+    {
+        auto origin = make_vector3D( box );
+        auto ort_x = make_vector3D( box + 3 );
+        auto ort_y = make_vector3D( box + 6 );
+        auto ort_z = make_vector3D( box + 9 );
+        // a bottom rectangle
+        vertices[0] = origin + ort_x + ort_y - ort_z;
+        vertices[1] = origin - ort_x + ort_y - ort_z;
+        vertices[2] = origin - ort_x - ort_y - ort_z;
+        vertices[3] = origin + ort_x - ort_y - ort_z;
+        // a top rectangle
+        vertices[4] = origin + ort_x + ort_y + ort_z;
+        vertices[5] = origin - ort_x + ort_y + ort_z;
+        vertices[6] = origin - ort_x - ort_y + ort_z;
+        vertices[7] = origin + ort_x - ort_y + ort_z;
+    }
+
+    static constexpr unsigned box_edges[12][2] = {
+        { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+        { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+
+    /// @brief The 12 edges of the box with the corners starting at first
+    static void set_box_edges( aiFace* faces, unsigned first )
+    {
+        for ( int e = 0; e != 12; ++e )
+        {
+            faces[e].mNumIndices = 2;
+            faces[e].mIndices = new unsigned int[2] { first + box_edges[e][0], first + box_edges[e][1] };
+        }
+    }
+
+    /// @brief set_box_edges() with the 24 indices taken from a block
+    /// (owned by a meshtoolbox::FaceArena)
+    static void set_box_edges( aiFace* faces, unsigned first, unsigned* indices )
+    {
+        for ( int e = 0; e != 12; ++e, indices += 2 )
+        {
+            indices[0] = first + box_edges[e][0];
+            indices[1] = first + box_edges[e][1];
+            faces[e].mNumIndices = 2;
+            faces[e].mIndices = indices;
+        }
+    }
+
     /// <summary>
     /// 
     /// </summary>
@@ -470,30 +587,11 @@ public:
     aiMesh* bounding_box_mesh( boundingVolumeBox_t const* box )
     {
         // the mesh will represent a wire-frame box
-        auto origin = make_vector3D( box->box );
-        auto ort_x = make_vector3D( box->box + 3 );
-        auto ort_y = make_vector3D( box->box + 6 );
-        auto ort_z = make_vector3D( box->box + 9 );
-#if 0
-        CONSOLE( "origin:" << origin );
-        CONSOLE( "ort_X:" << ort_x );
-        CONSOLE( "ort_Y:" << ort_y );
-        CONSOLE( "ort_Z:" << ort_z );
-#endif
         aiMesh* mesh = new aiMesh;
         mesh->mPrimitiveTypes = aiPrimitiveType_LINE;
 
         auto vertices = new aiVector3D[8];
-        // a bottom rectangle
-        vertices[0] = origin + ort_x + ort_y - ort_z;
-        vertices[1] = origin - ort_x + ort_y - ort_z;
-        vertices[2] = origin - ort_x - ort_y - ort_z;
-        vertices[3] = origin + ort_x - ort_y - ort_z;
-        // a top rectangle
-        vertices[4] = origin + ort_x + ort_y + ort_z;
-        vertices[5] = origin - ort_x + ort_y + ort_z;
-        vertices[6] = origin - ort_x - ort_y + ort_z;
-        vertices[7] = origin + ort_x - ort_y + ort_z;
+        box_corners( box->box, vertices );
 
         mesh->mVertices = vertices;
         mesh->mNumVertices = 8;
@@ -505,42 +603,7 @@ public:
         mesh->mColors[0] = red;
 
         aiFace* faces = new aiFace[12];
-
-        faces[0].mNumIndices = 2;
-        faces[0].mIndices = new unsigned int[2] { 0, 1 };
-
-        faces[1].mNumIndices = 2;
-        faces[1].mIndices = new unsigned int[2] { 1, 2 };
-
-        faces[2].mNumIndices = 2;
-        faces[2].mIndices = new unsigned int[2] { 2, 3 };
-
-        faces[3].mNumIndices = 2;
-        faces[3].mIndices = new unsigned int[2] { 3, 0 };
-
-        faces[4].mNumIndices = 2;
-        faces[4].mIndices = new unsigned int[2] { 4, 5 };
-
-        faces[5].mNumIndices = 2;
-        faces[5].mIndices = new unsigned int[2] { 5, 6 };
-
-        faces[6].mNumIndices = 2;
-        faces[6].mIndices = new unsigned int[2] { 6, 7 };
-
-        faces[7].mNumIndices = 2;
-        faces[7].mIndices = new unsigned int[2] { 7, 4 };
-
-        faces[8].mNumIndices = 2;
-        faces[8].mIndices = new unsigned int[2] { 0, 4 };
-
-        faces[9].mNumIndices = 2;
-        faces[9].mIndices = new unsigned int[2] { 1, 5 };
-
-        faces[10].mNumIndices = 2;
-        faces[10].mIndices = new unsigned int[2] { 2, 6 };
-
-        faces[11].mNumIndices = 2;
-        faces[11].mIndices = new unsigned int[2] { 3, 7 };
+        set_box_edges( faces, 0 );
 
         mesh->mFaces = faces;
         mesh->mNumFaces = 12;
@@ -601,7 +664,7 @@ public:
             | JSON_C_TO_STRING_NOZERO
             | JSON_C_TO_STRING_PRETTY
             ;
-        int rc = json_object_to_file_ext( cp, m_root, flags );
+        int rc = json_object_to_file_ext( cp, dom(), flags );
         free( cp );
         return rc == 0;
     }
@@ -637,6 +700,136 @@ public:
         return scene;
     };
 
+    enum scene_layout_t
+    {
+        SCENE_NODE_PER_TILE,    // a mesh and a node per tile, as build_bounding_boxes_scene()
+        SCENE_MERGED_LEVELS,    // a line mesh per depth level
+        SCENE_INSTANCED         // one unit box mesh, a node per tile with the box as the transform
+    };
+
+    /// @brief Build a scene containing all bounding boxes, batched
+    /// @param layout SCENE_MERGED_LEVELS: the boxes of a depth level are
+    ///     merged into one mesh ("level[depth]"), SCENE_INSTANCED: the nodes
+    ///     "level[depth]" hold a node per tile, all referencing the mesh 0
+    /// @param level_colors the vertex color per depth level (cycled), red if empty
+    /// @return the line indices of a mesh are one block of the scene arena
+    meshtoolbox::scene_ptr build_bounding_boxes_scene( scene_layout_t layout, std::vector<aiColor4D> const& level_colors = {} )
+    {
+        if ( layout == SCENE_NODE_PER_TILE )
+            return build_bounding_boxes_scene();
+
+        // the boxes per depth level, document order
+        auto root_tile = this->root();
+        std::vector<std::vector<boundingVolumeBox_t const*>> levels;
+        std::vector<std::pair<child_t const*, unsigned>> stack{ { &root_tile, 0u } };
+        while ( !stack.empty() )
+        {
+            auto [tile, depth] = stack.back();
+            stack.pop_back();
+            auto box = dynamic_cast<boundingVolumeBox_t const*>( tile->boundingVolume.get() );
+            if ( !box )
+                throw std::runtime_error( "Is not supported" );
+            if ( levels.size() <= depth )
+                levels.resize( depth + 1 );
+            levels[depth].push_back( box );
+            for ( auto cp = tile->children.rbegin(); cp != tile->children.rend(); ++cp )
+                stack.push_back( { &*cp, depth + 1 } );
+        }
+        auto color = [&]( size_t depth ) {
+            return level_colors.empty() ? aiColor4D( 1, 0, 0, 0 ) : level_colors[depth % level_colors.size()];
+        };
+
+        auto scene = meshtoolbox::new_arena_scene();
+        auto& arena = meshtoolbox::arena_of( scene );
+        aiNode* root = new aiNode( "node[0]" );
+        root->mTransformation = aiMatrix4x4(
+            // Y coordinate is elevation
+            1, 0, 0, 0,
+            0, 0, 1, 0,
+            0, -1, 0, 0,
+            0, 0, 0, 1 );
+        scene->mRootNode = root;
+        root->mNumChildren = unsigned( levels.size() );
+        root->mChildren = new aiNode * [levels.size()];
+        for ( size_t d = 0; d != levels.size(); ++d )
+        {
+            root->mChildren[d] = new aiNode( "level[" + std::to_string( d ) + "]" );
+            root->mChildren[d]->mParent = root;
+        }
+
+        if ( layout == SCENE_MERGED_LEVELS )
+        {
+            scene->mNumMeshes = unsigned( levels.size() );
+            scene->mMeshes = new aiMesh * [levels.size()];
+            for ( size_t d = 0; d != levels.size(); ++d )
+            {
+                auto const& boxes = levels[d];
+                aiMesh* mesh = new aiMesh;
+                scene->mMeshes[d] = mesh;
+                mesh->mName = "level[" + std::to_string( d ) + "]";
+                mesh->mPrimitiveTypes = aiPrimitiveType_LINE;
+                mesh->mNumVertices = unsigned( boxes.size() * 8 );
+                mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+                mesh->mColors[0] = new aiColor4D[mesh->mNumVertices];
+                std::fill( mesh->mColors[0], mesh->mColors[0] + mesh->mNumVertices, color( d ) );
+                mesh->mNumFaces = unsigned( boxes.size() * 12 );
+                mesh->mFaces = new aiFace[mesh->mNumFaces];
+                unsigned* indices = arena.allocate( size_t( mesh->mNumFaces ) * 2 );
+                for ( size_t b = 0; b != boxes.size(); ++b )
+                {
+                    box_corners( boxes[b]->box, mesh->mVertices + b * 8 );
+                    set_box_edges( mesh->mFaces + b * 12, unsigned( b * 8 ), indices + b * 24 );
+                }
+
+                aiNode* node = root->mChildren[d];
+                node->mNumMeshes = 1;
+                node->mMeshes = new unsigned int{ unsigned( d ) };
+            }
+        }
+        else
+        {
+            static const double unit_box[12] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+            aiMesh* mesh = new aiMesh;
+            mesh->mName = "unit_box";
+            mesh->mPrimitiveTypes = aiPrimitiveType_LINE;
+            mesh->mNumVertices = 8;
+            mesh->mVertices = new aiVector3D[8];
+            box_corners( unit_box, mesh->mVertices );
+            mesh->mColors[0] = new aiColor4D[8];
+            std::fill( mesh->mColors[0], mesh->mColors[0] + 8, color( 0 ) );
+            mesh->mNumFaces = 12;
+            mesh->mFaces = new aiFace[12];
+            set_box_edges( mesh->mFaces, 0, arena.allocate( 24 ) );
+            scene->mNumMeshes = 1;
+            scene->mMeshes = new aiMesh * [1] { mesh };
+
+            size_t n = 0;
+            for ( size_t d = 0; d != levels.size(); ++d )
+            {
+                auto const& boxes = levels[d];
+                aiNode* level = root->mChildren[d];
+                level->mNumChildren = unsigned( boxes.size() );
+                level->mChildren = new aiNode * [boxes.size()];
+                for ( size_t b = 0; b != boxes.size(); ++b )
+                {
+                    // the columns are the half axes, the translation is the center
+                    double const* v = boxes[b]->box;
+                    aiNode* node = new aiNode( "node[" + std::to_string( ++n ) + "]" );
+                    node->mTransformation = aiMatrix4x4(
+                        ai_real( v[3] ), ai_real( v[6] ), ai_real( v[9] ), ai_real( v[0] ),
+                        ai_real( v[4] ), ai_real( v[7] ), ai_real( v[10] ), ai_real( v[1] ),
+                        ai_real( v[5] ), ai_real( v[8] ), ai_real( v[11] ), ai_real( v[2] ),
+                        0, 0, 0, 1 );
+                    node->mNumMeshes = 1;
+                    node->mMeshes = new unsigned int{ 0 };
+                    node->mParent = level;
+                    level->mChildren[b] = node;
+                }
+            }
+        }
+        return scene;
+    }
+
 protected:
     static int get_as_int( json_object* o, const char* key, int dflt = 0 )
     {
@@ -706,6 +899,20 @@ protected:
                 }
                 return p;
             }
+            else if ( json_object_object_get_ex( bv, "sphere", &box_obj ) )
+            {
+                auto sphere_size = json_object_array_length( box_obj );
+                auto p = new boundingVolumeSphere_t;
+                if ( sphere_size != SIZE( boundingVolumeSphere_t::sphere ) )
+                    throw std::runtime_error( "Wrong boundingVolume.sphere array size" );
+
+                for ( int i = 0; i < SIZE( boundingVolumeSphere_t::sphere ); ++i )
+                {
+                    json_object* oi = json_object_array_get_idx( box_obj, i );
+                    p->sphere[i] = json_object_get_double( oi );
+                }
+                return p;
+            }
             throw std::runtime_error( "Unsupported boundingVolume type" );
         }
 
@@ -768,7 +975,22 @@ protected:
         return jso;
     }
 
-    json_object* m_root;
+    /// @brief The document (parsed on the first use if there is a source)
+    json_object* dom() const
+    {
+        if ( !m_root )
+        {
+            m_root = json_object_from_file( m_filename.c_str() );
+            if ( !m_root )
+                throw std::runtime_error( "Document root is not valid" );
+            m_source.reset();
+        }
+        return m_root;
+    }
+
+    mutable json_object* m_root;
+    std::string m_filename;
+    mutable std::unique_ptr<source_t> m_source;
 };
 
 
@@ -0,0 +1,114 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETJSONIMAGE_H
+#define TILESETJSONIMAGE_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "TilesetImage.h"
+#include "TilesetJson.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief The binary image next to tileset.json as the tiles of a TilesetJson
+///
+///     TilesetJson doc( filename, TilesetJsonImage::open( filename ) );
+///
+/// The image is mapped (MappedFile.cpp), the users of the plain TilesetJson
+/// do not depend on it.
+class TilesetJsonImage : public TilesetJson::source_t
+{
+public:
+    /// @brief The image of the tileset.json, nullptr if there is no valid one
+    static std::unique_ptr<TilesetJson::source_t> open( std::string const& filename )
+    {
+        auto image = TilesetImage::open( filename );
+        if ( !image )
+            return nullptr;
+        return std::unique_ptr<TilesetJson::source_t>( new TilesetJsonImage( std::move( image ) ) );
+    }
+
+    TilesetJson::asset_t asset() const override
+    {
+        auto const& h = m_image->header();
+        TilesetJson::asset_t r{};
+        r.version = m_image->str( h.asset_version );
+        if ( h.flags & TilesetImage::HAS_GEOREFERENCED )
+            r.extra_ion_georeferenced = ( h.flags & TilesetImage::GEOREFERENCED ) != 0;
+        return r;
+    }
+
+    double geometricError() const override { return m_image->header().geometric_error; }
+
+    TilesetJson::root_tile_t root() const override
+    {
+        TilesetJson::root_tile_t tile{};
+        if ( m_image->size() )
+        {
+            child_from_image( 0, tile );
+            if ( m_image->tile( 0 ).refine == TilesetImage::REFINE_REPLACE )
+                tile.refine = "REPLACE";
+        }
+        return tile;
+    }
+
+protected:
+    explicit TilesetJsonImage( std::unique_ptr<TilesetImage> image )
+        : m_image( std::move( image ) )
+    {
+    }
+
+    void child_from_image( uint32_t i, TilesetJson::child_t& tile ) const
+    {
+        auto const& t = m_image->tile( i );
+        tile.geometricError = t.geometric_error;
+        switch ( t.volume_kind )
+        {
+        case TilesetImage::VOLUME_BOX:
+            tile.boundingVolume.reset( new TilesetJson::boundingVolumeBox_t );
+            std::copy( t.volume, t.volume + 12,
+                       static_cast<TilesetJson::boundingVolumeBox_t*>( tile.boundingVolume.get() )->box );
+            break;
+        case TilesetImage::VOLUME_REGION:
+            tile.boundingVolume.reset( new TilesetJson::boundingVolumeRegion_t );
+            std::copy( t.volume, t.volume + 6,
+                       static_cast<TilesetJson::boundingVolumeRegion_t*>( tile.boundingVolume.get() )->region );
+            break;
+        case TilesetImage::VOLUME_SPHERE:
+            tile.boundingVolume.reset( new TilesetJson::boundingVolumeSphere_t );
+            std::copy( t.volume, t.volume + 4,
+                       static_cast<TilesetJson::boundingVolumeSphere_t*>( tile.boundingVolume.get() )->sphere );
+            break;
+        }
+        tile.content.uri = m_image->str( t.uri );
+        if ( t.transform != TilesetImage::NONE )
+        {
+            tile.transform.reset( new TilesetJson::transform_t );
+            auto m = m_image->transform( t.transform );
+            std::copy( m, m + 16, tile.transform->matrix4x4 );
+        }
+        for ( uint32_t c = t.first_child; c != TilesetImage::NONE; c = m_image->tile( c ).next_sibling )
+        {
+            TilesetJson::child_t ch;
+            child_from_image( c, ch );
+            tile.children.push_back( std::move( ch ) );
+        }
+    }
+
+    std::unique_ptr<TilesetImage> m_image;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETJSONIMAGE_H
@@ -0,0 +1,663 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETREADER_H
+#define TILESETREADER_H
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TilesetTree.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Pull tokenizer for JSON text
+///
+/// The input is either a memory block (e.g. a mapped file) or a FILE* read
+/// in fixed size chunks. No document is built: the caller asks for the next
+/// token and decides what to keep.
+class JsonReader
+{
+public:
+    enum token_t
+    {
+        T_END,          // end of input
+        T_BEGIN_OBJECT,
+        T_END_OBJECT,
+        T_BEGIN_ARRAY,
+        T_END_ARRAY,
+        T_KEY,          // see str()
+        T_STRING,       // see str()
+        T_NUMBER,       // see number()
+        T_TRUE,
+        T_FALSE,
+        T_NULL
+    };
+
+    /// @brief Read from memory (the block must outlive the reader)
+    JsonReader( const char* data, size_t size )
+        : m_begin( data )
+        , m_p( data )
+        , m_end( data + size )
+    {
+    }
+
+    /// @brief Read from a file, chunk by chunk
+    explicit JsonReader( std::FILE* f, size_t chunk_size = 64 * 1024 )
+        : m_file( f )
+        , m_buffer( chunk_size )
+    {
+    }
+
+    JsonReader( JsonReader const& ) = delete;
+    JsonReader& operator=( JsonReader const& ) = delete;
+
+    /// @brief Get the next token
+    token_t next()
+    {
+        for ( ;; )
+        {
+            int c = get_non_ws();
+            switch ( c )
+            {
+            case EOF:
+                if ( !m_stack.empty() )
+                    error( "Unexpected end of input" );
+                return T_END;
+            case ',':
+                if ( m_stack.empty() || !m_has_value )
+                    error( "Unexpected ','" );
+                m_has_value = false;
+                m_comma = true;
+                continue;
+            case ':':
+                if ( !m_expect_colon )
+                    error( "Unexpected ':'" );
+                m_expect_colon = false;
+                continue;
+            case '{':
+                before_value();
+                m_stack.push_back( '{' );
+                m_has_value = false;
+                return T_BEGIN_OBJECT;
+            case '[':
+                before_value();
+                m_stack.push_back( '[' );
+                m_has_value = false;
+                return T_BEGIN_ARRAY;
+            case '}':
+            case ']':
+                if ( m_stack.empty() || m_stack.back() != ( c == '}' ? '{' : '[' ) || m_key_read )
+                    error( "Unbalanced brackets" );
+                if ( m_comma )
+                    error( "Trailing ','" );
+                m_stack.pop_back();
+                m_has_value = true;
+                return c == '}' ? T_END_OBJECT : T_END_ARRAY;
+            case '"':
+                if ( in_object() && !m_key_read )
+                {
+                    if ( m_has_value )
+                        error( "Missing ','" );
+                    read_string();
+                    m_comma = false;
+                    m_key_read = true;
+                    m_expect_colon = true;
+                    return T_KEY;
+                }
+                before_value();
+                read_string();
+                return T_STRING;
+            case 't':
+                before_value();
+                expect_literal( "rue" );
+                return T_TRUE;
+            case 'f':
+                before_value();
+                expect_literal( "alse" );
+                return T_FALSE;
+            case 'n':
+                before_value();
+                expect_literal( "ull" );
+                return T_NULL;
+            default:
+                if ( c == '-' || ( c >= '0' && c <= '9' ) )
+                {
+                    before_value();
+                    read_number( char( c ) );
+                    return T_NUMBER;
+                }
+                error( "Unexpected character" );
+            }
+        }
+    }
+
+    /// @brief The key or string value (valid until the next call of next())
+    std::string_view str() const { return m_string; }
+
+    double number() const { return m_number; }
+
+    /// @brief Number of open objects and arrays
+    size_t depth() const { return m_stack.size(); }
+
+    /// @brief Bytes consumed so far
+    size_t offset() const { return m_consumed + size_t( m_p - m_begin ); }
+
+    /// @brief Skip the value started by the token t (iteratively)
+    void skip( token_t t )
+    {
+        if ( t != T_BEGIN_OBJECT && t != T_BEGIN_ARRAY )
+            return;
+        size_t d = depth() - 1;
+        while ( depth() > d )
+            if ( next() == T_END )
+                error( "Unexpected end of input" );
+    }
+
+    [[noreturn]] void error( const char* what ) const
+    {
+        throw std::runtime_error( std::string( what ) + " at offset " + std::to_string( offset() ) );
+    }
+
+protected:
+    bool in_object() const { return !m_stack.empty() && m_stack.back() == '{'; }
+
+    /// @brief Check the value is allowed here and update the state
+    void before_value()
+    {
+        if ( in_object() )
+        {
+            if ( !m_key_read || m_expect_colon )
+                error( "Object member without a key" );
+            m_key_read = false;
+        }
+        else if ( m_has_value )
+        {
+            error( m_stack.empty() ? "Extra data after the document" : "Missing ','" );
+        }
+        m_has_value = true;
+        m_comma = false;
+    }
+
+    bool fill()
+    {
+        if ( !m_file )
+            return false;
+        m_consumed += size_t( m_p - m_begin );
+        size_t n = std::fread( m_buffer.data(), 1, m_buffer.size(), m_file );
+        m_begin = m_p = m_buffer.data();
+        m_end = m_p + n;
+        return n != 0;
+    }
+
+    int get()
+    {
+        if ( m_p == m_end && !fill() )
+            return EOF;
+        return (unsigned char)*m_p++;
+    }
+
+    int peek()
+    {
+        if ( m_p == m_end && !fill() )
+            return EOF;
+        return (unsigned char)*m_p;
+    }
+
+    int get_non_ws()
+    {
+        for ( ;; )
+        {
+            int c = get();
+            if ( c != ' ' && c != '\n' && c != '\r' && c != '\t' )
+                return c;
+        }
+    }
+
+    void expect_literal( const char* rest )
+    {
+        for ( ; *rest; ++rest )
+            if ( get() != *rest )
+                error( "Invalid literal" );
+    }
+
+    unsigned read_hex4()
+    {
+        unsigned r = 0;
+        for ( int i = 0; i != 4; ++i )
+        {
+            int c = get();
+            r <<= 4;
+            if ( c >= '0' && c <= '9' )
+                r |= c - '0';
+            else if ( c >= 'a' && c <= 'f' )
+                r |= c - 'a' + 10;
+            else if ( c >= 'A' && c <= 'F' )
+                r |= c - 'A' + 10;
+            else
+                error( "Invalid \\u escape" );
+        }
+        return r;
+    }
+
+    void append_utf8( unsigned cp )
+    {
+        if ( cp < 0x80 )
+        {
+            m_string += char( cp );
+        }
+        else if ( cp < 0x800 )
+        {
+            m_string += char( 0xC0 | ( cp >> 6 ) );
+            m_string += char( 0x80 | ( cp & 0x3F ) );
+        }
+        else if ( cp < 0x10000 )
+        {
+            m_string += char( 0xE0 | ( cp >> 12 ) );
+            m_string += char( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            m_string += char( 0x80 | ( cp & 0x3F ) );
+        }
+        else
+        {
+            m_string += char( 0xF0 | ( cp >> 18 ) );
+            m_string += char( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+            m_string += char( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            m_string += char( 0x80 | ( cp & 0x3F ) );
+        }
+    }
+
+    void read_string()
+    {
+        m_string.clear();
+        for ( ;; )
+        {
+            // copy the run of plain characters at once
+            const char* run = m_p;
+            while ( m_p != m_end && *m_p != '"' && *m_p != '\\' && (unsigned char)*m_p >= 0x20 )
+                ++m_p;
+            m_string.append( run, m_p );
+
+            int c = get();
+            if ( c == '"' )
+                return;
+            if ( c == EOF )
+                error( "Unterminated string" );
+            if ( c < 0x20 )
+                error( "Control character in string" );
+            if ( c != '\\' )
+            {
+                // the run stopped at the end of the buffer
+                m_string += char( c );
+                continue;
+            }
+            switch ( c = get() )
+            {
+            case '"': m_string += '"'; break;
+            case '\\': m_string += '\\'; break;
+            case '/': m_string += '/'; break;
+            case 'b': m_string += '\b'; break;
+            case 'f': m_string += '\f'; break;
+            case 'n': m_string += '\n'; break;
+            case 'r': m_string += '\r'; break;
+            case 't': m_string += '\t'; break;
+            case 'u':
+            {
+                unsigned cp = read_hex4();
+                if ( cp >= 0xD800 && cp < 0xDC00 )
+                {
+                    if ( get() != '\\' || get() != 'u' )
+                        error( "Invalid surrogate pair" );
+                    unsigned lo = read_hex4();
+                    if ( lo < 0xDC00 || lo >= 0xE000 )
+                        error( "Invalid surrogate pair" );
+                    cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( lo - 0xDC00 );
+                }
+                append_utf8( cp );
+                break;
+            }
+            default:
+                error( "Invalid escape sequence" );
+            }
+        }
+    }
+
+    void read_number( char first )
+    {
+        char buf[64];
+        size_t n = 0;
+        buf[n++] = first;
+        for ( int c = peek(); ( c >= '0' && c <= '9' ) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-'; c = peek() )
+        {
+            if ( n == sizeof( buf ) )
+                error( "Number is too long" );
+            buf[n++] = char( get() );
+        }
+        if ( !is_number( buf, buf + n ) )
+            error( "Invalid number" );
+        auto [ptr, ec] = std::from_chars( buf, buf + n, m_number );
+        if ( ec != std::errc() || ptr != buf + n )
+            error( "Invalid number" );
+    }
+
+    /// @brief The JSON number grammar, stricter than from_chars: no leading
+    /// zeros, no "1." or "-.5"
+    static bool is_number( const char* p, const char* end )
+    {
+        auto digits = [&] {
+            const char* b = p;
+            while ( p != end && *p >= '0' && *p <= '9' )
+                ++p;
+            return p != b;
+        };
+        if ( p != end && *p == '-' )
+            ++p;
+        if ( p != end && *p == '0' )
+            ++p;
+        else if ( !digits() )
+            return false;
+        if ( p != end && *p == '.' && ( ++p, !digits() ) )
+            return false;
+        if ( p != end && ( *p == 'e' || *p == 'E' ) )
+        {
+            ++p;
+            if ( p != end && ( *p == '+' || *p == '-' ) )
+                ++p;
+            if ( !digits() )
+                return false;
+        }
+        return p == end;
+    }
+
+    // input
+    std::FILE* m_file = nullptr;
+    std::vector<char> m_buffer;
+    const char* m_begin = nullptr;
+    const char* m_p = nullptr;
+    const char* m_end = nullptr;
+    size_t m_consumed = 0;
+
+    // state
+    std::vector<char> m_stack;  // '{' or '['
+    bool m_has_value = false;   // a value was read in the current container
+    bool m_key_read = false;    // in an object: the key is read, the value is expected
+    bool m_expect_colon = false;
+    bool m_comma = false;       // a ',' was read, a value or key must follow
+
+    // current token
+    std::string m_string;
+    double m_number = 0;
+};
+
+/// @brief Streaming tileset.json loader
+///
+/// Builds the TileTree while the document is being tokenized. Neither a
+/// json-c DOM nor a TilesetJson::root_tile_t hierarchy is created, the
+/// additional memory is the read buffer and a stack of open tiles.
+class TilesetReader
+{
+public:
+    /// @brief Load a tileset.json file
+    static TileTree load( std::string const& filename )
+    {
+        std::unique_ptr<std::FILE, int ( * )( std::FILE* )> f( std::fopen( filename.c_str(), "rb" ), &std::fclose );
+        if ( !f )
+            throw std::runtime_error( "Cannot open " + filename );
+        JsonReader reader( f.get() );
+        return load( reader );
+    }
+
+    /// @brief Load from the binary image if it is valid, parse the file otherwise
+    /// @param write_image (re)create the image after parsing
+    static TileTree load_cached( std::string const& filename, bool write_image = true )
+    {
+        if ( auto image = TilesetImage::open( filename ) )
+            return TileTree::from_image( *image );
+        TileTree tree = load( filename );
+        if ( write_image )
+            tree.write_image( filename );
+        return tree;
+    }
+
+    /// @brief Load the tileset from memory (e.g. a mapped file)
+    static TileTree load( const char* data, size_t size )
+    {
+        JsonReader reader( data, size );
+        return load( reader );
+    }
+
+    static TileTree load( JsonReader& r )
+    {
+        TileTree tree;
+        if ( r.next() != JsonReader::T_BEGIN_OBJECT )
+            r.error( "Document root is not an object" );
+        for ( auto t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+        {
+            std::string key( r.str() );
+            t = r.next();
+            if ( key == "asset" )
+                read_asset( r, t, tree.asset );
+            else if ( key == "geometricError" )
+                tree.geometricError = read_number( r, t );
+            else if ( key == "root" )
+                read_tiles( r, t, tree );
+            else
+                r.skip( t );
+        }
+        if ( r.next() != JsonReader::T_END )
+            r.error( "Extra data after the document" );
+        return tree;
+    }
+
+protected:
+    typedef TileTree::index_t index_t;
+
+    static double read_number( JsonReader& r, JsonReader::token_t t )
+    {
+        if ( t != JsonReader::T_NUMBER )
+            r.error( "Number is expected" );
+        return r.number();
+    }
+
+    /// @brief Read an array of exactly n numbers
+    static void read_numbers( JsonReader& r, JsonReader::token_t t, double* out, size_t n, const char* what )
+    {
+        if ( t != JsonReader::T_BEGIN_ARRAY )
+            r.error( what );
+        size_t i = 0;
+        for ( t = r.next(); t != JsonReader::T_END_ARRAY; t = r.next() )
+        {
+            if ( i == n )
+                r.error( what );
+            out[i++] = read_number( r, t );
+        }
+        if ( i != n )
+            r.error( what );
+    }
+
+    static void read_asset( JsonReader& r, JsonReader::token_t t, TilesetJson::asset_t& asset )
+    {
+        if ( t != JsonReader::T_BEGIN_OBJECT )
+        {
+            r.skip( t );
+            return;
+        }
+        for ( t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+        {
+            std::string key( r.str() );
+            t = r.next();
+            if ( key == "version" && t == JsonReader::T_STRING )
+                asset.version = r.str();
+            else if ( key == "extras" && t == JsonReader::T_BEGIN_OBJECT )
+                read_asset_extras( r, asset );
+            else
+                r.skip( t );
+        }
+    }
+
+    /// @brief "extras": { "ion": { "georeferenced": ... } }
+    static void read_asset_extras( JsonReader& r, TilesetJson::asset_t& asset )
+    {
+        for ( auto t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+        {
+            std::string key( r.str() );
+            t = r.next();
+            if ( key != "ion" || t != JsonReader::T_BEGIN_OBJECT )
+            {
+                r.skip( t );
+                continue;
+            }
+            for ( t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+            {
+                std::string ion_key( r.str() );
+                t = r.next();
+                if ( ion_key == "georeferenced" && ( t == JsonReader::T_TRUE || t == JsonReader::T_FALSE ) )
+                    asset.extra_ion_georeferenced = t == JsonReader::T_TRUE;
+                else
+                    r.skip( t );
+            }
+        }
+    }
+
+    static TileTree::volume_t read_bounding_volume( JsonReader& r, JsonReader::token_t t )
+    {
+        TileTree::volume_t v;
+        if ( t != JsonReader::T_BEGIN_OBJECT )
+        {
+            r.skip( t );
+            return v;
+        }
+        for ( t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+        {
+            std::string key( r.str() );
+            t = r.next();
+            if ( key == "box" )
+            {
+                TileTree::box_t b;
+                read_numbers( r, t, b.box, 12, "Wrong boundingVolume.box array size" );
+                v = b;
+            }
+            else if ( key == "region" )
+            {
+                TileTree::region_t g;
+                read_numbers( r, t, g.region, 6, "Wrong boundingVolume.region array size" );
+                v = g;
+            }
+            else if ( key == "sphere" )
+            {
+                TileTree::sphere_t s;
+                read_numbers( r, t, s.sphere, 4, "Wrong boundingVolume.sphere array size" );
+                v = s;
+            }
+            else
+            {
+                r.skip( t );
+            }
+        }
+        return v;
+    }
+
+    static void read_content( JsonReader& r, JsonReader::token_t t, TileTree& tree, index_t i )
+    {
+        if ( t != JsonReader::T_BEGIN_OBJECT )
+        {
+            r.skip( t );
+            return;
+        }
+        for ( t = r.next(); t != JsonReader::T_END_OBJECT; t = r.next() )
+        {
+            std::string key( r.str() );
+            t = r.next();
+            // "url" is used by pre-1.0 tilesets
+            if ( ( key == "uri" || key == "url" ) && t == JsonReader::T_STRING )
+                tree.set_uri( i, r.str() );
+            else
+                r.skip( t );
+        }
+    }
+
+    /// @brief Read the root tile and all its descendants
+    ///
+    /// The tiles are processed with an explicit stack, so the nesting
+    /// depth is limited by the memory only.
+    static void read_tiles( JsonReader& r, JsonReader::token_t t, TileTree& tree )
+    {
+        if ( t != JsonReader::T_BEGIN_OBJECT )
+            r.error( "Tile is not an object" );
+
+        std::vector<index_t> open{ tree.add_tile( TileTree::npos ) };
+        while ( !open.empty() )
+        {
+            index_t i = open.back();
+            t = r.next();
+            if ( t == JsonReader::T_END_OBJECT )
+            {
+                // the tile is complete, continue with the parent's children array
+                open.pop_back();
+                if ( open.empty() )
+                    break;
+                t = r.next();
+                if ( t == JsonReader::T_BEGIN_OBJECT )
+                    open.push_back( tree.add_tile( open.back() ) );
+                else if ( t != JsonReader::T_END_ARRAY )
+                    r.error( "Tile is not an object" );
+                continue;
+            }
+
+            std::string key( r.str() );
+            t = r.next();
+            if ( key == "children" )
+            {
+                if ( t != JsonReader::T_BEGIN_ARRAY )
+                    r.error( "Tile children is not an array" );
+                t = r.next();
+                if ( t == JsonReader::T_BEGIN_OBJECT )
+                    open.push_back( tree.add_tile( i ) );
+                else if ( t != JsonReader::T_END_ARRAY )
+                    r.error( "Tile is not an object" );
+            }
+            else if ( key == "geometricError" )
+            {
+                tree[i].geometricError = read_number( r, t );
+            }
+            else if ( key == "boundingVolume" )
+            {
+                tree[i].boundingVolume = read_bounding_volume( r, t );
+            }
+            else if ( key == "content" )
+            {
+                read_content( r, t, tree, i );
+            }
+            else if ( key == "transform" )
+            {
+                TileTree::transform_t tr;
+                read_numbers( r, t, tr.matrix4x4, 16, "Wrong transform array size" );
+                tree.set_transform( i, tr );
+            }
+            else if ( key == "refine" && t == JsonReader::T_STRING )
+            {
+                tree[i].refine = TileTree::refine_from_string( r.str() );
+            }
+            else
+            {
+                r.skip( t );
+            }
+        }
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETREADER_H
@@ -0,0 +1,332 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETTRAVERSAL_H
+#define TILESETTRAVERSAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "TilesetIndex.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Headless screen space error tile selection
+///
+/// Gives the set of tiles a Cesium viewer would render for a camera, if all
+/// the content were loaded: frustum culling, SSE driven refinement with ADD
+/// and REPLACE semantics. Consecutive calls of select() reuse the refinement
+/// decisions that the camera movement cannot change and report the tiles
+/// entering and leaving the selection.
+class TileSelector
+{
+public:
+    typedef TileTree::index_t index_t;
+    typedef TilesetIndex::vec3_t vec3_t;
+
+    struct camera_t
+    {
+        vec3_t position;
+        vec3_t direction;
+        vec3_t up;
+        double fovy = M_PI / 3; // vertical field of view (radians)
+        double znear = 1;
+        double zfar = 1e8;
+    };
+
+    struct view_t
+    {
+        unsigned width = 1920;
+        unsigned height = 1080;
+        double max_sse = 16;    // maximum screen space error (pixels)
+    };
+
+    struct stats_t
+    {
+        size_t visited;  // tiles tested
+        size_t culled;   // tiles outside the frustum
+        size_t reused;   // refinement decisions taken from the previous frame
+    };
+
+    explicit TileSelector( TileTree const& tree )
+        : TileSelector( tree, view_t() )
+    {
+    }
+
+    TileSelector( TileTree const& tree, view_t const& view )
+        : m_tree( tree )
+        , m_view( view )
+    {
+        build_volumes();
+        m_cache.assign( tree.size(), cache_t{} );
+        m_selected_frame.assign( tree.size(), ~0u );
+    }
+
+    view_t const& view() const { return m_view; }
+
+    void set_view( view_t const& view )
+    {
+        m_view = view;
+        invalidate();
+    }
+
+    /// @brief Forget the previous frame
+    void invalidate()
+    {
+        for ( auto& c : m_cache )
+            c.frame = 0;
+    }
+
+    /// @brief Screen space error of the tile seen from the camera
+    double screen_space_error( index_t i, camera_t const& camera ) const
+    {
+        double d = std::max( distance( i, camera.position ), 1e-7 );
+        return m_tree[i].geometricError * m_view.height / ( d * 2 * std::tan( camera.fovy / 2 ) );
+    }
+
+    /// @brief Select the tiles to render
+    /// @return the selected tiles in the traversal order
+    std::vector<index_t> const& select( camera_t const& camera )
+    {
+        if ( camera.fovy != m_fovy )
+        {
+            m_fovy = camera.fovy;
+            invalidate();
+        }
+        ++m_frame;
+        m_stats = stats_t{};
+
+        auto frustum = TilesetIndex::frustum_t::perspective(
+            camera.position, camera.direction, camera.up,
+            camera.fovy, double( m_view.width ) / m_view.height, camera.znear, camera.zfar );
+        // SSE > max_sse <=> distance < geometricError * k
+        double k = m_view.height / ( 2 * std::tan( camera.fovy / 2 ) * m_view.max_sse );
+
+        m_previous.swap( m_selected );
+        m_selected.clear();
+        m_added.clear();
+        m_removed.clear();
+
+        if ( !m_tree.empty() )
+            m_stack.assign( 1, m_tree.root() );
+        while ( !m_stack.empty() )
+        {
+            index_t i = m_stack.back();
+            m_stack.pop_back();
+            ++m_stats.visited;
+
+            if ( !visible( i, frustum ) )
+            {
+                ++m_stats.culled;
+                continue;
+            }
+
+            auto const& tile = m_tree[i];
+            bool refine = tile.first_child != TileTree::npos && must_refine( i, camera.position, k );
+            if ( !refine || m_tree.effective_refine( i ) == TileTree::REFINE_ADD )
+                add_selected( i );
+            if ( refine )
+            {
+                size_t n = m_stack.size();
+                m_tree.for_each_child( i, [&]( index_t c ) { m_stack.push_back( c ); } );
+                // keep the document order
+                std::reverse( m_stack.begin() + n, m_stack.end() );
+            }
+        }
+
+        for ( index_t i : m_previous )
+            if ( m_selected_frame[i] != m_frame )
+                m_removed.push_back( i );
+        return m_selected;
+    }
+
+    std::vector<index_t> const& selected() const { return m_selected; }
+
+    /// @brief Selected now, not selected in the previous frame
+    std::vector<index_t> const& added() const { return m_added; }
+
+    /// @brief Selected in the previous frame, not selected now
+    std::vector<index_t> const& removed() const { return m_removed; }
+
+    stats_t const& stats() const { return m_stats; }
+
+    /// @brief Distance from the point to the tile bounding volume
+    double distance( index_t i, vec3_t const& p ) const
+    {
+        auto const& v = m_volumes[i];
+        if ( v.kind == volume_t::NONE )
+            return 0;
+        vec3_t d = TilesetIndex::sub( p, v.center );
+        if ( v.kind == volume_t::SPHERE )
+            return std::max( 0.0, TilesetIndex::length( d ) - v.radius );
+
+        // the axes of an oriented box are orthogonal, the offset left after
+        // the projections is along the degenerated axes (if any)
+        double r = 0;
+        vec3_t rest = d;
+        for ( auto const& a : v.axes )
+        {
+            double len2 = TilesetIndex::dot( a, a );
+            if ( len2 == 0 )
+                continue;
+            double t = TilesetIndex::dot( d, a ) / len2; // in half lengths
+            rest = TilesetIndex::sub( rest, TilesetIndex::scale( a, t ) );
+            double e = ( std::abs( t ) - 1 ) * std::sqrt( len2 );
+            if ( e > 0 )
+                r += e * e;
+        }
+        r += TilesetIndex::dot( rest, rest );
+        return std::sqrt( r );
+    }
+
+protected:
+    /// @brief Bounding volume in the tileset frame
+    struct volume_t
+    {
+        enum kind_t : uint8_t
+        {
+            NONE,   // no bounding volume: always visible, always refined
+            BOX,    // oriented box
+            SPHERE
+        } kind = NONE;
+        vec3_t center{};
+        vec3_t axes[3]{};
+        double radius = 0;
+    };
+
+    struct cache_t
+    {
+        unsigned frame = 0;  // 0: not valid
+        vec3_t position;    // the camera position of the decision
+        double margin;      // the camera can move this far without changing the decision
+        bool refine;
+    };
+
+    void build_volumes()
+    {
+        m_volumes.assign( m_tree.size(), volume_t{} );
+        std::vector<TilesetIndex::matrix_t> path;
+        m_tree.depth_first( [&]( index_t i, unsigned depth ) {
+            path.resize( depth + 1 );
+            auto m = depth ? path[depth - 1] : TilesetIndex::identity();
+            if ( auto t = m_tree.transform( i ) )
+                m = TilesetIndex::multiply( m, t->matrix4x4 );
+            path[depth] = m;
+
+            auto const& bv = m_tree[i].boundingVolume;
+            volume_t& v = m_volumes[i];
+            if ( auto box = std::get_if<TileTree::box_t>( &bv ) )
+            {
+                v.kind = volume_t::BOX;
+                v.center = TilesetIndex::transform_point( m, { box->box[0], box->box[1], box->box[2] } );
+                for ( int a = 0; a != 3; ++a )
+                    v.axes[a] = TilesetIndex::transform_vector(
+                        m, { box->box[3 + a * 3], box->box[4 + a * 3], box->box[5 + a * 3] } );
+            }
+            else if ( auto sphere = std::get_if<TileTree::sphere_t>( &bv ) )
+            {
+                TilesetIndex::box_t b;
+                TilesetIndex::volume_bounds( bv, m, b );
+                v.kind = volume_t::SPHERE;
+                v.center = TilesetIndex::transform_point( m, { sphere->sphere[0], sphere->sphere[1], sphere->sphere[2] } );
+                v.radius = ( b.max_corner().get<0>() - b.min_corner().get<0>() ) / 2;
+            }
+            else if ( std::holds_alternative<TileTree::region_t>( bv ) )
+            {
+                // the ECEF box around the region
+                TilesetIndex::box_t b;
+                TilesetIndex::volume_bounds( bv, m, b );
+                v.kind = volume_t::BOX;
+                vec3_t lo{ b.min_corner().get<0>(), b.min_corner().get<1>(), b.min_corner().get<2>() };
+                vec3_t hi{ b.max_corner().get<0>(), b.max_corner().get<1>(), b.max_corner().get<2>() };
+                v.center = TilesetIndex::scale( TilesetIndex::add( lo, hi ), 0.5 );
+                for ( int a = 0; a != 3; ++a )
+                {
+                    v.axes[a] = { 0, 0, 0 };
+                    v.axes[a][a] = ( hi[a] - lo[a] ) / 2;
+                }
+            }
+        } );
+    }
+
+    bool visible( index_t i, TilesetIndex::frustum_t const& f ) const
+    {
+        auto const& v = m_volumes[i];
+        if ( v.kind == volume_t::NONE )
+            return true;
+        for ( auto const& p : f.planes )
+        {
+            double s = TilesetIndex::dot( p.n, v.center ) + p.d;
+            double r = v.radius;
+            if ( v.kind == volume_t::BOX )
+                r = std::abs( TilesetIndex::dot( p.n, v.axes[0] ) ) + std::abs( TilesetIndex::dot( p.n, v.axes[1] ) )
+                    + std::abs( TilesetIndex::dot( p.n, v.axes[2] ) );
+            if ( s + r < 0 )
+                return false;
+        }
+        return true;
+    }
+
+    /// @brief SSE test, reusing the previous frame decision when possible
+    ///
+    /// The distance to the volume changes at most by the camera displacement.
+    bool must_refine( index_t i, vec3_t const& eye, double k )
+    {
+        cache_t& c = m_cache[i];
+        if ( c.frame != 0 )
+        {
+            vec3_t d = TilesetIndex::sub( eye, c.position );
+            if ( TilesetIndex::dot( d, d ) < c.margin * c.margin )
+            {
+                ++m_stats.reused;
+                return c.refine;
+            }
+        }
+        double threshold = m_tree[i].geometricError * k;
+        double dist = distance( i, eye );
+        c.frame = m_frame;
+        c.position = eye;
+        c.margin = std::abs( dist - threshold );
+        c.refine = dist < threshold;
+        return c.refine;
+    }
+
+    void add_selected( index_t i )
+    {
+        if ( m_tree[i].uri == TileTree::npos )
+            return; // nothing to render
+        m_selected.push_back( i );
+        if ( m_selected_frame[i] != m_frame - 1 )
+            m_added.push_back( i );
+        m_selected_frame[i] = m_frame;
+    }
+
+    TileTree const& m_tree;
+    view_t m_view;
+    double m_fovy = 0;
+
+    std::vector<volume_t> m_volumes;
+    std::vector<cache_t> m_cache;
+    std::vector<unsigned> m_selected_frame;
+    unsigned m_frame = 0;
+
+    std::vector<index_t> m_stack;
+    std::vector<index_t> m_selected;
+    std::vector<index_t> m_previous;
+    std::vector<index_t> m_added;
+    std::vector<index_t> m_removed;
+    stats_t m_stats{};
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETTRAVERSAL_H
@@ -0,0 +1,603 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETTREE_H
+#define TILESETTREE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "TilesetImage.h"
+#include "TilesetJson.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Append-only string storage with interning
+///
+/// The characters live in fixed size blocks, so a std::string_view returned
+/// by str() stays valid until the arena is destroyed.
+class StringArena
+{
+public:
+    typedef uint32_t index_t;
+    static constexpr index_t npos = ~index_t( 0 );
+
+    StringArena() : m_used( BLOCK_SIZE ) {}
+
+    StringArena( StringArena const& ) = delete;
+    StringArena& operator=( StringArena const& ) = delete;
+    StringArena( StringArena&& ) = default;
+    StringArena& operator=( StringArena&& ) = default;
+
+    /// @brief Store a string (once)
+    /// @return the string id
+    index_t intern( std::string_view s )
+    {
+        auto pos = m_index.find( s );
+        if ( pos != m_index.end() )
+            return pos->second;
+
+        std::string_view stored = store( s );
+        index_t id = index_t( m_strings.size() );
+        m_strings.push_back( stored );
+        m_index.emplace( stored, id );
+        return id;
+    }
+
+    std::string_view str( index_t id ) const
+    {
+        return id == npos ? std::string_view{} : m_strings[id];
+    }
+
+    size_t size() const { return m_strings.size(); }
+
+    /// @brief Bytes allocated for the characters
+    size_t capacity() const
+    {
+        size_t r = m_blocks.size() * BLOCK_SIZE;
+        for ( auto const& b : m_large )
+            r += b.size();
+        return r;
+    }
+
+protected:
+    enum { BLOCK_SIZE = 64 * 1024 };
+
+    std::string_view store( std::string_view s )
+    {
+        if ( s.empty() )
+            return std::string_view( "", 0 ); // no block needed (there may be none yet)
+        if ( s.size() > BLOCK_SIZE / 4 )
+        {
+            // long strings get their own allocation
+            m_large.emplace_back( s );
+            return m_large.back();
+        }
+        if ( m_used + s.size() > BLOCK_SIZE )
+        {
+            m_blocks.emplace_back( new char[BLOCK_SIZE] );
+            m_used = 0;
+        }
+        char* p = m_blocks.back().get() + m_used;
+        std::copy( s.begin(), s.end(), p );
+        m_used += s.size();
+        return std::string_view( p, s.size() );
+    }
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    std::list<std::string> m_large;
+    size_t m_used;
+    std::vector<std::string_view> m_strings;
+    std::unordered_map<std::string_view, index_t> m_index;
+};
+
+/// @brief Compact tile tree
+///
+/// All tiles are stored in one contiguous array. The topology is kept as
+/// first-child/next-sibling indices, bounding volumes are stored inline
+/// and content URIs are interned. Conversion from/to TilesetJson::root_tile_t
+/// keeps the existing API usable.
+class TileTree
+{
+public:
+    typedef uint32_t index_t;
+    static constexpr index_t npos = ~index_t( 0 );
+
+    struct box_t
+    {
+        double box[12];
+    };
+
+    struct region_t
+    {
+        double region[6];
+    };
+
+    struct sphere_t
+    {
+        double sphere[4];
+    };
+
+    typedef std::variant<std::monostate, box_t, region_t, sphere_t> volume_t;
+
+    typedef TilesetJson::transform_t transform_t;
+
+    enum refine_t : uint8_t
+    {
+        REFINE_UNDEFINED, // inherited from the parent
+        REFINE_ADD,
+        REFINE_REPLACE
+    };
+
+    struct tile_t
+    {
+        double geometricError;
+        volume_t boundingVolume;
+        index_t transform;    // index in transforms() or npos
+        index_t uri;          // string id or npos
+        index_t parent;
+        index_t first_child;
+        index_t last_child;
+        index_t next_sibling;
+        refine_t refine;
+    };
+
+public:
+    TileTree() {}
+
+    TileTree( TileTree const& ) = delete;
+    TileTree& operator=( TileTree const& ) = delete;
+    TileTree( TileTree&& ) = default;
+    TileTree& operator=( TileTree&& ) = default;
+
+    /// @brief Build from the document (via TilesetJson::root())
+    explicit TileTree( TilesetJson& doc )
+    {
+        asset = doc.asset();
+        geometricError = doc.geometricError();
+        from_root_tile( doc.root() );
+    }
+
+    TilesetJson::asset_t asset;
+    double geometricError{};
+
+#pragma region construction
+    void reserve( size_t n ) { m_tiles.reserve( n ); }
+
+    /// @brief Append a tile
+    /// @param parent the parent tile or npos for the root
+    /// @return the new tile index
+    index_t add_tile( index_t parent )
+    {
+        index_t i = index_t( m_tiles.size() );
+        m_tiles.push_back( tile_t{ 0.0, {}, npos, npos, parent, npos, npos, npos, REFINE_UNDEFINED } );
+        if ( parent != npos )
+        {
+            tile_t& p = m_tiles[parent];
+            if ( p.last_child == npos )
+                p.first_child = i;
+            else
+                m_tiles[p.last_child].next_sibling = i;
+            p.last_child = i;
+        }
+        return i;
+    }
+
+    void set_uri( index_t i, std::string_view uri )
+    {
+        m_tiles[i].uri = uri.empty() ? npos : m_strings.intern( uri );
+    }
+
+    void set_transform( index_t i, transform_t const& t )
+    {
+        if ( m_tiles[i].transform == npos )
+        {
+            m_tiles[i].transform = index_t( m_transforms.size() );
+            m_transforms.push_back( t );
+        }
+        else
+        {
+            m_transforms[m_tiles[i].transform] = t;
+        }
+    }
+
+    /// @brief Append a copy of a tile of another tree (without the children)
+    index_t append_copy( TileTree const& src, index_t i, index_t parent )
+    {
+        index_t r = add_tile( parent );
+        tile_t const& t = src[i];
+        m_tiles[r].geometricError = t.geometricError;
+        m_tiles[r].boundingVolume = t.boundingVolume;
+        m_tiles[r].refine = parent == npos ? src.effective_refine( i ) : t.refine;
+        if ( t.uri != npos )
+            set_uri( r, src.uri( i ) );
+        if ( auto tr = src.transform( i ) )
+            set_transform( r, *tr );
+        return r;
+    }
+#pragma endregion
+
+#pragma region access
+    size_t size() const { return m_tiles.size(); }
+    bool empty() const { return m_tiles.empty(); }
+
+    index_t root() const { return m_tiles.empty() ? npos : 0; }
+
+    tile_t& operator[]( index_t i ) { return m_tiles[i]; }
+    tile_t const& operator[]( index_t i ) const { return m_tiles[i]; }
+
+    std::vector<tile_t> const& tiles() const { return m_tiles; }
+    std::vector<transform_t> const& transforms() const { return m_transforms; }
+    StringArena const& strings() const { return m_strings; }
+
+    std::string_view uri( index_t i ) const { return m_strings.str( m_tiles[i].uri ); }
+
+    transform_t const* transform( index_t i ) const
+    {
+        auto t = m_tiles[i].transform;
+        return t == npos ? nullptr : &m_transforms[t];
+    }
+
+    /// @brief Refinement in effect for the tile (inherited if not defined)
+    refine_t effective_refine( index_t i ) const
+    {
+        for ( ; i != npos; i = m_tiles[i].parent )
+            if ( m_tiles[i].refine != REFINE_UNDEFINED )
+                return m_tiles[i].refine;
+        return REFINE_ADD;
+    }
+
+    /// @brief JSON pointer of the tile in the tileset.json, e.g. "/root/children/1/children/0"
+    std::string json_pointer( index_t i ) const
+    {
+        std::vector<unsigned> ordinals;
+        for ( ; m_tiles[i].parent != npos; i = m_tiles[i].parent )
+        {
+            unsigned n = 0;
+            for ( index_t c = m_tiles[m_tiles[i].parent].first_child; c != i; c = m_tiles[c].next_sibling )
+                ++n;
+            ordinals.push_back( n );
+        }
+        std::string r = "/root";
+        for ( auto it = ordinals.rbegin(); it != ordinals.rend(); ++it )
+            r += "/children/" + std::to_string( *it );
+        return r;
+    }
+
+    unsigned depth( index_t i ) const
+    {
+        unsigned d = 0;
+        while ( ( i = m_tiles[i].parent ) != npos )
+            ++d;
+        return d;
+    }
+
+    template <typename F>
+    void for_each_child( index_t i, F&& f ) const
+    {
+        for ( index_t c = m_tiles[i].first_child; c != npos; c = m_tiles[c].next_sibling )
+            f( c );
+    }
+
+    /// @brief Pre-order traversal without recursion
+    /// @param f called as f(index, depth)
+    template <typename F>
+    void depth_first( F&& f ) const
+    {
+        if ( m_tiles.empty() )
+            return;
+        index_t i = 0;
+        unsigned d = 0;
+        while ( i != npos )
+        {
+            f( i, d );
+            if ( m_tiles[i].first_child != npos )
+            {
+                i = m_tiles[i].first_child;
+                ++d;
+                continue;
+            }
+            while ( i != npos && m_tiles[i].next_sibling == npos )
+            {
+                i = m_tiles[i].parent;
+                --d;
+            }
+            if ( i != npos )
+                i = m_tiles[i].next_sibling;
+        }
+    }
+
+    /// @brief Approximate memory used by the tree
+    size_t memory_usage() const
+    {
+        return sizeof( *this )
+            + m_tiles.capacity() * sizeof( tile_t )
+            + m_transforms.capacity() * sizeof( transform_t )
+            + m_strings.capacity()
+            + m_strings.size() * ( sizeof( std::string_view ) * 2 + sizeof( index_t ) * 2 );
+    }
+#pragma endregion
+
+#pragma region conversion
+    static volume_t make_volume( TilesetJson::boundingVolume_t const* vp )
+    {
+        volume_t v;
+        if ( auto box = dynamic_cast<TilesetJson::boundingVolumeBox_t const*>( vp ) )
+        {
+            box_t b;
+            std::copy( box->box, box->box + 12, b.box );
+            v = b;
+        }
+        else if ( auto region = dynamic_cast<TilesetJson::boundingVolumeRegion_t const*>( vp ) )
+        {
+            region_t r;
+            std::copy( region->region, region->region + 6, r.region );
+            v = r;
+        }
+        else if ( auto sphere = dynamic_cast<TilesetJson::boundingVolumeSphere_t const*>( vp ) )
+        {
+            sphere_t s;
+            std::copy( sphere->sphere, sphere->sphere + 4, s.sphere );
+            v = s;
+        }
+        return v;
+    }
+
+    static TilesetJson::boundingVolume_t* make_bounding_volume( volume_t const& v )
+    {
+        if ( auto box = std::get_if<box_t>( &v ) )
+        {
+            auto p = new TilesetJson::boundingVolumeBox_t;
+            std::copy( box->box, box->box + 12, p->box );
+            return p;
+        }
+        if ( auto region = std::get_if<region_t>( &v ) )
+        {
+            auto p = new TilesetJson::boundingVolumeRegion_t;
+            std::copy( region->region, region->region + 6, p->region );
+            return p;
+        }
+        if ( auto sphere = std::get_if<sphere_t>( &v ) )
+        {
+            auto p = new TilesetJson::boundingVolumeSphere_t;
+            std::copy( sphere->sphere, sphere->sphere + 4, p->sphere );
+            return p;
+        }
+        return nullptr;
+    }
+
+    /// @brief Replace the tree content with the tile hierarchy
+    void from_root_tile( TilesetJson::root_tile_t const& root )
+    {
+        m_tiles.clear();
+        m_transforms.clear();
+
+        index_t r = append_child( npos, root );
+        m_tiles[r].refine = refine_from_string( root.refine );
+
+        // iterative to survive very deep trees
+        std::vector<std::pair<TilesetJson::child_t const*, index_t>> stack{ { &root, r } };
+        while ( !stack.empty() )
+        {
+            auto [tile, i] = stack.back();
+            stack.pop_back();
+            for ( auto const& ch : tile->children )
+            {
+                index_t c = append_child( i, ch );
+                if ( !ch.children.empty() )
+                    stack.emplace_back( &ch, c );
+            }
+        }
+    }
+
+    /// @brief Convert a sub-tree to the TilesetJson representation
+    TilesetJson::child_t to_child( index_t i ) const
+    {
+        TilesetJson::child_t r;
+        fill_child( i, r );
+        return r;
+    }
+
+    TilesetJson::root_tile_t to_root_tile() const
+    {
+        TilesetJson::root_tile_t r;
+        if ( m_tiles.empty() )
+            return r;
+        fill_child( 0, r );
+        r.refine = refine_to_string( effective_refine( 0 ) );
+        return r;
+    }
+
+    /// @brief Store the tree in the document (asset, geometricError and root)
+    void to_json( TilesetJson& doc ) const
+    {
+        if ( !asset.version.empty() )
+            doc.asset( asset );
+        doc.geometricError( geometricError );
+        doc.root( to_root_tile() );
+    }
+
+    static refine_t refine_from_string( std::string_view s )
+    {
+        if ( s == "ADD" )
+            return REFINE_ADD;
+        if ( s == "REPLACE" )
+            return REFINE_REPLACE;
+        return REFINE_UNDEFINED;
+    }
+
+    static const char* refine_to_string( refine_t r )
+    {
+        return r == REFINE_REPLACE ? "REPLACE" : "ADD";
+    }
+
+    /// @brief Copy the tree from the binary image
+    static TileTree from_image( TilesetImage const& image )
+    {
+        static_assert( int( TilesetImage::REFINE_REPLACE ) == int( REFINE_REPLACE ), "refine_t values" );
+        auto const& h = image.header();
+
+        TileTree r;
+        r.asset.version = image.str( h.asset_version );
+        if ( h.flags & TilesetImage::HAS_GEOREFERENCED )
+            r.asset.extra_ion_georeferenced = ( h.flags & TilesetImage::GEOREFERENCED ) != 0;
+        r.geometricError = h.geometric_error;
+
+        // the string ids are kept
+        for ( uint32_t s = 0; s != h.string_count; ++s )
+            r.m_strings.intern( image.str( s ) );
+        r.m_transforms.resize( h.transform_count );
+        for ( uint32_t t = 0; t != h.transform_count; ++t )
+            std::copy( image.transform( t ), image.transform( t ) + 16, r.m_transforms[t].matrix4x4 );
+
+        r.m_tiles.resize( image.size() );
+        for ( uint32_t i = 0; i != image.size(); ++i )
+        {
+            auto const& src = image.tile( i );
+            tile_t& t = r.m_tiles[i];
+            t.geometricError = src.geometric_error;
+            switch ( src.volume_kind )
+            {
+            case TilesetImage::VOLUME_BOX:
+            {
+                box_t b;
+                std::copy( src.volume, src.volume + 12, b.box );
+                t.boundingVolume = b;
+                break;
+            }
+            case TilesetImage::VOLUME_REGION:
+            {
+                region_t g;
+                std::copy( src.volume, src.volume + 6, g.region );
+                t.boundingVolume = g;
+                break;
+            }
+            case TilesetImage::VOLUME_SPHERE:
+            {
+                sphere_t sp;
+                std::copy( src.volume, src.volume + 4, sp.sphere );
+                t.boundingVolume = sp;
+                break;
+            }
+            }
+            t.transform = src.transform;
+            t.uri = src.uri;
+            t.parent = src.parent;
+            t.first_child = src.first_child;
+            t.last_child = src.last_child;
+            t.next_sibling = src.next_sibling;
+            t.refine = refine_t( src.refine );
+        }
+        return r;
+    }
+
+    /// @brief Write the binary image next to the tileset.json
+    /// @param json the file the tree was loaded from
+    bool write_image( std::string const& json ) const
+    {
+        TilesetImage::writer_t w;
+        w.header.geometric_error = geometricError;
+        w.header.asset_version = asset.version.empty() ? TilesetImage::NONE : uint32_t( m_strings.size() );
+        if ( asset.extra_ion_georeferenced.has_value() )
+            w.header.flags = TilesetImage::HAS_GEOREFERENCED
+                | ( asset.extra_ion_georeferenced.value() ? uint32_t( TilesetImage::GEOREFERENCED ) : 0 );
+
+        w.strings.reserve( m_strings.size() + 1 );
+        for ( size_t s = 0; s != m_strings.size(); ++s )
+            w.strings.push_back( m_strings.str( index_t( s ) ) );
+        if ( !asset.version.empty() )
+            w.strings.push_back( asset.version );
+
+        w.transforms.reserve( m_transforms.size() * 16 );
+        for ( auto const& t : m_transforms )
+            w.transforms.insert( w.transforms.end(), t.matrix4x4, t.matrix4x4 + 16 );
+
+        w.tiles.resize( m_tiles.size() );
+        for ( size_t i = 0; i != m_tiles.size(); ++i )
+        {
+            tile_t const& t = m_tiles[i];
+            TilesetImage::tile_t& dst = w.tiles[i];
+            dst.geometric_error = t.geometricError;
+            if ( auto box = std::get_if<box_t>( &t.boundingVolume ) )
+            {
+                dst.volume_kind = TilesetImage::VOLUME_BOX;
+                std::copy( box->box, box->box + 12, dst.volume );
+            }
+            else if ( auto region = std::get_if<region_t>( &t.boundingVolume ) )
+            {
+                dst.volume_kind = TilesetImage::VOLUME_REGION;
+                std::copy( region->region, region->region + 6, dst.volume );
+            }
+            else if ( auto sphere = std::get_if<sphere_t>( &t.boundingVolume ) )
+            {
+                dst.volume_kind = TilesetImage::VOLUME_SPHERE;
+                std::copy( sphere->sphere, sphere->sphere + 4, dst.volume );
+            }
+            dst.transform = t.transform;
+            dst.uri = t.uri;
+            dst.parent = t.parent;
+            dst.first_child = t.first_child;
+            dst.last_child = t.last_child;
+            dst.next_sibling = t.next_sibling;
+            dst.refine = t.refine;
+        }
+        return w.write( json );
+    }
+#pragma endregion
+
+protected:
+    index_t append_child( index_t parent, TilesetJson::child_t const& ch )
+    {
+        index_t i = add_tile( parent );
+        tile_t& t = m_tiles[i];
+        t.geometricError = ch.geometricError;
+        t.boundingVolume = make_volume( ch.boundingVolume.get() );
+        set_uri( i, ch.content.uri );
+        if ( ch.transform )
+            set_transform( i, *ch.transform );
+        return i;
+    }
+
+    void fill_child( index_t i, TilesetJson::child_t& r ) const
+    {
+        // explicit stack of (tile, destination)
+        std::vector<std::pair<index_t, TilesetJson::child_t*>> stack{ { i, &r } };
+        while ( !stack.empty() )
+        {
+            auto [ti, dst] = stack.back();
+            stack.pop_back();
+
+            tile_t const& t = m_tiles[ti];
+            dst->geometricError = t.geometricError;
+            dst->content.uri = std::string( uri( ti ) );
+            if ( auto tr = transform( ti ) )
+                dst->transform = std::make_unique<transform_t>( *tr );
+            dst->boundingVolume.reset( make_bounding_volume( t.boundingVolume ) );
+
+            for_each_child( ti, [&]( index_t c )
+                {
+                    dst->children.emplace_back();
+                    stack.emplace_back( c, &dst->children.back() );
+                } );
+        }
+    }
+
+    std::vector<tile_t> m_tiles;
+    std::vector<transform_t> m_transforms;
+    StringArena m_strings;
+};
+
+} // namespace
+
+#endif // TILESETTREE_H
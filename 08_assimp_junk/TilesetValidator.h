@@ -0,0 +1,611 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETVALIDATOR_H
+#define TILESETVALIDATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TileComposite.h"
+#include "TileFormat.h"
+#include "TilesetIndex.h"
+#include "TilesetReader.h"
+#include "TilesetWriter.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Consistency checks of a tile tree
+///
+/// - the geometric error does not grow from a parent to a child
+/// - the bounding volumes are well formed and a child volume lies inside the
+///   parent volume (box, region and sphere in any combination)
+/// - the transforms are finite, affine and invertible
+/// - the content files exist and start with a valid header
+///
+/// The tiles near the root are checked first, the subtrees below them are
+/// checked as parallel tasks. Every check needs only the tile and its parent.
+class TilesetValidator
+{
+public:
+    typedef TileTree::index_t index_t;
+    typedef TilesetIndex::vec3_t vec3_t;
+    typedef TilesetIndex::matrix_t matrix_t;
+
+    enum severity_t : uint8_t
+    {
+        SEVERITY_WARNING,
+        SEVERITY_ERROR // not ERROR, <windows.h> defines it
+    };
+
+    enum code_t : uint8_t
+    {
+        GEOMETRIC_ERROR_INVALID,        // negative or not finite
+        GEOMETRIC_ERROR_INCREASES,      // child error > parent error
+        GEOMETRIC_ERROR_NOT_DECREASING, // child error == parent error
+        VOLUME_MISSING,
+        VOLUME_INVALID,
+        VOLUME_NOT_CONTAINED,           // the child volume exceeds the parent volume
+        TRANSFORM_INVALID,
+        CONTENT_MISSING,
+        CONTENT_INVALID
+    };
+
+    struct issue_t
+    {
+        index_t tile;
+        code_t code;
+        severity_t severity;
+        std::string message;
+    };
+
+    struct options_t
+    {
+        unsigned threads = 0;           // 0: std::thread::hardware_concurrency()
+        bool check_content = true;      // open the content files
+        double tolerance = 1e-3;        // containment tolerance (meters)
+    };
+
+    struct report_t
+    {
+        size_t tiles = 0;
+        size_t errors = 0;
+        size_t warnings = 0;
+        std::vector<issue_t> issues;    // ordered by tile
+
+        bool ok() const { return errors == 0; }
+
+        /// @brief Issues of the kind
+        size_t count( code_t code ) const
+        {
+            return size_t( std::count_if( issues.begin(), issues.end(), [&]( issue_t const& i ) { return i.code == code; } ) );
+        }
+    };
+
+    static const char* code_name( code_t c )
+    {
+        static const char* names[] = {
+            "geometric_error_invalid", "geometric_error_increases", "geometric_error_not_decreasing",
+            "volume_missing", "volume_invalid", "volume_not_contained",
+            "transform_invalid", "content_missing", "content_invalid" };
+        return names[c];
+    }
+
+    /// @brief Validate a tree
+    /// @param base_dir the directory of the tileset.json (content uris are relative to it)
+    static report_t validate( TileTree const& tree, std::filesystem::path const& base_dir )
+    {
+        return validate( tree, base_dir, options_t() );
+    }
+
+    static report_t validate( TileTree const& tree, std::filesystem::path const& base_dir, options_t const& options )
+    {
+        TilesetValidator v( tree, base_dir, options );
+        return v.run();
+    }
+
+    static report_t validate( TilesetJson& doc, std::filesystem::path const& base_dir, options_t const& options )
+    {
+        return validate( TileTree( doc ), base_dir, options );
+    }
+
+    /// @brief Load and validate a tileset.json
+    static report_t validate( std::string const& filename )
+    {
+        return validate( filename, options_t() );
+    }
+
+    static report_t validate( std::string const& filename, options_t const& options )
+    {
+        return validate( TilesetReader::load( filename ), std::filesystem::u8path( filename ).parent_path(), options );
+    }
+
+    /// @brief Machine readable report
+    static void write_report( report_t const& report, TileTree const& tree, JsonWriter& w )
+    {
+        w.begin_object();
+        w.key( "tiles" );
+        w.value( double( report.tiles ) );
+        w.key( "errors" );
+        w.value( double( report.errors ) );
+        w.key( "warnings" );
+        w.value( double( report.warnings ) );
+        w.key( "issues" );
+        w.begin_array();
+        for ( auto const& issue : report.issues )
+        {
+            w.begin_object();
+            w.key( "tile" );
+            w.value( double( issue.tile ) );
+            w.key( "path" );
+            w.value( tree.json_pointer( issue.tile ) );
+            if ( tree[issue.tile].uri != TileTree::npos )
+            {
+                w.key( "uri" );
+                w.value( tree.uri( issue.tile ) );
+            }
+            w.key( "severity" );
+            w.value( issue.severity == SEVERITY_ERROR ? "error" : "warning" );
+            w.key( "code" );
+            w.value( code_name( issue.code ) );
+            w.key( "message" );
+            w.value( issue.message );
+            w.end_object();
+        }
+        w.end_array();
+        w.end_object();
+    }
+
+    static std::string report_to_string( report_t const& report, TileTree const& tree, bool pretty = false )
+    {
+        std::string r;
+        {
+            JsonWriter w( r, pretty );
+            write_report( report, tree, w );
+        }
+        return r;
+    }
+
+protected:
+    /// @brief A bounding volume in the tileset frame
+    struct shape_t
+    {
+        enum kind_t : uint8_t
+        {
+            NONE,
+            BOX,
+            SPHERE,
+            REGION
+        } kind = NONE;
+        vec3_t center{};
+        vec3_t axes[3]{};
+        double radius = 0;
+        double region[6]{};
+    };
+
+    /// @brief What a task passes from a tile to its children
+    struct frame_t
+    {
+        matrix_t world;
+        shape_t shape;
+        double geometricError;
+    };
+
+    enum { TASKS_PER_THREAD = 8 };
+
+    TilesetValidator( TileTree const& tree, std::filesystem::path const& base_dir, options_t const& options )
+        : m_tree( tree )
+        , m_base_dir( base_dir )
+        , m_options( options )
+    {
+    }
+
+    report_t run()
+    {
+        report_t report;
+        report.tiles = m_tree.size();
+        if ( m_tree.empty() )
+            return report;
+
+        unsigned threads = m_options.threads ? m_options.threads : std::max( 1u, std::thread::hardware_concurrency() );
+
+        // the top levels, breadth first, until there are enough subtrees
+        std::vector<issue_t> issues;
+        std::unordered_map<index_t, frame_t> top;
+        std::vector<index_t> level{ m_tree.root() };
+        while ( !level.empty() && ( threads == 1 ? level.size() < 2 : level.size() < threads * TASKS_PER_THREAD ) )
+        {
+            std::vector<index_t> next;
+            for ( index_t i : level )
+            {
+                index_t p = m_tree[i].parent;
+                frame_t f;
+                check_tile( i, p == TileTree::npos ? nullptr : &top[p], f, issues );
+                top.emplace( i, f );
+                m_tree.for_each_child( i, [&]( index_t c ) { next.push_back( c ); } );
+            }
+            level.swap( next );
+        }
+
+        // the subtrees below
+        std::vector<std::vector<issue_t>> task_issues( threads );
+        std::atomic<size_t> next_task{ 0 };
+        auto worker = [&]( unsigned t ) {
+            std::vector<frame_t> path;
+            std::vector<std::pair<index_t, unsigned>> stack;
+            for ( size_t k; ( k = next_task++ ) < level.size(); )
+            {
+                index_t r = level[k];
+                frame_t const& parent = top.at( m_tree[r].parent );
+                stack.assign( 1, { r, 0u } );
+                while ( !stack.empty() )
+                {
+                    auto [i, depth] = stack.back();
+                    stack.pop_back();
+                    path.resize( depth + 1 );
+                    check_tile( i, depth ? &path[depth - 1] : &parent, path[depth], task_issues[t] );
+                    m_tree.for_each_child( i, [&, d = depth]( index_t c ) { stack.push_back( { c, d + 1 } ); } );
+                }
+            }
+        };
+        if ( threads == 1 || level.empty() )
+        {
+            worker( 0 );
+        }
+        else
+        {
+            std::vector<std::thread> pool;
+            for ( unsigned t = 0; t != threads; ++t )
+                pool.emplace_back( worker, t );
+            for ( auto& th : pool )
+                th.join();
+        }
+
+        for ( auto& ti : task_issues )
+            issues.insert( issues.end(), std::make_move_iterator( ti.begin() ), std::make_move_iterator( ti.end() ) );
+        std::stable_sort( issues.begin(), issues.end(), []( issue_t const& a, issue_t const& b ) {
+            return a.tile != b.tile ? a.tile < b.tile : a.code < b.code;
+        } );
+        for ( auto const& i : issues )
+            ++( i.severity == SEVERITY_ERROR ? report.errors : report.warnings );
+        report.issues = std::move( issues );
+        return report;
+    }
+
+    /// @brief All the checks of one tile
+    /// @param parent the frame of the parent or nullptr for the root
+    /// @param self [out] the frame of the tile for its children
+    void check_tile( index_t i, frame_t const* parent, frame_t& self, std::vector<issue_t>& issues ) const
+    {
+        auto const& tile = m_tree[i];
+        auto issue = [&]( code_t code, severity_t severity, std::string message ) {
+            issues.push_back( issue_t{ i, code, severity, std::move( message ) } );
+        };
+
+        // geometric error
+        self.geometricError = tile.geometricError;
+        if ( !std::isfinite( tile.geometricError ) || tile.geometricError < 0 )
+        {
+            issue( GEOMETRIC_ERROR_INVALID, SEVERITY_ERROR, "geometricError " + to_string( tile.geometricError ) );
+        }
+        else if ( parent && std::isfinite( parent->geometricError ) )
+        {
+            if ( tile.geometricError > parent->geometricError )
+                issue( GEOMETRIC_ERROR_INCREASES, SEVERITY_ERROR,
+                       "geometricError " + to_string( tile.geometricError ) + " > parent geometricError " + to_string( parent->geometricError ) );
+            else if ( tile.geometricError == parent->geometricError && tile.geometricError > 0 )
+                issue( GEOMETRIC_ERROR_NOT_DECREASING, SEVERITY_WARNING,
+                       "geometricError " + to_string( tile.geometricError ) + " == parent geometricError" );
+        }
+        else if ( !parent && tile.geometricError > m_tree.geometricError )
+        {
+            issue( GEOMETRIC_ERROR_INCREASES, SEVERITY_WARNING,
+                   "root geometricError " + to_string( tile.geometricError ) + " > tileset geometricError " + to_string( m_tree.geometricError ) );
+        }
+
+        // transform
+        self.world = parent ? parent->world : TilesetIndex::identity();
+        if ( auto t = m_tree.transform( i ) )
+        {
+            std::string why;
+            if ( check_transform( t->matrix4x4, why ) )
+                self.world = TilesetIndex::multiply( self.world, t->matrix4x4 );
+            else
+                issue( TRANSFORM_INVALID, SEVERITY_ERROR, why );
+        }
+
+        // bounding volume
+        std::string why;
+        self.shape = shape_t();
+        if ( std::holds_alternative<std::monostate>( tile.boundingVolume ) )
+            issue( VOLUME_MISSING, SEVERITY_ERROR, "no boundingVolume" );
+        else if ( !check_volume( tile.boundingVolume, why ) )
+            issue( VOLUME_INVALID, SEVERITY_ERROR, why );
+        else
+            self.shape = make_shape( tile.boundingVolume, self.world );
+        if ( parent && self.shape.kind != shape_t::NONE && parent->shape.kind != shape_t::NONE
+             && !contains( parent->shape, self.shape, m_options.tolerance, why ) )
+            issue( VOLUME_NOT_CONTAINED, SEVERITY_WARNING, why );
+
+        // content
+        if ( m_options.check_content && tile.uri != TileTree::npos )
+        {
+            std::string_view uri = m_tree.uri( i );
+            uri = uri.substr( 0, uri.find_first_of( "?#" ) );
+            if ( uri.find( "://" ) == std::string_view::npos && uri.compare( 0, 5, "data:" ) != 0 )
+            {
+                auto file = m_base_dir / std::filesystem::u8path( uri );
+                std::error_code ec;
+                TileHeader header;
+                TileComposite composite;
+                if ( !std::filesystem::is_regular_file( file, ec ) )
+                    issue( CONTENT_MISSING, SEVERITY_ERROR, "no such file: " + file.u8string() );
+                else if ( !header.read( file, why ) )
+                    issue( CONTENT_INVALID, SEVERITY_ERROR, why );
+                else if ( header.format == TileHeader::CMPT && !composite.open( file ) )
+                    issue( CONTENT_INVALID, SEVERITY_ERROR, composite.error() );
+            }
+        }
+    }
+
+    static std::string to_string( double d )
+    {
+        char buf[32];
+        auto r = std::to_chars( buf, buf + sizeof( buf ), d );
+        return std::string( buf, r.ptr );
+    }
+
+    static bool finite( double const* v, size_t n )
+    {
+        return std::all_of( v, v + n, []( double d ) { return std::isfinite( d ); } );
+    }
+
+#pragma region checks
+    /// @brief The transform is finite, affine and not singular
+    static bool check_transform( double const* m, std::string& why )
+    {
+        if ( !finite( m, 16 ) )
+            return false_because( why, "the transform is not finite" );
+        if ( m[3] != 0 || m[7] != 0 || m[11] != 0 || m[15] != 1 )
+            return false_because( why, "the transform is not affine (the last row must be 0 0 0 1)" );
+        double det = m[0] * ( m[5] * m[10] - m[9] * m[6] )
+                   - m[4] * ( m[1] * m[10] - m[9] * m[2] )
+                   + m[8] * ( m[1] * m[6] - m[5] * m[2] );
+        double s = 0;
+        for ( int k : { 0, 1, 2, 4, 5, 6, 8, 9, 10 } )
+            s = std::max( s, std::abs( m[k] ) );
+        if ( !( std::abs( det ) > 1e-12 * s * s * s ) )
+            return false_because( why, "the transform is singular" );
+        return true;
+    }
+
+    static bool check_volume( TileTree::volume_t const& v, std::string& why )
+    {
+        if ( auto box = std::get_if<TileTree::box_t>( &v ) )
+        {
+            if ( !finite( box->box, 12 ) )
+                return false_because( why, "the box is not finite" );
+            return true;
+        }
+        if ( auto sphere = std::get_if<TileTree::sphere_t>( &v ) )
+        {
+            if ( !finite( sphere->sphere, 4 ) )
+                return false_because( why, "the sphere is not finite" );
+            if ( sphere->sphere[3] < 0 )
+                return false_because( why, "negative sphere radius" );
+            return true;
+        }
+        if ( auto region = std::get_if<TileTree::region_t>( &v ) )
+        {
+            double const* r = region->region;
+            if ( !finite( r, 6 ) )
+                return false_because( why, "the region is not finite" );
+            if ( r[0] < -M_PI || r[0] > M_PI || r[2] < -M_PI || r[2] > M_PI )
+                return false_because( why, "region longitude outside [-PI, PI]" );
+            if ( r[1] < -M_PI / 2 || r[3] > M_PI / 2 || r[1] > r[3] )
+                return false_because( why, "region latitudes must be south <= north in [-PI/2, PI/2]" );
+            if ( r[4] > r[5] )
+                return false_because( why, "region minimum height > maximum height" );
+            return true;
+        }
+        return true;
+    }
+#pragma endregion
+
+#pragma region containment
+    static shape_t make_shape( TileTree::volume_t const& v, matrix_t const& m )
+    {
+        shape_t s;
+        if ( auto box = std::get_if<TileTree::box_t>( &v ) )
+        {
+            s.kind = shape_t::BOX;
+            s.center = TilesetIndex::transform_point( m, { box->box[0], box->box[1], box->box[2] } );
+            for ( int a = 0; a != 3; ++a )
+                s.axes[a] = TilesetIndex::transform_vector( m, { box->box[3 + a * 3], box->box[4 + a * 3], box->box[5 + a * 3] } );
+        }
+        else if ( auto sphere = std::get_if<TileTree::sphere_t>( &v ) )
+        {
+            s.kind = shape_t::SPHERE;
+            s.center = TilesetIndex::transform_point( m, { sphere->sphere[0], sphere->sphere[1], sphere->sphere[2] } );
+            double k = 0;
+            for ( int col = 0; col != 3; ++col )
+                k = std::max( k, TilesetIndex::length( { m[col * 4], m[col * 4 + 1], m[col * 4 + 2] } ) );
+            s.radius = sphere->sphere[3] * k;
+        }
+        else if ( auto region = std::get_if<TileTree::region_t>( &v ) )
+        {
+            // regions ignore the transforms
+            s.kind = shape_t::REGION;
+            std::copy( region->region, region->region + 6, s.region );
+        }
+        return s;
+    }
+
+    /// @brief ECEF to WGS84 geodetic (radians, meters)
+    static vec3_t ecef_to_cartographic( vec3_t const& p )
+    {
+        const double a = 6378137.0;
+        const double e2 = 6.69437999014e-3;
+        double r = std::hypot( p[0], p[1] );
+        double lon = std::atan2( p[1], p[0] );
+        double lat = std::atan2( p[2], r * ( 1 - e2 ) );
+        double h = 0;
+        for ( int k = 0; k != 5; ++k )
+        {
+            double s = std::sin( lat );
+            double n = a / std::sqrt( 1 - e2 * s * s );
+            h = std::abs( lat ) < M_PI / 4 ? r / std::cos( lat ) - n : p[2] / s - n * ( 1 - e2 );
+            lat = std::atan2( p[2], r * ( 1 - e2 * n / ( n + h ) ) );
+        }
+        return { lon, lat, h };
+    }
+
+    /// @brief The longitude is in [west, east] (east < west crosses the antimeridian)
+    static bool longitude_inside( double lon, double west, double east, double tol )
+    {
+        if ( east < west )
+            east += 2 * M_PI;
+        while ( lon < west - tol )
+            lon += 2 * M_PI;
+        return lon <= east + tol;
+    }
+
+    /// @brief Points of the child volume to test against the parent and their radius
+    static void sample( shape_t const& s, std::vector<vec3_t>& points, double& radius )
+    {
+        points.clear();
+        radius = 0;
+        switch ( s.kind )
+        {
+        case shape_t::BOX:
+            for ( int k = 0; k != 8; ++k )
+            {
+                vec3_t p = s.center;
+                for ( int a = 0; a != 3; ++a )
+                    p = TilesetIndex::add( p, TilesetIndex::scale( s.axes[a], k & ( 1 << a ) ? 1 : -1 ) );
+                points.push_back( p );
+            }
+            break;
+        case shape_t::SPHERE:
+            points.push_back( s.center );
+            radius = s.radius;
+            break;
+        case shape_t::REGION:
+        {
+            // a grid over the surfaces (the region is not convex in ECEF)
+            double w = s.region[0], e = s.region[2];
+            if ( e < w )
+                e += 2 * M_PI;
+            const int n = 4;
+            for ( int i = 0; i <= n; ++i )
+                for ( int j = 0; j <= n; ++j )
+                    for ( double h : { s.region[4], s.region[5] } )
+                        points.push_back( TilesetIndex::cartographic_to_ecef(
+                            w + ( e - w ) * i / n, s.region[1] + ( s.region[3] - s.region[1] ) * j / n, h ) );
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /// @brief The ball (p, r) is inside the volume
+    static bool inside( shape_t const& s, vec3_t const& p, double r, double tol )
+    {
+        switch ( s.kind )
+        {
+        case shape_t::BOX:
+        {
+            vec3_t d = TilesetIndex::sub( p, s.center );
+            vec3_t rest = d;
+            bool flat = false;
+            for ( auto const& a : s.axes )
+            {
+                double len2 = TilesetIndex::dot( a, a );
+                if ( len2 == 0 )
+                {
+                    flat = true;
+                    continue;
+                }
+                double t = TilesetIndex::dot( d, a ) / len2;
+                rest = TilesetIndex::sub( rest, TilesetIndex::scale( a, t ) );
+                if ( std::abs( t ) * std::sqrt( len2 ) + r > std::sqrt( len2 ) + tol )
+                    return false;
+            }
+            // along the degenerated axes (if any)
+            return TilesetIndex::length( rest ) + ( flat ? r : 0 ) <= tol;
+        }
+        case shape_t::SPHERE:
+            return TilesetIndex::length( TilesetIndex::sub( p, s.center ) ) + r <= s.radius + tol;
+        case shape_t::REGION:
+        {
+            vec3_t c = ecef_to_cartographic( p );
+            double angle = ( r + tol ) / 6378137.0;
+            return longitude_inside( c[0], s.region[0] - angle / std::max( std::cos( c[1] ), 1e-6 ), s.region[2] + angle / std::max( std::cos( c[1] ), 1e-6 ), 0 )
+                && c[1] >= s.region[1] - angle && c[1] <= s.region[3] + angle
+                && c[2] - r >= s.region[4] - tol && c[2] + r <= s.region[5] + tol;
+        }
+        default:
+            return true;
+        }
+    }
+
+    static bool contains( shape_t const& parent, shape_t const& child, double tol, std::string& why )
+    {
+        if ( parent.kind == shape_t::REGION && child.kind == shape_t::REGION )
+        {
+            double const* p = parent.region;
+            double const* c = child.region;
+            double angle = tol / 6378137.0;
+            double pw = p[2] < p[0] ? p[2] + 2 * M_PI - p[0] : p[2] - p[0];
+            double cw = c[2] < c[0] ? c[2] + 2 * M_PI - c[0] : c[2] - c[0];
+            double west = c[0];
+            while ( west < p[0] - angle )
+                west += 2 * M_PI;
+            if ( west + cw > p[0] + pw + angle || c[1] < p[1] - angle || c[3] > p[3] + angle
+                 || c[4] < p[4] - tol || c[5] > p[5] + tol )
+                return false_because( why, "the region is outside the parent region" );
+            return true;
+        }
+
+        std::vector<vec3_t> points;
+        double r;
+        sample( child, points, r );
+        for ( auto const& pt : points )
+            if ( !inside( parent, pt, r, tol ) )
+            {
+                static const char* names[] = { "", "box", "sphere", "region" };
+                return false_because( why, std::string( "the " ) + names[child.kind] + " is outside the parent " + names[parent.kind] );
+            }
+        return true;
+    }
+#pragma endregion
+
+    static bool false_because( std::string& why, std::string s )
+    {
+        why = std::move( s );
+        return false;
+    }
+
+    TileTree const& m_tree;
+    std::filesystem::path m_base_dir;
+    options_t m_options;
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETVALIDATOR_H
@@ -0,0 +1,399 @@
+//
+// Created on 2026/10/18
+//
+
+#ifndef TILESETWRITER_H
+#define TILESETWRITER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TilesetTree.h"
+
+namespace cesiumjs
+{
+#if 0
+}
+#endif
+
+/// @brief Buffered JSON output
+///
+/// Writes to a FILE* or appends to a std::string. Doubles are formatted with
+/// std::to_chars, i.e. the shortest text that reads back to the same value.
+class JsonWriter
+{
+public:
+    JsonWriter( std::FILE* f, bool pretty = false )
+        : m_file( f )
+        , m_pretty( pretty )
+    {
+        m_buffer.reserve( BUFFER_SIZE );
+    }
+
+    JsonWriter( std::string& s, bool pretty = false )
+        : m_string( &s )
+        , m_pretty( pretty )
+    {
+        m_buffer.reserve( BUFFER_SIZE );
+    }
+
+    ~JsonWriter() { flush(); }
+
+    JsonWriter( JsonWriter const& ) = delete;
+    JsonWriter& operator=( JsonWriter const& ) = delete;
+
+    /// @param inline_items (pretty mode) keep the members on one line
+    void begin_object( bool inline_items = false ) { open( '{', inline_items ); }
+    void end_object() { close( '}' ); }
+    void begin_array( bool inline_items = false ) { open( '[', inline_items ); }
+    void end_array() { close( ']' ); }
+
+    void key( std::string_view k )
+    {
+        separator();
+        string( k );
+        put( ':' );
+        if ( m_pretty )
+            put( ' ' );
+        m_after_key = true;
+    }
+
+    void value( double d )
+    {
+        separator();
+        number( d );
+    }
+
+    void value( std::string_view s )
+    {
+        separator();
+        string( s );
+    }
+
+    void value( const char* s ) { value( std::string_view( s ) ); }
+
+    void value( bool b )
+    {
+        separator();
+        append( b ? std::string_view( "true" ) : std::string_view( "false" ) );
+    }
+
+    void null_value()
+    {
+        separator();
+        append( "null" );
+    }
+
+    /// @brief Array of numbers
+    void numbers( double const* v, size_t n )
+    {
+        begin_array( true );
+        for ( size_t i = 0; i != n; ++i )
+            value( v[i] );
+        end_array();
+    }
+
+    void flush()
+    {
+        if ( m_buffer.empty() )
+            return;
+        if ( m_file )
+        {
+            if ( std::fwrite( m_buffer.data(), 1, m_buffer.size(), m_file ) != m_buffer.size() )
+                m_failed = true;
+        }
+        else if ( m_string )
+        {
+            m_string->append( m_buffer.data(), m_buffer.size() );
+        }
+        m_buffer.clear();
+    }
+
+    /// @brief A write error happened
+    bool failed() const { return m_failed; }
+
+protected:
+    enum { BUFFER_SIZE = 64 * 1024 };
+
+    struct level_t
+    {
+        bool first;
+        bool inline_items;
+    };
+
+    void put( char c )
+    {
+        if ( m_buffer.size() == BUFFER_SIZE )
+            flush();
+        m_buffer.push_back( c );
+    }
+
+    void append( std::string_view s )
+    {
+        if ( m_buffer.size() + s.size() > BUFFER_SIZE )
+            flush();
+        m_buffer.insert( m_buffer.end(), s.begin(), s.end() );
+    }
+
+    void newline()
+    {
+        put( '\n' );
+        for ( size_t i = 0; i != m_levels.size(); ++i )
+            append( "  " );
+    }
+
+    /// @brief The comma and the indentation before a value or a key
+    void separator()
+    {
+        if ( m_after_key )
+        {
+            m_after_key = false;
+            return;
+        }
+        if ( m_levels.empty() )
+            return;
+        level_t& l = m_levels.back();
+        bool first = l.first;
+        l.first = false;
+        if ( !first )
+            put( ',' );
+        if ( m_pretty )
+        {
+            if ( !l.inline_items )
+                newline();
+            else if ( !first )
+                put( ' ' );
+        }
+    }
+
+    void open( char c, bool inline_items )
+    {
+        separator();
+        put( c );
+        // the items of an inline container's children are inline too
+        bool parent_inline = !m_levels.empty() && m_levels.back().inline_items;
+        m_levels.push_back( level_t{ true, inline_items || parent_inline } );
+    }
+
+    void close( char c )
+    {
+        level_t l = m_levels.back();
+        m_levels.pop_back();
+        if ( m_pretty && !l.first && !l.inline_items )
+            newline();
+        put( c );
+    }
+
+    void number( double d )
+    {
+        if ( !std::isfinite( d ) )
+            throw std::runtime_error( "JSON cannot hold NaN or infinity" );
+        char buf[32];
+        auto r = std::to_chars( buf, buf + sizeof( buf ), d );
+        append( std::string_view( buf, size_t( r.ptr - buf ) ) );
+    }
+
+    void string( std::string_view s )
+    {
+        static const char hex[] = "0123456789abcdef";
+        put( '"' );
+        size_t run = 0;
+        for ( size_t i = 0; i != s.size(); ++i )
+        {
+            unsigned char c = (unsigned char)s[i];
+            if ( c >= 0x20 && c != '"' && c != '\\' )
+                continue;
+            append( s.substr( run, i - run ) );
+            run = i + 1;
+            put( '\\' );
+            switch ( c )
+            {
+            case '"': put( '"' ); break;
+            case '\\': put( '\\' ); break;
+            case '\n': put( 'n' ); break;
+            case '\r': put( 'r' ); break;
+            case '\t': put( 't' ); break;
+            case '\b': put( 'b' ); break;
+            case '\f': put( 'f' ); break;
+            default:
+                append( "u00" );
+                put( hex[c >> 4] );
+                put( hex[c & 15] );
+            }
+        }
+        append( s.substr( run ) );
+        put( '"' );
+    }
+
+    std::FILE* m_file = nullptr;
+    std::string* m_string = nullptr;
+    bool m_pretty;
+    bool m_failed = false;
+    bool m_after_key = false;
+    std::vector<char> m_buffer;
+    std::vector<level_t> m_levels;
+};
+
+/// @brief tileset.json writer for TileTree
+///
+/// Writes the tree straight to the output, no json-c objects in between.
+class TilesetWriter
+{
+public:
+    static void write( TileTree const& tree, JsonWriter& w )
+    {
+        w.begin_object();
+
+        w.key( "asset" );
+        w.begin_object();
+        w.key( "version" );
+        w.value( tree.asset.version.empty() ? std::string_view( "1.0" ) : std::string_view( tree.asset.version ) );
+        if ( tree.asset.extra_ion_georeferenced.has_value() )
+        {
+            w.key( "extras" );
+            w.begin_object();
+            w.key( "ion" );
+            w.begin_object();
+            w.key( "georeferenced" );
+            w.value( tree.asset.extra_ion_georeferenced.value() );
+            w.key( "movable" );
+            w.value( true );
+            w.end_object();
+            w.end_object();
+        }
+        w.end_object();
+
+        w.key( "geometricError" );
+        w.value( tree.geometricError );
+
+        if ( !tree.empty() )
+        {
+            w.key( "root" );
+            write_tiles( tree, w );
+        }
+        w.end_object();
+    }
+
+    static std::string to_string( TileTree const& tree, bool pretty = false )
+    {
+        std::string r;
+        {
+            JsonWriter w( r, pretty );
+            write( tree, w );
+        }
+        return r;
+    }
+
+    static bool save_as( TileTree const& tree, std::string const& filename, bool pretty = false )
+    {
+        std::unique_ptr<std::FILE, int ( * )( std::FILE* )> f( std::fopen( filename.c_str(), "wb" ), &std::fclose );
+        if ( !f )
+            return false;
+        JsonWriter w( f.get(), pretty );
+        write( tree, w );
+        w.flush();
+        return !w.failed();
+    }
+
+protected:
+    typedef TileTree::index_t index_t;
+
+    static void write_volume( TileTree::volume_t const& v, JsonWriter& w )
+    {
+        if ( auto box = std::get_if<TileTree::box_t>( &v ) )
+        {
+            w.key( "boundingVolume" );
+            w.begin_object();
+            w.key( "box" );
+            w.numbers( box->box, 12 );
+            w.end_object();
+        }
+        else if ( auto region = std::get_if<TileTree::region_t>( &v ) )
+        {
+            w.key( "boundingVolume" );
+            w.begin_object();
+            w.key( "region" );
+            w.numbers( region->region, 6 );
+            w.end_object();
+        }
+        else if ( auto sphere = std::get_if<TileTree::sphere_t>( &v ) )
+        {
+            w.key( "boundingVolume" );
+            w.begin_object();
+            w.key( "sphere" );
+            w.numbers( sphere->sphere, 4 );
+            w.end_object();
+        }
+    }
+
+    /// @brief Open the tile object and write everything but the children
+    static void write_tile_head( TileTree const& tree, index_t i, JsonWriter& w )
+    {
+        auto const& t = tree[i];
+        w.begin_object();
+        write_volume( t.boundingVolume, w );
+        w.key( "geometricError" );
+        w.value( t.geometricError );
+        TileTree::refine_t refine = i == tree.root() ? tree.effective_refine( i ) : t.refine;
+        if ( refine != TileTree::REFINE_UNDEFINED )
+        {
+            w.key( "refine" );
+            w.value( TileTree::refine_to_string( refine ) );
+        }
+        if ( t.uri != TileTree::npos )
+        {
+            w.key( "content" );
+            w.begin_object();
+            w.key( "uri" );
+            w.value( tree.uri( i ) );
+            w.end_object();
+        }
+        if ( auto tr = tree.transform( i ) )
+        {
+            w.key( "transform" );
+            w.numbers( tr->matrix4x4, 16 );
+        }
+    }
+
+    /// @brief Write the root and all the descendants without recursion
+    static void write_tiles( TileTree const& tree, JsonWriter& w )
+    {
+        index_t i = tree.root();
+        write_tile_head( tree, i, w );
+        for ( ;; )
+        {
+            if ( tree[i].first_child != TileTree::npos )
+            {
+                w.key( "children" );
+                w.begin_array();
+                i = tree[i].first_child;
+                write_tile_head( tree, i, w );
+                continue;
+            }
+            // close the tile and the finished ancestors
+            w.end_object();
+            while ( i != tree.root() && tree[i].next_sibling == TileTree::npos )
+            {
+                i = tree[i].parent;
+                w.end_array();
+                w.end_object();
+            }
+            if ( i == tree.root() )
+                break;
+            i = tree[i].next_sibling;
+            write_tile_head( tree, i, w );
+        }
+    }
+};
+
+#if 0
+{
+#endif
+} // namespace cesiumjs
+
+#endif // TILESETWRITER_H
@@ -0,0 +1,216 @@
+//
+// Replay a camera path over a tileset: the tiles a viewer would select
+// per frame, the tiles to download and the time spent in the selection.
+//
+// Camera path file: one pose per line
+//     x y z  dx dy dz  ux uy uz
+// (position, view direction, up; separated by spaces or commas, '#' comments)
+//
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+#include <assimp/scene.h>
+
+#include "TilesetReader.h"
+#include "TilesetTraversal.h"
+
+using namespace cesiumjs;
+
+static std::vector<TileSelector::camera_t> read_camera_path(std::string const &filename, double fovy) {
+    std::ifstream is(filename);
+    if (!is)
+        throw std::runtime_error("Cannot open " + filename);
+
+    std::vector<TileSelector::camera_t> path;
+    std::string line;
+    while (std::getline(is, line)) {
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.resize(hash);
+        for (auto &c : line)
+            if (c == ',')
+                c = ' ';
+        std::istringstream ls(line);
+        TileSelector::camera_t cam;
+        cam.fovy = fovy;
+        if (!(ls >> cam.position[0] >> cam.position[1] >> cam.position[2] >> cam.direction[0] >> cam.direction[1] >>
+              cam.direction[2] >> cam.up[0] >> cam.up[1] >> cam.up[2]))
+            continue;
+        path.push_back(cam);
+    }
+    return path;
+}
+
+/// @brief A circle around the root volume, looking at its center
+static std::vector<TileSelector::camera_t> make_orbit(TileTree const &tree, unsigned n, double fovy) {
+    std::vector<TileSelector::camera_t> path;
+    if (tree.empty())
+        return path;
+    // the bounds, the eye and the view are in the world frame: the root
+    // transform is applied to the volume (a region is in ECEF anyway)
+    auto m = TilesetIndex::identity();
+    if (auto t = tree.transform(tree.root()))
+        m = TilesetIndex::multiply(m, t->matrix4x4);
+    auto const &bv = tree[tree.root()].boundingVolume;
+    TilesetIndex::box_t b;
+    if (!TilesetIndex::volume_bounds(bv, m, b))
+        return path;
+
+    TilesetIndex::vec3_t lo{b.min_corner().get<0>(), b.min_corner().get<1>(), b.min_corner().get<2>()};
+    TilesetIndex::vec3_t hi{b.max_corner().get<0>(), b.max_corner().get<1>(), b.max_corner().get<2>()};
+    auto center = TilesetIndex::scale(TilesetIndex::add(lo, hi), 0.5);
+    double radius = TilesetIndex::length(TilesetIndex::sub(hi, lo)) / 2;
+
+    // the orbit is in the xy plane of the root tile, in the tangent plane
+    // at the center for a region
+    TilesetIndex::vec3_t up{0, 0, 1}, x{1, 0, 0};
+    if (std::holds_alternative<TileTree::region_t>(bv)) {
+        if (TilesetIndex::length(center) > radius * 1e-6)
+            up = TilesetIndex::normalize(center);
+        auto east = TilesetIndex::cross({0, 0, 1}, up);
+        if (TilesetIndex::length(east) > 1e-9)
+            x = east;
+    } else {
+        up = TilesetIndex::transform_vector(m, {0, 0, 1});
+        x = TilesetIndex::transform_vector(m, {1, 0, 0});
+    }
+    up = TilesetIndex::normalize(up);
+    x = TilesetIndex::normalize(x);
+    auto y = TilesetIndex::cross(up, x);
+
+    for (unsigned i = 0; i != n; ++i) {
+        double a = 2 * M_PI * i / n;
+        auto offset = TilesetIndex::add(TilesetIndex::scale(x, std::cos(a)), TilesetIndex::scale(y, std::sin(a)));
+        offset = TilesetIndex::add(offset, TilesetIndex::scale(up, 0.5));
+        TileSelector::camera_t cam;
+        cam.fovy = fovy;
+        cam.position = TilesetIndex::add(center, TilesetIndex::scale(offset, radius));
+        cam.direction = TilesetIndex::sub(center, cam.position);
+        cam.up = up;
+        path.push_back(cam);
+    }
+    return path;
+}
+
+int main(int ac, char *av[]) {
+    try {
+        po::options_description desc("Allowed options");
+        // clang-format off
+        desc.add_options()
+            ("help", "produce help message")
+            ("tileset", po::value<std::string>(), "tileset.json")
+            ("path", po::value<std::string>(), "camera path file")
+            ("orbit", po::value<unsigned>()->default_value(0), "generate an orbit with N poses instead of --path")
+            ("width", po::value<unsigned>()->default_value(1920), "viewport width (pixels)")
+            ("height", po::value<unsigned>()->default_value(1080), "viewport height (pixels)")
+            ("fovy", po::value<double>()->default_value(60), "vertical field of view (degrees)")
+            ("sse", po::value<double>()->default_value(16), "maximum screen space error (pixels)")
+            ("repeat", po::value<unsigned>()->default_value(1), "replay the path N times (timing)")
+            ("frames", "print a line per frame");
+        // clang-format on
+        po::positional_options_description pos;
+        pos.add("tileset", 1).add("path", 1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(ac, av).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || !vm.count("tileset")) {
+            std::cout << "Usage: " << av[0] << " tileset.json [camera_path.txt] [options]\n" << desc << "\n";
+            return 0;
+        }
+
+        fs::path tileset = vm["tileset"].as<std::string>();
+        auto t0 = std::chrono::steady_clock::now();
+        TileTree tree = TilesetReader::load(tileset.string());
+        auto t1 = std::chrono::steady_clock::now();
+        std::cout << "tiles: " << tree.size() << ", loaded in "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+
+        double fovy = vm["fovy"].as<double>() * M_PI / 180;
+        std::vector<TileSelector::camera_t> path;
+        if (vm.count("path"))
+            path = read_camera_path(vm["path"].as<std::string>(), fovy);
+        else
+            path = make_orbit(tree, std::max(vm["orbit"].as<unsigned>(), 1u), fovy);
+
+        TileSelector::view_t view;
+        view.width = vm["width"].as<unsigned>();
+        view.height = vm["height"].as<unsigned>();
+        view.max_sse = vm["sse"].as<double>();
+        TileSelector selector(tree, view);
+
+        // content sizes (bandwidth estimate), 0 if the file is not there
+        std::vector<int64_t> bytes(tree.size(), -1);
+        auto content_size = [&](TileTree::index_t i) -> int64_t {
+            if (bytes[i] == -1) {
+                std::error_code ec;
+                auto sz = fs::file_size(tileset.parent_path() / fs::u8path(tree.uri(i)), ec);
+                bytes[i] = ec ? 0 : int64_t(sz);
+            }
+            return bytes[i];
+        };
+
+        bool print_frames = vm.count("frames") != 0;
+        if (print_frames)
+            std::cout << "frame,selected,added,removed,added_bytes,visited,culled,reused,us\n";
+
+        std::vector<char> requested(tree.size(), 0);
+        size_t unique_tiles = 0, selected_total = 0;
+        int64_t unique_bytes = 0;
+        double total_us = 0, max_us = 0;
+        unsigned repeat = std::max(vm["repeat"].as<unsigned>(), 1u);
+        for (unsigned r = 0; r != repeat; ++r) {
+            selector.invalidate();
+            for (size_t f = 0; f != path.size(); ++f) {
+                auto s0 = std::chrono::steady_clock::now();
+                auto const &sel = selector.select(path[f]);
+                auto s1 = std::chrono::steady_clock::now();
+                double us = std::chrono::duration<double, std::micro>(s1 - s0).count();
+                total_us += us;
+                max_us = std::max(max_us, us);
+                selected_total += sel.size();
+
+                int64_t added_bytes = 0;
+                for (auto i : selector.added()) {
+                    added_bytes += content_size(i);
+                    if (!requested[i]) {
+                        requested[i] = 1;
+                        ++unique_tiles;
+                        unique_bytes += content_size(i);
+                    }
+                }
+                if (print_frames && r == 0) {
+                    auto const &st = selector.stats();
+                    std::cout << f << ',' << sel.size() << ',' << selector.added().size() << ','
+                              << selector.removed().size() << ',' << added_bytes << ',' << st.visited << ','
+                              << st.culled << ',' << st.reused << ',' << us << '\n';
+                }
+            }
+        }
+
+        size_t frames = path.size() * repeat;
+        std::cout << "frames: " << frames << "\n"
+                  << "selected per frame: " << (frames ? double(selected_total) / frames : 0) << "\n"
+                  << "tiles requested: " << unique_tiles << " (" << unique_bytes << " bytes)\n"
+                  << "selection time: avg " << (frames ? total_us / frames : 0) << " us, max " << max_us << " us\n";
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    } catch (...) {
+        std::cerr << "Exception of unknown type!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+//
+// Check a tileset: geometric error monotonicity, bounding volume containment,
+// transforms and content file headers. Prints a JSON report, the exit code
+// is 1 if there are errors (warnings do not count unless --strict).
+//
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <assimp/scene.h>
+
+#include "TilesetReader.h"
+#include "TilesetValidator.h"
+#include "TilesetWriter.h"
+
+using namespace cesiumjs;
+
+int main(int ac, char *av[]) {
+    try {
+        po::options_description desc("Allowed options");
+        // clang-format off
+        desc.add_options()
+            ("help", "produce help message")
+            ("tileset", po::value<std::string>(), "tileset.json")
+            ("threads", po::value<unsigned>()->default_value(0), "number of threads (0: all cores)")
+            ("tolerance", po::value<double>()->default_value(1e-3), "bounding volume containment tolerance (meters)")
+            ("no-content", "do not open the content files")
+            ("pretty", "indent the report")
+            ("strict", "fail on warnings too");
+        // clang-format on
+        po::positional_options_description pos;
+        pos.add("tileset", 1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(ac, av).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || !vm.count("tileset")) {
+            std::cout << "Usage: " << av[0] << " tileset.json [options]\n" << desc << "\n";
+            return 0;
+        }
+
+        auto filename = vm["tileset"].as<std::string>();
+        TileTree tree = TilesetReader::load(filename);
+
+        TilesetValidator::options_t options;
+        options.threads = vm["threads"].as<unsigned>();
+        options.tolerance = vm["tolerance"].as<double>();
+        options.check_content = !vm.count("no-content");
+
+        auto t0 = std::chrono::steady_clock::now();
+        auto report = TilesetValidator::validate(tree, std::filesystem::u8path(filename).parent_path(), options);
+        auto t1 = std::chrono::steady_clock::now();
+
+        {
+            JsonWriter w(stdout, vm.count("pretty") != 0);
+            TilesetValidator::write_report(report, tree, w);
+        }
+        std::cout << std::endl;
+        std::cerr << report.tiles << " tiles, " << report.errors << " errors, " << report.warnings << " warnings ("
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms)\n";
+
+        if (!report.ok() || (vm.count("strict") && report.warnings))
+            return 1;
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    } catch (...) {
+        std::cerr << "Exception of unknown type!\n";
+        return 2;
+    }
+    return 0;
+}
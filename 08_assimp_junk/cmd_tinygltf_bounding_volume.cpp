@@ -15,6 +15,8 @@
 #include <cmath>
 #include <algorithm>
 
+#include "TileSphere.h"
+
 #ifndef M_PI
 /** PI definition */
 #define M_PI 3.14159265358979323846
@@ -237,55 +239,25 @@ public:
         return BoundingSphere(center, radius);
     }
     
-    // Calculate optimal bounding sphere using Ritter's algorithm
-    BoundingSphere calculateOptimalBoundingSphere(const std::vector<Vec3>& points) const {
+    // Calculate optimal bounding sphere in linear time (EPOS-Ritter, or Welzl when exact)
+    BoundingSphere calculateOptimalBoundingSphere(const std::vector<Vec3>& points,
+                                                  cesiumjs::TileSphere::quality_t quality = cesiumjs::TileSphere::BALANCED) const {
         if (points.empty()) {
             return BoundingSphere();
         }
         
-        if (points.size() == 1) {
-            return BoundingSphere(points[0], 0);
-        }
-        
-        // Find two points that are farthest apart
-        Vec3 p1 = points[0];
-        Vec3 p2 = points[0];
-        float max_dist_sq = 0;
-        
-        for (size_t i = 0; i < points.size(); ++i) {
-            for (size_t j = i + 1; j < points.size(); ++j) {
-                Vec3 diff = points[i] - points[j];
-                float dist_sq = diff.dot(diff);
-                if (dist_sq > max_dist_sq) {
-                    max_dist_sq = dist_sq;
-                    p1 = points[i];
-                    p2 = points[j];
-                }
-            }
-        }
-        
-        // Initial sphere
-        Vec3 center = (p1 + p2) * 0.5f;
-        float radius = (p2 - p1).length() * 0.5f;
+        auto s = cesiumjs::TileSphere::of_points(&points[0].x, points.size(), sizeof(Vec3), quality);
         
-        // Expand sphere to include all points
-        for (const Vec3& point : points) {
-            Vec3 diff = point - center;
-            float dist = diff.length();
-            
-            if (dist > radius) {
-                float new_radius = (radius + dist) * 0.5f;
-                float factor = new_radius - radius;
-                center = center + diff * (factor / dist);
-                radius = new_radius;
-            }
-        }
-        
-        return BoundingSphere(center, radius);
+        // Rounding the center to float moves it, the radius covers that
+        Vec3 center(static_cast<float>(s[0]), static_cast<float>(s[1]), static_cast<float>(s[2]));
+        double dx = center.x - s[0], dy = center.y - s[1], dz = center.z - s[2];
+        double radius = s[3] + std::sqrt(dx * dx + dy * dy + dz * dz);
+        return BoundingSphere(center, std::nextafter(float(radius), std::numeric_limits<float>::max()));
     }
     
     // Calculate model bounding sphere
-    BoundingSphere calculateModelBoundingSphere() const {
+    BoundingSphere calculateModelBoundingSphere(
+        cesiumjs::TileSphere::quality_t quality = cesiumjs::TileSphere::BALANCED) const {
         std::vector<Vec3> all_vertices;
         
         // Collect all vertices from all meshes
@@ -296,7 +268,7 @@ public:
             }
         }
         
-        return calculateOptimalBoundingSphere(all_vertices);
+        return calculateOptimalBoundingSphere(all_vertices, quality);
     }
     
     // Calculate OBB (simplified - uses AABB as approximation)
@@ -308,7 +280,7 @@ public:
     }
     
     // Print all bounding volume statistics
-    void printAllBoundingVolumes() const {
+    void printAllBoundingVolumes(cesiumjs::TileSphere::quality_t quality = cesiumjs::TileSphere::BALANCED) const {
         std::cout << "\n=== MODEL BOUNDING VOLUMES ===\n";
         
         // AABB
@@ -322,7 +294,7 @@ public:
         sphere_from_aabb.print();
         
         // Optimal Bounding Sphere
-        BoundingSphere optimal_sphere = calculateModelBoundingSphere();
+        BoundingSphere optimal_sphere = calculateModelBoundingSphere(quality);
         std::cout << "\n--- Optimal Bounding Sphere ---\n";
         optimal_sphere.print();
         
@@ -347,7 +319,8 @@ public:
 };
 
 // Example usage
-int main() {
+// Usage: cmd_tinygltf_bounding_volume [model.glb] [--fast|--balanced|--exact]
+int main(int argc, char *argv[]) {
 
     namespace fs = std::filesystem;
     auto test_data = [](const char *relative_path) {
@@ -359,6 +332,22 @@ int main() {
 
     filename = R"(C:\home\work\GM-19017\out\model.glb)";
 
+    auto quality = cesiumjs::TileSphere::BALANCED;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fast")
+            quality = cesiumjs::TileSphere::FAST;
+        else if (arg == "--balanced")
+            quality = cesiumjs::TileSphere::BALANCED;
+        else if (arg == "--exact")
+            quality = cesiumjs::TileSphere::EXACT;
+        else if (arg.rfind("--", 0) == 0) {
+            std::cout << "Usage: " << argv[0] << " [model.glb] [--fast|--balanced|--exact]\n";
+            return 1;
+        } else
+            filename = arg;
+    }
+
     std::cout << "=== TINYGLTF BOUNDING VOLUME CALCULATOR ===\n";
     
     // Load GLTF model
@@ -426,7 +415,7 @@ int main() {
     
     // Calculate bounding volumes
     GLTFBoundingVolumeCalculator calculator(model);
-    calculator.printAllBoundingVolumes();
+    calculator.printAllBoundingVolumes(quality);
     
     // Example: Get just the model AABB
     std::cout << "\n=== QUICK USAGE EXAMPLES ===\n";
@@ -436,7 +425,7 @@ int main() {
               << model_bounds.center().y << ", " << model_bounds.center().z << ")\n";
     std::cout << "Model size: " << model_bounds.diagonal() << "\n";
     
-    BoundingSphere sphere = calculator.calculateModelBoundingSphere();
+    BoundingSphere sphere = calculator.calculateModelBoundingSphere(quality);
     std::cout << "Bounding sphere radius: " << sphere.radius << "\n";
     
     return 0;
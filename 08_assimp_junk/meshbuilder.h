@@ -0,0 +1,334 @@
+#ifndef MESHBUILDER_H
+#define MESHBUILDER_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Call f(begin, end) on the chunks of [0, count) from a few threads
+/// @param threads 0: std::thread::hardware_concurrency(); one chunk runs inline
+template <typename F>
+void parallel_chunks(size_t count, size_t chunk, unsigned threads, F &&f) {
+    chunk = std::max<size_t>(chunk, 1);
+    size_t chunks = (count + chunk - 1) / chunk;
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = unsigned(std::min<size_t>(threads, chunks));
+    if (threads < 2) {
+        for (size_t begin = 0; begin < count; begin += chunk)
+            f(begin, std::min(count, begin + chunk));
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t k; (k = next++) < chunks;)
+            f(k * chunk, std::min(count, (k + 1) * chunk));
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool)
+        th.join();
+}
+
+/// @brief A mesh in flat arrays, no aiFace
+///
+/// The faces are consecutive runs of indices: face_size indices each, or
+/// face_offsets (size = faces + 1) when the sizes differ.
+struct flat_mesh_t {
+    std::string name;
+    unsigned primitive_types = 0; // aiPrimitiveType_* flags
+    std::vector<aiVector3D> positions;
+    std::vector<aiVector3D> normals; // empty or one per position
+    std::vector<aiVector3D> uvs;     // empty or one per position
+    std::vector<aiColor4D> colors;   // empty or one per position
+    std::vector<unsigned> indices;
+    unsigned face_size = 0;            // 0: see face_offsets
+    std::vector<unsigned> face_offsets;
+
+    size_t num_faces() const {
+        return face_size ? indices.size() / face_size : (face_offsets.empty() ? 0 : face_offsets.size() - 1);
+    }
+
+    /// @brief The number of indices of the face f
+    unsigned size_of(size_t f) const { return face_size ? face_size : face_offsets[f + 1] - face_offsets[f]; }
+
+    /// @brief The position of the face f in indices
+    size_t offset_of(size_t f) const { return face_size ? f * face_size : face_offsets[f]; }
+};
+
+/// @brief Index storage for the faces of many meshes
+///
+/// aiFace deletes its mIndices, so the faces built on an arena must be
+/// detached before their mesh is deleted. scene_ptr does it.
+class FaceArena {
+public:
+    unsigned *allocate(size_t n) {
+        m_blocks.emplace_back(new unsigned[n]);
+        return m_blocks.back().get();
+    }
+
+    /// @brief Forget the face indices (owned by an arena)
+    static void detach(aiMesh *mesh) {
+        for (unsigned f = 0; f != mesh->mNumFaces; ++f)
+            mesh->mFaces[f].mIndices = nullptr;
+    }
+
+    static void detach(aiScene *scene) {
+        for (unsigned m = 0; m != scene->mNumMeshes; ++m)
+            detach(scene->mMeshes[m]);
+    }
+
+    size_t blocks() const { return m_blocks.size(); }
+
+private:
+    std::vector<std::unique_ptr<unsigned[]>> m_blocks;
+};
+
+/// @brief Deletes a scene whose meshes use an arena, then the arena
+///
+/// Without an arena it is a plain delete: a std::unique_ptr<aiScene>
+/// converts to scene_ptr.
+struct arena_scene_deleter {
+    std::shared_ptr<FaceArena> arena;
+
+    arena_scene_deleter() = default;
+    arena_scene_deleter(std::shared_ptr<FaceArena> a) : arena(std::move(a)) {}
+    arena_scene_deleter(std::default_delete<aiScene>) {}
+
+    void operator()(aiScene *scene) const {
+        if (!scene)
+            return;
+        if (arena)
+            FaceArena::detach(scene);
+        delete scene;
+    }
+};
+
+typedef std::unique_ptr<aiScene, arena_scene_deleter> scene_ptr;
+
+/// @brief An empty scene with a new arena for the faces of its meshes
+inline scene_ptr new_arena_scene() {
+    auto arena = std::make_shared<FaceArena>();
+    return scene_ptr(new aiScene{}, arena_scene_deleter{arena});
+}
+
+/// @brief The arena of the scene (new_arena_scene())
+inline FaceArena &arena_of(scene_ptr const &scene) {
+    if (!scene.get_deleter().arena)
+        throw std::logic_error("the scene has no face arena");
+    return *scene.get_deleter().arena;
+}
+
+/// @brief Accumulates a mesh in contiguous buffers
+///
+/// Converts to aiMesh with the exact sizes: to_aimesh() allocates the
+/// index array of every face (the aiMesh owns them), to_aimesh(arena) puts
+/// all the indices in one block. flat() gives the buffers as they are.
+class MeshBuilder {
+public:
+    explicit MeshBuilder(std::string name = std::string()) { m.name = std::move(name); }
+
+    void reserve(size_t vertices, size_t indices) {
+        m.positions.reserve(vertices);
+        m.indices.reserve(indices);
+    }
+
+    size_t num_vertices() const { return m.positions.size(); }
+    size_t num_faces() const { return m.num_faces(); }
+
+    /// @return the vertex index
+    unsigned add_vertex(aiVector3D const &p) {
+        m.positions.push_back(p);
+        return unsigned(m.positions.size() - 1);
+    }
+
+    unsigned add_vertex(aiVector3D const &p, aiVector3D const &normal) {
+        m.normals.resize(m.positions.size());
+        m.normals.push_back(normal);
+        return add_vertex(p);
+    }
+
+    unsigned add_vertex(aiVector3D const &p, aiVector3D const &normal, aiVector3D const &uv) {
+        m.uvs.resize(m.positions.size());
+        m.uvs.push_back(uv);
+        return add_vertex(p, normal);
+    }
+
+    /// @brief The color of the last vertex
+    void set_color(aiColor4D const &c) {
+        if (m.positions.empty())
+            throw std::logic_error("set_color() before add_vertex()");
+        m.colors.resize(m.positions.size());
+        m.colors.back() = c;
+    }
+
+    void add_point(unsigned a) { add_face({a}); }
+    void add_line(unsigned a, unsigned b) { add_face({a, b}); }
+    void add_triangle(unsigned a, unsigned b, unsigned c) { add_face({a, b, c}); }
+
+    /// @brief A face of any size (a polygon if more than 3)
+    void add_face(std::initializer_list<unsigned> face) { add_face(face.begin(), unsigned(face.size())); }
+
+    void add_face(unsigned const *face, unsigned n) {
+        if (!n)
+            throw std::invalid_argument("empty face");
+        unsigned faces = unsigned(num_faces());
+        if (faces == 0 && m.face_offsets.empty())
+            m.face_size = n;
+        else if (m.face_size && m.face_size != n) {
+            // the sizes differ from now on
+            m.face_offsets.resize(faces + 1);
+            for (unsigned f = 0; f <= faces; ++f)
+                m.face_offsets[f] = f * m.face_size;
+            m.face_size = 0;
+        }
+        m.indices.insert(m.indices.end(), face, face + n);
+        if (!m.face_size) {
+            if (m.face_offsets.empty())
+                m.face_offsets.push_back(0);
+            m.face_offsets.push_back(unsigned(m.indices.size()));
+        }
+        m.primitive_types |= n == 1 ? aiPrimitiveType_POINT
+                             : n == 2 ? aiPrimitiveType_LINE
+                             : n == 3 ? aiPrimitiveType_TRIANGLE
+                                      : aiPrimitiveType_POLYGON;
+    }
+
+    /// @brief Append a transformed copy of a mesh (its faces follow the current ones)
+    void add_mesh(flat_mesh_t const &mesh, aiMatrix4x4 const &transform) {
+        unsigned base = unsigned(num_vertices());
+        m.positions.reserve(m.positions.size() + mesh.positions.size());
+        for (auto const &p : mesh.positions)
+            m.positions.push_back(transform * p);
+        if (!mesh.normals.empty()) {
+            // the cofactors of the 3x3 part (the inverse transpose up to a scale)
+            auto const &t = transform;
+            aiMatrix4x4 n(t.b2 * t.c3 - t.b3 * t.c2, t.b3 * t.c1 - t.b1 * t.c3, t.b1 * t.c2 - t.b2 * t.c1, 0,
+                          t.a3 * t.c2 - t.a2 * t.c3, t.a1 * t.c3 - t.a3 * t.c1, t.a2 * t.c1 - t.a1 * t.c2, 0,
+                          t.a2 * t.b3 - t.a3 * t.b2, t.a3 * t.b1 - t.a1 * t.b3, t.a1 * t.b2 - t.a2 * t.b1, 0, 0, 0, 0, 1);
+            m.normals.resize(base);
+            for (auto const &v : mesh.normals)
+                m.normals.push_back((n * v).Normalize());
+        }
+        if (!mesh.uvs.empty()) {
+            m.uvs.resize(base);
+            m.uvs.insert(m.uvs.end(), mesh.uvs.begin(), mesh.uvs.end());
+        }
+        if (!mesh.colors.empty()) {
+            m.colors.resize(base);
+            m.colors.insert(m.colors.end(), mesh.colors.begin(), mesh.colors.end());
+        }
+
+        std::vector<unsigned> face;
+        for (size_t f = 0, faces = mesh.num_faces(); f != faces; ++f) {
+            auto first = mesh.indices.begin() + mesh.offset_of(f);
+            face.assign(first, first + mesh.size_of(f));
+            for (auto &i : face)
+                i += base;
+            add_face(face.data(), unsigned(face.size()));
+        }
+    }
+
+    /// @brief The buffers (kept)
+    flat_mesh_t const &mesh() {
+        complete();
+        return m;
+    }
+
+    /// @brief The buffers (the builder is left empty)
+    flat_mesh_t flat() {
+        complete();
+        flat_mesh_t r = std::move(m);
+        m = flat_mesh_t{};
+        return r;
+    }
+
+    /// @brief A new aiMesh, every face owns its indices
+    aiMesh *to_aimesh() {
+        complete();
+        auto mesh = new_mesh();
+        size_t faces = num_faces();
+        for (size_t f = 0; f != faces; ++f) {
+            auto &face = mesh->mFaces[f];
+            face.mNumIndices = m.size_of(f);
+            face.mIndices = new unsigned[face.mNumIndices];
+            std::memcpy(face.mIndices, m.indices.data() + m.offset_of(f), face.mNumIndices * sizeof(unsigned));
+        }
+        return mesh;
+    }
+
+    /// @brief A new aiMesh, the face indices in one arena block
+    ///
+    /// FaceArena::detach() the mesh (or use scene_ptr) before deleting it.
+    aiMesh *to_aimesh(FaceArena &arena) {
+        complete();
+        auto mesh = new_mesh();
+        unsigned *block = arena.allocate(m.indices.size());
+        std::copy(m.indices.begin(), m.indices.end(), block);
+        size_t faces = num_faces();
+        for (size_t f = 0; f != faces; ++f) {
+            mesh->mFaces[f].mNumIndices = m.size_of(f);
+            mesh->mFaces[f].mIndices = block + m.offset_of(f);
+        }
+        return mesh;
+    }
+
+private:
+    /// @brief The per-vertex arrays as long as the positions
+    void complete() {
+        if (!m.normals.empty())
+            m.normals.resize(m.positions.size());
+        if (!m.uvs.empty())
+            m.uvs.resize(m.positions.size());
+        if (!m.colors.empty())
+            m.colors.resize(m.positions.size());
+    }
+
+    /// @brief The mesh without the face indices
+    aiMesh *new_mesh() const {
+        auto mesh = new aiMesh{};
+        mesh->mName = m.name;
+        mesh->mPrimitiveTypes = m.primitive_types;
+        mesh->mNumVertices = unsigned(m.positions.size());
+        mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+        std::copy(m.positions.begin(), m.positions.end(), mesh->mVertices);
+        if (!m.normals.empty()) {
+            mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+            std::copy(m.normals.begin(), m.normals.end(), mesh->mNormals);
+        }
+        if (!m.uvs.empty()) {
+            mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+            mesh->mNumUVComponents[0] = 2;
+            std::copy(m.uvs.begin(), m.uvs.end(), mesh->mTextureCoords[0]);
+        }
+        if (!m.colors.empty()) {
+            mesh->mColors[0] = new aiColor4D[mesh->mNumVertices];
+            std::copy(m.colors.begin(), m.colors.end(), mesh->mColors[0]);
+        }
+        mesh->mNumFaces = unsigned(num_faces());
+        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        return mesh;
+    }
+
+    flat_mesh_t m;
+};
+
+}; // namespace meshtoolbox
+
+#endif
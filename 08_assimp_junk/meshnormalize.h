@@ -0,0 +1,146 @@
+#ifndef MESHNORMALIZE_H
+#define MESHNORMALIZE_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "meshbuilder.h"
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief An axis aligned box in double
+struct bounds_t {
+    double min[3] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max()};
+    double max[3] = {-std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+                     -std::numeric_limits<double>::max()};
+
+    bool empty() const { return min[0] > max[0]; }
+
+    void add(aiVector3D const &p) {
+        double const v[3] = {p.x, p.y, p.z};
+        for (int a = 0; a != 3; ++a) {
+            min[a] = std::min(min[a], v[a]);
+            max[a] = std::max(max[a], v[a]);
+        }
+    }
+
+    bounds_t &operator+=(bounds_t const &o) {
+        for (int a = 0; a != 3; ++a) {
+            min[a] = std::min(min[a], o.min[a]);
+            max[a] = std::max(max[a], o.max[a]);
+        }
+        return *this;
+    }
+
+    double center(int a) const { return 0.5 * (min[a] + max[a]); }
+};
+
+/// @brief The bounds of the vertices of a mesh (parallel chunks)
+inline bounds_t mesh_bounds(aiMesh const *mesh, unsigned threads = 0, size_t chunk = 1 << 16) {
+    bounds_t r;
+    std::mutex guard;
+    parallel_chunks(mesh->mNumVertices, chunk, threads, [&](size_t begin, size_t end) {
+        bounds_t b;
+        for (size_t i = begin; i != end; ++i)
+            b.add(mesh->mVertices[i]);
+        std::lock_guard<std::mutex> lock(guard);
+        r += b;
+    });
+    return r;
+}
+
+/// @brief The bounds of the vertices of all the meshes (the node transforms
+/// are not applied)
+inline bounds_t scene_bounds(aiScene const *scene, unsigned threads = 0, size_t chunk = 1 << 16) {
+    bounds_t r;
+    for (unsigned m = 0; m != scene->mNumMeshes; ++m)
+        if (scene->mMeshes[m])
+            r += mesh_bounds(scene->mMeshes[m], threads, chunk);
+    return r;
+}
+
+/// @brief Where normalize_scene() puts the origin
+enum class origin_t {
+    min,   // the minimum corner of the bounds (the vertices are >= 0)
+    center // the center of the bounds
+};
+
+/// @brief Options of normalize_scene()
+struct normalize_options_t {
+    origin_t origin = origin_t::min;
+    unsigned threads = 0;   // 0: std::thread::hardware_concurrency()
+    size_t chunk = 1 << 16; // vertices per task
+};
+
+/// @brief The offset the normalized vertices are relative to (RTC center)
+struct rtc_offset_t {
+    double offset[3] = {0, 0, 0};
+    bounds_t bounds; // of the original vertices
+
+    /// @brief The translation by offset, column major (as the glTF node
+    /// matrix and the 3D Tiles tile transform)
+    std::array<double, 16> transform() const {
+        return {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, offset[0], offset[1], offset[2], 1};
+    }
+};
+
+/// @brief Subtract the offset from the vertices of all the meshes, in place
+///
+/// The differences are computed in double and rounded once. Many meshes
+/// run in parallel (one thread each), a few big ones with parallel chunks.
+inline void translate_scene(aiScene *scene, double const offset[3], unsigned threads = 0,
+                            size_t chunk = 1 << 16) {
+    auto translate = [offset](aiMesh *mesh, size_t begin, size_t end) {
+        for (size_t i = begin; i != end; ++i) {
+            aiVector3D &v = mesh->mVertices[i];
+            v.x = ai_real(double(v.x) - offset[0]);
+            v.y = ai_real(double(v.y) - offset[1]);
+            v.z = ai_real(double(v.z) - offset[2]);
+        }
+    };
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    if (scene->mNumMeshes >= threads) {
+        parallel_chunks(scene->mNumMeshes, 1, threads, [&](size_t begin, size_t end) {
+            for (size_t m = begin; m != end; ++m)
+                if (aiMesh *mesh = scene->mMeshes[m])
+                    translate(mesh, 0, mesh->mNumVertices);
+        });
+        return;
+    }
+    for (unsigned m = 0; m != scene->mNumMeshes; ++m)
+        if (aiMesh *mesh = scene->mMeshes[m])
+            parallel_chunks(mesh->mNumVertices, chunk, threads,
+                            [&](size_t begin, size_t end) { translate(mesh, begin, end); });
+}
+
+/// @brief Move the scene next to the origin, in place (no scene copy)
+///
+/// The bounds and the offset stay in double: adding the offset to the new
+/// vertices (in double) gives the original ones back to the float precision
+/// near the origin, not to the float precision of the UTM-scale coordinates.
+/// The offset is the RTC center (or the tile transform) of the result.
+inline rtc_offset_t normalize_scene(aiScene *scene, normalize_options_t const &options = {}) {
+    rtc_offset_t r;
+    r.bounds = scene_bounds(scene, options.threads, options.chunk);
+    if (r.bounds.empty())
+        return r;
+    for (int a = 0; a != 3; ++a)
+        r.offset[a] = options.origin == origin_t::min ? r.bounds.min[a] : r.bounds.center(a);
+    translate_scene(scene, r.offset, options.threads, options.chunk);
+    return r;
+}
+
+}; // namespace meshtoolbox
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef MESHREORDER_H
+#define MESHREORDER_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "meshbuilder.h"
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Options of reorder_mesh() and reorder_scene()
+struct reorder_options_t {
+    unsigned cache_size = 16; // the post-transform vertex cache (FIFO) the order targets
+    bool triangles = true;    // the vertex cache order of the triangles
+    bool vertices = true;     // the vertices by first use (fetch locality)
+    unsigned threads = 0;     // meshes in parallel, 0: std::thread::hardware_concurrency()
+};
+
+/// @brief The cache misses of the triangles before and after reorder_mesh()
+struct reorder_stats_t {
+    size_t triangles = 0;
+    size_t misses_before = 0;
+    size_t misses_after = 0;
+
+    /// @brief The average cache miss ratio (the vertices transformed per triangle)
+    double acmr_before() const { return triangles ? double(misses_before) / triangles : 0; }
+    double acmr_after() const { return triangles ? double(misses_after) / triangles : 0; }
+
+    reorder_stats_t &operator+=(reorder_stats_t const &o) {
+        triangles += o.triangles;
+        misses_before += o.misses_before;
+        misses_after += o.misses_after;
+        return *this;
+    }
+};
+
+/// @brief The misses of a FIFO vertex cache over the triangle faces
+inline size_t cache_misses(aiMesh const *mesh, unsigned cache_size = 16) {
+    std::vector<unsigned> stamp(mesh->mNumVertices, 0);
+    size_t misses = 0;
+    for (unsigned f = 0; f != mesh->mNumFaces; ++f) {
+        aiFace const &face = mesh->mFaces[f];
+        if (face.mNumIndices != 3)
+            continue;
+        for (unsigned k = 0; k != 3; ++k) {
+            // in the cache while less than cache_size misses followed its own
+            unsigned &s = stamp[face.mIndices[k]];
+            if (!s || misses - s >= cache_size)
+                s = unsigned(++misses);
+        }
+    }
+    return misses;
+}
+
+/// @brief Reorder the triangles for the vertex cache, then the vertices by
+/// first use, in place
+///
+/// The triangle order is Tipsify (Sander, Nehab, Barczak 2007): fan around
+/// the vertex that stays in the cache the longest, jump to a recent vertex
+/// with triangles left at a dead end. Linear in the triangles. The vertex
+/// arrays are permuted together, the unused vertices go last. Meshes with
+/// non-triangle faces are left alone, meshes with bones or anim meshes keep
+/// their vertex order.
+inline reorder_stats_t reorder_mesh(aiMesh *mesh, reorder_options_t const &options) {
+    reorder_stats_t stats;
+    size_t const n = mesh->mNumVertices, faces = mesh->mNumFaces;
+    for (unsigned f = 0; f != faces; ++f)
+        if (mesh->mFaces[f].mNumIndices != 3)
+            return stats;
+    stats.triangles = faces;
+    stats.misses_before = stats.misses_after = cache_misses(mesh, options.cache_size);
+    if (!faces)
+        return stats;
+
+    std::vector<unsigned> idx(3 * faces);
+    for (unsigned f = 0; f != faces; ++f)
+        std::copy(mesh->mFaces[f].mIndices, mesh->mFaces[f].mIndices + 3, &idx[3 * f]);
+
+    if (options.triangles) {
+        // the triangles of each vertex (CSR) and how many are left
+        std::vector<unsigned> offsets(n + 1, 0), adjacent(3 * faces), live(n, 0);
+        for (unsigned i : idx)
+            ++live[i];
+        for (size_t v = 0; v != n; ++v)
+            offsets[v + 1] = offsets[v] + live[v];
+        std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+        for (unsigned t = 0; t != faces; ++t)
+            for (unsigned k = 0; k != 3; ++k)
+                adjacent[fill[idx[3 * t + k]]++] = t;
+
+        int64_t const k = options.cache_size;
+        std::vector<int64_t> stamp(n, 0);
+        std::vector<uint8_t> emitted(faces, 0);
+        std::vector<unsigned> dead_end, candidates, order;
+        order.reserve(faces);
+        int64_t time = k + 1;
+        size_t cursor = 0;
+        for (int64_t fan = 0; fan >= 0;) {
+            candidates.clear();
+            for (unsigned a = offsets[fan]; a != offsets[fan + 1]; ++a) {
+                unsigned t = adjacent[a];
+                if (emitted[t])
+                    continue;
+                emitted[t] = 1;
+                order.push_back(t);
+                for (unsigned c = 0; c != 3; ++c) {
+                    unsigned v = idx[3 * t + c];
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    --live[v];
+                    if (time - stamp[v] > k)
+                        stamp[v] = time++;
+                }
+            }
+
+            // the candidate that stays in the cache during its whole fan
+            fan = -1;
+            int64_t best = -1;
+            for (unsigned v : candidates) {
+                if (!live[v])
+                    continue;
+                int64_t age = time - stamp[v];
+                int64_t priority = age + 2 * int64_t(live[v]) <= k ? age : 0;
+                if (priority > best) {
+                    best = priority;
+                    fan = v;
+                }
+            }
+            if (fan >= 0)
+                continue;
+            // a dead end: the most recent vertex with triangles left, else the next one
+            while (!dead_end.empty() && fan < 0) {
+                unsigned v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v])
+                    fan = v;
+            }
+            while (fan < 0 && cursor != n)
+                if (live[cursor++])
+                    fan = int64_t(cursor - 1);
+        }
+
+        std::vector<unsigned> reordered(3 * faces);
+        for (size_t t = 0; t != faces; ++t)
+            std::copy(&idx[3 * order[t]], &idx[3 * order[t] + 3], &reordered[3 * t]);
+        idx.swap(reordered);
+    }
+
+    if (options.vertices && !mesh->mNumBones && !mesh->mNumAnimMeshes) {
+        // the new number of each vertex, by first use
+        std::vector<unsigned> remap(n, ~0u);
+        unsigned next = 0;
+        for (unsigned &i : idx) {
+            if (remap[i] == ~0u)
+                remap[i] = next++;
+            i = remap[i];
+        }
+        for (auto &r : remap)
+            if (r == ~0u)
+                r = next++;
+
+        auto permute = [&](auto *a) {
+            if (!a)
+                return;
+            std::vector<std::remove_reference_t<decltype(*a)>> c(a, a + n);
+            for (size_t i = 0; i != n; ++i)
+                a[remap[i]] = c[i];
+        };
+        permute(mesh->mVertices);
+        permute(mesh->mNormals);
+        permute(mesh->mTangents);
+        permute(mesh->mBitangents);
+        for (auto *c : mesh->mColors)
+            permute(c);
+        for (auto *t : mesh->mTextureCoords)
+            permute(t);
+    }
+
+    for (unsigned f = 0; f != faces; ++f)
+        std::copy(&idx[3 * f], &idx[3 * f + 3], mesh->mFaces[f].mIndices);
+    stats.misses_after = cache_misses(mesh, options.cache_size);
+    return stats;
+}
+
+/// @brief reorder_mesh() on every mesh of the scene, in parallel
+/// @param per_mesh the stats of each mesh (optional)
+inline reorder_stats_t reorder_scene(aiScene *scene, reorder_options_t const &options,
+                                     std::vector<reorder_stats_t> *per_mesh = nullptr) {
+    std::vector<reorder_stats_t> stats(scene->mNumMeshes);
+    parallel_chunks(scene->mNumMeshes, 1, options.threads, [&](size_t begin, size_t end) {
+        for (size_t m = begin; m != end; ++m)
+            stats[m] = reorder_mesh(scene->mMeshes[m], options);
+    });
+
+    reorder_stats_t total;
+    for (auto const &s : stats)
+        total += s;
+    if (per_mesh)
+        *per_mesh = std::move(stats);
+    return total;
+}
+
+}; // namespace meshtoolbox
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef MESHREPAIR_H
+#define MESHREPAIR_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "meshbuilder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHREPAIR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Options of repair_mesh() and repair_scene()
+struct repair_options_t {
+    /// a triangle is degenerate when |e1 x e2| <= epsilon * (longest edge)^2
+    double epsilon = 1e-9;
+    bool remove_degenerate = true;
+    bool remove_duplicates = true; // the same vertices in the same winding
+    bool compact_vertices = true;  // drop the vertices no face uses
+    unsigned threads = 0;          // 0: std::thread::hardware_concurrency()
+    size_t chunk = 1 << 14;        // faces per task
+    /// the face indices are in a FaceArena (to_aimesh(arena)): the removed
+    /// faces are detached, not deleted
+    bool arena = false;
+};
+
+/// @brief What repair_mesh() found (and removed)
+struct repair_stats_t {
+    size_t degenerate = 0;
+    size_t duplicates = 0;
+    size_t unused_vertices = 0;
+
+    repair_stats_t &operator+=(repair_stats_t const &o) {
+        degenerate += o.degenerate;
+        duplicates += o.duplicates;
+        unused_vertices += o.unused_vertices;
+        return *this;
+    }
+};
+
+/// @brief The area test of degenerate_faces() on triangles in SoA form
+///
+/// e holds 6 rows of n values: the edges p1 - p0 (x, y, z), then p2 - p0
+/// (x, y, z). out[k] is set when |e1 x e2|^2 <= eps2 * (longest edge)^4.
+/// Two triangles per SSE2 step (the same double arithmetic as the scalar
+/// loop, which does the rest).
+inline void small_area_kernel(double const *e, size_t n, double eps2, uint8_t *out) {
+    double const *ax = e, *ay = e + n, *az = e + 2 * n;
+    double const *bx = e + 3 * n, *by = e + 4 * n, *bz = e + 5 * n;
+    size_t k = 0;
+#ifdef MESHREPAIR_SSE2
+    __m128d const e2 = _mm_set1_pd(eps2);
+    auto dot = [](__m128d x, __m128d y, __m128d z) {
+        return _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)), _mm_mul_pd(z, z));
+    };
+    for (; k + 2 <= n; k += 2) {
+        __m128d x1 = _mm_loadu_pd(ax + k), y1 = _mm_loadu_pd(ay + k), z1 = _mm_loadu_pd(az + k);
+        __m128d x2 = _mm_loadu_pd(bx + k), y2 = _mm_loadu_pd(by + k), z2 = _mm_loadu_pd(bz + k);
+        __m128d cx = _mm_sub_pd(_mm_mul_pd(y1, z2), _mm_mul_pd(z1, y2));
+        __m128d cy = _mm_sub_pd(_mm_mul_pd(z1, x2), _mm_mul_pd(x1, z2));
+        __m128d cz = _mm_sub_pd(_mm_mul_pd(x1, y2), _mm_mul_pd(y1, x2));
+        __m128d area2 = dot(cx, cy, cz);
+        __m128d a2 = dot(x1, y1, z1), b2 = dot(x2, y2, z2);
+        __m128d c2 = dot(_mm_sub_pd(x2, x1), _mm_sub_pd(y2, y1), _mm_sub_pd(z2, z1));
+        __m128d l2 = _mm_max_pd(a2, _mm_max_pd(b2, c2));
+        int m = _mm_movemask_pd(_mm_cmple_pd(area2, _mm_mul_pd(e2, _mm_mul_pd(l2, l2))));
+        out[k] = uint8_t(m & 1);
+        out[k + 1] = uint8_t(m >> 1);
+    }
+#endif
+    for (; k != n; ++k) {
+        double cx = ay[k] * bz[k] - az[k] * by[k];
+        double cy = az[k] * bx[k] - ax[k] * bz[k];
+        double cz = ax[k] * by[k] - ay[k] * bx[k];
+        double area2 = cx * cx + cy * cy + cz * cz;
+        double a2 = ax[k] * ax[k] + ay[k] * ay[k] + az[k] * az[k];
+        double b2 = bx[k] * bx[k] + by[k] * by[k] + bz[k] * bz[k];
+        double dx = bx[k] - ax[k], dy = by[k] - ay[k], dz = bz[k] - az[k];
+        double c2 = dx * dx + dy * dy + dz * dz;
+        double l2 = std::max(a2, std::max(b2, c2));
+        out[k] = uint8_t(area2 <= eps2 * l2 * l2);
+    }
+}
+
+/// @brief Mark the degenerate triangles (repeated indices or no area)
+///
+/// Other faces are never marked. Each face range gathers the edges of its
+/// triangles into arrays (SoA) and runs small_area_kernel() on them.
+/// @return one flag per face
+inline std::vector<uint8_t> degenerate_faces(aiMesh const *mesh,
+                                             double epsilon = 1e-9,
+                                             unsigned threads = 0,
+                                             size_t chunk = 1 << 14) {
+    std::vector<uint8_t> r(mesh->mNumFaces, 0);
+    aiVector3D const *v = mesh->mVertices;
+    aiFace const *faces = mesh->mFaces;
+    double const eps2 = epsilon * epsilon;
+    parallel_chunks(mesh->mNumFaces, chunk, threads, [&](size_t begin, size_t end) {
+        size_t const n = end - begin;
+        std::vector<double> e(6 * n, 0.0); // the other faces: no edges, masked below
+        std::vector<uint8_t> triangle(n, 0), small(n);
+        for (size_t k = 0; k != n; ++k) {
+            aiFace const &face = faces[begin + k];
+            if (face.mNumIndices != 3)
+                continue;
+            unsigned const *i = face.mIndices;
+            aiVector3D const &p0 = v[i[0]], &p1 = v[i[1]], &p2 = v[i[2]];
+            e[k] = double(p1.x) - p0.x;
+            e[n + k] = double(p1.y) - p0.y;
+            e[2 * n + k] = double(p1.z) - p0.z;
+            e[3 * n + k] = double(p2.x) - p0.x;
+            e[4 * n + k] = double(p2.y) - p0.y;
+            e[5 * n + k] = double(p2.z) - p0.z;
+            triangle[k] = 1;
+            r[begin + k] = uint8_t((i[0] == i[1]) | (i[1] == i[2]) | (i[0] == i[2]));
+        }
+        small_area_kernel(e.data(), n, eps2, small.data());
+        for (size_t k = 0; k != n; ++k)
+            r[begin + k] |= small[k] & triangle[k];
+    });
+    return r;
+}
+
+/// @brief Remove the degenerate and duplicate faces, then the unused vertices
+///
+/// The kept faces keep their index arrays (moved, not copied). The vertices
+/// are not compacted when the mesh has bones or animation meshes (they
+/// refer to the vertex numbers).
+inline repair_stats_t repair_mesh(aiMesh *mesh, repair_options_t const &options) {
+    repair_stats_t stats;
+    std::vector<uint8_t> remove = options.remove_degenerate
+                                      ? degenerate_faces(mesh, options.epsilon, options.threads, options.chunk)
+                                      : std::vector<uint8_t>(mesh->mNumFaces, 0);
+    for (auto d : remove)
+        stats.degenerate += d;
+
+    if (options.remove_duplicates) {
+        struct hash_t {
+            size_t operator()(std::array<unsigned, 3> const &k) const {
+                return (size_t(k[0]) * 73856093u) ^ (size_t(k[1]) * 19349663u) ^ (size_t(k[2]) * 83492791u);
+            }
+        };
+        std::unordered_set<std::array<unsigned, 3>, hash_t> seen;
+        seen.reserve(mesh->mNumFaces);
+        for (unsigned f = 0; f != mesh->mNumFaces; ++f) {
+            aiFace const &face = mesh->mFaces[f];
+            if (remove[f] || face.mNumIndices != 3)
+                continue;
+            // the rotation starting at the smallest index
+            unsigned const *i = face.mIndices;
+            unsigned s = i[0] < i[1] ? (i[0] < i[2] ? 0 : 2) : (i[1] < i[2] ? 1 : 2);
+            std::array<unsigned, 3> key{i[s], i[(s + 1) % 3], i[(s + 2) % 3]};
+            if (!seen.insert(key).second) {
+                remove[f] = 1;
+                ++stats.duplicates;
+            }
+        }
+    }
+
+    if (stats.degenerate || stats.duplicates) {
+        unsigned kept = unsigned(mesh->mNumFaces - stats.degenerate - stats.duplicates);
+        aiFace *faces = new aiFace[kept];
+        for (unsigned f = 0, k = 0; f != mesh->mNumFaces; ++f)
+            if (!remove[f]) {
+                faces[k].mNumIndices = mesh->mFaces[f].mNumIndices;
+                faces[k++].mIndices = mesh->mFaces[f].mIndices;
+                mesh->mFaces[f].mIndices = nullptr;
+            }
+        if (options.arena)
+            FaceArena::detach(mesh); // the removed ones
+        delete[] mesh->mFaces;
+        mesh->mFaces = faces;
+        mesh->mNumFaces = kept;
+    }
+
+    if (!options.compact_vertices || mesh->mNumBones || mesh->mNumAnimMeshes)
+        return stats;
+
+    std::vector<unsigned> remap(mesh->mNumVertices, 0);
+    for (unsigned f = 0; f != mesh->mNumFaces; ++f)
+        for (unsigned k = 0; k != mesh->mFaces[f].mNumIndices; ++k)
+            remap[mesh->mFaces[f].mIndices[k]] = 1;
+    unsigned used = 0;
+    for (auto &r : remap)
+        r = r ? used++ : ~0u;
+    stats.unused_vertices = mesh->mNumVertices - used;
+    if (!stats.unused_vertices)
+        return stats;
+
+    auto compact = [&](auto *&a) {
+        if (!a)
+            return;
+        auto *c = new std::remove_reference_t<decltype(*a)>[used];
+        for (unsigned i = 0; i != mesh->mNumVertices; ++i)
+            if (remap[i] != ~0u)
+                c[remap[i]] = a[i];
+        delete[] a;
+        a = c;
+    };
+    compact(mesh->mVertices);
+    compact(mesh->mNormals);
+    compact(mesh->mTangents);
+    compact(mesh->mBitangents);
+    for (auto &c : mesh->mColors)
+        compact(c);
+    for (auto &t : mesh->mTextureCoords)
+        compact(t);
+    mesh->mNumVertices = used;
+
+    parallel_chunks(mesh->mNumFaces, options.chunk, options.threads, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f != end; ++f)
+            for (unsigned k = 0; k != mesh->mFaces[f].mNumIndices; ++k)
+                mesh->mFaces[f].mIndices[k] = remap[mesh->mFaces[f].mIndices[k]];
+    });
+    return stats;
+}
+
+/// @brief repair_mesh() on every mesh of the scene
+///
+/// Many meshes are repaired in parallel (one thread each), a few big ones
+/// one after the other with parallel face ranges.
+/// @param per_mesh the stats of each mesh (optional)
+inline repair_stats_t repair_scene(aiScene *scene, repair_options_t const &options,
+                                   std::vector<repair_stats_t> *per_mesh = nullptr) {
+    std::vector<repair_stats_t> stats(scene->mNumMeshes);
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    if (scene->mNumMeshes >= threads) {
+        repair_options_t single = options;
+        single.threads = 1;
+        parallel_chunks(scene->mNumMeshes, 1, threads, [&](size_t begin, size_t end) {
+            for (size_t m = begin; m != end; ++m)
+                stats[m] = repair_mesh(scene->mMeshes[m], single);
+        });
+    } else {
+        for (unsigned m = 0; m != scene->mNumMeshes; ++m)
+            stats[m] = repair_mesh(scene->mMeshes[m], options);
+    }
+
+    repair_stats_t total;
+    for (auto const &s : stats)
+        total += s;
+    if (per_mesh)
+        *per_mesh = std::move(stats);
+    return total;
+}
+
+/// @brief repair_scene() knowing whether the faces are on the scene arena
+inline repair_stats_t repair_scene(scene_ptr const &scene, repair_options_t options,
+                                   std::vector<repair_stats_t> *per_mesh = nullptr) {
+    options.arena = bool(scene.get_deleter().arena);
+    return repair_scene(scene.get(), options, per_mesh);
+}
+
+}; // namespace meshtoolbox
+
+#endif
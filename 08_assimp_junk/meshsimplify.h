@@ -0,0 +1,359 @@
+#ifndef MESHSIMPLIFY_H
+#define MESHSIMPLIFY_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "meshbuilder.h"
+#include "meshrepair.h"
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Options of simplify_mesh() and simplify_scene()
+struct simplify_options_t {
+    double target_ratio = 0.5; // of the triangles of each mesh
+    size_t target_faces = 0;   // per mesh, overrides target_ratio
+    /// no collapse moves the surface farther than this (model units)
+    double max_error = std::numeric_limits<double>::infinity();
+    /// the open edges stay where they are (the neighbour tiles keep matching);
+    /// otherwise they collapse along themselves
+    bool lock_boundary = true;
+    unsigned threads = 0; // meshes in parallel, 0: std::thread::hardware_concurrency()
+    /// the face indices are in a FaceArena (to_aimesh(arena)): the collapsed
+    /// faces are detached, not deleted
+    bool arena = false;
+};
+
+/// @brief What simplify_mesh() did
+struct simplify_stats_t {
+    size_t faces_before = 0;
+    size_t faces_after = 0;
+    size_t vertices_before = 0;
+    size_t vertices_after = 0;
+    double error = 0; // the largest collapse error, model units (the tile geometricError)
+
+    simplify_stats_t &operator+=(simplify_stats_t const &o) {
+        faces_before += o.faces_before;
+        faces_after += o.faces_after;
+        vertices_before += o.vertices_before;
+        vertices_after += o.vertices_after;
+        error = std::max(error, o.error);
+        return *this;
+    }
+};
+
+/// @brief The sum of the squared distances to a set of planes
+struct quadric_t {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    /// @brief The plane n.p + d = 0 (n is a unit vector)
+    static quadric_t plane(double a, double b, double c, double d) {
+        return {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+    }
+
+    quadric_t &operator+=(quadric_t const &o) {
+        a2 += o.a2, ab += o.ab, ac += o.ac, ad += o.ad, b2 += o.b2;
+        bc += o.bc, bd += o.bd, c2 += o.c2, cd += o.cd, d2 += o.d2;
+        return *this;
+    }
+
+    double operator()(double x, double y, double z) const {
+        double e = a2 * x * x + b2 * y * y + c2 * z * z + d2 +
+                   2 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+        return std::max(e, 0.0);
+    }
+};
+
+/// @brief Reduce the triangles of a mesh by quadric error edge collapses
+///
+/// A vertex collapses onto a neighbour (a half edge collapse: no new
+/// positions, the attributes of the kept vertices stay valid) in the order
+/// of the smallest quadric error, until the target count or max_error.
+/// The vertices on UV seams (and other attribute splits), on non-manifold
+/// edges and, with lock_boundary, on the open edges never move; no collapse
+/// flips a triangle or breaks the manifold (the link condition). The
+/// quadric error bounds the distance to the original planes, the largest
+/// one is reported. Meshes with bones, anim meshes or non-triangle faces
+/// are left alone; weld_mesh() the plain duplicates first (they look like
+/// seams).
+inline simplify_stats_t simplify_mesh(aiMesh *mesh, simplify_options_t const &options) {
+    simplify_stats_t stats;
+    size_t const n = stats.vertices_before = stats.vertices_after = mesh->mNumVertices;
+    size_t const faces = stats.faces_before = stats.faces_after = mesh->mNumFaces;
+    if (!n || !faces || mesh->mNumBones || mesh->mNumAnimMeshes)
+        return stats;
+    for (unsigned f = 0; f != faces; ++f)
+        if (mesh->mFaces[f].mNumIndices != 3)
+            return stats;
+    size_t const target = options.target_faces ? options.target_faces : size_t(faces * options.target_ratio);
+    if (target >= faces)
+        return stats;
+
+    // the position of each vertex: the first vertex at the same place
+    std::vector<double> p(3 * n);
+    for (size_t i = 0; i != n; ++i) {
+        p[3 * i] = mesh->mVertices[i].x;
+        p[3 * i + 1] = mesh->mVertices[i].y;
+        p[3 * i + 2] = mesh->mVertices[i].z;
+    }
+    std::vector<unsigned> pos(n), order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](unsigned a, unsigned b) {
+        return std::lexicographical_compare(&p[3 * a], &p[3 * a + 3], &p[3 * b], &p[3 * b + 3]) ||
+               (std::equal(&p[3 * a], &p[3 * a + 3], &p[3 * b]) && a < b);
+    };
+    std::sort(order.begin(), order.end(), less);
+    std::vector<uint8_t> locked(n, 0), border(n, 0);
+    for (size_t s = 0; s != n; ++s) {
+        unsigned i = order[s];
+        bool same = s && std::equal(&p[3 * i], &p[3 * i + 3], &p[3 * order[s - 1]]);
+        pos[i] = same ? pos[order[s - 1]] : i;
+        if (same)
+            locked[pos[i]] = 1; // a seam
+    }
+
+    std::vector<unsigned> idx(3 * faces);
+    std::vector<uint8_t> dead(faces, 0);
+    std::vector<std::vector<unsigned>> faces_of(n); // by position
+    for (unsigned f = 0; f != faces; ++f)
+        for (unsigned k = 0; k != 3; ++k) {
+            idx[3 * f + k] = mesh->mFaces[f].mIndices[k];
+            faces_of[pos[idx[3 * f + k]]].push_back(f);
+        }
+    auto at = [&](unsigned f, unsigned k) { return pos[idx[3 * f + k]]; };
+    auto normal = [&](unsigned a, unsigned b, unsigned c, double *r) {
+        double u[3], v[3];
+        for (int j = 0; j != 3; ++j) {
+            u[j] = p[3 * b + j] - p[3 * a + j];
+            v[j] = p[3 * c + j] - p[3 * a + j];
+        }
+        r[0] = u[1] * v[2] - u[2] * v[1];
+        r[1] = u[2] * v[0] - u[0] * v[2];
+        r[2] = u[0] * v[1] - u[1] * v[0];
+    };
+
+    // the face planes, the open edges (one face) and the non-manifold ones
+    std::vector<quadric_t> q(n);
+    std::unordered_map<uint64_t, unsigned> edges;
+    edges.reserve(3 * faces);
+    auto edge_key = [](unsigned a, unsigned b) { return uint64_t(std::min(a, b)) << 32 | std::max(a, b); };
+    for (unsigned f = 0; f != faces; ++f) {
+        unsigned a = at(f, 0), b = at(f, 1), c = at(f, 2);
+        double nr[3];
+        normal(a, b, c, nr);
+        double l = std::sqrt(nr[0] * nr[0] + nr[1] * nr[1] + nr[2] * nr[2]);
+        if (l > 0) {
+            auto plane = quadric_t::plane(nr[0] / l, nr[1] / l, nr[2] / l,
+                                          -(nr[0] * p[3 * a] + nr[1] * p[3 * a + 1] + nr[2] * p[3 * a + 2]) / l);
+            q[a] += plane, q[b] += plane, q[c] += plane;
+        }
+        for (unsigned k = 0; k != 3; ++k)
+            ++edges[edge_key(at(f, k), at(f, (k + 1) % 3))];
+    }
+    for (unsigned f = 0; f != faces; ++f)
+        for (unsigned k = 0; k != 3; ++k) {
+            unsigned a = at(f, k), b = at(f, (k + 1) % 3);
+            unsigned count = edges[edge_key(a, b)];
+            if (count > 2 || a == b)
+                locked[a] = locked[b] = 1;
+            if (count != 1)
+                continue;
+            border[a] = border[b] = 1;
+            if (options.lock_boundary) {
+                locked[a] = locked[b] = 1;
+                continue;
+            }
+            // the plane along the open edge, perpendicular to the face
+            double nr[3], e[3], m[3];
+            normal(a, b, at(f, (k + 2) % 3), nr);
+            for (int j = 0; j != 3; ++j)
+                e[j] = p[3 * b + j] - p[3 * a + j];
+            m[0] = e[1] * nr[2] - e[2] * nr[1];
+            m[1] = e[2] * nr[0] - e[0] * nr[2];
+            m[2] = e[0] * nr[1] - e[1] * nr[0];
+            double l = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+            if (l > 0) {
+                auto plane = quadric_t::plane(m[0] / l, m[1] / l, m[2] / l,
+                                              -(m[0] * p[3 * a] + m[1] * p[3 * a + 1] + m[2] * p[3 * a + 2]) / l);
+                q[a] += plane, q[b] += plane;
+            }
+        }
+
+    // the collapses of u (a position) onto the vertex v, the cheapest first;
+    // a changed quadric makes the older entries stale
+    struct candidate_t {
+        double cost;
+        unsigned u, v, version;
+        bool operator<(candidate_t const &o) const { return cost > o.cost; }
+    };
+    std::priority_queue<candidate_t> heap;
+    std::vector<unsigned> version(n, 0);
+    std::vector<uint8_t> removed(n, 0);
+    auto cost = [&](unsigned u, unsigned v) {
+        quadric_t s = q[u];
+        s += q[pos[v]];
+        return s(p[3 * v], p[3 * v + 1], p[3 * v + 2]);
+    };
+    auto push_from = [&](unsigned u) {
+        if (locked[u] || removed[u])
+            return;
+        for (unsigned f : faces_of[u])
+            if (!dead[f])
+                for (unsigned k = 0; k != 3; ++k)
+                    if (at(f, k) != u)
+                        heap.push({cost(u, idx[3 * f + k]), u, idx[3 * f + k], version[u] + version[pos[idx[3 * f + k]]]});
+    };
+    for (unsigned u = 0; u != n; ++u)
+        if (pos[u] == u)
+            push_from(u);
+
+    std::vector<unsigned> ring_u, ring_v;
+    auto ring = [&](unsigned a, std::vector<unsigned> &r) {
+        r.clear();
+        for (unsigned f : faces_of[a])
+            if (!dead[f])
+                for (unsigned k = 0; k != 3; ++k)
+                    if (at(f, k) != a)
+                        r.push_back(at(f, k));
+        std::sort(r.begin(), r.end());
+        r.erase(std::unique(r.begin(), r.end()), r.end());
+    };
+    auto valid = [&](unsigned u, unsigned v) {
+        unsigned pv = pos[v];
+        unsigned shared = 0;
+        for (unsigned f : faces_of[u]) {
+            if (dead[f])
+                continue;
+            unsigned a = at(f, 0), b = at(f, 1), c = at(f, 2);
+            if (a == pv || b == pv || c == pv) {
+                ++shared;
+                continue;
+            }
+            // the face must not flip (or degenerate)
+            double before[3], after[3];
+            normal(a, b, c, before);
+            normal(a == u ? pv : a, b == u ? pv : b, c == u ? pv : c, after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0)
+                return false;
+        }
+        // an open edge collapses only along itself
+        if (!shared || (border[u] && (!border[pv] || shared != 1)))
+            return false;
+        // the link condition: the common neighbours are the opposite corners
+        ring(u, ring_u);
+        ring(pv, ring_v);
+        size_t common = 0;
+        for (size_t i = 0, j = 0; i != ring_u.size() && j != ring_v.size();)
+            if (ring_u[i] < ring_v[j])
+                ++i;
+            else if (ring_v[j] < ring_u[i])
+                ++j;
+            else
+                ++common, ++i, ++j;
+        return common == shared;
+    };
+
+    size_t live = faces;
+    double max_cost = options.max_error * options.max_error;
+    while (live > target && !heap.empty()) {
+        candidate_t c = heap.top();
+        heap.pop();
+        unsigned u = c.u, pv = pos[c.v];
+        if (removed[u] || removed[pv] || c.version != version[u] + version[pv])
+            continue;
+        if (c.cost > max_cost)
+            break; // the quadrics only grow, the rest cost more
+        if (!valid(u, c.v))
+            continue;
+
+        for (unsigned f : faces_of[u]) {
+            if (dead[f])
+                continue;
+            if (at(f, 0) == pv || at(f, 1) == pv || at(f, 2) == pv) {
+                dead[f] = 1;
+                --live;
+                continue;
+            }
+            for (unsigned k = 0; k != 3; ++k)
+                if (idx[3 * f + k] == u)
+                    idx[3 * f + k] = c.v;
+            faces_of[pv].push_back(f);
+        }
+        faces_of[u].clear();
+        removed[u] = 1;
+        q[pv] += q[u];
+        ++version[pv];
+        stats.error = std::max(stats.error, std::sqrt(c.cost));
+
+        // the collapses around v (its quadric and the faces changed)
+        ring(pv, ring_v);
+        push_from(pv);
+        for (unsigned w : ring_v)
+            push_from(w);
+    }
+
+    // the live faces keep their index arrays
+    aiFace *kept = new aiFace[live];
+    for (unsigned f = 0, k = 0; f != faces; ++f)
+        if (!dead[f]) {
+            std::copy(&idx[3 * f], &idx[3 * f + 3], mesh->mFaces[f].mIndices);
+            kept[k].mNumIndices = 3;
+            kept[k++].mIndices = mesh->mFaces[f].mIndices;
+            mesh->mFaces[f].mIndices = nullptr;
+        }
+    if (options.arena)
+        FaceArena::detach(mesh); // the dead ones
+    delete[] mesh->mFaces;
+    mesh->mFaces = kept;
+    mesh->mNumFaces = unsigned(live);
+
+    repair_options_t compact;
+    compact.remove_degenerate = compact.remove_duplicates = false;
+    compact.threads = 1;
+    repair_mesh(mesh, compact);
+    stats.faces_after = mesh->mNumFaces;
+    stats.vertices_after = mesh->mNumVertices;
+    return stats;
+}
+
+/// @brief simplify_mesh() on every mesh of the scene (the tiles or clusters
+/// in parallel, one thread each)
+/// @param per_mesh the stats of each mesh (optional)
+inline simplify_stats_t simplify_scene(aiScene *scene, simplify_options_t const &options,
+                                       std::vector<simplify_stats_t> *per_mesh = nullptr) {
+    std::vector<simplify_stats_t> stats(scene->mNumMeshes);
+    parallel_chunks(scene->mNumMeshes, 1, options.threads, [&](size_t begin, size_t end) {
+        for (size_t m = begin; m != end; ++m)
+            stats[m] = simplify_mesh(scene->mMeshes[m], options);
+    });
+
+    simplify_stats_t total;
+    for (auto const &s : stats)
+        total += s;
+    if (per_mesh)
+        *per_mesh = std::move(stats);
+    return total;
+}
+
+/// @brief simplify_scene() knowing whether the faces are on the scene arena
+inline simplify_stats_t simplify_scene(scene_ptr const &scene, simplify_options_t options,
+                                       std::vector<simplify_stats_t> *per_mesh = nullptr) {
+    options.arena = bool(scene.get_deleter().arena);
+    return simplify_scene(scene.get(), options, per_mesh);
+}
+
+}; // namespace meshtoolbox
+
+#endif
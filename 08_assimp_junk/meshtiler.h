@@ -0,0 +1,376 @@
+#ifndef MESHTILER_H
+#define MESHTILER_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "TilesetExporter.h"
+#include "meshbuilder.h"
+#include "meshweld.h"
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Options of tile_mesh()
+struct tiler_options_t {
+    size_t max_faces = 1 << 16; // a tile with more triangles is split
+    unsigned max_depth = 6;     // the levels below the root
+    bool octree = false;        // split all the axes, not only the horizontal ones
+    int up_axis = 1;            // the axis a quadtree does not split (glTF: Y)
+    bool clip = true;           // cut the triangles at the tile planes, otherwise by centroid
+    unsigned threads = 0;       // tiles in parallel, 0: std::thread::hardware_concurrency()
+};
+
+/// @brief A tile of tile_mesh(), the parents before the children
+struct mesh_tile_t {
+    unsigned parent = ~0u; // the index of the parent tile, ~0u: the root
+    unsigned level = 0;
+    double lo[3] = {0, 0, 0}; // the cell, the coordinates of the source mesh
+    double hi[3] = {0, 0, 0};
+    double rtc[3] = {0, 0, 0};    // the cell center, subtracted from the vertices of the mesh
+    size_t faces = 0;             // the source triangles in the cell
+    std::unique_ptr<aiMesh> mesh; // the leaves only, null if all their triangles clip away
+
+    /// @brief The half diagonal of the cell (the geometric error without the children)
+    double radius() const {
+        double d = 0;
+        for (int a = 0; a != 3; ++a)
+            d += (hi[a] - lo[a]) * (hi[a] - lo[a]);
+        return 0.5 * std::sqrt(d);
+    }
+};
+
+/// @brief Cut a triangle mesh into a quadtree (or an octree) of tiles
+///
+/// The cells are halved while they hold more than max_faces triangles. The
+/// triangles are clipped at the planes of the leaf cells (Sutherland-Hodgman
+/// in double) with all the vertex attributes interpolated; a cut edge gives
+/// the same vertex on both sides, so the tiles meet without cracks. Without
+/// clip a triangle goes to the cell of its centroid. The leaves are built in
+/// parallel, relative to their centers (the RTC offsets).
+inline std::vector<mesh_tile_t> tile_mesh(aiMesh const *mesh, tiler_options_t const &options) {
+    size_t const faces = mesh->mNumFaces;
+    for (unsigned f = 0; f != faces; ++f)
+        if (mesh->mFaces[f].mNumIndices != 3)
+            throw std::invalid_argument("tile_mesh: not a triangle mesh");
+
+    // the triangle bounds
+    std::vector<double> box(6 * faces);
+    parallel_chunks(faces, 1 << 14, options.threads, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f != end; ++f) {
+            unsigned const *i = mesh->mFaces[f].mIndices;
+            for (int a = 0; a != 3; ++a) {
+                double v0 = mesh->mVertices[i[0]][a], v1 = mesh->mVertices[i[1]][a], v2 = mesh->mVertices[i[2]][a];
+                box[6 * f + a] = std::min(v0, std::min(v1, v2));
+                box[6 * f + 3 + a] = std::max(v0, std::max(v1, v2));
+            }
+        }
+    });
+
+    std::vector<mesh_tile_t> tiles(1);
+    std::vector<std::vector<unsigned>> members(1);
+    members[0].resize(faces);
+    for (unsigned f = 0; f != faces; ++f)
+        members[0][f] = f;
+    double root_lo[3] = {0, 0, 0}, root_hi[3] = {0, 0, 0};
+    for (size_t f = 0; f != faces; ++f)
+        for (int a = 0; a != 3; ++a) {
+            root_lo[a] = f ? std::min(root_lo[a], box[6 * f + a]) : box[a];
+            root_hi[a] = f ? std::max(root_hi[a], box[6 * f + 3 + a]) : box[3 + a];
+        }
+    std::copy(root_lo, root_lo + 3, tiles[0].lo);
+    std::copy(root_hi, root_hi + 3, tiles[0].hi);
+
+    // the cells, breadth first (a leaf keeps its members)
+    std::vector<unsigned> leaves;
+    for (unsigned t = 0; t != tiles.size(); ++t) {
+        tiles[t].faces = members[t].size();
+        if (members[t].size() <= options.max_faces || tiles[t].level >= options.max_depth) {
+            leaves.push_back(t);
+            continue;
+        }
+        double mid[3];
+        for (int a = 0; a != 3; ++a)
+            mid[a] = 0.5 * (tiles[t].lo[a] + tiles[t].hi[a]);
+        for (unsigned k = 0; k != 8; ++k) {
+            bool skip = false;
+            mesh_tile_t child;
+            child.parent = t;
+            child.level = tiles[t].level + 1;
+            for (int a = 0; a != 3; ++a) {
+                bool split = options.octree || a != options.up_axis;
+                skip |= !split && (k >> a & 1);
+                bool upper = split && (k >> a & 1);
+                child.lo[a] = upper ? mid[a] : tiles[t].lo[a];
+                child.hi[a] = split && !upper ? mid[a] : tiles[t].hi[a];
+            }
+            if (skip)
+                continue;
+
+            std::vector<unsigned> inside;
+            for (unsigned f : members[t]) {
+                bool in = true;
+                for (int a = 0; a != 3 && in; ++a) {
+                    double lo = box[6 * f + a], hi = box[6 * f + 3 + a];
+                    if (options.clip)
+                        // as the clipping: the lower plane keeps the points on it, the upper one not
+                        in = (hi > child.lo[a] || lo >= child.lo[a]) &&
+                             (lo < child.hi[a] || child.hi[a] == root_hi[a]);
+                    else {
+                        // the centroid, the upper planes belong to the next cell
+                        double c = (double(mesh->mVertices[mesh->mFaces[f].mIndices[0]][a]) +
+                                    mesh->mVertices[mesh->mFaces[f].mIndices[1]][a] +
+                                    mesh->mVertices[mesh->mFaces[f].mIndices[2]][a]) /
+                                   3;
+                        in = c >= child.lo[a] && (c < child.hi[a] || child.hi[a] == root_hi[a]);
+                    }
+                }
+                if (in)
+                    inside.push_back(f);
+            }
+            if (inside.empty())
+                continue;
+            tiles.push_back(std::move(child));
+            members.push_back(std::move(inside));
+        }
+        members[t] = std::vector<unsigned>();
+    }
+    for (auto &t : tiles)
+        for (int a = 0; a != 3; ++a)
+            t.rtc[a] = 0.5 * (t.lo[a] + t.hi[a]);
+
+    // the vertex attributes after the position: the float columns
+    enum column_kind_t { NORMALS, TANGENTS, BITANGENTS, COLORS, TEXTURE_COORDS };
+    struct column_t {
+        float const *data;
+        unsigned components; // floats per vertex
+        column_kind_t kind;
+        unsigned set;
+    };
+    std::vector<column_t> columns;
+    if (mesh->mNormals)
+        columns.push_back({&mesh->mNormals->x, 3, NORMALS, 0});
+    if (mesh->mTangents)
+        columns.push_back({&mesh->mTangents->x, 3, TANGENTS, 0});
+    if (mesh->mBitangents)
+        columns.push_back({&mesh->mBitangents->x, 3, BITANGENTS, 0});
+    for (unsigned k = 0; k != AI_MAX_NUMBER_OF_COLOR_SETS; ++k)
+        if (mesh->mColors[k])
+            columns.push_back({&mesh->mColors[k]->r, 4, COLORS, k});
+    for (unsigned k = 0; k != AI_MAX_NUMBER_OF_TEXTURECOORDS; ++k)
+        if (mesh->mTextureCoords[k])
+            columns.push_back({&mesh->mTextureCoords[k]->x, 3, TEXTURE_COORDS, k});
+    unsigned width = 0;
+    for (auto const &c : columns)
+        width += c.components;
+
+    // a polygon vertex: the position in double, the source vertex (if not
+    // cut) and the attributes
+    struct corner_t {
+        double p[3];
+        unsigned source;
+        unsigned first; // in the attribute pool
+    };
+
+    parallel_chunks(leaves.size(), 1, options.threads, [&](size_t begin, size_t end) {
+        std::vector<float> pool;
+        std::vector<corner_t> polygon, clipped;
+        for (size_t l = begin; l != end; ++l) {
+            mesh_tile_t &tile = tiles[leaves[l]];
+            MeshBuilder b(std::string(mesh->mName.C_Str()) + "_" + std::to_string(leaves[l]));
+            std::vector<std::vector<float>> attributes(columns.size());
+            std::unordered_map<unsigned, unsigned> added;
+            bool cut = false;
+            auto add_corner = [&](corner_t const &c) -> unsigned {
+                if (c.source != ~0u) {
+                    auto it = added.find(c.source);
+                    if (it != added.end())
+                        return it->second;
+                }
+                unsigned v = b.add_vertex(aiVector3D(ai_real(c.p[0] - tile.rtc[0]), ai_real(c.p[1] - tile.rtc[1]),
+                                                     ai_real(c.p[2] - tile.rtc[2])));
+                for (size_t k = 0, o = c.first; k != columns.size(); o += columns[k++].components)
+                    attributes[k].insert(attributes[k].end(), &pool[o], &pool[o] + columns[k].components);
+                if (c.source != ~0u)
+                    added.emplace(c.source, v);
+                return v;
+            };
+
+            for (unsigned f : members[leaves[l]]) {
+                pool.clear();
+                polygon.clear();
+                for (unsigned k = 0; k != 3; ++k) {
+                    unsigned i = mesh->mFaces[f].mIndices[k];
+                    aiVector3D const &v = mesh->mVertices[i];
+                    polygon.push_back({{v.x, v.y, v.z}, i, unsigned(pool.size())});
+                    for (auto const &c : columns)
+                        pool.insert(pool.end(), c.data + size_t(i) * c.components,
+                                    c.data + size_t(i + 1) * c.components);
+                }
+
+                // the planes of the cell inside the root (the outer ones cut nothing)
+                for (int plane = 0; options.clip && plane != 6 && polygon.size() >= 3; ++plane) {
+                    int a = plane % 3;
+                    bool upper = plane >= 3;
+                    double c = upper ? tile.hi[a] : tile.lo[a];
+                    if (c == (upper ? root_hi[a] : root_lo[a]))
+                        continue;
+                    // the lower planes keep the points on them, the upper ones leave them to the next cell
+                    auto inside = [&](corner_t const &v) { return upper ? v.p[a] < c : v.p[a] >= c; };
+                    clipped.clear();
+                    for (size_t k = 0; k != polygon.size(); ++k) {
+                        corner_t const &s = polygon[k], &e = polygon[(k + 1) % polygon.size()];
+                        if (inside(s))
+                            clipped.push_back(s);
+                        if (inside(s) == inside(e))
+                            continue;
+                        // the same point from both sides of the edge: from its smaller end
+                        bool swap = std::lexicographical_compare(e.p, e.p + 3, s.p, s.p + 3);
+                        corner_t const &x = swap ? e : s, &y = swap ? s : e;
+                        double t = (c - x.p[a]) / (y.p[a] - x.p[a]);
+                        corner_t m{{0, 0, 0}, ~0u, unsigned(pool.size())};
+                        for (int j = 0; j != 3; ++j)
+                            m.p[j] = x.p[j] + t * (y.p[j] - x.p[j]);
+                        m.p[a] = c;
+                        pool.resize(pool.size() + width);
+                        for (size_t k2 = 0, o = 0; k2 != columns.size(); o += columns[k2++].components) {
+                            float *r = &pool[m.first + o];
+                            float const *fx = &pool[x.first + o], *fy = &pool[y.first + o];
+                            double l2 = 0;
+                            for (unsigned j = 0; j != columns[k2].components; ++j) {
+                                r[j] = float(fx[j] + t * (fy[j] - fx[j]));
+                                l2 += double(r[j]) * r[j];
+                            }
+                            if (columns[k2].kind < COLORS && l2 > 0)
+                                for (unsigned j = 0; j != columns[k2].components; ++j)
+                                    r[j] = float(r[j] / std::sqrt(l2));
+                        }
+                        clipped.push_back(m);
+                        cut = true;
+                    }
+                    // a corner on the plane comes twice
+                    auto same = [](corner_t const &x, corner_t const &y) { return std::equal(x.p, x.p + 3, y.p); };
+                    polygon.clear();
+                    for (auto const &v : clipped)
+                        if (polygon.empty() || !same(polygon.back(), v))
+                            polygon.push_back(v);
+                    while (polygon.size() > 1 && same(polygon.front(), polygon.back()))
+                        polygon.pop_back();
+                }
+                if (polygon.size() < 3)
+                    continue;
+
+                unsigned first = add_corner(polygon[0]);
+                unsigned prev = add_corner(polygon[1]);
+                for (size_t k = 2; k != polygon.size(); ++k) {
+                    unsigned v = add_corner(polygon[k]);
+                    b.add_triangle(first, prev, v);
+                    prev = v;
+                }
+            }
+            if (!b.num_faces())
+                continue;
+
+            aiMesh *m = b.to_aimesh();
+            m->mMaterialIndex = mesh->mMaterialIndex;
+            for (size_t k = 0; k != columns.size(); ++k) {
+                float *dst = nullptr;
+                unsigned set = columns[k].set;
+                switch (columns[k].kind) {
+                case NORMALS:
+                    dst = &(m->mNormals = new aiVector3D[m->mNumVertices])->x;
+                    break;
+                case TANGENTS:
+                    dst = &(m->mTangents = new aiVector3D[m->mNumVertices])->x;
+                    break;
+                case BITANGENTS:
+                    dst = &(m->mBitangents = new aiVector3D[m->mNumVertices])->x;
+                    break;
+                case COLORS:
+                    dst = &(m->mColors[set] = new aiColor4D[m->mNumVertices])->r;
+                    break;
+                case TEXTURE_COORDS:
+                    dst = &(m->mTextureCoords[set] = new aiVector3D[m->mNumVertices])->x;
+                    m->mNumUVComponents[set] = mesh->mNumUVComponents[set];
+                    break;
+                }
+                std::copy(attributes[k].begin(), attributes[k].end(), dst);
+            }
+
+            if (cut) {
+                // the cut vertices shared by the neighbour triangles
+                weld_options_t exact;
+                exact.epsilon = exact.normal_epsilon = exact.uv_epsilon = exact.color_epsilon = 0;
+                exact.threads = 1;
+                weld_mesh(m, exact);
+            }
+            tile.mesh.reset(m);
+        }
+    });
+    return tiles;
+}
+
+/// @brief Add the tiles of tile_mesh() to the exporter, under parent
+///
+/// The inner tiles have no content and the half diagonal of their cell as
+/// the geometric error, the leaves are b3dm with their RTC offset as the
+/// tile transform. The tiles are moved out. The leaves without a mesh and
+/// the inner tiles without such leaves below are not added (a tile needs
+/// content or children for its bounding volume).
+/// @param y_up the exporter writes Y-up glTF (the transform is Z-up)
+/// @return the exporter index of each tile, npos if not added
+inline std::vector<cesiumjs::TilesetExporter::index_t> add_tiles(cesiumjs::TilesetExporter &exporter,
+                                                                 std::vector<mesh_tile_t> &tiles,
+                                                                 cesiumjs::TilesetExporter::index_t parent,
+                                                                 bool y_up = true) {
+    // the tiles with a mesh below (the children follow their parents)
+    std::vector<uint8_t> used(tiles.size(), 0);
+    for (size_t t = tiles.size(); t-- != 0;)
+        if ((used[t] |= tiles[t].mesh ? 1 : 0) && tiles[t].parent != ~0u)
+            used[tiles[t].parent] = 1;
+
+    std::vector<cesiumjs::TilesetExporter::index_t> ids(tiles.size(), cesiumjs::TilesetExporter::npos);
+    for (size_t t = 0; t != tiles.size(); ++t) {
+        auto &tile = tiles[t];
+        if (!used[t])
+            continue;
+        auto p = tile.parent == ~0u ? parent : ids[tile.parent];
+        if (!tile.mesh) {
+            ids[t] = exporter.add_tile(p, tile.radius());
+            continue;
+        }
+
+        std::unique_ptr<aiScene> scene = std::make_unique<aiScene>();
+        scene->mRootNode = new aiNode("tile");
+        scene->mRootNode->mNumMeshes = 1;
+        scene->mRootNode->mMeshes = new unsigned[1]{0};
+        scene->mNumMeshes = 1;
+        scene->mMeshes = new aiMesh *[1]{tile.mesh.release()};
+        scene->mMeshes[0]->mMaterialIndex = 0;
+        ids[t] = exporter.add_tile(p, 0.0, std::move(scene));
+
+        cesiumjs::TileTree::transform_t transform{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, tile.rtc[0], tile.rtc[1],
+                                                  tile.rtc[2], 1};
+        if (y_up) {
+            // glTF (x, y, z) is (x, -z, y) in the tileset
+            transform.matrix4x4[13] = -tile.rtc[2];
+            transform.matrix4x4[14] = tile.rtc[1];
+        }
+        exporter.tree().set_transform(ids[t], transform);
+    }
+    return ids;
+}
+
+}; // namespace meshtoolbox
+
+#endif
@@ -17,21 +17,30 @@
 #include <Eigen/Dense>
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <filesystem>
 #include <limits>
 #include <map>
 
 #include "assimp_aux.h"
+#include "meshbuilder.h"
 
 #if _WIN32
 #   pragma warning(disable : 4390)
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHTOOLBOX_SSE2 1
+#include <emmintrin.h>
+#endif
+
 namespace fs = std::filesystem;
 
 
 
 #include "TilesetJson.h"
+#include "TileInstances.h"
 
 using namespace cesiumjs;
 
@@ -56,6 +65,22 @@ struct lidarptr_t {
     uint16_t r, g, b;
 };
 
+/// @brief A lidar point with double coordinates (e.g. a scaled LAS record)
+struct lidar_point_t {
+    double x, y, z;
+    uint16_t intensity;
+    uint16_t r, g, b;
+};
+
+/// @brief Options of Toolbox::mesh_lidar_bulk()
+struct lidar_options_t {
+    Vector3D rtc_center{0, 0, 0}; // subtracted (in double) from the Z-up points
+    bool colors = true;           // COLOR_0 from r, g, b
+    bool intensity = false;       // the gray intensity as the next color set
+    unsigned threads = 0;         // 0: std::thread::hardware_concurrency()
+    size_t chunk = 1 << 16;       // points per task
+};
+
 #ifndef M_PI
 /** PI definition */
 #define M_PI 3.14159265358979323846
@@ -63,6 +88,13 @@ struct lidarptr_t {
 #endif
 
 /// @brief Helper class to produce meshes and scenes
+///
+/// The mesh_*() generators come in two forms: the aiMesh owns the indices
+/// of each face (one allocation per face, the caller deletes the mesh), or
+/// all of them are in one block of a FaceArena. The make_*() scenes own
+/// their faces, as every other aiScene; the arena is opt-in: the *_arena()
+/// and make_lidar_pc_bulk() scenes are scene_ptr, which detaches the faces
+/// before deleting the scene.
 class Toolbox {
 public:
     /// @brief Create a cone mesh
@@ -74,47 +106,39 @@ public:
     /// @param N Number of segments for the base circle
     aiMesh *mesh_cone(double height, double radius, const unsigned N = 32)
     {
-        auto mesh = new aiMesh{};
-        mesh->mName = "cone";
-        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        return cone_builder(height, radius, N).to_aimesh();
+    }
+
+    aiMesh *mesh_cone(double height, double radius, FaceArena &arena, const unsigned N = 32) {
+        return cone_builder(height, radius, N).to_aimesh(arena);
+    }
 
-        // Vertices: N base + 1 apex + 1 center of base
-        mesh->mNumVertices = N + 2;
-        mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    /// @brief The builder of mesh_cone()
+    MeshBuilder cone_builder(double height, double radius, const unsigned N) {
+        MeshBuilder b("cone");
+        b.reserve(N + 2, 2 * N * 3);
 
         // Apex vertex (top of the cone)
-        mesh->mVertices[0] = aiVector3D(0.0, height, 0.0);
+        b.add_vertex(aiVector3D(0.0, height, 0.0));
 
         // Base circle vertices
         for (unsigned i = 0; i < N; ++i) {
             double angle = 2.0 * M_PI * i / N;
-            double x = radius * cos(angle);
-            double z = radius * sin(angle);
-            mesh->mVertices[i + 1] = aiVector3D(x, 0.0, z);
+            b.add_vertex(aiVector3D(radius * cos(angle), 0.0, radius * sin(angle)));
         }
 
         // Center of base
-        mesh->mVertices[N + 1] = aiVector3D(0.0, 0.0, 0.0);
-
-        // Faces: N for sides, N for base
-        mesh->mNumFaces = 2 * N;
-        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        b.add_vertex(aiVector3D(0.0, 0.0, 0.0));
 
         // Side faces (triangles)
-        for (unsigned i = 0; i < N; ++i) {
-            unsigned next = (i + 1) % N;
-            mesh->mFaces[i].mNumIndices = 3;
-            mesh->mFaces[i].mIndices = new unsigned[3]{0, i + 1, next + 1};
-        }
+        for (unsigned i = 0; i < N; ++i)
+            b.add_triangle(0, i + 1, (i + 1) % N + 1);
 
         // Base faces (triangles)
-        for (unsigned i = 0; i < N; ++i) {
-            unsigned next = (i + 1) % N;
-            mesh->mFaces[N + i].mNumIndices = 3;
-            mesh->mFaces[N + i].mIndices = new unsigned[3]{N + 1, next + 1, i + 1};
-        }
+        for (unsigned i = 0; i < N; ++i)
+            b.add_triangle(N + 1, (i + 1) % N + 1, i + 1);
 
-        return mesh;
+        return b;
     }
     /// @brief Create a box mesh
     /// @param origin a corner
@@ -123,89 +147,53 @@ public:
     /// @return an object pointer. The user owns the object
     aiMesh *mesh_box(aiVector3D const &origin, aiVector3D const &dimensions,
                      const char *name = nullptr) {
-        auto box = new aiMesh{};
-        box->mName = name ? name : "";
-        box->mNumVertices = 8;
-        box->mVertices = new aiVector3D[box->mNumVertices];
-
-        auto const &v = dimensions;
-        box->mVertices[0] = origin;
-        box->mVertices[1] = aiVector3D{origin.x + v.x, origin.y, origin.z};
-        box->mVertices[2] =
-            aiVector3D{origin.x + v.x, origin.y + v.y, origin.z};
-        box->mVertices[3] = aiVector3D{origin.x, origin.y + v.y, origin.z};
-
-        box->mVertices[4] = aiVector3D{origin.x, origin.y, origin.z + v.z};
-        box->mVertices[5] =
-            aiVector3D{origin.x + v.x, origin.y, origin.z + v.z};
-        box->mVertices[6] = origin + dimensions;
-        box->mVertices[7] =
-            aiVector3D{origin.x, origin.y + v.y, origin.z + v.z};
-
-        box->mNumFaces = 12;
-        box->mFaces = new aiFace[box->mNumFaces];
-        box->mFaces[0].mNumIndices = 3;
-        box->mFaces[0].mIndices = new unsigned[3]{0, 2, 1};
-
-        box->mFaces[1].mNumIndices = 3;
-        box->mFaces[1].mIndices = new unsigned[3]{3, 2, 0};
-
-        box->mFaces[2].mNumIndices = 3;
-        box->mFaces[2].mIndices = new unsigned[3]{4, 5, 6};
-
-        box->mFaces[3].mNumIndices = 3;
-        box->mFaces[3].mIndices = new unsigned[3]{4, 6, 7};
-
-        box->mFaces[4].mNumIndices = 3;
-        box->mFaces[4].mIndices = new unsigned[3]{0, 4, 3};
-
-        box->mFaces[5].mNumIndices = 3;
-        box->mFaces[5].mIndices = new unsigned[3]{3, 4, 7};
-
-        box->mFaces[6].mNumIndices = 3;
-        box->mFaces[6].mIndices = new unsigned[3]{7, 2, 3};
-
-        box->mFaces[7].mNumIndices = 3;
-        box->mFaces[7].mIndices = new unsigned[3]{6, 2, 7};
-
-        box->mFaces[8].mNumIndices = 3;
-        box->mFaces[8].mIndices = new unsigned[3]{6, 1, 2};
-
-        box->mFaces[9].mNumIndices = 3;
-        box->mFaces[9].mIndices = new unsigned[3]{5, 1, 6};
-
-        box->mFaces[10].mNumIndices = 3;
-        box->mFaces[10].mIndices = new unsigned[3]{0, 1, 4};
+        return box_builder(origin, dimensions, name).to_aimesh();
+    };
 
-        box->mFaces[11].mNumIndices = 3;
-        box->mFaces[11].mIndices = new unsigned[3]{4, 1, 5};
+    aiMesh *mesh_box(aiVector3D const &origin, aiVector3D const &dimensions,
+                     FaceArena &arena, const char *name = nullptr) {
+        return box_builder(origin, dimensions, name).to_aimesh(arena);
+    }
 
-        box->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    /// @brief The builder of mesh_box()
+    MeshBuilder box_builder(aiVector3D const &origin,
+                            aiVector3D const &dimensions, const char *name) {
+        MeshBuilder b(name ? name : "");
+        b.reserve(8, 36);
+        for (auto const &p : box_corners(origin, dimensions))
+            b.add_vertex(p);
+
+        static const unsigned faces[12][3] = {
+            {0, 2, 1}, {3, 2, 0}, {4, 5, 6}, {4, 6, 7}, {0, 4, 3}, {3, 4, 7},
+            {7, 2, 3}, {6, 2, 7}, {6, 1, 2}, {5, 1, 6}, {0, 1, 4}, {4, 1, 5}};
+        for (auto const &f : faces)
+            b.add_face(f, 3);
+        return b;
+    }
 
-        return box;
-    };
+    /// @brief The corners of the box, the bottom (z = origin.z) first
+    std::array<aiVector3D, 8> box_corners(aiVector3D const &origin,
+                                          aiVector3D const &dimensions) {
+        auto const &v = dimensions;
+        return {origin,
+                aiVector3D{origin.x + v.x, origin.y, origin.z},
+                aiVector3D{origin.x + v.x, origin.y + v.y, origin.z},
+                aiVector3D{origin.x, origin.y + v.y, origin.z},
+                aiVector3D{origin.x, origin.y, origin.z + v.z},
+                aiVector3D{origin.x + v.x, origin.y, origin.z + v.z},
+                origin + dimensions,
+                aiVector3D{origin.x, origin.y + v.y, origin.z + v.z}};
+    }
 
     aiMesh *mesh_tile(ai_real width, ai_real height)
     {
-        auto box = new aiMesh{};
-        box->mName= "tile";
-        box->mNumVertices = 4;
-        box->mVertices = new aiVector3D[box->mNumVertices];
-        box->mPrimitiveTypes = aiPrimitiveType_POLYGON;
-
-        auto origin = aiVector3D{0, 0, 0};
-        auto v = aiVector3D{width, height, 0};
-        box->mVertices[0] = origin;
-        box->mVertices[1] = aiVector3D{origin.x + v.x, origin.y, origin.z};
-        box->mVertices[2] = aiVector3D{origin.x + v.x, origin.y + v.y, origin.z};
-        box->mVertices[3] = aiVector3D{origin.x, origin.y + v.y, origin.z};
-
-        box->mNumFaces = 1;
-        box->mFaces = new aiFace[box->mNumFaces];
-        box->mFaces[0].mNumIndices = 4;
-        box->mFaces[0].mIndices = new unsigned[4]{0, 1, 2, 3};
-
-        return box;
+        MeshBuilder b("tile");
+        b.add_vertex({0, 0, 0});
+        b.add_vertex({width, 0, 0});
+        b.add_vertex({width, height, 0});
+        b.add_vertex({0, height, 0});
+        b.add_face({0, 1, 2, 3});
+        return b.to_aimesh();
     }
 
     /// @brief Create a box point cloud "mesh"
@@ -215,90 +203,208 @@ public:
     /// @return an object pointer. The user owns the object
     aiMesh *mesh_pc_box(aiVector3D const &origin, aiVector3D const &dimensions,
                         const char *name = nullptr) {
-        auto box = new aiMesh{};
-        box->mName = name ? name : "";
-        box->mNumVertices = 8;
-        box->mVertices = new aiVector3D[box->mNumVertices];
-
-        auto const &v = dimensions;
-        box->mVertices[0] = origin;
-        box->mVertices[1] = aiVector3D{origin.x + v.x, origin.y, origin.z};
-        box->mVertices[2] =
-            aiVector3D{origin.x + v.x, origin.y + v.y, origin.z};
-        box->mVertices[3] = aiVector3D{origin.x, origin.y + v.y, origin.z};
-
-        box->mVertices[4] = aiVector3D{origin.x, origin.y, origin.z + v.z};
-        box->mVertices[5] =
-            aiVector3D{origin.x + v.x, origin.y, origin.z + v.z};
-        box->mVertices[6] = origin + dimensions;
-        box->mVertices[7] =
-            aiVector3D{origin.x, origin.y + v.y, origin.z + v.z};
-
-        box->mNumFaces = 8;
-        box->mFaces = new aiFace[box->mNumFaces];
-
-        box->mFaces[0].mNumIndices = 1;
-        box->mFaces[0].mIndices = new unsigned[1]{0};
-
-        box->mFaces[1].mNumIndices = 1;
-        box->mFaces[1].mIndices = new unsigned[1]{1};
-
-        box->mFaces[2].mNumIndices = 1;
-        box->mFaces[2].mIndices = new unsigned[1]{2};
-
-        box->mFaces[3].mNumIndices = 1;
-        box->mFaces[3].mIndices = new unsigned[1]{3};
-
-        box->mFaces[4].mNumIndices = 1;
-        box->mFaces[4].mIndices = new unsigned[1]{4};
-
-        box->mFaces[5].mNumIndices = 1;
-        box->mFaces[5].mIndices = new unsigned[1]{5};
-
-        box->mFaces[6].mNumIndices = 1;
-        box->mFaces[6].mIndices = new unsigned[1]{6};
-
-        box->mFaces[7].mNumIndices = 1;
-        box->mFaces[7].mIndices = new unsigned[1]{7};
+        return pc_box_builder(origin, dimensions, name).to_aimesh();
+    };
 
-        box->mPrimitiveTypes = aiPrimitiveType_POINT;
+    aiMesh *mesh_pc_box(aiVector3D const &origin, aiVector3D const &dimensions,
+                        FaceArena &arena, const char *name = nullptr) {
+        return pc_box_builder(origin, dimensions, name).to_aimesh(arena);
+    }
 
-        return box;
-    };
+    /// @brief The builder of mesh_pc_box()
+    MeshBuilder pc_box_builder(aiVector3D const &origin,
+                               aiVector3D const &dimensions, const char *name) {
+        MeshBuilder b(name ? name : "");
+        b.reserve(8, 8);
+        for (auto const &p : box_corners(origin, dimensions))
+            b.add_point(b.add_vertex(p));
+        return b;
+    }
 
     /// @brief Create a "mesh" of Lidar points
     /// @param data
     /// @param count
     /// @param name [optional]
     /// @return
-    aiMesh *mesh_lidar_pc(lidarptr_t *data, size_t count,
+    aiMesh *mesh_lidar_pc(lidarptr_t const *data, size_t count,
+                          const char *name = nullptr) {
+        return lidar_builder(data, count, name).to_aimesh();
+    };
+
+    aiMesh *mesh_lidar_pc(lidarptr_t const *data, size_t count, FaceArena &arena,
                           const char *name = nullptr) {
-        auto box = new aiMesh{};
-        box->mName = name ? name : "";
-        box->mNumVertices = unsigned(count);
-        box->mVertices = new aiVector3D[box->mNumVertices];
+        return lidar_builder(data, count, name).to_aimesh(arena);
+    }
 
-        box->mColors[0] = new aiColor4D[box->mNumVertices];
+    /// @brief Lidar points in flat arrays (no aiFace)
+    flat_mesh_t lidar_points(lidarptr_t const *data, size_t count,
+                             const char *name = nullptr) {
+        return lidar_builder(data, count, name).flat();
+    }
 
+    /// @brief The builder of mesh_lidar_pc()
+    MeshBuilder lidar_builder(lidarptr_t const *data, size_t count,
+                              const char *name) {
+        MeshBuilder b(name ? name : "");
+        b.reserve(count, count);
         ai_real d = ai_real(1.0 / 0xFFFF);
-        for (unsigned i = 0; i < box->mNumVertices; ++i) {
-            box->mVertices[i] = aiVector3D{data[i].x, data[i].z, -data[i].y};
-            box->mColors[0][i] =
-                aiColor4D{data[i].r * d, data[i].g * d, data[i].b * d, 1.0};
+        for (size_t i = 0; i < count; ++i) {
+            unsigned v = b.add_vertex(aiVector3D{data[i].x, data[i].z, -data[i].y});
+            b.set_color(aiColor4D{data[i].r * d, data[i].g * d, data[i].b * d, 1.0});
+            b.add_point(v);
         }
+        return b;
+    }
+
+    /// @brief The points of mesh_lidar_pc() in one pass, on parallel chunks
+    ///
+    /// The positions are relative to options.rtc_center (the caller writes it
+    /// to the tile, e.g. RTC_CENTER) and narrowed to float after the
+    /// subtraction. lidar_point_t records go through SSE2 kernels (see
+    /// lidar_positions() and lidar_colors()). The point faces are on the
+    /// arena (see scene_ptr).
+    template <typename Point>
+    aiMesh *mesh_lidar_bulk(Point const *data, size_t count,
+                            lidar_options_t const &options, FaceArena &arena,
+                            const char *name = nullptr) {
+        if (count > std::numeric_limits<unsigned>::max())
+            throw std::length_error("too many points for an aiMesh");
+        unsigned n = unsigned(count);
+
+        auto mesh = new aiMesh{};
+        mesh->mName = name ? name : "";
+        mesh->mPrimitiveTypes = aiPrimitiveType_POINT;
+        mesh->mNumVertices = n;
+        mesh->mVertices = new aiVector3D[n];
+        unsigned channel = 0;
+        aiColor4D *colors =
+            options.colors ? mesh->mColors[channel++] = new aiColor4D[n]
+                           : nullptr;
+        aiColor4D *intensity =
+            options.intensity ? mesh->mColors[channel++] = new aiColor4D[n]
+                              : nullptr;
+        mesh->mNumFaces = n;
+        mesh->mFaces = new aiFace[n];
+        unsigned *indices = arena.allocate(count);
+
+        double const origin[3] = {options.rtc_center.x, options.rtc_center.y,
+                                  options.rtc_center.z};
+        aiVector3D *vertices = mesh->mVertices;
+        aiFace *faces = mesh->mFaces;
+        parallel_chunks(count, options.chunk, options.threads,
+                        [&](size_t begin, size_t end) {
+            lidar_positions(data, vertices, begin, end, origin);
+            if (colors || intensity)
+                lidar_colors(data, colors, intensity, begin, end);
+            for (size_t i = begin; i != end; ++i) {
+                indices[i] = unsigned(i);
+                faces[i].mNumIndices = 1;
+                faces[i].mIndices = indices + i;
+            }
+        });
+        return mesh;
+    }
+
+    /// @brief A scene of mesh_lidar_bulk()
+    template <typename Point>
+    scene_ptr make_lidar_pc_bulk(Point const *data, size_t count,
+                                 lidar_options_t const &options) {
+        scene_ptr model = new_arena_scene();
+
+        model->mNumMeshes = 1;
+        model->mMeshes = new aiMesh *[model->mNumMeshes] {
+            mesh_lidar_bulk(data, count, options, arena_of(model), "points")
+        };
+
+        model->mRootNode = new aiNode("ROOT");
+        model->mRootNode->mNumChildren = 1;
+        model->mRootNode->mChildren =
+            new aiNode *[model->mRootNode->mNumChildren];
+        model->mRootNode->mChildren[0] = new aiNode("pc");
+        model->mRootNode->mChildren[0]->mNumMeshes = 1;
+        model->mRootNode->mChildren[0]->mMeshes = new unsigned[1]{0};
 
-        box->mNumFaces = box->mNumVertices;
-        box->mFaces = new aiFace[box->mNumFaces];
+        return model;
+    }
 
-        for (unsigned i = 0; i < box->mNumFaces; ++i) {
-            box->mFaces[i].mNumIndices = 1;
-            box->mFaces[i].mIndices = new unsigned[1]{i};
+    static uint16_t intensity_of(lidar_point_t const &p) { return p.intensity; }
+    static uint16_t intensity_of(lidarptr_t const &) { return 0; }
+
+    /// @brief The Z-up points [begin, end) relative to the origin as Y-up
+    /// float vertices
+    template <typename Point>
+    static void lidar_positions(Point const *data, aiVector3D *vertices,
+                                size_t begin, size_t end,
+                                double const origin[3]) {
+        for (size_t i = begin; i != end; ++i) {
+            vertices[i].x = float(data[i].x - origin[0]);
+            vertices[i].y = float(data[i].z - origin[2]);
+            vertices[i].z = float(origin[1] - data[i].y);
         }
+    }
+
+    /// @brief The colors (r, g, b) and the gray intensity of the points
+    /// [begin, end), either can be null
+    template <typename Point>
+    static void lidar_colors(Point const *data, aiColor4D *colors,
+                             aiColor4D *intensity, size_t begin, size_t end) {
+        float const d = float(1.0 / 0xFFFF);
+        if (colors)
+            for (size_t i = begin; i != end; ++i)
+                colors[i] = aiColor4D{data[i].r * d, data[i].g * d,
+                                      data[i].b * d, 1.0f};
+        if (intensity)
+            for (size_t i = begin; i != end; ++i) {
+                float v = intensity_of(data[i]) * d;
+                intensity[i] = aiColor4D{v, v, v, 1.0f};
+            }
+    }
 
-        box->mPrimitiveTypes = aiPrimitiveType_POINT;
+#ifdef MESHTOOLBOX_SSE2
+    /// @brief lidar_positions() of the double records: (x, z) and y in two
+    /// lanes each, narrowed with one conversion (the same rounding as the
+    /// scalar loop)
+    static void lidar_positions(lidar_point_t const *data, aiVector3D *vertices,
+                                size_t begin, size_t end,
+                                double const origin[3]) {
+        __m128d const xz0 = _mm_set_pd(origin[2], origin[0]);
+        __m128d const y0 = _mm_set1_pd(origin[1]);
+        for (size_t i = begin; i != end; ++i) {
+            __m128d xy = _mm_loadu_pd(&data[i].x);
+            __m128d xz = _mm_loadh_pd(xy, &data[i].z);
+            __m128 a = _mm_cvtpd_ps(_mm_sub_pd(xz, xz0));
+            __m128 b = _mm_cvtpd_ps(_mm_sub_pd(y0, _mm_unpackhi_pd(xy, xy)));
+            _mm_storel_pi(reinterpret_cast<__m64 *>(&vertices[i].x), a);
+            _mm_store_ss(&vertices[i].z, b);
+        }
+    }
 
-        return box;
-    };
+    /// @brief lidar_colors() of the double records: the 4 channels
+    /// (intensity, r, g, b) widened and scaled at once
+    static void lidar_colors(lidar_point_t const *data, aiColor4D *colors,
+                             aiColor4D *intensity, size_t begin, size_t end) {
+        static_assert(offsetof(lidar_point_t, b) ==
+                          offsetof(lidar_point_t, intensity) + 3 * sizeof(uint16_t),
+                      "intensity, r, g, b are contiguous");
+        __m128 const d = _mm_set1_ps(float(1.0 / 0xFFFF));
+        __m128 const rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        __m128 const one = _mm_set_ps(1.0f, 0, 0, 0);
+        __m128i const zero = _mm_setzero_si128();
+        for (size_t i = begin; i != end; ++i) {
+            __m128i irgb = _mm_loadl_epi64(
+                reinterpret_cast<__m128i const *>(&data[i].intensity));
+            __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(irgb, zero)), d);
+            if (colors) {
+                __m128 c = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 3, 2, 1));
+                _mm_storeu_ps(&colors[i].r, _mm_or_ps(_mm_and_ps(c, rgb), one));
+            }
+            if (intensity) {
+                __m128 c = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+                _mm_storeu_ps(&intensity[i].r, _mm_or_ps(_mm_and_ps(c, rgb), one));
+            }
+        }
+    }
+#endif
 
     /// @brief Create a single box scene
     /// @param origin coordinate of the origin (a corner)
@@ -440,62 +546,45 @@ public:
 
     aiMesh *mesh_cylinder(aiVector3D const &origin, ai_real H, ai_real R,
                           unsigned N, const char *name) {
-        auto box = new aiMesh{};
-        box->mName = name ? name : "";
-        box->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        return cylinder_builder(origin, H, R, N, name).to_aimesh();
+    }
 
-        //
-        box->mNumVertices = (N + 1) * 2;
-        box->mVertices = new aiVector3D[box->mNumVertices];
+    aiMesh *mesh_cylinder(aiVector3D const &origin, ai_real H, ai_real R,
+                          unsigned N, FaceArena &arena, const char *name) {
+        return cylinder_builder(origin, H, R, N, name).to_aimesh(arena);
+    }
+
+    /// @brief The builder of mesh_cylinder()
+    MeshBuilder cylinder_builder(aiVector3D const &origin, ai_real H, ai_real R,
+                                 unsigned N, const char *name) {
+        MeshBuilder b(name ? name : "");
+        b.reserve((N + 1) * 2, 4 * N * 3);
 
         ai_real a = 0, da = ai_real(2 * M_PI / N);
         for (unsigned i = 0; i < N; ++i) {
             ai_real x = R * cos(a + i * da) + origin.x;
             ai_real z = R * sin(a + i * da) + origin.z;
 
-            box->mVertices[2 * i] = {x, 0, z};
-            box->mVertices[2 * i + 1] = {x, H, z};
+            b.add_vertex({x, 0, z});
+            b.add_vertex({x, H, z});
         }
-        box->mVertices[N * 2] = origin;
-        box->mVertices[N * 2 + 1] = {origin.x, origin.y + H, origin.z};
-
-        box->mNumFaces = 4 * N;
-        box->mFaces = new aiFace[box->mNumFaces];
+        b.add_vertex(origin);
+        b.add_vertex({origin.x, origin.y + H, origin.z});
 
         // the cylinder sides
         for (unsigned i = 0; i < N; ++i) {
             auto i_next = (i + 1) % N;
-
-            box->mFaces[2 * i].mNumIndices = 3;
-            box->mFaces[2 * i].mIndices =
-                new unsigned[3]{2 * i, 2 * i + 1, 2 * i_next};
-
-            box->mFaces[2 * i + 1].mNumIndices = 3;
-            box->mFaces[2 * i + 1].mIndices =
-                new unsigned[3]{2 * i_next, 2 * i + 1, 2 * i_next + 1};
-        }
-
-        {
-            // The cylinder bottom
-            int pos = 2 * N;
-            for (unsigned i = 0; i < N; ++i) {
-                auto i_next = (i + 1) % N;
-                box->mFaces[pos].mNumIndices = 3;
-                box->mFaces[pos].mIndices =
-                    new unsigned[3]{2 * N, 2 * i, 2 * i_next};
-                pos += 1;
-            }
-            // The cylinder top
-            for (unsigned i = 0; i < N; ++i) {
-                auto i_next = (i + 1) % N;
-                box->mFaces[pos].mNumIndices = 3;
-                box->mFaces[pos].mIndices =
-                    new unsigned[3]{2 * i + 1, 2 * N + 1, 2 * i_next + 1};
-                pos += 1;
-            }
+            b.add_triangle(2 * i, 2 * i + 1, 2 * i_next);
+            b.add_triangle(2 * i_next, 2 * i + 1, 2 * i_next + 1);
         }
-
-        return box;
+        // The cylinder bottom
+        for (unsigned i = 0; i < N; ++i)
+            b.add_triangle(2 * N, 2 * i, 2 * ((i + 1) % N));
+        // The cylinder top
+        for (unsigned i = 0; i < N; ++i)
+            b.add_triangle(2 * i + 1, 2 * N + 1, 2 * ((i + 1) % N) + 1);
+
+        return b;
     }
 
     aiMesh *mesh_cylinder(ai_real H, ai_real R, unsigned N = 32,
@@ -555,6 +644,205 @@ public:
         return model.release();
     }
 
+    /// @brief How the make_*_shared() scenes use the unit mesh
+    enum class sharing_t {
+        /// one node per primitive (its transform) referencing the unit mesh
+        nodes,
+        /// one mesh per material, the primitives baked into it
+        merge_by_material
+    };
+
+    /// @brief The boxes of make_boxes() sharing one unit box mesh
+    /// @param materials the mMaterialIndex of each box (empty: 0); the caller
+    /// adds the materials to the scene
+    aiScene *make_boxes_shared(std::vector<box_t> const &boxes,
+                               std::vector<unsigned> const &materials = {},
+                               sharing_t mode = sharing_t::nodes) {
+        std::vector<aiMatrix4x4> transforms;
+        transforms.reserve(boxes.size());
+        for (auto const &b : boxes)
+            transforms.push_back(make_offset_transformation(b.first) *
+                                 make_scaling(b.second));
+        return make_shared_scene(box_builder({0, 0, 0}, {1, 1, 1}, "box"),
+                                 transforms, materials, mode, "box_");
+    }
+
+    /// @brief The boxes of make_boxes_with_transform() sharing one unit box
+    /// mesh (the centroid is the root node offset)
+    aiScene *
+    make_boxes_with_transform_shared(std::vector<box_t> const &boxes,
+                                     std::vector<unsigned> const &materials = {},
+                                     sharing_t mode = sharing_t::nodes) {
+        if (boxes.empty())
+            return make_boxes_shared(boxes, materials, mode);
+        Vector3D origin{0, 0, 0};
+        for (auto &bp : boxes)
+            origin += bp.first;
+        origin /= double(boxes.size());
+
+        std::vector<aiMatrix4x4> transforms;
+        transforms.reserve(boxes.size());
+        for (auto const &b : boxes)
+            transforms.push_back(make_offset_transformation(b.first - origin) *
+                                 make_scaling(b.second));
+        auto model =
+            make_shared_scene(box_builder({0, 0, 0}, {1, 1, 1}, "box"),
+                              transforms, materials, mode, "box_");
+        model->mRootNode->mTransformation = make_offset_transformation(origin);
+        return model;
+    }
+
+    /// @brief The cylinders of make_cylinders() sharing one unit cylinder mesh
+    /// @param N the number of segments
+    aiScene *make_cylinders_shared(std::vector<cylinder_t> const &cylinders,
+                                   unsigned N,
+                                   std::vector<unsigned> const &materials = {},
+                                   sharing_t mode = sharing_t::nodes) {
+        std::vector<aiMatrix4x4> transforms;
+        transforms.reserve(cylinders.size());
+        for (auto const &c : cylinders)
+            transforms.push_back(
+                make_offset_transformation(c.origin) *
+                make_scaling(Vector3D(c.radius, c.height, c.radius)));
+        return make_shared_scene(
+            cylinder_builder({0, 0, 0}, 1, 1, N, "cylinder"), transforms,
+            materials, mode, "cyl_");
+    }
+
+    aiMatrix4x4 make_scaling(Vector3D const &s) {
+        aiMatrix4x4 r;
+        aiMatrix4x4::Scaling(s, r);
+        return r;
+    }
+
+    /// @brief A scene of one mesh placed many times
+    ///
+    /// sharing_t::nodes: a copy of the unit mesh per material, referenced by
+    /// the nodes "<prefix><i>" (the transforms); sharing_t::merge_by_material:
+    /// a mesh per material with the transformed copies, under the nodes
+    /// "<prefix>m<material>".
+    aiScene *make_shared_scene(MeshBuilder unit,
+                               std::vector<aiMatrix4x4> const &transforms,
+                               std::vector<unsigned> const &materials,
+                               sharing_t mode, std::string const &prefix) {
+        if (!materials.empty() && materials.size() != transforms.size())
+            throw std::invalid_argument("a material per primitive expected");
+        auto material = [&](size_t i) {
+            return materials.empty() ? 0u : materials[i];
+        };
+
+        // the mesh of each material
+        std::map<unsigned, unsigned> meshes;
+        for (size_t i = 0; i != transforms.size(); ++i)
+            meshes.emplace(material(i), 0);
+        unsigned k = 0;
+        for (auto &m : meshes)
+            m.second = k++;
+
+        std::unique_ptr<aiScene> model = std::make_unique<aiScene>();
+        model->mRootNode = new aiNode("ROOT");
+        if (transforms.empty())
+            return model.release();
+
+        model->mNumMeshes = unsigned(meshes.size());
+        model->mMeshes = new aiMesh *[model->mNumMeshes] {};
+        aiNode *root = model->mRootNode;
+        if (mode == sharing_t::nodes) {
+            for (auto const &m : meshes) {
+                model->mMeshes[m.second] = unit.to_aimesh();
+                model->mMeshes[m.second]->mMaterialIndex = m.first;
+            }
+            root->mNumChildren = unsigned(transforms.size());
+            root->mChildren = new aiNode *[root->mNumChildren];
+            for (unsigned i = 0; i != root->mNumChildren; ++i) {
+                auto node = new aiNode(prefix + std::to_string(i));
+                node->mParent = root;
+                node->mTransformation = transforms[i];
+                node->mNumMeshes = 1;
+                node->mMeshes = new unsigned[1]{meshes[material(i)]};
+                root->mChildren[i] = node;
+            }
+        } else {
+            flat_mesh_t const &mesh = unit.mesh();
+            std::vector<MeshBuilder> merged(meshes.size());
+            for (size_t i = 0; i != transforms.size(); ++i)
+                merged[meshes[material(i)]].add_mesh(mesh, transforms[i]);
+            root->mNumChildren = unsigned(meshes.size());
+            root->mChildren = new aiNode *[root->mNumChildren];
+            for (auto const &m : meshes) {
+                std::string name = prefix + "m" + std::to_string(m.first);
+                model->mMeshes[m.second] = merged[m.second].to_aimesh();
+                model->mMeshes[m.second]->mName = name;
+                model->mMeshes[m.second]->mMaterialIndex = m.first;
+                auto node = new aiNode(name);
+                node->mParent = root;
+                node->mNumMeshes = 1;
+                node->mMeshes = new unsigned[1]{m.second};
+                root->mChildren[m.second] = node;
+            }
+        }
+        return model.release();
+    }
+
+    /// @brief A model and its placements (i3dm content)
+    struct instanced_t {
+        std::unique_ptr<aiScene> model;
+        TileInstances instances;
+    };
+
+    /// @brief The boxes of make_boxes() as instances of a unit box
+    ///
+    /// The model is Y-up glTF (as the make_boxes() scene), the instance
+    /// positions and scales are in the Z-up tile frame.
+    instanced_t make_boxes_instanced(std::vector<box_t> const &boxes) {
+        instanced_t r{std::unique_ptr<aiScene>(make_box({0, 0, 0}, {1, 1, 1})), {}};
+        r.instances.reserve(boxes.size());
+        for (auto const &b : boxes)
+            r.instances.add(to_tile_frame(b.first), scale_to_tile_frame(b.second));
+        return r;
+    }
+
+    /// @brief The boxes of make_boxes_with_transform() as instances of a unit box
+    ///
+    /// The centroid of the boxes goes to RTC_CENTER (double precision), the
+    /// positions are relative to it.
+    instanced_t make_boxes_with_transform_instanced(std::vector<box_t> const &boxes) {
+        instanced_t r{std::unique_ptr<aiScene>(make_box({0, 0, 0}, {1, 1, 1})), {}};
+        if (boxes.empty())
+            return r;
+        Vector3D origin{0, 0, 0};
+        for (auto &bp : boxes)
+            origin += bp.first;
+        origin /= double(boxes.size());
+        r.instances.rtc_center = {origin.x, -origin.z, origin.y};
+
+        r.instances.reserve(boxes.size());
+        for (auto const &b : boxes)
+            r.instances.add(to_tile_frame(b.first - origin), scale_to_tile_frame(b.second));
+        return r;
+    }
+
+    /// @brief The cylinders of make_cylinders() as instances of a unit cylinder
+    /// @param N the number of segments of the model
+    instanced_t make_cylinders_instanced(std::vector<cylinder_t> const &cylinders, unsigned N) {
+        instanced_t r{std::unique_ptr<aiScene>(make_cylinder({0, 0, 0}, 1, 1, N)), {}};
+        r.instances.reserve(cylinders.size());
+        for (auto const &c : cylinders)
+            r.instances.add(to_tile_frame(c.origin),
+                            scale_to_tile_frame(Vector3D(c.radius, c.height, c.radius)));
+        return r;
+    }
+
+    /// @brief Y-up (glTF) position to the Z-up tile frame
+    TileInstances::float3_t to_tile_frame(Vector3D const &p) {
+        return {float(p.x), float(-p.z), float(p.y)};
+    }
+
+    /// @brief Y-up (glTF) scale to the Z-up tile frame
+    TileInstances::float3_t scale_to_tile_frame(Vector3D const &s) {
+        return {float(s.x), float(s.z), float(s.y)};
+    }
+
     /// @brief Create a single PC-box scene
     /// @param origin coordinate of the origin (a corner)
     /// @param dimensions (x,y,z) dimensions of the box
@@ -580,7 +868,7 @@ public:
         return model.release();
     }
 
-    aiScene *make_lidar_pc(lidarptr_t *data, size_t count) {
+    aiScene *make_lidar_pc(lidarptr_t const *data, size_t count) {
         std::unique_ptr<aiScene> model = std::make_unique<aiScene>();
 
         auto box = mesh_lidar_pc(data, count, "box");
@@ -599,6 +887,29 @@ public:
         return model.release();
     }
 
+    /// @brief make_lidar_pc() with the point indices in one arena block
+    ///
+    /// One allocation for all the faces instead of one per point; the
+    /// scene_ptr detaches them before deleting the scene.
+    scene_ptr make_lidar_pc_arena(lidarptr_t const *data, size_t count) {
+        scene_ptr model = new_arena_scene();
+
+        model->mNumMeshes = 1;
+        model->mMeshes = new aiMesh *[model->mNumMeshes] {
+            mesh_lidar_pc(data, count, arena_of(model), "box")
+        };
+
+        model->mRootNode = new aiNode("ROOT");
+        model->mRootNode->mNumChildren = 1;
+        model->mRootNode->mChildren =
+            new aiNode *[model->mRootNode->mNumChildren];
+        model->mRootNode->mChildren[0] = new aiNode("pc-box");
+        model->mRootNode->mChildren[0]->mNumMeshes = 1;
+        model->mRootNode->mChildren[0]->mMeshes = new unsigned[1]{0};
+
+        return model;
+    }
+
     /// @brief Create a scene from the meshes provided
     aiScene *make_scene(std::vector<aiMesh *> meshes) {
         std::unique_ptr<aiScene> model = std::make_unique<aiScene>();
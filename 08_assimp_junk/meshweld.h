@@ -0,0 +1,225 @@
+#ifndef MESHWELD_H
+#define MESHWELD_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "meshbuilder.h"
+
+namespace meshtoolbox {
+#if 0
+}
+#endif
+
+/// @brief Options of weld_mesh() and weld_scene()
+struct weld_options_t {
+    double epsilon = 1e-6;        // the position distance (model units)
+    double normal_epsilon = 1e-3; // the distance of the normals (tangents)
+    double uv_epsilon = 1e-6;     // per texture coordinate set
+    double color_epsilon = 1e-3;  // per color set
+    unsigned threads = 0;         // 0: std::thread::hardware_concurrency()
+    size_t chunk = 1 << 14;       // vertices (faces) per task
+};
+
+/// @brief The vertex counts of weld_mesh()
+struct weld_stats_t {
+    size_t before = 0;
+    size_t after = 0;
+
+    weld_stats_t &operator+=(weld_stats_t const &o) {
+        before += o.before;
+        after += o.after;
+        return *this;
+    }
+};
+
+/// @brief Merge the vertices closer than the tolerances, in place
+///
+/// A vertex joins the first vertex (the smallest index) within epsilon whose
+/// normals, tangents, texture coordinates and colors match too; chains of
+/// close vertices end up in one. The candidates come from a spatial hash of
+/// 4 * epsilon cells (the cell and the neighbours within epsilon), the
+/// matching and the index remapping run on parallel chunks. Faces that collapse stay (see
+/// repair_mesh()); meshes with bones or anim meshes are left alone.
+inline weld_stats_t weld_mesh(aiMesh *mesh, weld_options_t const &options) {
+    weld_stats_t stats;
+    size_t n = stats.before = stats.after = mesh->mNumVertices;
+    if (n < 2 || mesh->mNumBones || mesh->mNumAnimMeshes)
+        return stats;
+
+    // any size finds the exact duplicates
+    double const cell = options.epsilon > 0 ? 4 * options.epsilon : 1.0;
+    aiVector3D const *v = mesh->mVertices;
+    auto coordinate = [&](double x) { return int64_t(std::floor(x / cell)); };
+    auto key = [](int64_t x, int64_t y, int64_t z) {
+        uint64_t h = uint64_t(x) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 31) ^ uint64_t(y)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 31) ^ uint64_t(z)) * 0x94D049BB133111EBull;
+        return h ^ (h >> 29);
+    };
+
+    // the vertices sorted by cell, with their positions (the hash collisions
+    // are rejected by the distances)
+    struct entry_t {
+        uint64_t key;
+        unsigned index;
+        aiVector3D p;
+        bool operator<(entry_t const &o) const { return key < o.key || (key == o.key && index < o.index); }
+    };
+    std::vector<entry_t> sorted(n);
+    parallel_chunks(n, options.chunk, options.threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i != end; ++i)
+            sorted[i] = {key(coordinate(v[i].x), coordinate(v[i].y), coordinate(v[i].z)), unsigned(i), v[i]};
+    });
+    std::sort(sorted.begin(), sorted.end());
+
+    // cell key -> the first entry (open addressing, the cell ends at a new key)
+    size_t mask = 1;
+    while (mask < 2 * n)
+        mask <<= 1;
+    --mask;
+    std::vector<unsigned> cells(mask + 1, ~0u);
+    for (unsigned s = 0; s != n; ++s)
+        if (s == 0 || sorted[s].key != sorted[s - 1].key) {
+            size_t h = sorted[s].key & mask;
+            while (cells[h] != ~0u)
+                h = (h + 1) & mask;
+            cells[h] = s;
+        }
+    auto find = [&](uint64_t k) {
+        for (size_t h = k & mask;; h = (h + 1) & mask)
+            if (cells[h] == ~0u || sorted[cells[h]].key == k)
+                return cells[h];
+    };
+
+    auto close = [](aiVector3D const &a, aiVector3D const &b, double eps) {
+        double dx = double(a.x) - b.x, dy = double(a.y) - b.y, dz = double(a.z) - b.z;
+        return dx * dx + dy * dy + dz * dz <= eps * eps;
+    };
+    auto close_colors = [](aiColor4D const &a, aiColor4D const &b, double eps) {
+        return std::abs(a.r - b.r) <= eps && std::abs(a.g - b.g) <= eps && std::abs(a.b - b.b) <= eps &&
+               std::abs(a.a - b.a) <= eps;
+    };
+    // the attributes (the positions are close)
+    std::vector<aiVector3D const *> directions, uvs;
+    std::vector<aiColor4D const *> colors;
+    for (aiVector3D const *a : {mesh->mNormals, mesh->mTangents, mesh->mBitangents})
+        if (a)
+            directions.push_back(a);
+    for (auto const *t : mesh->mTextureCoords)
+        if (t)
+            uvs.push_back(t);
+    for (auto const *c : mesh->mColors)
+        if (c)
+            colors.push_back(c);
+    auto same = [&](unsigned i, unsigned j) {
+        for (auto a : directions)
+            if (!close(a[i], a[j], options.normal_epsilon))
+                return false;
+        for (auto t : uvs)
+            if (!close(t[i], t[j], options.uv_epsilon))
+                return false;
+        for (auto c : colors)
+            if (!close_colors(c[i], c[j], options.color_epsilon))
+                return false;
+        return true;
+    };
+
+    // the first matching vertex of each one (in parallel and in the cell
+    // order, read only)
+    std::vector<unsigned> first(n);
+    parallel_chunks(n, options.chunk, options.threads, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s != end; ++s) {
+            entry_t const &e = sorted[s];
+            unsigned best = e.index;
+            double p[3] = {e.p.x, e.p.y, e.p.z};
+            int64_t c[3], d[3];
+            for (int a = 0; a != 3; ++a) {
+                c[a] = coordinate(p[a]);
+                // the neighbour cell the epsilon ball reaches (if any)
+                double o = p[a] - double(c[a]) * cell;
+                d[a] = o <= options.epsilon ? -1 : o >= cell - options.epsilon ? 1 : 0;
+            }
+            for (int k = 0; k != 8; ++k) {
+                if ((k & 1 && !d[0]) || (k & 2 && !d[1]) || (k & 4 && !d[2]))
+                    continue;
+                uint64_t ck = key(c[0] + (k & 1 ? d[0] : 0), c[1] + (k & 2 ? d[1] : 0), c[2] + (k & 4 ? d[2] : 0));
+                for (unsigned t = find(ck); t < n && sorted[t].key == ck; ++t) {
+                    unsigned j = sorted[t].index;
+                    if (j < best && close(e.p, sorted[t].p, options.epsilon) && same(e.index, j))
+                        best = j;
+                }
+            }
+            first[e.index] = best;
+        }
+    });
+
+    // the roots (first[i] <= i is final already) and their new numbers
+    std::vector<unsigned> remap(n);
+    unsigned used = 0;
+    for (size_t i = 0; i != n; ++i)
+        remap[i] = first[i] == i ? used++ : remap[first[i]];
+    stats.after = used;
+    if (used == n)
+        return stats;
+
+    auto compact = [&](auto *&a) {
+        if (!a)
+            return;
+        auto *c = new std::remove_reference_t<decltype(*a)>[used];
+        for (size_t i = 0; i != n; ++i)
+            if (first[i] == i)
+                c[remap[i]] = a[i];
+        delete[] a;
+        a = c;
+    };
+    compact(mesh->mVertices);
+    compact(mesh->mNormals);
+    compact(mesh->mTangents);
+    compact(mesh->mBitangents);
+    for (auto &c : mesh->mColors)
+        compact(c);
+    for (auto &t : mesh->mTextureCoords)
+        compact(t);
+    mesh->mNumVertices = used;
+
+    parallel_chunks(mesh->mNumFaces, options.chunk, options.threads, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f != end; ++f)
+            for (unsigned k = 0; k != mesh->mFaces[f].mNumIndices; ++k)
+                mesh->mFaces[f].mIndices[k] = remap[mesh->mFaces[f].mIndices[k]];
+    });
+    return stats;
+}
+
+/// @brief weld_mesh() on every mesh of the scene (see repair_scene())
+inline weld_stats_t weld_scene(aiScene *scene, weld_options_t const &options) {
+    std::vector<weld_stats_t> stats(scene->mNumMeshes);
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    if (scene->mNumMeshes >= threads) {
+        weld_options_t single = options;
+        single.threads = 1;
+        parallel_chunks(scene->mNumMeshes, 1, threads, [&](size_t begin, size_t end) {
+            for (size_t m = begin; m != end; ++m)
+                stats[m] = weld_mesh(scene->mMeshes[m], single);
+        });
+    } else {
+        for (unsigned m = 0; m != scene->mNumMeshes; ++m)
+            stats[m] = weld_mesh(scene->mMeshes[m], options);
+    }
+
+    weld_stats_t total;
+    for (auto const &s : stats)
+        total += s;
+    return total;
+}
+
+}; // namespace meshtoolbox
+
+#endif
@@ -4,9 +4,12 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <tuple>
 
 namespace fs = std::filesystem;
 
@@ -28,9 +31,18 @@ namespace fs = std::filesystem;
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#include "TileContent.h"
+#include "TilesetExporter.h"
 #include "TilesetJson.h"
+#include "TilesetReader.h"
 #include "assimp_aux.h"
+#include "meshnormalize.h"
+#include "meshrepair.h"
+#include "meshreorder.h"
+#include "meshsimplify.h"
+#include "meshtiler.h"
 #include "meshtoolbox.h"
+#include "meshweld.h"
 
 // Define implementation macros once per project.
 #define TINYGLTF_IMPLEMENTATION
@@ -370,6 +382,44 @@ TEST_F(AssimpF, load_textured_cube) {
     }
 }
 
+/// @brief Import the glb embedded in a b3dm straight from the mapped file
+/// @param --gtest_filter=AssimpF.load_b3dm_from_memory
+TEST_F(AssimpF, load_b3dm_from_memory) {
+    auto ws = create_ws();
+
+    // wrap BoxTextured.glb in a b3dm
+    std::string glb;
+    {
+        std::ifstream is(test_data("BoxTextured-glTF-Binary/BoxTextured.glb"), std::ios::binary);
+        glb.assign(std::istreambuf_iterator<char>(is), {});
+    }
+    std::string ft = R"({"BATCH_LENGTH":0})";
+    ft.resize((ft.size() + 28 + 7) / 8 * 8 - 28, ' ');
+    uint32_t header[7] = {0, 1, uint32_t(28 + ft.size() + glb.size()), uint32_t(ft.size()), 0, 0, 0};
+    std::memcpy(header, "b3dm", 4);
+    auto b3dm_file = ws / "BoxTextured.b3dm";
+    {
+        std::ofstream os(b3dm_file, std::ios::binary);
+        os.write(reinterpret_cast<const char *>(header), sizeof(header));
+        os << ft << glb;
+    }
+
+    cesiumjs::TileContent b3dm;
+    ASSERT_TRUE(b3dm.open(b3dm_file)) << b3dm.error();
+    ASSERT_EQ(glb.size(), b3dm.glb().size);
+
+    Assimp::Importer importer;
+    aiScene const *scene = b3dm.import_glb(importer, 0);
+    ASSERT_NE(nullptr, scene) << importer.GetErrorString();
+    EXPECT_EQ(1, scene->mNumMeshes);
+
+    tinygltf::TinyGLTF loader;
+    tinygltf::Model model;
+    std::string err, warn;
+    ASSERT_TRUE(b3dm.load_glb(loader, model, &err, &warn)) << err;
+    EXPECT_EQ(1, model.meshes.size());
+}
+
 /// @brief Load a textured (jpg) cube and save it as assxml
 /// @param --gtest_filter=AssimpF.load_textured_cube_jpg
 /// @param
@@ -650,6 +700,820 @@ TEST_F(AssimpF, meshtoolbox_t0) {
     }
 }
 
+/// @brief The same boxes as a b3dm (copies) and an i3dm (one unit box)
+/// @param --gtest_filter=AssimpF.meshtoolbox_instanced
+TEST_F(AssimpF, meshtoolbox_instanced) {
+    auto ws = create_ws();
+
+    meshtoolbox::Toolbox tb;
+    std::vector<meshtoolbox::box_t> boxes;
+    for (int i = 0; i != 1000; ++i)
+        boxes.push_back({{10.0 * (i % 40), 5.0 * (i / 40 % 3), 20.0 * (i / 40)}, {2, 3.0 + i % 5, 4}});
+
+    {
+        TilesetExporter exporter(ws / "b3dm");
+        exporter.add_tile(TilesetExporter::npos, 0.0, std::unique_ptr<aiScene>(tb.make_boxes(boxes)));
+        exporter.finish();
+    }
+    {
+        TilesetExporter exporter(ws / "i3dm");
+        auto instanced = tb.make_boxes_instanced(boxes);
+        EXPECT_EQ(1, instanced.model->mNumMeshes);
+        exporter.add_tile(TilesetExporter::npos, 0.0, std::move(instanced.model), std::move(instanced.instances));
+        exporter.finish();
+    }
+
+    TileTree b3dm = TilesetReader::load((ws / "b3dm/tileset.json").string());
+    TileTree i3dm = TilesetReader::load((ws / "i3dm/tileset.json").string());
+    auto expected = std::get_if<TileTree::box_t>(&b3dm[0].boundingVolume);
+    auto actual = std::get_if<TileTree::box_t>(&i3dm[0].boundingVolume);
+    ASSERT_TRUE(expected && actual);
+    for (int k = 0; k != 12; ++k)
+        EXPECT_NEAR(expected->box[k], actual->box[k], 1e-3) << k;
+
+    auto b3dm_size = fs::file_size(ws / "b3dm" / std::string(b3dm.uri(0)));
+    auto i3dm_size = fs::file_size(ws / "i3dm" / std::string(i3dm.uri(0)));
+    CONSOLE_EVAL(b3dm_size);
+    CONSOLE_EVAL(i3dm_size);
+    EXPECT_LT(i3dm_size * 5, b3dm_size);
+
+    TileContent tile;
+    ASSERT_TRUE(tile.open(ws / "i3dm" / std::string(i3dm.uri(0)))) << tile.error();
+    TileInstances instances;
+    std::string error;
+    ASSERT_TRUE(instances.parse(tile, error)) << error;
+    EXPECT_EQ(boxes.size(), instances.size());
+
+    Assimp::Importer importer;
+    auto scene = tile.import_glb(importer, 0);
+    ASSERT_TRUE(scene) << importer.GetErrorString();
+    EXPECT_EQ(1, scene->mNumMeshes);
+}
+
+/// @brief repair_mesh(): degenerate and duplicate faces, unused vertices
+/// @param --gtest_filter=AssimpF.meshrepair
+TEST_F(AssimpF, meshrepair) {
+    meshtoolbox::Toolbox tb;
+    auto broken_box = [&](int k) {
+        auto b = tb.box_builder({ai_real(k), 0, 0}, {1, 2, 3}, "broken");
+        unsigned a = b.add_vertex({0, 0, 0});
+        unsigned c = b.add_vertex({1, 1, 1});
+        unsigned d = b.add_vertex({2, 2, 2.000001f});
+        b.add_vertex({5, 5, 5}); // unused
+        b.add_triangle(a, c, d); // collinear (almost)
+        b.add_triangle(0, 0, 1); // repeated index
+        b.add_triangle(2, 1, 0); // the face 0 rotated
+        b.add_triangle(0, 1, 2); // the face 0 reversed (kept)
+        return b.to_aimesh();
+    };
+
+    std::unique_ptr<aiMesh> mesh(broken_box(0));
+    auto degenerate = meshtoolbox::degenerate_faces(mesh.get(), 1e-6);
+    EXPECT_EQ(16, degenerate.size());
+    EXPECT_EQ(2, std::count(degenerate.begin(), degenerate.end(), 1));
+
+    meshtoolbox::repair_options_t options;
+    options.epsilon = 1e-6;
+    auto stats = meshtoolbox::repair_mesh(mesh.get(), options);
+    EXPECT_EQ(2, stats.degenerate);
+    EXPECT_EQ(1, stats.duplicates);
+    EXPECT_EQ(4, stats.unused_vertices);
+    EXPECT_EQ(13, mesh->mNumFaces);
+    EXPECT_EQ(8, mesh->mNumVertices);
+    EXPECT_EQ(2, mesh->mFaces[12].mIndices[2]);
+    EXPECT_TRUE(meshtoolbox::degenerate_faces(mesh.get()) == std::vector<uint8_t>(13, 0));
+
+    // many meshes in parallel
+    std::vector<aiMesh *> meshes;
+    for (int k = 0; k != 64; ++k)
+        meshes.push_back(broken_box(k));
+    std::unique_ptr<aiScene> scene(tb.make_scene(meshes));
+    options.threads = 4;
+    std::vector<meshtoolbox::repair_stats_t> per_mesh;
+    auto total = meshtoolbox::repair_scene(scene.get(), options, &per_mesh);
+    EXPECT_EQ(64 * 2, total.degenerate);
+    EXPECT_EQ(64, total.duplicates);
+    EXPECT_EQ(64 * 4, total.unused_vertices);
+    ASSERT_EQ(64, per_mesh.size());
+    EXPECT_EQ(aiVector3D(63 + 1, 2, 3), scene->mMeshes[63]->mVertices[6]);
+
+    // the kernel pairs and the odd tails of any chunk size; points and
+    // polygons are never marked
+    auto mixed = tb.box_builder({0, 0, 0}, {1, 2, 3}, "mixed");
+    mixed.add_point(0);
+    mixed.add_face({0, 0, 1, 2});
+    mixed.add_triangle(3, 3, 3);
+    mixed.add_triangle(0, 1, 1);
+    std::unique_ptr<aiMesh> flags_mesh(mixed.to_aimesh());
+    auto expected = meshtoolbox::degenerate_faces(flags_mesh.get(), 1e-6, 1);
+    EXPECT_TRUE((std::vector<uint8_t>{0, 0, 1, 1}) == std::vector<uint8_t>(expected.end() - 4, expected.end()));
+    for (size_t chunk : {1, 2, 3, 5})
+        EXPECT_TRUE(expected == meshtoolbox::degenerate_faces(flags_mesh.get(), 1e-6, 2, chunk)) << chunk;
+
+    // the faces on an arena: the removed ones are detached, not deleted
+    auto on_arena = meshtoolbox::new_arena_scene();
+    on_arena->mNumMeshes = 8;
+    on_arena->mMeshes = new aiMesh *[8];
+    for (int k = 0; k != 8; ++k) {
+        std::unique_ptr<aiMesh> owned(broken_box(k));
+        auto b = tb.box_builder({ai_real(k), 0, 0}, {1, 2, 3}, "broken");
+        for (unsigned i = 8; i != owned->mNumVertices; ++i)
+            b.add_vertex(owned->mVertices[i]);
+        for (unsigned f = 12; f != owned->mNumFaces; ++f)
+            b.add_face(owned->mFaces[f].mIndices, 3);
+        on_arena->mMeshes[k] = b.to_aimesh(meshtoolbox::arena_of(on_arena));
+    }
+    total = meshtoolbox::repair_scene(on_arena, options);
+    EXPECT_EQ(8 * 2, total.degenerate);
+    EXPECT_EQ(8, total.duplicates);
+    EXPECT_EQ(13, on_arena->mMeshes[7]->mNumFaces);
+}
+
+/// @brief weld_mesh(): a grid of unshared triangles (photogrammetry-like)
+/// @param --gtest_filter=AssimpF.meshweld
+TEST_F(AssimpF, meshweld) {
+    const unsigned W = 300, H = 200;
+    auto grid = [&](float jitter, bool seam) {
+        meshtoolbox::MeshBuilder b("grid");
+        unsigned k = 0;
+        auto corner = [&](unsigned x, unsigned y) {
+            float j = jitter * float(k++ % 7) / 7;
+            // the texture coordinates jump at x == W / 2 (a seam)
+            float u = seam && x == W / 2 && k % 2 ? 0.f : float(x) / W;
+            return b.add_vertex({x + j, y - j, 1000 + j}, {0, 0, 1}, {u, float(y) / H, 0});
+        };
+        for (unsigned y = 0; y != H; ++y)
+            for (unsigned x = 0; x != W; ++x) {
+                b.add_triangle(corner(x, y), corner(x + 1, y), corner(x + 1, y + 1));
+                b.add_triangle(corner(x, y), corner(x + 1, y + 1), corner(x, y + 1));
+            }
+        return std::unique_ptr<aiMesh>(b.to_aimesh());
+    };
+
+    meshtoolbox::weld_options_t options;
+    options.epsilon = 1e-3;
+    options.threads = 4;
+    auto mesh = grid(1e-4f, false);
+    auto stats = meshtoolbox::weld_mesh(mesh.get(), options);
+    CONSOLE_EVAL(stats.before);
+    CONSOLE_EVAL(stats.after);
+    EXPECT_EQ(6 * W * H, stats.before);
+    EXPECT_EQ((W + 1) * (H + 1), stats.after);
+    EXPECT_EQ(stats.after, mesh->mNumVertices);
+    for (unsigned f = 0; f != mesh->mNumFaces; ++f)
+        for (unsigned k = 0; k != 3; ++k)
+            ASSERT_LT(mesh->mFaces[f].mIndices[k], mesh->mNumVertices);
+    // the face (x, y) = (1, 0) starts at the second vertex of the first row
+    EXPECT_NEAR(1, mesh->mVertices[mesh->mFaces[2].mIndices[0]].x, 1e-3);
+
+    // the same from one thread
+    auto serial = grid(1e-4f, false);
+    options.threads = 1;
+    meshtoolbox::weld_mesh(serial.get(), options);
+    ASSERT_EQ(mesh->mNumVertices, serial->mNumVertices);
+    for (unsigned f = 0; f != mesh->mNumFaces; ++f)
+        ASSERT_EQ(0, std::memcmp(mesh->mFaces[f].mIndices, serial->mFaces[f].mIndices, 3 * sizeof(unsigned)));
+
+    // the texture seam is kept
+    auto seam = grid(0, true);
+    stats = meshtoolbox::weld_mesh(seam.get(), options);
+    EXPECT_LT((W + 1) * (H + 1), stats.after);
+    EXPECT_GT((W + 1) * (H + 1) + 2 * (H + 1), stats.after);
+
+    // out of the tolerance: nothing welds
+    auto jitter = grid(1e-2f, false);
+    options.epsilon = 1e-4;
+    stats = meshtoolbox::weld_mesh(jitter.get(), options);
+    EXPECT_LT(3 * (W + 1) * (H + 1), stats.after);
+}
+
+/// @brief normalize_scene(): UTM-scale meshes moved next to the origin in place
+/// @param --gtest_filter=AssimpF.meshnormalize
+TEST_F(AssimpF, meshnormalize) {
+    // Mike_Niwot_quick_subset_Zup: { 496791.25, 1624.61084, -4420783 }
+    aiVector3D const corner{496791.25f, 1624.61084f, -4420783.f};
+    meshtoolbox::Toolbox tb;
+    std::vector<aiMesh *> meshes;
+    for (int k = 0; k != 16; ++k) {
+        meshtoolbox::MeshBuilder b("terrain");
+        for (int i = 0; i != 1000; ++i)
+            b.add_vertex(corner + aiVector3D(ai_real(k * 7 + (i % 113) * 0.37f), ai_real((i % 17) * 0.05f),
+                                             ai_real(k * 3 + (i % 101) * 0.13f)));
+        for (unsigned i = 0; i + 2 < 1000; i += 3)
+            b.add_triangle(i, i + 1, i + 2);
+        meshes.push_back(b.to_aimesh());
+    }
+    std::unique_ptr<aiScene> scene(tb.make_scene(meshes));
+    std::vector<aiVector3D> original(scene->mMeshes[15]->mVertices,
+                                     scene->mMeshes[15]->mVertices + scene->mMeshes[15]->mNumVertices);
+    aiVector3D const *vertices = scene->mMeshes[15]->mVertices;
+
+    meshtoolbox::normalize_options_t options;
+    options.threads = 4;
+    options.chunk = 64;
+    auto serial = meshtoolbox::scene_bounds(scene.get(), 1);
+    auto rtc = meshtoolbox::normalize_scene(scene.get(), options);
+    for (int a = 0; a != 3; ++a) {
+        EXPECT_EQ(serial.min[a], rtc.bounds.min[a]);
+        EXPECT_EQ(serial.max[a], rtc.bounds.max[a]);
+        EXPECT_EQ(rtc.bounds.min[a], rtc.offset[a]);
+    }
+    EXPECT_EQ(double(corner.x), rtc.offset[0]);
+    EXPECT_EQ(double(corner.z), rtc.offset[2]);
+    EXPECT_EQ(rtc.offset[1], rtc.transform()[13]);
+
+    // in place, and the offset gives the original vertices back
+    EXPECT_EQ(vertices, scene->mMeshes[15]->mVertices);
+    for (size_t i = 0; i != original.size(); ++i) {
+        aiVector3D const &v = vertices[i];
+        ASSERT_EQ(double(original[i].x), v.x + rtc.offset[0]);
+        ASSERT_EQ(double(original[i].y), v.y + rtc.offset[1]);
+        ASSERT_EQ(double(original[i].z), v.z + rtc.offset[2]);
+    }
+    auto normalized = meshtoolbox::scene_bounds(scene.get());
+    for (int a = 0; a != 3; ++a)
+        EXPECT_EQ(0, normalized.min[a]);
+
+    // the center: the double center of the float bounds is not a float
+    options.origin = meshtoolbox::origin_t::center;
+    double const back[3] = {-rtc.offset[0], -rtc.offset[1], -rtc.offset[2]};
+    meshtoolbox::translate_scene(scene.get(), back);
+    rtc = meshtoolbox::normalize_scene(scene.get(), options);
+    EXPECT_EQ(0.5 * (serial.min[0] + serial.max[0]), rtc.offset[0]);
+    normalized = meshtoolbox::scene_bounds(scene.get());
+    for (int a = 0; a != 3; ++a)
+        EXPECT_NEAR(-normalized.min[a], normalized.max[a], 1e-4);
+
+    // the tile transform (column major) takes the vertices back
+    auto t = rtc.transform();
+    for (size_t i = 0; i != original.size(); ++i) {
+        aiVector3D const &v = vertices[i];
+        double p[3];
+        for (int a = 0; a != 3; ++a)
+            p[a] = t[a] * v.x + t[4 + a] * v.y + t[8 + a] * v.z + t[12 + a];
+        ASSERT_NEAR(original[i].x, p[0], 1e-3);
+        ASSERT_NEAR(original[i].y, p[1], 1e-3);
+        ASSERT_NEAR(original[i].z, p[2], 1e-3);
+    }
+
+    // one big mesh: parallel vertex chunks, as one thread
+    std::unique_ptr<aiScene> big(tb.make_cylinder(corner, 10, 1, 4096));
+    std::unique_ptr<aiScene> big_serial(tb.make_cylinder(corner, 10, 1, 4096));
+    double const offset[3] = {double(corner.x) - 0.25, double(corner.y), double(corner.z) + 0.5};
+    meshtoolbox::translate_scene(big.get(), offset, 4, 64);
+    meshtoolbox::translate_scene(big_serial.get(), offset, 1);
+    ASSERT_EQ(big_serial->mMeshes[0]->mNumVertices, big->mMeshes[0]->mNumVertices);
+    for (unsigned i = 0; i != big->mMeshes[0]->mNumVertices; ++i)
+        ASSERT_EQ(big_serial->mMeshes[0]->mVertices[i], big->mMeshes[0]->mVertices[i]);
+    EXPECT_EQ(ai_real(0.25), big->mMeshes[0]->mVertices[2 * 4096].x);
+
+    // nothing to normalize
+    std::unique_ptr<aiScene> empty(tb.make_scene(std::vector<aiMesh *>{}));
+    rtc = meshtoolbox::normalize_scene(empty.get());
+    EXPECT_TRUE(rtc.bounds.empty());
+    EXPECT_EQ(0, rtc.offset[0]);
+}
+
+/// @brief simplify_mesh(): terrain tiles reduced for a coarser level of detail
+/// @param --gtest_filter=AssimpF.meshsimplify
+TEST_F(AssimpF, meshsimplify) {
+    auto ws = create_ws();
+    const unsigned W = 60, H = 40;
+    // a height field tile, a UV seam (the vertices split) at x == seam
+    auto terrain = [&](int tile, float amplitude, unsigned seam = 0) {
+        meshtoolbox::MeshBuilder b("tile " + std::to_string(tile));
+        std::vector<unsigned> grid((W + 1) * (H + 1)), split(H + 1);
+        for (unsigned y = 0; y <= H; ++y)
+            for (unsigned x = 0; x <= W; ++x) {
+                float X = float(tile * W + x), Y = float(y);
+                aiVector3D p{X, Y, amplitude * std::sin(X / 7) * std::cos(Y / 5)};
+                grid[y * (W + 1) + x] = b.add_vertex(p, {0, 0, 1}, {X / W, Y / H, 0});
+                if (seam && x == seam)
+                    split[y] = b.add_vertex(p, {0, 0, 1}, {0, Y / H, 0});
+            }
+        // the cells right of the seam use the split vertices
+        auto v = [&](unsigned x, unsigned y, unsigned cell) {
+            return seam && x == seam && cell >= seam ? split[y] : grid[y * (W + 1) + x];
+        };
+        for (unsigned y = 0; y != H; ++y)
+            for (unsigned x = 0; x != W; ++x) {
+                b.add_triangle(v(x, y, x), v(x + 1, y, x), v(x + 1, y + 1, x));
+                b.add_triangle(v(x, y, x), v(x + 1, y + 1, x), v(x, y + 1, x));
+            }
+        return b.to_aimesh();
+    };
+
+    // a plane: the interior goes, the outline stays, no error
+    std::unique_ptr<aiMesh> flat(terrain(0, 0));
+    meshtoolbox::simplify_options_t options;
+    options.target_faces = 1;
+    auto stats = meshtoolbox::simplify_mesh(flat.get(), options);
+    CONSOLE_EVAL(stats.faces_after);
+    CONSOLE_EVAL(stats.vertices_after);
+    EXPECT_EQ(2 * W * H, stats.faces_before);
+    EXPECT_EQ(flat->mNumFaces, stats.faces_after);
+    EXPECT_GT(W * H / 4, stats.faces_after);
+    EXPECT_LE(2 * (W + H), stats.vertices_after);
+    EXPECT_GE(2 * (W + H) + 4, stats.vertices_after);
+    EXPECT_NEAR(0, stats.error, 1e-6);
+    EXPECT_TRUE(meshtoolbox::degenerate_faces(flat.get()) == std::vector<uint8_t>(flat->mNumFaces, 0));
+
+    // the outline collapses along itself down to the corners
+    flat.reset(terrain(0, 0));
+    options.lock_boundary = false;
+    options.max_error = 1e-6;
+    stats = meshtoolbox::simplify_mesh(flat.get(), options);
+    EXPECT_GE(4, stats.faces_after);
+    EXPECT_EQ(4, stats.vertices_after);
+    options.lock_boundary = true;
+
+    // the error bound
+    std::unique_ptr<aiMesh> hills(terrain(0, 3));
+    options.target_faces = 0;
+    options.target_ratio = 0;
+    options.max_error = 0.2;
+    stats = meshtoolbox::simplify_mesh(hills.get(), options);
+    CONSOLE_EVAL(stats.faces_after);
+    CONSOLE_EVAL(stats.error);
+    EXPECT_LT(stats.faces_after, stats.faces_before / 2);
+    EXPECT_LE(stats.error, options.max_error);
+    EXPECT_GT(stats.error, 0);
+
+    // the seam vertices stay, both sides
+    std::unique_ptr<aiMesh> seamed(terrain(0, 3, W / 2));
+    EXPECT_EQ((W + 2) * (H + 1), seamed->mNumVertices);
+    options.max_error = std::numeric_limits<double>::infinity();
+    options.target_ratio = 0.1;
+    stats = meshtoolbox::simplify_mesh(seamed.get(), options);
+    EXPECT_GE(stats.faces_before / 10, stats.faces_after);
+    size_t on_seam = 0, seam_uv0 = 0;
+    for (unsigned i = 0; i != seamed->mNumVertices; ++i)
+        if (seamed->mVertices[i].x == W / 2) {
+            ++on_seam;
+            seam_uv0 += seamed->mTextureCoords[0][i].x == 0;
+        }
+    EXPECT_EQ(2 * (H + 1), on_seam);
+    EXPECT_EQ(H + 1, seam_uv0);
+
+    // the tiles in parallel, as one after the other
+    meshtoolbox::Toolbox tb;
+    std::vector<aiMesh *> tiles, copies;
+    for (int t = 0; t != 8; ++t) {
+        tiles.push_back(terrain(t, 3));
+        copies.push_back(terrain(t, 3));
+    }
+    std::unique_ptr<aiScene> coarse(tb.make_scene(tiles));
+    std::unique_ptr<aiScene> serial(tb.make_scene(copies));
+    options.threads = 4;
+    options.target_ratio = 0.25;
+    std::vector<meshtoolbox::simplify_stats_t> per_tile;
+    auto total = meshtoolbox::simplify_scene(coarse.get(), options, &per_tile);
+    options.threads = 1;
+    auto total_serial = meshtoolbox::simplify_scene(serial.get(), options);
+    EXPECT_EQ(total_serial.faces_after, total.faces_after);
+    EXPECT_EQ(total_serial.error, total.error);
+    ASSERT_EQ(8, per_tile.size());
+    for (auto const &s : per_tile)
+        EXPECT_LE(s.error, total.error);
+    EXPECT_GE(total.faces_before / 4, total.faces_after);
+
+    // the error is the geometricError of the coarse tile, the full
+    // resolution children have none
+    {
+        TilesetExporter exporter(ws / "lod");
+        auto root = exporter.add_tile(TilesetExporter::npos, total.error, std::move(coarse));
+        for (int t = 0; t != 8; ++t) {
+            std::vector<aiMesh *> one{terrain(t, 3)};
+            exporter.add_tile(root, 0.0, std::unique_ptr<aiScene>(tb.make_scene(one)));
+        }
+        exporter.finish();
+    }
+    TileTree lod = TilesetReader::load((ws / "lod/tileset.json").string());
+    EXPECT_EQ(9, lod.size());
+    EXPECT_EQ(total.error, lod[lod.root()].geometricError);
+
+    // a Toolbox cylinder, its faces owned or on an arena: the same result
+    std::unique_ptr<aiScene> cylinder(tb.make_cylinder({0, 0, 0}, 10, 1, 64));
+    auto on_arena = meshtoolbox::new_arena_scene();
+    on_arena->mNumMeshes = 1;
+    on_arena->mMeshes = new aiMesh *[1]{tb.mesh_cylinder({0, 0, 0}, 10, 1, 64, meshtoolbox::arena_of(on_arena), "cylinder")};
+    options = meshtoolbox::simplify_options_t();
+    auto owned = meshtoolbox::simplify_scene(cylinder.get(), options);
+    auto arena = meshtoolbox::simplify_scene(on_arena, options);
+    EXPECT_LT(owned.faces_after, owned.faces_before);
+    EXPECT_EQ(owned.faces_after, arena.faces_after);
+    EXPECT_EQ(owned.error, arena.error);
+    EXPECT_EQ(on_arena->mMeshes[0]->mNumFaces, arena.faces_after);
+}
+
+/// @brief reorder_mesh(): a grid in a scrambled triangle order
+/// @param --gtest_filter=AssimpF.meshreorder
+TEST_F(AssimpF, meshreorder) {
+    const unsigned W = 200, H = 150;
+    auto scrambled = [&](unsigned seed) {
+        meshtoolbox::MeshBuilder b("grid");
+        for (unsigned y = 0; y <= H; ++y)
+            for (unsigned x = 0; x <= W; ++x)
+                b.add_vertex({float(x), float(y), 0}, {0, 0, 1}, {float(x) / W, float(y) / H, 0});
+        std::vector<std::array<unsigned, 3>> triangles;
+        for (unsigned y = 0; y != H; ++y)
+            for (unsigned x = 0; x != W; ++x) {
+                unsigned i = y * (W + 1) + x;
+                triangles.push_back({i, i + 1, i + W + 2});
+                triangles.push_back({i, i + W + 2, i + W + 1});
+            }
+        for (size_t t = triangles.size() - 1; t; --t) {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(triangles[t], triangles[seed % (t + 1)]);
+        }
+        for (auto const &t : triangles)
+            b.add_triangle(t[0], t[1], t[2]);
+        return b.to_aimesh();
+    };
+    // the triangles by their corners, from the smallest one (the winding kept)
+    auto corners = [](aiMesh const *mesh) {
+        std::vector<std::array<float, 9>> r;
+        for (unsigned f = 0; f != mesh->mNumFaces; ++f) {
+            unsigned const *i = mesh->mFaces[f].mIndices;
+            unsigned s = 0;
+            for (unsigned k = 1; k != 3; ++k)
+                if (std::tie(mesh->mVertices[i[k]].x, mesh->mVertices[i[k]].y) <
+                    std::tie(mesh->mVertices[i[s]].x, mesh->mVertices[i[s]].y))
+                    s = k;
+            std::array<float, 9> c;
+            for (unsigned k = 0; k != 3; ++k) {
+                unsigned v = i[(s + k) % 3];
+                c[3 * k] = mesh->mVertices[v].x;
+                c[3 * k + 1] = mesh->mVertices[v].y;
+                c[3 * k + 2] = mesh->mTextureCoords[0][v].x;
+            }
+            r.push_back(c);
+        }
+        std::sort(r.begin(), r.end());
+        return r;
+    };
+
+    std::unique_ptr<aiMesh> mesh(scrambled(1));
+    auto before = corners(mesh.get());
+    meshtoolbox::reorder_options_t options;
+    auto stats = meshtoolbox::reorder_mesh(mesh.get(), options);
+    CONSOLE_EVAL(stats.acmr_before());
+    CONSOLE_EVAL(stats.acmr_after());
+    EXPECT_EQ(2 * W * H, stats.triangles);
+    EXPECT_LT(2.5, stats.acmr_before());
+    EXPECT_GT(0.8, stats.acmr_after());
+    EXPECT_EQ(stats.misses_after, meshtoolbox::cache_misses(mesh.get()));
+    EXPECT_TRUE(before == corners(mesh.get()));
+
+    // the vertices by first use
+    unsigned next = 0;
+    for (unsigned f = 0; f != mesh->mNumFaces; ++f)
+        for (unsigned k = 0; k != 3; ++k) {
+            ASSERT_GE(next, mesh->mFaces[f].mIndices[k]);
+            next = std::max(next, mesh->mFaces[f].mIndices[k] + 1);
+        }
+    EXPECT_EQ(mesh->mNumVertices, next);
+
+    // the meshes in parallel, as one after the other
+    meshtoolbox::Toolbox tb;
+    std::vector<aiMesh *> meshes, copies;
+    for (unsigned m = 0; m != 6; ++m) {
+        meshes.push_back(scrambled(m));
+        copies.push_back(scrambled(m));
+    }
+    std::unique_ptr<aiScene> scene(tb.make_scene(meshes)), serial(tb.make_scene(copies));
+    options.threads = 4;
+    std::vector<meshtoolbox::reorder_stats_t> per_mesh;
+    auto total = meshtoolbox::reorder_scene(scene.get(), options, &per_mesh);
+    options.threads = 1;
+    EXPECT_EQ(total.misses_after, meshtoolbox::reorder_scene(serial.get(), options).misses_after);
+    ASSERT_EQ(6, per_mesh.size());
+    EXPECT_EQ(6 * stats.triangles, total.triangles);
+    EXPECT_GT(total.acmr_before() / 3, total.acmr_after());
+
+    // the exporter reorders the tiles it writes
+    auto ws = create_ws();
+    TilesetExporter::options_t exporter_options;
+    exporter_options.reorder = true;
+    {
+        TilesetExporter exporter(ws / "reordered", exporter_options);
+        std::vector<aiMesh *> one{scrambled(7)};
+        exporter.add_tile(TilesetExporter::npos, 0.0, std::unique_ptr<aiScene>(tb.make_scene(one)));
+        exporter.finish();
+    }
+    EXPECT_EQ(1, TilesetReader::load((ws / "reordered/tileset.json").string()).size());
+
+    // a Toolbox scene, as reordered before it is exported
+    std::vector<meshtoolbox::cylinder_t> cylinders;
+    for (int i = 0; i != 8; ++i)
+        cylinders.push_back({{3.0f * i, 0, 0}, ai_real(2 + i), 1});
+    std::unique_ptr<aiScene> model(tb.make_cylinders(cylinders, 64));
+    auto acmr = meshtoolbox::reorder_scene(model.get(), meshtoolbox::reorder_options_t{});
+    EXPECT_EQ(8 * 4 * 64, acmr.triangles);
+    EXPECT_LE(acmr.acmr_after(), acmr.acmr_before());
+    size_t misses = 0;
+    for (unsigned m = 0; m != model->mNumMeshes; ++m)
+        misses += meshtoolbox::cache_misses(model->mMeshes[m]);
+    EXPECT_EQ(acmr.misses_after, misses);
+}
+
+/// @brief tile_mesh(): a terrain cut into a quadtree of RTC tiles
+/// @param --gtest_filter=AssimpF.meshtiler
+TEST_F(AssimpF, meshtiler) {
+    auto ws = create_ws();
+    const unsigned W = 160, H = 120;
+    double const X0 = 496791.25, Z0 = -4420783; // UTM-scale, Y is up
+    meshtoolbox::MeshBuilder b("terrain");
+    for (unsigned z = 0; z <= H; ++z)
+        for (unsigned x = 0; x <= W; ++x)
+            b.add_vertex({ai_real(X0 + 0.5 * x), ai_real(1600 + 5 * std::sin(x / 9.0)), ai_real(Z0 + 0.5 * z)},
+                         {0, 1, 0}, {float(x) / W, float(z) / H, 0});
+    for (unsigned z = 0; z != H; ++z)
+        for (unsigned x = 0; x != W; ++x) {
+            unsigned i = z * (W + 1) + x;
+            b.add_triangle(i, i + W + 1, i + 1);
+            b.add_triangle(i + 1, i + W + 1, i + W + 2);
+        }
+    std::unique_ptr<aiMesh> terrain(b.to_aimesh());
+    // the area seen from above
+    auto area = [](aiMesh const *m) {
+        double r = 0;
+        for (unsigned f = 0; f != m->mNumFaces; ++f) {
+            aiVector3D const &a = m->mVertices[m->mFaces[f].mIndices[0]];
+            aiVector3D const &b = m->mVertices[m->mFaces[f].mIndices[1]];
+            aiVector3D const &c = m->mVertices[m->mFaces[f].mIndices[2]];
+            r += 0.5 * std::abs(double(b.x - a.x) * (c.z - a.z) - double(b.z - a.z) * (c.x - a.x));
+        }
+        return r;
+    };
+
+    meshtoolbox::tiler_options_t options;
+    options.max_faces = 4000;
+    options.threads = 4;
+    auto tiles = meshtoolbox::tile_mesh(terrain.get(), options);
+    CONSOLE_EVAL(tiles.size());
+    ASSERT_LT(1, tiles.size());
+    size_t leaves = 0;
+    double tiled_area = 0;
+    for (size_t t = 0; t != tiles.size(); ++t) {
+        auto const &tile = tiles[t];
+        EXPECT_TRUE(t == 0 ? tile.parent == ~0u : tile.parent < t);
+        if (!tile.mesh) {
+            EXPECT_LT(options.max_faces, tile.faces);
+            continue;
+        }
+        ++leaves;
+        EXPECT_GE(options.max_faces, tile.faces);
+        tiled_area += area(tile.mesh.get());
+        EXPECT_TRUE(meshtoolbox::degenerate_faces(tile.mesh.get()) ==
+                    std::vector<uint8_t>(tile.mesh->mNumFaces, 0));
+        for (unsigned i = 0; i != tile.mesh->mNumVertices; ++i) {
+            aiVector3D const &v = tile.mesh->mVertices[i];
+            // relative to the center, inside the cell
+            double x = v.x + tile.rtc[0], z = v.z + tile.rtc[2];
+            ASSERT_LE(std::abs(v.x), 0.5 * (tile.hi[0] - tile.lo[0]) + 1e-3);
+            ASSERT_LE(std::abs(v.z), 0.5 * (tile.hi[2] - tile.lo[2]) + 1e-3);
+            // the interpolated attributes
+            ASSERT_NEAR((x - X0) / 0.5 / W, tile.mesh->mTextureCoords[0][i].x, 1e-4);
+            ASSERT_NEAR((z - Z0) / 0.5 / H, tile.mesh->mTextureCoords[0][i].y, 1e-4);
+            ASSERT_NEAR(1, tile.mesh->mNormals[i].y, 1e-6);
+        }
+    }
+    EXPECT_LE(4, leaves);
+    EXPECT_NEAR(area(terrain.get()), tiled_area, 1e-3 * area(terrain.get()));
+
+    // by centroid: every triangle once
+    options.clip = false;
+    options.threads = 1;
+    size_t assigned = 0;
+    for (auto const &tile : meshtoolbox::tile_mesh(terrain.get(), options))
+        assigned += tile.mesh ? tile.mesh->mNumFaces : 0;
+    EXPECT_EQ(terrain->mNumFaces, assigned);
+
+    // the hierarchy, the leaves placed by their RTC transforms
+    {
+        TilesetExporter exporter(ws / "tiles");
+        auto root = exporter.add_tile(TilesetExporter::npos, 100.0);
+        auto ids = meshtoolbox::add_tiles(exporter, tiles, root);
+        EXPECT_EQ(tiles.size(), ids.size());
+        exporter.finish();
+    }
+    TileTree tree = TilesetReader::load((ws / "tiles/tileset.json").string());
+    EXPECT_EQ(tiles.size() + 1, tree.size());
+    size_t placed = 0;
+    for (TileTree::index_t i = 0; i != tree.size(); ++i)
+        if (auto tr = tree.transform(i)) {
+            ++placed;
+            EXPECT_NEAR(X0, tr->matrix4x4[12], 0.5 * W);
+            EXPECT_NEAR(-Z0, tr->matrix4x4[13], 0.5 * H);
+        }
+    EXPECT_EQ(leaves, placed);
+
+    // triangles touching a cell only at its planes: no cell without content
+    meshtoolbox::MeshBuilder corners("corners");
+    corners.add_triangle(corners.add_vertex({0, 0, 0}), corners.add_vertex({0, 0, 1}), corners.add_vertex({1, 0, 0}));
+    corners.add_triangle(corners.add_vertex({1, 0, 1}), corners.add_vertex({1, 0, 2}), corners.add_vertex({2, 0, 1}));
+    std::unique_ptr<aiMesh> touching(corners.to_aimesh());
+    options = meshtoolbox::tiler_options_t();
+    options.max_faces = 1;
+    options.max_depth = 1;
+    options.threads = 1;
+    auto cells = meshtoolbox::tile_mesh(touching.get(), options);
+    EXPECT_EQ(3, cells.size());
+    for (size_t t = 1; t != cells.size(); ++t)
+        EXPECT_TRUE(cells[t].mesh) << t;
+
+    // an empty leaf is left out
+    cells.emplace_back();
+    cells.back().parent = 0;
+    cells.back().level = 1;
+    {
+        TilesetExporter exporter(ws / "touching");
+        auto ids = meshtoolbox::add_tiles(exporter, cells, TilesetExporter::npos);
+        EXPECT_EQ(TilesetExporter::npos, ids.back());
+        EXPECT_NO_THROW(exporter.finish());
+    }
+    EXPECT_EQ(3, TilesetReader::load((ws / "touching/tileset.json").string()).size());
+}
+
+/// @brief The bulk lidar mesh: UTM-scale points relative to an RTC center
+/// @param --gtest_filter=AssimpF.meshtoolbox_lidar_bulk
+TEST_F(AssimpF, meshtoolbox_lidar_bulk) {
+    meshtoolbox::Toolbox tb;
+
+    const size_t N = 1000000;
+    meshtoolbox::lidar_options_t options;
+    options.rtc_center = {500000, 4400000, 1600};
+    options.intensity = true;
+
+    std::vector<meshtoolbox::lidar_point_t> points(N);
+    std::vector<meshtoolbox::lidarptr_t> relative(N);
+    for (size_t i = 0; i != N; ++i) {
+        auto &p = points[i];
+        p = {500000.0 + (i % 1000) * 0.01, 4400000.0 + (i / 1000) * 0.01, 1600.0 + (i % 7) * 0.125,
+             uint16_t(i), uint16_t(i * 3), uint16_t(i * 5), uint16_t(i * 7)};
+        relative[i] = {ai_real(p.x - options.rtc_center.x), ai_real(p.y - options.rtc_center.y),
+                       ai_real(p.z - options.rtc_center.z), p.r, p.g, p.b};
+    }
+
+    std::unique_ptr<aiScene> expected(tb.make_lidar_pc(relative.data(), N));
+    auto actual = tb.make_lidar_pc_bulk(points.data(), N, options);
+
+    aiMesh const *a = expected->mMeshes[0];
+    aiMesh const *b = actual->mMeshes[0];
+    ASSERT_EQ(N, b->mNumVertices);
+    ASSERT_EQ(N, b->mNumFaces);
+    EXPECT_EQ(aiPrimitiveType_POINT, b->mPrimitiveTypes);
+    ASSERT_TRUE(b->mColors[0] && b->mColors[1]);
+    for (size_t i = 0; i < N; i += 997) {
+        EXPECT_EQ(a->mVertices[i], b->mVertices[i]) << i;
+        EXPECT_EQ(a->mColors[0][i], b->mColors[0][i]) << i;
+        EXPECT_EQ(i, b->mFaces[i].mIndices[0]);
+        EXPECT_FLOAT_EQ(points[i].intensity / 65535.0f, b->mColors[1][i].r);
+    }
+
+    // the same result from one thread
+    options.threads = 1;
+    auto serial = tb.make_lidar_pc_bulk(points.data(), N, options);
+    EXPECT_EQ(0, std::memcmp(serial->mMeshes[0]->mVertices, b->mVertices, N * sizeof(aiVector3D)));
+}
+
+/// @brief make_boxes() and make_cylinders() against the shared unit mesh scenes
+/// @param --gtest_filter=AssimpF.meshtoolbox_shared
+TEST_F(AssimpF, meshtoolbox_shared) {
+    meshtoolbox::Toolbox tb;
+    using sharing_t = meshtoolbox::Toolbox::sharing_t;
+
+    std::vector<meshtoolbox::box_t> boxes;
+    std::vector<unsigned> materials;
+    for (int i = 0; i != 10000; ++i) {
+        boxes.push_back({{10.0 * (i % 100), 5.0 * (i / 100 % 7), 20.0 * (i / 100)}, {2, 3.0 + i % 5, 4}});
+        materials.push_back(i % 3);
+    }
+
+    auto bounds = [](aiScene const *scene) {
+        std::array<double, 6> r;
+        TilesetExporter::scene_bounds(scene, false, r.data(), r.data() + 3);
+        return r;
+    };
+    auto vertices = [](aiScene const *scene) {
+        size_t n = 0;
+        for (unsigned k = 0; k != scene->mNumMeshes; ++k)
+            n += scene->mMeshes[k]->mNumVertices;
+        return n;
+    };
+
+    std::unique_ptr<aiScene> copies(tb.make_boxes(boxes));
+    std::unique_ptr<aiScene> shared(tb.make_boxes_shared(boxes));
+    std::unique_ptr<aiScene> by_material(tb.make_boxes_shared(boxes, materials));
+    std::unique_ptr<aiScene> merged(tb.make_boxes_shared(boxes, materials, sharing_t::merge_by_material));
+
+    EXPECT_EQ(1, shared->mNumMeshes);
+    EXPECT_EQ(boxes.size(), shared->mRootNode->mNumChildren);
+    EXPECT_EQ(3, by_material->mNumMeshes);
+    EXPECT_EQ(2, by_material->mMeshes[by_material->mRootNode->mChildren[5]->mMeshes[0]]->mMaterialIndex);
+    EXPECT_EQ(3, merged->mNumMeshes);
+    EXPECT_EQ(3, merged->mRootNode->mNumChildren);
+    EXPECT_EQ(vertices(copies.get()), vertices(merged.get()));
+    EXPECT_EQ(8, vertices(shared.get()));
+
+    auto expected = bounds(copies.get());
+    for (aiScene const *actual : {shared.get(), by_material.get(), merged.get()}) {
+        auto b = bounds(actual);
+        for (int k = 0; k != 6; ++k)
+            EXPECT_NEAR(expected[k], b[k], 1e-3) << k;
+    }
+
+    // the same box through its node and baked
+    aiNode const *node = shared->mRootNode->mChildren[1234];
+    aiVector3D corner = node->mTransformation * shared->mMeshes[0]->mVertices[6];
+    EXPECT_EQ(copies->mMeshes[1234]->mVertices[6], corner);
+
+    std::unique_ptr<aiScene> transformed(tb.make_boxes_with_transform(boxes));
+    std::unique_ptr<aiScene> transformed_shared(tb.make_boxes_with_transform_shared(boxes));
+    EXPECT_EQ(transformed->mRootNode->mTransformation, transformed_shared->mRootNode->mTransformation);
+
+    std::vector<meshtoolbox::cylinder_t> cylinders;
+    for (int i = 0; i != 1000; ++i)
+        cylinders.push_back({{10.0 * (i % 40), 0, 20.0 * (i / 40)}, ai_real(3 + i % 4), 1});
+    std::unique_ptr<aiScene> cylinder_copies(tb.make_cylinders(cylinders, 40));
+    std::unique_ptr<aiScene> cylinders_shared(tb.make_cylinders_shared(cylinders, 40));
+    EXPECT_EQ(1, cylinders_shared->mNumMeshes);
+    expected = bounds(cylinder_copies.get());
+    auto actual = bounds(cylinders_shared.get());
+    for (int k = 0; k != 6; ++k)
+        EXPECT_NEAR(expected[k], actual[k], 1e-3) << k;
+
+    auto copies_glb = TilesetExporter::encode_glb(copies.get());
+    auto shared_glb = TilesetExporter::encode_glb(shared.get());
+    CONSOLE_EVAL(copies_glb.size());
+    CONSOLE_EVAL(shared_glb.size());
+    EXPECT_LT(shared_glb.size(), copies_glb.size());
+}
+
+/// @brief The Toolbox meshes on MeshBuilder: the flat, owned and arena outputs
+/// @param --gtest_filter=AssimpF.meshbuilder
+TEST_F(AssimpF, meshbuilder) {
+    meshtoolbox::Toolbox tb;
+
+    std::unique_ptr<aiMesh> box(tb.mesh_box({0, 0, 0}, {1, 2, 3}));
+    EXPECT_EQ(8, box->mNumVertices);
+    EXPECT_EQ(12, box->mNumFaces);
+    EXPECT_EQ(aiPrimitiveType_TRIANGLE, box->mPrimitiveTypes);
+    EXPECT_EQ(aiVector3D(1, 2, 3), box->mVertices[6]);
+    EXPECT_EQ(5, box->mFaces[11].mIndices[2]);
+
+    std::vector<meshtoolbox::lidarptr_t> points;
+    for (int i = 0; i != 1000; ++i)
+        points.push_back({ai_real(i), ai_real(2 * i), 1, 0xFFFF, 0, uint16_t(i)});
+
+    auto flat = tb.lidar_points(points.data(), points.size());
+    EXPECT_EQ(points.size(), flat.positions.size());
+    EXPECT_EQ(points.size(), flat.colors.size());
+    EXPECT_EQ(points.size(), flat.num_faces());
+    EXPECT_EQ(1, flat.face_size);
+    EXPECT_EQ(aiPrimitiveType_POINT, flat.primitive_types);
+    EXPECT_EQ(aiVector3D(10, 1, -20), flat.positions[10]);
+
+    std::unique_ptr<aiScene> owned(tb.make_lidar_pc(points.data(), points.size()));
+    auto arena = tb.make_lidar_pc_arena(points.data(), points.size());
+    EXPECT_EQ(1, arena.get_deleter().arena->blocks());
+    aiMesh const *a = owned->mMeshes[0];
+    aiMesh const *b = arena->mMeshes[0];
+    ASSERT_EQ(a->mNumFaces, b->mNumFaces);
+    for (unsigned f = 0; f != a->mNumFaces; ++f) {
+        ASSERT_EQ(1, b->mFaces[f].mNumIndices);
+        EXPECT_EQ(a->mFaces[f].mIndices[0], b->mFaces[f].mIndices[0]);
+    }
+    EXPECT_EQ(a->mColors[0][999], b->mColors[0][999]);
+
+    meshtoolbox::MeshBuilder mixed("mixed");
+    for (int i = 0; i != 5; ++i)
+        mixed.add_vertex({ai_real(i), 0, 0});
+    mixed.add_triangle(0, 1, 2);
+    mixed.add_face({0, 1, 3, 4});
+    std::unique_ptr<aiMesh> m(mixed.to_aimesh());
+    EXPECT_EQ(2, m->mNumFaces);
+    EXPECT_EQ(4, m->mFaces[1].mNumIndices);
+    EXPECT_EQ(aiPrimitiveType_TRIANGLE | aiPrimitiveType_POLYGON, m->mPrimitiveTypes);
+    EXPECT_THROW(meshtoolbox::MeshBuilder().set_color(aiColor4D{1, 1, 1, 1}), std::logic_error);
+
+    // the make_*() scenes own their faces: the stages that drop faces delete them
+    std::unique_ptr<aiScene> boxes(tb.make_boxes({{{0, 0, 0}, {1, 1, 1}}, {{2, 0, 0}, {1, 1, 1}}}));
+    for (unsigned k = 0; k != boxes->mNumMeshes; ++k) {
+        aiFace const &f0 = boxes->mMeshes[k]->mFaces[0];
+        std::copy(f0.mIndices, f0.mIndices + 3, boxes->mMeshes[k]->mFaces[1].mIndices);
+    }
+    auto repaired = meshtoolbox::repair_scene(boxes.get(), meshtoolbox::repair_options_t());
+    EXPECT_EQ(2, repaired.duplicates);
+    EXPECT_EQ(11, boxes->mMeshes[1]->mNumFaces);
+
+    std::unique_ptr<aiScene> cylinder(tb.make_cylinder({0, 0, 0}, 10, 1, 64));
+    auto simplified = meshtoolbox::simplify_scene(cylinder.get(), meshtoolbox::simplify_options_t());
+    EXPECT_LT(simplified.faces_after, simplified.faces_before);
+    EXPECT_EQ(cylinder->mMeshes[0]->mNumFaces, simplified.faces_after);
+}
+
 /// @brief Create a georeferenced "graveyard" scene (the test data)
 /// @param
 /// --gtest_filter=AssimpF.meshtoolbox_t1
@@ -1669,6 +2533,43 @@ TEST_F(TransF, c3dprototype_translate_coordinates) {
     }
 }
 
+/// @brief weld_scene() against aiProcess_JoinIdenticalVertices on the UTM
+/// scene of c3dprototype_translate_coordinates
+/// @param --gtest_filter=TransF.c3dprototype_weld
+TEST_F(TransF, c3dprototype_weld) {
+    auto bounding_boxes_glb = test_data("tileset2/bounding_boxes.glb").string();
+    ASSERT_TRUE(fs::is_regular_file(bounding_boxes_glb));
+
+    Assimp::Importer joined_importer;
+    auto joined = joined_importer.ReadFile(bounding_boxes_glb, aiProcess_JoinIdenticalVertices);
+    ASSERT_TRUE(joined);
+
+    Assimp::Importer importer;
+    ASSERT_TRUE(importer.ReadFile(bounding_boxes_glb, 0));
+    std::unique_ptr<aiScene> actual{importer.GetOrphanedScene()};
+
+    meshtoolbox::weld_options_t options;
+    // the exact duplicates, as JoinIdenticalVertices
+    options.epsilon = options.normal_epsilon = options.uv_epsilon = options.color_epsilon = 0;
+    auto stats = meshtoolbox::weld_scene(actual.get(), options);
+    CONSOLE_EVAL(stats.before);
+    CONSOLE_EVAL(stats.after);
+
+    size_t expected = 0;
+    for (unsigned m = 0; m != joined->mNumMeshes; ++m)
+        expected += joined->mMeshes[m]->mNumVertices;
+    EXPECT_EQ(expected, stats.after);
+
+    // the UTM coordinates are float: 1 cm welds more
+    options.epsilon = 0.01;
+    EXPECT_GE(stats.after, meshtoolbox::weld_scene(actual.get(), options).after);
+
+    auto bounding_box = compute_aabb(actual.get());
+    auto expected_box = compute_aabb(joined);
+    EXPECT_EQ(expected_box.mMin, bounding_box.mMin);
+    EXPECT_EQ(expected_box.mMax, bounding_box.mMax);
+}
+
 /*
     echo "EASTING NORTHING" | cs2cs +proj=utm +zone=13 +ellps=WGS84 +to
    +proj=latlong +datum=WGS84
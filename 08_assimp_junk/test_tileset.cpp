@@ -0,0 +1,1423 @@
+//
+// TilesetJson helpers: the compact tile tree and friends
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+#include <assimp/scene.h>
+
+#include "TileComposite.h"
+#include "TileContent.h"
+#include "TileInstances.h"
+#include "TileSphere.h"
+#include "TilesetJson.h"
+#include "TilesetJsonImage.h"
+#include "TilesetTree.h"
+#include "TilesetDiff.h"
+#include "TilesetExporter.h"
+#include "TilesetReader.h"
+#include "TilesetGraph.h"
+#include "TilesetIndex.h"
+#include "TilesetTraversal.h"
+#include "TilesetValidator.h"
+#include "TilesetWriter.h"
+
+#include "../common/CONSOLE.h"
+
+using namespace cesiumjs;
+
+class TilesetF : public testing::Test {
+protected:
+    std::string test_name() const { return ::testing::UnitTest::GetInstance()->current_test_info()->name(); }
+
+    std::string test_case_name() const {
+        return ::testing::UnitTest::GetInstance()->current_test_info()->test_case_name();
+    }
+
+    fs::path create_ws() {
+        auto ws = fs::absolute("out") / test_case_name() / test_name();
+        fs::remove_all(ws);
+        fs::create_directories(ws);
+        return ws;
+    }
+
+    auto test_data(const char *relative_path) {
+        auto test_data_dir = fs::absolute(__FILE__).parent_path() / "test_data";
+        return test_data_dir / relative_path;
+    }
+
+    /// @brief A small hierarchy with all kinds of bounding volumes
+    ///
+    /// root (box, transform)
+    ///   +- a (region, "a.b3dm")
+    ///   |    +- a0 (box, "shared.glb")
+    ///   |    +- a1 (box, "shared.glb")
+    ///   +- b (sphere, "b.pnts")
+    TilesetJson::root_tile_t make_root_tile() {
+        TilesetJson::root_tile_t root("REPLACE", {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 10, 20, 30, 1});
+        root.geometricError = 100;
+        root.boundingVolume.reset(new TilesetJson::boundingVolumeBox_t({0, 0, 0, 50, 0, 0, 0, 50, 0, 0, 0, 10}));
+
+        TilesetJson::child_t a(50, {"a.b3dm"});
+        a.boundingVolume.reset(new TilesetJson::boundingVolumeRegion_t({-1.3, 0.6, -1.2, 0.7, 0, 100}));
+        for (int i = 0; i != 2; ++i) {
+            TilesetJson::child_t ai(0, {"shared.glb"});
+            ai.boundingVolume.reset(
+                new TilesetJson::boundingVolumeBox_t({i * 10.0, 0, 0, 5, 0, 0, 0, 5, 0, 0, 0, 5}));
+            a.children.push_back(std::move(ai));
+        }
+        root.children.push_back(std::move(a));
+
+        TilesetJson::child_t b(25, {"b.pnts"});
+        b.boundingVolume.reset(new TilesetJson::boundingVolumeSphere_t({1, 2, 3, 4}));
+        root.children.push_back(std::move(b));
+        return root;
+    }
+
+    /// @brief Serialize a root tile (for comparisons)
+    std::string to_string(TilesetJson::root_tile_t const &root, fs::path const &ws, const char *name) {
+        TilesetJson doc;
+        doc.root(root);
+        auto f = ws / name;
+        EXPECT_TRUE(doc.save_as(f.string()));
+        std::ifstream is(f);
+        return std::string(std::istreambuf_iterator<char>(is), {});
+    }
+
+    /// @brief Write a tileset with n leaf tiles
+    /// @param links the tiles with content uri (may be external tilesets)
+    static void write_tileset(fs::path const &f, std::vector<std::string> const &links) {
+        fs::create_directories(f.parent_path());
+        std::ofstream os(f);
+        os << R"({"asset":{"version":"1.0"},"geometricError":10,"root":{"geometricError":10,"refine":"ADD",)"
+           << R"("boundingVolume":{"sphere":[0,0,0,100]},"children":[)";
+        for (size_t i = 0; i != links.size(); ++i)
+            os << (i ? "," : "") << R"({"geometricError":0,"content":{"uri":")" << links[i] << R"("}})";
+        os << "]}}";
+    }
+
+    /// @brief Quadtree over [0, size]^2, the geometric error halves per level
+    static TileTree make_quadtree(unsigned levels, TileTree::refine_t refine, double size = 1024) {
+        TileTree tree;
+        struct item_t {
+            TileTree::index_t parent;
+            double x, y, half;
+            unsigned level;
+        };
+        std::vector<item_t> todo{{TileTree::npos, size / 2, size / 2, size / 2, 0}};
+        while (!todo.empty()) {
+            auto it = todo.back();
+            todo.pop_back();
+            auto i = tree.add_tile(it.parent);
+            tree[i].geometricError = it.level + 1 == levels ? 0 : it.half / 8;
+            tree[i].boundingVolume = TileTree::box_t{{it.x, it.y, 0, it.half, 0, 0, 0, it.half, 0, 0, 0, 1}};
+            tree.set_uri(i, std::to_string(i) + ".b3dm");
+            if (it.level + 1 != levels)
+                for (int k = 0; k != 4; ++k)
+                    todo.push_back({i, it.x + (k & 1 ? 1 : -1) * it.half / 2, it.y + (k & 2 ? 1 : -1) * it.half / 2,
+                                    it.half / 2, it.level + 1});
+        }
+        tree[0].refine = refine;
+        return tree;
+    }
+
+    /// @brief root.json -> a.json -> (a/sub.json -> 2 b3dm, 1 b3dm), b.json -> 3 b3dm
+    fs::path write_external_tilesets(fs::path const &ws) {
+        write_tileset(ws / "root.json", {"a.json", "b.json?v=1"});
+        write_tileset(ws / "a.json", {"a/sub.json", "a0.b3dm"});
+        write_tileset(ws / "a" / "sub.json", {"x.b3dm", "../y.b3dm"});
+        write_tileset(ws / "b.json", {"b0.b3dm", "b1.b3dm", "b2.b3dm"});
+        return ws / "root.json";
+    }
+};
+
+/// @brief Convert the TilesetJson tile hierarchy to the compact tree and back
+/// @param --gtest_filter=TilesetF.tree_round_trip
+TEST_F(TilesetF, tree_round_trip) {
+    auto ws = create_ws();
+
+    auto root = make_root_tile();
+
+    TileTree tree;
+    tree.from_root_tile(root);
+
+    ASSERT_EQ(5, tree.size());
+    EXPECT_EQ(0, tree.root());
+    EXPECT_EQ(TileTree::REFINE_REPLACE, tree[0].refine);
+    EXPECT_EQ(TileTree::REFINE_REPLACE, tree.effective_refine(3));
+    ASSERT_TRUE(tree.transform(0));
+    EXPECT_EQ(30, tree.transform(0)->matrix4x4[14]);
+    EXPECT_FALSE(tree.transform(1));
+
+    // "shared.glb" is stored once
+    EXPECT_EQ(3, tree.strings().size());
+
+    // the empty string first: no block yet
+    StringArena arena;
+    auto empty = arena.intern("");
+    EXPECT_EQ(empty, arena.intern(""));
+    EXPECT_EQ("", arena.str(empty));
+    EXPECT_EQ("x", arena.str(arena.intern("x")));
+
+    std::vector<std::pair<std::string, unsigned>> visited;
+    tree.depth_first([&](TileTree::index_t i, unsigned depth) {
+        visited.emplace_back(std::string(tree.uri(i)), depth);
+        EXPECT_EQ(tree.depth(i), depth);
+    });
+    std::vector<std::pair<std::string, unsigned>> expected{
+        {"", 0}, {"a.b3dm", 1}, {"shared.glb", 2}, {"shared.glb", 2}, {"b.pnts", 1}};
+    EXPECT_EQ(expected, visited);
+
+    auto a = tree[0].first_child;
+    ASSERT_NE(TileTree::npos, a);
+    EXPECT_TRUE(std::holds_alternative<TileTree::region_t>(tree[a].boundingVolume));
+    auto b = tree[a].next_sibling;
+    ASSERT_NE(TileTree::npos, b);
+    ASSERT_TRUE(std::holds_alternative<TileTree::sphere_t>(tree[b].boundingVolume));
+    EXPECT_EQ(4, std::get<TileTree::sphere_t>(tree[b].boundingVolume).sphere[3]);
+    EXPECT_EQ(TileTree::npos, tree[b].next_sibling);
+
+    auto back = tree.to_root_tile();
+    EXPECT_EQ(to_string(root, ws, "expected.json"), to_string(back, ws, "actual.json"));
+}
+
+/// @brief Build the compact tree from tileset.json files
+/// @param --gtest_filter=TilesetF.tree_from_tileset_json
+TEST_F(TilesetF, tree_from_tileset_json) {
+    {
+        TilesetJson doc(test_data("GM13206_test.tb_1_tiles/tileset.json").string());
+        TileTree tree(doc);
+        EXPECT_EQ(3, tree.size());
+        EXPECT_EQ(std::string("1.0"), tree.asset.version);
+        EXPECT_DOUBLE_EQ(112.249721603218, tree.geometricError);
+        EXPECT_EQ(TileTree::REFINE_ADD, tree.effective_refine(2));
+        EXPECT_EQ(2, tree.depth(2));
+        EXPECT_TRUE(std::holds_alternative<TileTree::box_t>(tree[0].boundingVolume));
+    }
+    {
+        // the bounding volume is a sphere
+        TilesetJson doc(test_data("cesium/pnts/PointCloudBatched/tileset.json").string());
+        TileTree tree(doc);
+        ASSERT_EQ(1, tree.size());
+        ASSERT_TRUE(std::holds_alternative<TileTree::sphere_t>(tree[0].boundingVolume));
+        EXPECT_EQ(5, std::get<TileTree::sphere_t>(tree[0].boundingVolume).sphere[3]);
+        EXPECT_EQ(std::string("pointCloudBatched.pnts"), tree.uri(0));
+    }
+}
+
+/// @brief The streaming loader gives the same tree as the DOM based one
+/// @param --gtest_filter=TilesetF.reader_vs_dom
+TEST_F(TilesetF, reader_vs_dom) {
+    auto ws = create_ws();
+
+    for (auto name : {"GM13206_test.tb_1_tiles/tileset.json", "tileset2/tileset2.json",
+                      "cesium/pnts/PointCloudBatched/tileset.json"}) {
+        TilesetJson doc(test_data(name).string());
+        TileTree expected(doc);
+        TileTree actual = TilesetReader::load(test_data(name).string());
+
+        ASSERT_EQ(expected.size(), actual.size()) << name;
+        EXPECT_EQ(expected.asset.version, actual.asset.version);
+        EXPECT_EQ(expected.geometricError, actual.geometricError);
+        EXPECT_EQ(to_string(expected.to_root_tile(), ws, "expected.json"),
+                  to_string(actual.to_root_tile(), ws, "actual.json"))
+            << name;
+    }
+}
+
+/// @brief Tokenizer corner cases and deep trees
+/// @param --gtest_filter=TilesetF.reader_memory
+TEST_F(TilesetF, reader_memory) {
+    {
+        std::string text = R"({
+            "asset": {"version": "1.1", "extras": [1, {"a": [true, false, null]}, 0, -0.5, 0e1, {}, []]},
+            "geometricError": 1e3,
+            "root": {
+                "refine": "REPLACE",
+                "geometricError": 500.5,
+                "boundingVolume": {"sphere": [1, -2.5, 3E-1, 4]},
+                "children": [
+                    {"geometricError": 0, "content": {"uri": "a\\b\"cé😀.b3dm"}},
+                    {"geometricError": 0, "content": {"url": "legacy.b3dm"}, "refine": "ADD", "children": []}
+                ]
+            }
+        })";
+        auto tree = TilesetReader::load(text.data(), text.size());
+        ASSERT_EQ(3, tree.size());
+        EXPECT_EQ(std::string("1.1"), tree.asset.version);
+        EXPECT_EQ(1000, tree.geometricError);
+        EXPECT_EQ(TileTree::REFINE_REPLACE, tree[0].refine);
+        EXPECT_EQ(500.5, tree[0].geometricError);
+        EXPECT_EQ(0.3, std::get<TileTree::sphere_t>(tree[0].boundingVolume).sphere[2]);
+        EXPECT_EQ(std::string("a\\b\"c\xC3\xA9\xF0\x9F\x98\x80.b3dm"), tree.uri(1));
+        EXPECT_EQ(std::string("legacy.b3dm"), tree.uri(2));
+        EXPECT_EQ(TileTree::REFINE_REPLACE, tree.effective_refine(1));
+        EXPECT_EQ(TileTree::REFINE_ADD, tree.effective_refine(2));
+    }
+    {
+        // far deeper than a recursive parser can handle
+        const int depth = 100000;
+        std::string text = R"({"root":)";
+        for (int i = 0; i != depth; ++i)
+            text += R"({"geometricError":1,"children":[)";
+        text += R"({"geometricError":0})";
+        for (int i = 0; i != depth; ++i)
+            text += "]}";
+        text += "}";
+        auto tree = TilesetReader::load(text.data(), text.size());
+        ASSERT_EQ(depth + 1, tree.size());
+        EXPECT_EQ(depth, tree.depth(depth));
+    }
+    for (auto bad : {R"({"root":{"children":[{}]})", R"({"root":{"boundingVolume":{"box":[1,2]}}})",
+                     R"({"root":{} "x":1})", R"({"root":{}} x)", R"({"root":{"geometricError":1.2.3}})",
+                     R"({"root":{"content":{"uri":"a
+b"}}})", R"({"root":{"geometricError":1,}})", R"({"root":{"geometricError":1},"extras":[1,]})",
+                     R"({"root":{"geometricError":01}})", R"({"root":{"geometricError":-00}})",
+                     R"({"root":{"geometricError":1.}})", R"({"root":{"geometricError":-.5}})",
+                     R"({"root":{"geometricError":1e}})"}) {
+        EXPECT_THROW(TilesetReader::load(bad, strlen(bad)), std::runtime_error) << bad;
+    }
+}
+
+/// @brief Streaming from a file in small chunks
+/// @param --gtest_filter=TilesetF.reader_chunks
+TEST_F(TilesetF, reader_chunks) {
+    auto name = test_data("GM13206_test.tb_1_tiles/tileset.json");
+    TileTree expected = TilesetReader::load(name.string());
+
+    // every token crosses a chunk boundary at some point
+    for (size_t chunk : {1, 2, 3, 7, 64}) {
+        std::unique_ptr<FILE, int (*)(FILE *)> f(fopen(name.string().c_str(), "rb"), &fclose);
+        ASSERT_TRUE(f);
+        JsonReader reader(f.get(), chunk);
+        TileTree actual = TilesetReader::load(reader);
+        ASSERT_EQ(expected.size(), actual.size());
+        for (TileTree::index_t i = 0; i != actual.size(); ++i) {
+            EXPECT_EQ(expected[i].geometricError, actual[i].geometricError);
+            EXPECT_EQ(expected.uri(i), actual.uri(i));
+            EXPECT_EQ(expected[i].boundingVolume.index(), actual[i].boundingVolume.index());
+        }
+    }
+}
+
+/// @brief External tilesets are loaded on the first traversal and cached
+/// @param --gtest_filter=TilesetF.graph_lazy
+TEST_F(TilesetF, graph_lazy) {
+    auto ws = create_ws();
+    auto root = write_external_tilesets(ws);
+
+    auto cache = std::make_shared<TilesetCache>(1 << 20);
+    TilesetGraph graph(root, cache);
+
+    // visit the top level only
+    graph.traverse([&](TilesetGraph::node_t const &, unsigned depth) { return depth < 1; });
+    EXPECT_EQ(1, cache->stats().misses);
+    EXPECT_FALSE(cache->contains(ws / "a.json"));
+
+    std::vector<std::string> leaves;
+    graph.traverse([&](TilesetGraph::node_t const &n, unsigned) {
+        if (!n.uri().empty() && !graph.is_external(n))
+            leaves.push_back(TilesetGraph::content_path(n).lexically_relative(ws).generic_string());
+        return true;
+    });
+    std::vector<std::string> expected{"a/x.b3dm", "y.b3dm", "a0.b3dm", "b0.b3dm", "b1.b3dm", "b2.b3dm"};
+    EXPECT_EQ(expected, leaves);
+
+    auto stats = cache->stats();
+    EXPECT_EQ(4, stats.misses);
+    EXPECT_EQ(4, stats.entries);
+    EXPECT_EQ(0, stats.evictions);
+
+    // again, all from the cache
+    graph.traverse([&](TilesetGraph::node_t const &, unsigned) { return true; });
+    EXPECT_EQ(4, cache->stats().misses);
+    EXPECT_EQ(1 + 4, cache->stats().hits);
+}
+
+/// @brief Links back to an open tileset are not followed
+/// @param --gtest_filter=TilesetF.graph_cycle
+TEST_F(TilesetF, graph_cycle) {
+    auto ws = create_ws();
+    // root -> a -> root, a -> a, and b reached twice without a cycle
+    write_tileset(ws / "root.json", {"a.json", "b.json"});
+    write_tileset(ws / "a.json", {"./root.json", "a.json", "sub/../b.json", "a0.b3dm"});
+    write_tileset(ws / "b.json", {"b0.b3dm"});
+
+    auto cache = std::make_shared<TilesetCache>(1 << 20);
+    TilesetGraph graph(ws / "root.json", cache);
+    std::vector<std::pair<std::string, unsigned>> visited;
+    graph.traverse([&](TilesetGraph::node_t const &n, unsigned depth) {
+        if (!n.uri().empty())
+            visited.emplace_back(std::string(n.uri()), depth);
+        return true;
+    });
+    std::vector<std::pair<std::string, unsigned>> expected{
+        {"a.json", 1},  {"./root.json", 3}, {"a.json", 3},  {"sub/../b.json", 3},
+        {"b0.b3dm", 5}, {"a0.b3dm", 3},     {"b.json", 1}, {"b0.b3dm", 3}};
+    EXPECT_EQ(expected, visited);
+    EXPECT_EQ(3, cache->stats().misses);
+}
+
+/// @brief The cache memory is bounded, concurrent users share the loads
+/// @param --gtest_filter=TilesetF.graph_cache
+TEST_F(TilesetF, graph_cache) {
+    auto ws = create_ws();
+    auto root = write_external_tilesets(ws);
+
+    size_t one_tree = TilesetReader::load((ws / "b.json").string()).memory_usage();
+    {
+        // room for two trees only
+        auto cache = std::make_shared<TilesetCache>(one_tree * 2 + one_tree / 2);
+        TilesetGraph graph(root, cache);
+        size_t n = 0;
+        graph.traverse([&](TilesetGraph::node_t const &, unsigned) { return ++n; });
+        EXPECT_EQ(13, n);
+        auto stats = cache->stats();
+        EXPECT_LE(stats.bytes, cache->capacity());
+        EXPECT_EQ(2, stats.entries);
+        EXPECT_EQ(2, stats.evictions);
+        // the most recent ones are kept
+        EXPECT_TRUE(cache->contains(ws / "b.json"));
+        EXPECT_FALSE(cache->contains(ws / "root.json"));
+    }
+    {
+        std::atomic<int> loads{0};
+        auto cache = std::make_shared<TilesetCache>(1 << 20, [&](fs::path const &p) {
+            ++loads;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return TilesetCache::default_loader(p);
+        });
+        std::vector<std::thread> threads;
+        std::atomic<int> visited{0};
+        for (int i = 0; i != 8; ++i)
+            threads.emplace_back([&] {
+                TilesetGraph graph(root, cache);
+                graph.traverse([&](TilesetGraph::node_t const &, unsigned) { return ++visited; });
+            });
+        for (auto &t : threads)
+            t.join();
+        EXPECT_EQ(8 * 13, visited);
+        EXPECT_EQ(4, loads);
+    }
+    {
+        auto cache = std::make_shared<TilesetCache>(1 << 20);
+        TilesetGraph graph(ws / "missing.json", cache);
+        EXPECT_THROW(graph.root(), std::runtime_error);
+        EXPECT_EQ(0, cache->stats().entries);
+    }
+}
+
+/// @brief Siblings are loaded in the background
+/// @param --gtest_filter=TilesetF.graph_prefetch
+TEST_F(TilesetF, graph_prefetch) {
+    auto ws = create_ws();
+    auto root = write_external_tilesets(ws);
+
+    auto cache = std::make_shared<TilesetCache>(1 << 20);
+    TilesetGraph graph(root, cache);
+    graph.set_prefetch(true);
+
+    graph.for_each_child(graph.root(), [](TilesetGraph::node_t const &) {});
+    cache->wait_prefetch();
+    EXPECT_TRUE(cache->contains(ws / "a.json"));
+    EXPECT_TRUE(cache->contains(ws / "b.json"));
+    EXPECT_FALSE(cache->contains(ws / "a" / "sub.json"));
+    EXPECT_EQ(3, cache->stats().misses);
+}
+
+/// @brief R-tree queries agree with the brute force checks
+/// @param --gtest_filter=TilesetF.index_queries
+TEST_F(TilesetF, index_queries) {
+    // a 20 x 20 grid of 10 m boxes, the last row moved by a transform
+    TileTree tree;
+    auto root = tree.add_tile(TileTree::npos);
+    tree[root].boundingVolume = TileTree::box_t{{100, 100, 5, 100, 0, 0, 0, 100, 0, 0, 0, 5}};
+    auto row = root;
+    for (int y = 0; y != 20; ++y) {
+        row = tree.add_tile(root);
+        if (y == 19)
+            tree.set_transform(row, TileTree::transform_t{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 1000, 0, 0, 1});
+        for (int x = 0; x != 20; ++x) {
+            auto t = tree.add_tile(row);
+            // rotated by 45 degrees around z
+            double h = 5 / std::sqrt(2.0);
+            tree[t].boundingVolume = TileTree::box_t{{x * 10 + 5.0, y * 10 + 5.0, 5, h, h, 0, -h, h, 0, 0, 0, 5}};
+        }
+    }
+    auto sphere = tree.add_tile(root);
+    tree[sphere].boundingVolume = TileTree::sphere_t{{-50, -50, 0, 10}};
+    auto region = tree.add_tile(root);
+    tree[region].boundingVolume = TileTree::region_t{{-0.1, -0.1, 0.1, 0.1, 0, 10}};
+
+    TilesetIndex index(tree);
+    EXPECT_EQ(tree.size() - 20, index.size()); // the rows have no volume
+
+    // the rotated box grows by sqrt(2)
+    auto const &b = index.bounds(tree[tree[root].first_child].first_child);
+    EXPECT_NEAR(5 - 5 * std::sqrt(2.0), b.min_corner().get<0>(), 1e-9);
+    // the transformed row
+    EXPECT_NEAR(1005, (index.bounds(tree[row].first_child).min_corner().get<0>() +
+                       index.bounds(tree[row].first_child).max_corner().get<0>()) / 2, 1e-9);
+
+    // the region around (lon 0, lat 0) is at x ~ 6378 km
+    EXPECT_NEAR(6378137 + 10, index.bounds(region).max_corner().get<0>(), 1e-6);
+    EXPECT_NEAR(6378137 * std::sin(0.1), index.bounds(region).max_corner().get<1>(), 1000);
+
+    auto sorted = [](std::vector<TileTree::index_t> v) {
+        std::sort(v.begin(), v.end());
+        return v;
+    };
+    auto brute = [&](auto pred) {
+        std::vector<TileTree::index_t> r;
+        tree.depth_first([&](TileTree::index_t i, unsigned) {
+            if (tree[i].boundingVolume.index() && pred(index.bounds(i)))
+                r.push_back(i);
+        });
+        return sorted(r);
+    };
+    namespace bg = boost::geometry;
+    using P = TilesetIndex::point_t;
+
+    {
+        TilesetIndex::box_t q(P(42, 42, 0), P(58, 58, 1));
+        auto r = sorted(index.query_box(q));
+        EXPECT_EQ(brute([&](auto const &b) { return bg::intersects(b, q); }), r);
+        // root + 4 x 4 (the rotated boxes reach the neighbours)
+        EXPECT_EQ(1 + 16, r.size());
+    }
+    {
+        auto r = sorted(index.query_sphere({-50, -50, 0}, 1));
+        ASSERT_EQ(1, r.size());
+        EXPECT_EQ(sphere, r[0]);
+        r = sorted(index.query_sphere({100, 100, 5}, 12));
+        EXPECT_EQ(brute([&](auto const &b) { return TilesetIndex::distance2(b, {100, 100, 5}) <= 144; }), r);
+    }
+    {
+        // a thin diagonal triangle
+        TilesetIndex::polygon_t poly;
+        bg::read_wkt("POLYGON((0 0,190 190,190 180,0 0))", poly);
+        auto r = sorted(index.query_polygon(poly));
+        EXPECT_EQ(brute([&](auto const &b) {
+                      bg::model::box<TilesetIndex::point2d_t> b2({b.min_corner().template get<0>(), b.min_corner().template get<1>()},
+                                                                 {b.max_corner().template get<0>(), b.max_corner().template get<1>()});
+                      return bg::intersects(poly, b2);
+                  }),
+                  r);
+        EXPECT_LT(r.size(), 100);
+        EXPECT_GT(r.size(), 20);
+    }
+    {
+        // looking down at the grid center
+        auto f = TilesetIndex::frustum_t::perspective({100, 100, 100}, {0, 0, -1}, {0, 1, 0}, M_PI / 4, 1.0, 1, 1000);
+        auto fb = f.bounds();
+        EXPECT_NEAR(100 - 1000 * std::tan(M_PI / 8), fb.min_corner().get<0>(), 1e-6);
+        auto r = sorted(index.query_frustum(f));
+        EXPECT_EQ(brute([&](auto const &b) { return f.intersects(b); }), r);
+        EXPECT_GT(r.size(), 30);
+        EXPECT_LT(r.size(), 300);
+    }
+}
+
+/// @brief Index of a real tileset
+/// @param --gtest_filter=TilesetF.index_tileset
+TEST_F(TilesetF, index_tileset) {
+    auto tree = TilesetReader::load(test_data("GM13206_test.tb_1_tiles/tileset.json").string());
+    TilesetIndex index(tree);
+    ASSERT_EQ(tree.size(), index.size());
+    auto all = index.query_box(index.rtree().bounds());
+    EXPECT_EQ(tree.size(), all.size());
+}
+
+/// @brief SSE driven selection with REPLACE and ADD refinement
+/// @param --gtest_filter=TilesetF.selector_refine
+TEST_F(TilesetF, selector_refine) {
+    TileSelector::camera_t far_away{{512, 512, 1e6}, {0, 0, -1}, {0, 1, 0}};
+    TileSelector::camera_t close{{512, 512, 1000}, {0, 0, -1}, {0, 1, 0}};
+    TileSelector::camera_t away{{512, 512, 100}, {0, 0, 1}, {0, 1, 0}};
+    TileSelector::camera_t corner{{0, 0, 50}, {1, 1, -0.2}, {0, 0, 1}};
+
+    {
+        auto tree = make_quadtree(5, TileTree::REFINE_REPLACE);
+        ASSERT_EQ(1 + 4 + 16 + 64 + 256, tree.size());
+        TileSelector sel(tree);
+
+        EXPECT_EQ(std::vector<TileTree::index_t>{0}, sel.select(far_away));
+        EXPECT_TRUE(sel.select(away).empty());
+        EXPECT_EQ(1, sel.stats().culled);
+
+        auto const &r = sel.select(close);
+        EXPECT_GT(r.size(), 4);
+        // REPLACE: the selected tiles do not overlap and do not need refinement
+        double area = 0;
+        for (auto i : r) {
+            auto const &b = std::get<TileTree::box_t>(tree[i].boundingVolume);
+            area += 4 * b.box[3] * b.box[7];
+            if (tree[i].first_child != TileTree::npos)
+                EXPECT_LE(sel.screen_space_error(i, close), sel.view().max_sse);
+            else
+                EXPECT_EQ(0, tree[i].geometricError);
+        }
+        // the camera sees everything
+        EXPECT_DOUBLE_EQ(1024 * 1024, area);
+
+        // the tiles far from the camera are coarser
+        auto const &rc = sel.select(corner);
+        unsigned near_depth = 0, far_depth = 100;
+        for (auto i : rc) {
+            auto const &b = std::get<TileTree::box_t>(tree[i].boundingVolume);
+            if (b.box[0] < 64 && b.box[1] < 64)
+                near_depth = std::max(near_depth, tree.depth(i));
+            if (b.box[0] > 768 && b.box[1] > 768)
+                far_depth = std::min(far_depth, tree.depth(i));
+        }
+        EXPECT_EQ(4, near_depth);
+        EXPECT_LT(far_depth, near_depth);
+    }
+    {
+        auto tree = make_quadtree(5, TileTree::REFINE_ADD);
+        TileSelector sel(tree);
+        auto const &r = sel.select(close);
+        // ADD: the refined tiles are rendered too
+        EXPECT_EQ(0, r.front());
+        size_t refined = 0;
+        for (auto i : r)
+            refined += tree[i].first_child != TileTree::npos && sel.screen_space_error(i, close) > 16;
+        EXPECT_GT(refined, 0);
+    }
+}
+
+/// @brief Consecutive frames reuse the decisions and give the same result
+/// @param --gtest_filter=TilesetF.selector_incremental
+TEST_F(TilesetF, selector_incremental) {
+    auto tree = make_quadtree(7, TileTree::REFINE_REPLACE, 8192);
+    TileSelector incremental(tree);
+    TileSelector full(tree);
+
+    std::vector<TileTree::index_t> previous;
+    size_t reused = 0;
+    for (int f = 0; f != 200; ++f) {
+        // a low pass over the tileset
+        TileSelector::camera_t cam{{f * 40.0, 1000 + f * 10.0, 300}, {1, 1, -0.5}, {0, 0, 1}};
+        auto r = incremental.select(cam);
+        reused += incremental.stats().reused;
+
+        full.invalidate();
+        ASSERT_EQ(full.select(cam), r) << f;
+
+        // added/removed is the difference of the consecutive selections
+        auto now = r;
+        std::sort(now.begin(), now.end());
+        std::vector<TileTree::index_t> added, removed;
+        std::set_difference(now.begin(), now.end(), previous.begin(), previous.end(), std::back_inserter(added));
+        std::set_difference(previous.begin(), previous.end(), now.begin(), now.end(), std::back_inserter(removed));
+        auto a = incremental.added(), d = incremental.removed();
+        std::sort(a.begin(), a.end());
+        std::sort(d.begin(), d.end());
+        ASSERT_EQ(added, a) << f;
+        ASSERT_EQ(removed, d) << f;
+        previous = now;
+    }
+    EXPECT_GT(reused, 0);
+}
+
+/// @brief The writer output reads back bit exact and is smaller than the json-c one
+/// @param --gtest_filter=TilesetF.writer_round_trip
+TEST_F(TilesetF, writer_round_trip) {
+    auto ws = create_ws();
+
+    auto tree = make_quadtree(5, TileTree::REFINE_REPLACE);
+    std::mt19937 rng(13206);
+    std::uniform_real_distribution<double> any(-1e7, 1e7);
+    tree.depth_first([&](TileTree::index_t i, unsigned) {
+        auto &b = std::get<TileTree::box_t>(tree[i].boundingVolume);
+        for (auto &d : b.box)
+            d = d == 0 ? 0 : any(rng);
+        tree[i].geometricError = std::abs(any(rng)) / 1e5;
+    });
+    tree.set_transform(0, TileTree::transform_t{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.1, 0.2, 0.3, 1});
+    tree.set_uri(1, "needs \"escaping\"\n\x01.b3dm");
+    tree.asset.version = "1.0";
+    tree.asset.extra_ion_georeferenced = true;
+    tree.geometricError = 0.1;
+
+    for (bool pretty : {false, true}) {
+        auto text = TilesetWriter::to_string(tree, pretty);
+        auto back = TilesetReader::load(text.data(), text.size());
+        ASSERT_EQ(tree.size(), back.size());
+        EXPECT_EQ(tree.asset.extra_ion_georeferenced, back.asset.extra_ion_georeferenced);
+        EXPECT_EQ(0.1, back.geometricError);
+        for (TileTree::index_t i = 0; i != tree.size(); ++i) {
+            EXPECT_EQ(tree[i].geometricError, back[i].geometricError);
+            EXPECT_EQ(0, memcmp(&std::get<TileTree::box_t>(tree[i].boundingVolume),
+                                &std::get<TileTree::box_t>(back[i].boundingVolume), sizeof(TileTree::box_t)));
+            EXPECT_EQ(tree.uri(i), back.uri(i));
+            EXPECT_EQ(tree.effective_refine(i), back.effective_refine(i));
+            EXPECT_EQ(tree[i].parent, back[i].parent);
+        }
+        ASSERT_TRUE(back.transform(0));
+        EXPECT_EQ(0.3, back.transform(0)->matrix4x4[14]);
+
+        // json-c agrees
+        json_object *o = json_tokener_parse(text.c_str());
+        ASSERT_TRUE(o);
+        json_object_put(o);
+    }
+
+    // shortest representation
+    auto text = TilesetWriter::to_string(tree);
+    EXPECT_NE(std::string::npos, text.find(R"("geometricError":0.1,"root")"));
+    EXPECT_NE(std::string::npos, text.find(R"("transform":[1,0,0,0,0,1,0,0,0,0,1,0,0.1,0.2,0.3,1])"));
+
+    // compared to TilesetJson with the same (pretty) layout
+    auto f_ours = ws / "ours.json";
+    ASSERT_TRUE(TilesetWriter::save_as(tree, f_ours.string(), true));
+    auto f_theirs = ws / "theirs.json";
+    TilesetJson doc;
+    tree.to_json(doc);
+    ASSERT_TRUE(doc.save_as(f_theirs.string()));
+    CONSOLE_EVAL(fs::file_size(f_ours));
+    CONSOLE_EVAL(fs::file_size(f_theirs));
+    EXPECT_LT(fs::file_size(f_ours), fs::file_size(f_theirs));
+    EXPECT_EQ(tree.size(), TilesetReader::load(f_ours.string()).size());
+}
+
+/// @brief The binary image next to tileset.json is used when it is valid
+/// @param --gtest_filter=TilesetF.image_sidecar
+TEST_F(TilesetF, image_sidecar) {
+    auto ws = create_ws();
+    auto json = ws / "tileset.json";
+    fs::copy_file(test_data("GM13206_test.tb_1_tiles/tileset.json"), json);
+    auto image_file = TilesetImage::sidecar_path(json);
+
+    std::string expected;
+    {
+        TilesetJson doc(json.string());
+        EXPECT_FALSE(doc.has_image());
+        expected = to_string(doc.root(), ws, "expected.json");
+    }
+
+    // the first load writes the image, the second one uses it
+    auto parsed = TilesetReader::load_cached(json.string());
+    ASSERT_TRUE(fs::exists(image_file));
+    auto image = TilesetImage::open(json, true);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(parsed.size(), image->size());
+    auto cached = TileTree::from_image(*image);
+    EXPECT_EQ(TilesetWriter::to_string(parsed), TilesetWriter::to_string(cached));
+    image.reset();
+    EXPECT_FALSE(TilesetJson(json.string()).has_image());
+
+    {
+        TilesetJson doc(json.string(), TilesetJsonImage::open(json.string()));
+        EXPECT_TRUE(doc.has_image());
+        ASSERT_TRUE(parsed.asset.extra_ion_georeferenced.has_value());
+        EXPECT_EQ(parsed.asset.extra_ion_georeferenced, doc.asset().extra_ion_georeferenced);
+        EXPECT_EQ(std::string("1.0"), doc.asset().version);
+        EXPECT_DOUBLE_EQ(112.249721603218, doc.geometricError());
+        EXPECT_EQ(expected, to_string(doc.root(), ws, "actual.json"));
+
+        // modifications need the document
+        doc.geometricError(1.0);
+        EXPECT_FALSE(doc.has_image());
+        EXPECT_EQ(1.0, doc.geometricError());
+    }
+
+    // the asset extras are in the header flags
+    for (bool georeferenced : {true, false}) {
+        cached.asset.extra_ion_georeferenced = georeferenced;
+        ASSERT_TRUE(cached.write_image(json.string()));
+        TilesetJson doc(json.string(), TilesetJsonImage::open(json.string()));
+        ASSERT_TRUE(doc.has_image());
+        ASSERT_TRUE(doc.asset().extra_ion_georeferenced.has_value());
+        EXPECT_EQ(georeferenced, doc.asset().extra_ion_georeferenced.value());
+    }
+
+    // same content, new time: validated by the hash
+    fs::last_write_time(json, fs::last_write_time(json) + std::chrono::hours(1));
+    EXPECT_TRUE(TilesetImage::open(json));
+
+    // changed content
+    {
+        std::string text;
+        {
+            std::ifstream is(json);
+            text.assign(std::istreambuf_iterator<char>(is), {});
+        }
+        auto pos = text.find("112.249721603218");
+        ASSERT_NE(std::string::npos, pos);
+        text[pos] = '9';
+        std::ofstream(json) << text;
+    }
+    EXPECT_FALSE(TilesetImage::open(json));
+    EXPECT_FALSE(TilesetJsonImage::open(json.string()));
+    auto reloaded = TilesetReader::load_cached(json.string());
+    EXPECT_DOUBLE_EQ(912.249721603218, reloaded.geometricError);
+    EXPECT_TRUE(TilesetImage::open(json, true));
+
+    // damaged image
+    {
+        auto size = fs::file_size(image_file);
+        fs::resize_file(image_file, size - 1);
+        EXPECT_FALSE(TilesetImage::open(json));
+        fs::resize_file(image_file, size);
+        EXPECT_TRUE(TilesetImage::open(json));
+
+        // a broken link: the parent of the second tile
+        std::fstream f(image_file, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(sizeof(TilesetImage::header_t) + sizeof(TilesetImage::tile_t) + offsetof(TilesetImage::tile_t, parent));
+        uint32_t bad = 7;
+        f.write(reinterpret_cast<const char *>(&bad), sizeof(bad));
+        f.flush();
+        EXPECT_FALSE(TilesetImage::open(json));
+        uint32_t good = 0;
+        f.seekp(sizeof(TilesetImage::header_t) + sizeof(TilesetImage::tile_t) + offsetof(TilesetImage::tile_t, parent));
+        f.write(reinterpret_cast<const char *>(&good), sizeof(good));
+        f.flush();
+        EXPECT_TRUE(TilesetImage::open(json));
+
+        // a sibling cycle: the second tile follows itself
+        uint32_t self = 1;
+        f.seekp(sizeof(TilesetImage::header_t) + sizeof(TilesetImage::tile_t) +
+                offsetof(TilesetImage::tile_t, next_sibling));
+        f.write(reinterpret_cast<const char *>(&self), sizeof(self));
+        f.close();
+        EXPECT_FALSE(TilesetImage::open(json));
+    }
+}
+
+/// @brief Error monotonicity, containment, transforms and content files
+/// @param --gtest_filter=TilesetF.validator
+TEST_F(TilesetF, validator) {
+    auto ws = create_ws();
+    typedef TilesetValidator V;
+
+    auto tree = make_quadtree(5, TileTree::REFINE_REPLACE);
+    tree.geometricError = tree[0].geometricError;
+    V::options_t options;
+    options.check_content = false;
+    for (unsigned threads : {1u, 4u}) {
+        options.threads = threads;
+        auto report = V::validate(tree, ws, options);
+        EXPECT_EQ(tree.size(), report.tiles);
+        EXPECT_TRUE(report.ok());
+        EXPECT_TRUE(report.issues.empty());
+    }
+
+    // break some tiles
+    auto a = tree[0].first_child;
+    auto b = tree[a].first_child;
+    auto c = tree[a].next_sibling;
+    auto d = tree[c].next_sibling;
+    auto e = tree[b].first_child;
+    tree[a].geometricError = 1e6;
+    auto &half_axes = std::get<TileTree::box_t>(tree[b].boundingVolume).box;
+    for (int k = 3; k != 12; ++k)
+        half_axes[k] *= 2;
+    tree.set_transform(c, TileTree::transform_t{1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+    tree.set_transform(d, TileTree::transform_t{1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+    tree[e].boundingVolume = {};
+
+    std::string expected;
+    for (unsigned threads : {1u, 3u, 8u}) {
+        options.threads = threads;
+        auto report = V::validate(tree, ws, options);
+        EXPECT_FALSE(report.ok());
+        EXPECT_EQ(1, report.count(V::GEOMETRIC_ERROR_INCREASES));
+        EXPECT_EQ(1, report.count(V::VOLUME_NOT_CONTAINED));
+        EXPECT_EQ(2, report.count(V::TRANSFORM_INVALID));
+        EXPECT_EQ(1, report.count(V::VOLUME_MISSING));
+        EXPECT_EQ(4, report.errors);
+        EXPECT_EQ(1, report.warnings);
+        ASSERT_EQ(5, report.issues.size());
+        EXPECT_EQ(a, report.issues[0].tile);
+        EXPECT_EQ(b, report.issues[1].tile);
+
+        // the same report whatever the number of threads
+        auto text = V::report_to_string(report, tree);
+        if (expected.empty())
+            expected = text;
+        EXPECT_EQ(expected, text);
+    }
+    CONSOLE_EVAL(expected);
+    EXPECT_NE(std::string::npos, expected.find(R"("tile":)" + std::to_string(b) +
+                                               R"(,"path":"/root/children/0/children/0",)"));
+    EXPECT_NE(std::string::npos, expected.find(R"("code":"transform_invalid")"));
+
+    // regions and mixed volumes
+    {
+        TileTree geo;
+        auto root = geo.add_tile(TileTree::npos);
+        geo[root].geometricError = 10;
+        geo[root].boundingVolume = TileTree::region_t{{-1.3, 0.6, -1.2, 0.7, 0, 100}};
+        auto in = geo.add_tile(root);
+        geo[in].geometricError = 5;
+        geo[in].boundingVolume = TileTree::region_t{{-1.29, 0.61, -1.21, 0.69, 10, 90}};
+        auto out = geo.add_tile(root);
+        geo[out].geometricError = 5;
+        geo[out].boundingVolume = TileTree::region_t{{-1.29, 0.61, -1.1, 0.69, 10, 90}};
+        auto p = TilesetIndex::cartographic_to_ecef(-1.25, 0.65, 50);
+        auto box = geo.add_tile(in);
+        geo[box].boundingVolume = TileTree::box_t{{p[0], p[1], p[2], 10, 0, 0, 0, 10, 0, 0, 0, 10}};
+        auto sphere = geo.add_tile(in);
+        geo[sphere].boundingVolume = TileTree::sphere_t{{p[0], p[1], p[2], 100}};
+        auto local = geo.add_tile(box);
+        geo.set_transform(local, TileTree::transform_t{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, p[0], p[1], p[2], 1});
+        geo[local].boundingVolume = TileTree::sphere_t{{1, 2, 3, 5}};
+
+        geo.geometricError = 10;
+        auto report = V::validate(geo, ws, options);
+        CONSOLE_EVAL(V::report_to_string(report, geo, true));
+        ASSERT_EQ(2, report.issues.size());
+        EXPECT_EQ(out, report.issues[0].tile);
+        EXPECT_EQ(V::VOLUME_NOT_CONTAINED, report.issues[0].code);
+        EXPECT_EQ(sphere, report.issues[1].tile);
+        EXPECT_EQ(V::VOLUME_NOT_CONTAINED, report.issues[1].code);
+        EXPECT_TRUE(report.ok());
+    }
+
+    // content files
+    {
+        auto b3dm = test_data("GM13206_test.tb_1_tiles/0composite0.b3dm");
+        fs::copy_file(b3dm, ws / "good.b3dm");
+        fs::copy_file(b3dm, ws / "short.b3dm");
+        fs::resize_file(ws / "short.b3dm", fs::file_size(b3dm) - 4);
+        std::ofstream(ws / "external.json") << "  {\"asset\":{\"version\":\"1.0\"}}";
+        std::ofstream(ws / "text.b3dm") << "not a tile";
+
+        TileTree files;
+        auto root = files.add_tile(TileTree::npos);
+        files[root].boundingVolume = TileTree::sphere_t{{0, 0, 0, 1}};
+        for (auto uri : {"good.b3dm", "short.b3dm", "missing.b3dm", "external.json?v=2", "text.b3dm",
+                         "https://example.com/remote.b3dm"}) {
+            auto i = files.add_tile(root);
+            files[i].boundingVolume = TileTree::sphere_t{{0, 0, 0, 1}};
+            files.set_uri(i, uri);
+        }
+        auto report = V::validate(files, ws);
+        CONSOLE_EVAL(V::report_to_string(report, files, true));
+        EXPECT_EQ(1, report.count(V::CONTENT_MISSING));
+        EXPECT_EQ(2, report.count(V::CONTENT_INVALID));
+        EXPECT_EQ(3, report.errors);
+        EXPECT_EQ(0, report.warnings);
+    }
+
+    // the sample tileset is fine
+    auto report = V::validate(test_data("GM13206_test.tb_1_tiles/tileset.json").string());
+    CONSOLE_EVAL(report.issues.size());
+    EXPECT_TRUE(report.ok());
+}
+
+/// @brief The bounding boxes scene merged per depth level and instanced
+/// @param --gtest_filter=TilesetF.bounding_boxes_scene
+TEST_F(TilesetF, bounding_boxes_scene) {
+    auto tree = make_quadtree(4, TileTree::REFINE_REPLACE);
+    TilesetJson doc;
+    tree.to_json(doc);
+
+    // the reference: a mesh per tile, in the document order
+    auto per_tile = doc.build_bounding_boxes_scene();
+    ASSERT_EQ(tree.size(), per_tile->mNumMeshes);
+
+    std::vector<aiColor4D> colors{{1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1}};
+    auto merged = doc.build_bounding_boxes_scene(TilesetJson::SCENE_MERGED_LEVELS, colors);
+    ASSERT_EQ(4, merged->mNumMeshes);
+    ASSERT_EQ(4, merged->mRootNode->mNumChildren);
+    unsigned n = 0;
+    for (unsigned d = 0; d != 4; ++d) {
+        auto mesh = merged->mMeshes[d];
+        auto boxes = 1u << (2 * d);
+        ASSERT_EQ(8 * boxes, mesh->mNumVertices);
+        ASSERT_EQ(12 * boxes, mesh->mNumFaces);
+        EXPECT_EQ(colors[d % 3], mesh->mColors[0][0]);
+        EXPECT_EQ(d, merged->mRootNode->mChildren[d]->mMeshes[0]);
+        EXPECT_EQ(mesh->mNumVertices - 1, mesh->mFaces[mesh->mNumFaces - 1].mIndices[1]);
+        // the line indices of the level are one block
+        EXPECT_EQ(mesh->mFaces[0].mIndices + 2 * (mesh->mNumFaces - 1), mesh->mFaces[mesh->mNumFaces - 1].mIndices);
+        n += boxes;
+    }
+    EXPECT_EQ(tree.size(), n);
+    EXPECT_EQ(4, meshtoolbox::arena_of(merged).blocks());
+
+    // the same lines: the first box of the level 1 is the second tile
+    auto const *m1 = merged->mMeshes[1];
+    auto const *t1 = per_tile->mMeshes[1];
+    for (unsigned v = 0; v != 8; ++v)
+        EXPECT_EQ(t1->mVertices[v], m1->mVertices[v]);
+    for (unsigned f = 0; f != 12; ++f) {
+        EXPECT_EQ(t1->mFaces[f].mIndices[0], m1->mFaces[f].mIndices[0]);
+        EXPECT_EQ(t1->mFaces[f].mIndices[1], m1->mFaces[f].mIndices[1]);
+    }
+
+    auto instanced = doc.build_bounding_boxes_scene(TilesetJson::SCENE_INSTANCED);
+    ASSERT_EQ(1, instanced->mNumMeshes);
+    EXPECT_EQ(8, instanced->mMeshes[0]->mNumVertices);
+    ASSERT_EQ(4, instanced->mRootNode->mNumChildren);
+    EXPECT_EQ(16, instanced->mRootNode->mChildren[2]->mNumChildren);
+    auto const *node = instanced->mRootNode->mChildren[1]->mChildren[0];
+    ASSERT_EQ(1, node->mNumMeshes);
+    EXPECT_EQ(0, node->mMeshes[0]);
+    for (unsigned v = 0; v != 8; ++v)
+        EXPECT_EQ(t1->mVertices[v], node->mTransformation * instanced->mMeshes[0]->mVertices[v]);
+}
+
+/// @brief Added, removed and changed subtrees; overlay and mirror merges
+/// @param --gtest_filter=TilesetF.diff_merge
+TEST_F(TilesetF, diff_merge) {
+    auto ws = create_ws();
+    typedef TilesetDiff D;
+
+    auto a = make_quadtree(4, TileTree::REFINE_REPLACE);
+    {
+        auto same = make_quadtree(4, TileTree::REFINE_REPLACE);
+        auto d = D::diff(a, same);
+        EXPECT_TRUE(d.identical());
+        EXPECT_EQ(a.size(), d.unchanged);
+        EXPECT_EQ(a.size(), size_t(std::count(d.same.begin(), d.same.end(), 1)));
+    }
+
+    // b: one error changed, one leaf moved, one content renamed, one tile added
+    auto b = make_quadtree(4, TileTree::REFINE_REPLACE);
+    auto c1 = b[0].first_child;
+    auto c2 = b[c1].next_sibling;
+    auto c3 = b[c2].next_sibling;
+    auto c4 = b[c3].next_sibling;
+    b[c2].geometricError /= 2;
+    auto leaf = b[b[c3].first_child].first_child;
+    std::get<TileTree::box_t>(b[leaf].boundingVolume).box[2] = 0.5;
+    auto renamed = b[b[c4].first_child].last_child;
+    b.set_uri(renamed, "renamed.b3dm");
+    auto added = b.add_tile(leaf);
+    b[added].boundingVolume = b[leaf].boundingVolume;
+    b.set_uri(added, "added.b3dm");
+
+    auto d = D::diff(a, b);
+    CONSOLE_EVAL(D::report_to_string(d, a, b, true));
+    EXPECT_FALSE(d.identical());
+    EXPECT_EQ(3, d.changed);
+    EXPECT_EQ(1, d.added);
+    EXPECT_EQ(0, d.removed);
+    // all but the root, c2, c3, c4, the parents of the leaf and of the renamed tile, the leaf and the renamed tile
+    EXPECT_EQ(a.size() - 8, d.unchanged);
+    for (auto const &c : d.changes) {
+        if (c.kind == D::ADDED)
+            EXPECT_EQ(added, c.b);
+        else if (c.b == c2)
+            EXPECT_EQ(D::GEOMETRIC_ERROR, c.what);
+        else if (c.b == leaf)
+            EXPECT_EQ(D::VOLUME, c.what);
+        else {
+            EXPECT_EQ(renamed, c.b);
+            EXPECT_EQ(D::URI, c.what);
+        }
+    }
+    EXPECT_EQ((std::vector<std::string>{"added.b3dm", "renamed.b3dm"}), D::changed_content(d, b));
+
+    // the reverse: the added tile is removed
+    auto r = D::diff(b, a);
+    EXPECT_EQ(1, r.removed);
+    EXPECT_EQ(3, r.changed);
+
+    // mirror: the update itself
+    auto mirror = D::merge(a, b, d, D::MERGE_MIRROR);
+    EXPECT_EQ(TilesetWriter::to_string(b), TilesetWriter::to_string(mirror.tree));
+    // the same 8 and the added tile
+    EXPECT_EQ(9, mirror.rewritten.size());
+
+    // overlay: a regional update (a subtree of b) keeps the rest of a
+    TileTree regional;
+    {
+        regional.append_copy(b, 0, TileTree::npos);
+        std::vector<std::pair<TileTree::index_t, TileTree::index_t>> stack{{c4, 0}};
+        while (!stack.empty()) {
+            auto [i, p] = stack.back();
+            stack.pop_back();
+            auto t = regional.append_copy(b, i, p);
+            b.for_each_child(i, [&, t = t](TileTree::index_t c) { stack.emplace_back(c, t); });
+        }
+    }
+    auto dr = D::diff(a, regional);
+    EXPECT_EQ(3 * 21, dr.removed);
+    auto overlay = D::merge(a, regional, dr, D::MERGE_OVERLAY, "regional/");
+    ASSERT_EQ(a.size(), overlay.tree.size());
+    auto back = D::diff(overlay.tree, b);
+    // c2 and the moved leaf (c3) come from a, the renamed tile got the prefix
+    EXPECT_EQ(3, back.changed);
+    bool prefixed = false;
+    for (TileTree::index_t i = 0; i != overlay.tree.size(); ++i)
+        prefixed |= overlay.tree.uri(i) == "regional/renamed.b3dm";
+    EXPECT_TRUE(prefixed);
+
+    // content files: same names, different bytes
+    auto dir_a = ws / "a", dir_b = ws / "b";
+    fs::create_directories(dir_a);
+    fs::create_directories(dir_b);
+    for (TileTree::index_t i = 0; i != a.size(); ++i) {
+        std::ofstream(dir_a / std::string(a.uri(i))) << "tile " << i;
+        std::ofstream(dir_b / std::string(a.uri(i))) << "tile " << (i == 7 ? 70 : i);
+    }
+    auto same = make_quadtree(4, TileTree::REFINE_REPLACE);
+    D::options_t options;
+    options.compare_content = true;
+    options.dir_a = dir_a;
+    options.dir_b = dir_b;
+    options.threads = 3;
+    auto dc = D::diff(a, same, options);
+    ASSERT_EQ(1, dc.changes.size());
+    EXPECT_EQ(7, dc.changes[0].a);
+    EXPECT_EQ(D::CONTENT, dc.changes[0].what);
+    EXPECT_EQ(1, dc.changed);
+    EXPECT_EQ(a.size() - a.depth(7) - 1, dc.unchanged);
+}
+
+/// @brief The tables and the glb of a tile are views of the mapped file
+/// @param --gtest_filter=TilesetF.tile_content
+TEST_F(TilesetF, tile_content) {
+    auto b3dm_file = test_data("GM13206_test.tb_1_tiles/0composite0.b3dm");
+    TileContent b3dm;
+    ASSERT_TRUE(b3dm.open(b3dm_file)) << b3dm.error();
+    EXPECT_EQ(TileHeader::B3DM, b3dm.format());
+    EXPECT_EQ(fs::file_size(b3dm_file), b3dm.data().size);
+    EXPECT_EQ(R"({"BATCH_LENGTH":0})", b3dm.feature_table_json().str());
+    EXPECT_TRUE(b3dm.batch_table_json().empty());
+    auto glb = b3dm.glb();
+    ASSERT_EQ(b3dm.data().size - b3dm.header().body_offset(), glb.size);
+    EXPECT_EQ(b3dm.data().data + b3dm.header().body_offset(), glb.data);
+    EXPECT_EQ("glTF", std::string_view(glb.data, 4));
+
+    auto pnts_file = test_data("cesium/pnts/0.pnts");
+    TileContent pnts;
+    ASSERT_TRUE(pnts.open(pnts_file)) << pnts.error();
+    EXPECT_EQ(TileHeader::PNTS, pnts.format());
+    EXPECT_EQ(0, pnts.feature_table_json().str().find(R"({"POINTS_LENGTH":507)"));
+    EXPECT_EQ(pnts.header().featureTableBinaryByteLength, pnts.points().size);
+    EXPECT_TRUE(pnts.glb().empty());
+
+    // a b3dm with a batch table in memory
+    std::string glb_bytes;
+    {
+        std::ifstream is(test_data("BoxTextured-glTF-Binary/BoxTextured.glb"), std::ios::binary);
+        glb_bytes.assign(std::istreambuf_iterator<char>(is), {});
+    }
+    std::string ft = R"({"BATCH_LENGTH":1})", bt = R"({"name":["box"]})";
+    ft.resize((ft.size() + 28 + 7) / 8 * 8 - 28, ' ');
+    bt.resize((bt.size() + 7) / 8 * 8, ' ');
+    uint32_t header[7] = {0, 1, uint32_t(28 + ft.size() + bt.size() + glb_bytes.size()), uint32_t(ft.size()), 0,
+                          uint32_t(bt.size()), 0};
+    std::memcpy(header, "b3dm", 4);
+    std::string tile(reinterpret_cast<const char *>(header), sizeof(header));
+    tile += ft + bt + glb_bytes;
+
+    TileContent mem;
+    ASSERT_TRUE(mem.parse(tile.data(), tile.size())) << mem.error();
+    EXPECT_EQ(R"({"BATCH_LENGTH":1})", mem.feature_table_json().str());
+    EXPECT_EQ(R"({"name":["box"]})", mem.batch_table_json().str());
+    EXPECT_EQ(tile.data() + 28 + ft.size() + bt.size(), mem.glb().data);
+    EXPECT_EQ(glb_bytes.size(), mem.glb().size);
+
+    // damaged
+    tile.resize(tile.size() - 1);
+    EXPECT_FALSE(mem.parse(tile.data(), tile.size()));
+    CONSOLE_EVAL(mem.error());
+    TileContent missing;
+    EXPECT_FALSE(missing.open(test_data("no-such.b3dm")));
+}
+
+/// @brief A scene with a triangle mesh per feature
+static std::unique_ptr<aiScene> make_triangles(unsigned meshes, aiVector3D const &at) {
+    auto scene = std::make_unique<aiScene>();
+    scene->mNumMaterials = 1;
+    scene->mMaterials = new aiMaterial *[1]{new aiMaterial()};
+    scene->mNumMeshes = meshes;
+    scene->mMeshes = new aiMesh *[meshes];
+    scene->mRootNode = new aiNode("root");
+    scene->mRootNode->mNumMeshes = meshes;
+    scene->mRootNode->mMeshes = new unsigned[meshes];
+    for (unsigned m = 0; m != meshes; ++m) {
+        auto mesh = new aiMesh();
+        mesh->mName = "m" + std::to_string(m);
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        mesh->mNumVertices = 3;
+        mesh->mVertices = new aiVector3D[3]{at, at + aiVector3D(1, 0, float(m)), at + aiVector3D(0, 1, float(m))};
+        mesh->mNumFaces = 1;
+        mesh->mFaces = new aiFace[1];
+        mesh->mFaces[0].mNumIndices = 3;
+        mesh->mFaces[0].mIndices = new unsigned[3]{0, 1, 2};
+        scene->mMeshes[m] = mesh;
+        scene->mRootNode->mMeshes[m] = m;
+    }
+    return scene;
+}
+
+/// @param --gtest_filter=TilesetF.exporter
+TEST_F(TilesetF, exporter) {
+    auto ws = create_ws();
+
+    TilesetExporter::options_t options;
+    options.threads = 4;
+    options.max_pending = 2;
+    {
+        TilesetExporter exporter(ws, options);
+        auto root = exporter.add_tile(TilesetExporter::npos, 100.0);
+        exporter.tree()[root].refine = TileTree::REFINE_ADD;
+        for (int k = 0; k != 8; ++k) {
+            TilesetExporter::batch_t batch;
+            batch.mesh_batch_ids = {0, 0, 1};
+            batch.strings = {{"name", {"wall", "roof"}}};
+            batch.numbers = {{"height", {10.0 + k, 2.5}}};
+            exporter.add_tile(root, 0.0, make_triangles(3, aiVector3D(10.0f * k, 0, 0)), batch);
+        }
+        auto filename = exporter.finish();
+        EXPECT_EQ(8u, exporter.written());
+        EXPECT_EQ(ws / "tileset.json", filename);
+    }
+
+    TileTree tree = TilesetReader::load((ws / "tileset.json").string());
+    ASSERT_EQ(9u, tree.size());
+    EXPECT_EQ(100.0, tree.geometricError);
+    auto root_box = std::get_if<TileTree::box_t>(&tree[tree.root()].boundingVolume);
+    ASSERT_TRUE(root_box);
+    EXPECT_DOUBLE_EQ(35.5, root_box->box[0]); // x: 0 .. 71
+    EXPECT_DOUBLE_EQ(35.5, root_box->box[3]);
+    // Y-up content: the scene z (0 .. 2) goes to -y, y (0 .. 1) to z
+    EXPECT_DOUBLE_EQ(-1.0, root_box->box[1]);
+    EXPECT_DOUBLE_EQ(1.0, root_box->box[7]);
+    EXPECT_DOUBLE_EQ(0.5, root_box->box[2]);
+    EXPECT_DOUBLE_EQ(0.5, root_box->box[11]);
+
+    auto report = TilesetValidator::validate((ws / "tileset.json").string());
+    EXPECT_TRUE(report.ok()) << TilesetValidator::report_to_string(report, tree);
+
+    TileContent b3dm;
+    ASSERT_TRUE(b3dm.open(ws / std::string(tree.uri(tree[tree.root()].first_child)))) << b3dm.error();
+    EXPECT_EQ(0u, b3dm.data().size % 8);
+    EXPECT_EQ(R"({"BATCH_LENGTH":2})", b3dm.feature_table_json().str());
+    EXPECT_EQ(R"({"name":["wall","roof"],"height":{"byteOffset":0,"componentType":"DOUBLE","type":"SCALAR"}})",
+              b3dm.batch_table_json().str());
+    ASSERT_EQ(2 * sizeof(double), b3dm.batch_table_binary().size);
+    double height[2];
+    std::memcpy(height, b3dm.batch_table_binary().data, sizeof(height));
+    EXPECT_EQ(10.0, height[0]);
+    EXPECT_EQ(2.5, height[1]);
+    ASSERT_FALSE(b3dm.glb().empty());
+    EXPECT_EQ(0u, (b3dm.glb().data - b3dm.data().data) % 8);
+    EXPECT_EQ(b3dm.data().data + b3dm.data().size, b3dm.glb().data + b3dm.glb().size);
+    EXPECT_NE(std::string_view::npos, b3dm.glb().str().find("\"_BATCHID\""));
+
+    // the property length must match BATCH_LENGTH
+    {
+        TilesetExporter exporter(ws / "bad", options);
+        TilesetExporter::batch_t batch;
+        batch.numbers = {{"height", {1.0}}};
+        exporter.add_tile(TilesetExporter::npos, 0.0, make_triangles(2, aiVector3D()), batch);
+        EXPECT_THROW(exporter.finish(), std::runtime_error);
+    }
+}
+
+/// @param --gtest_filter=TilesetF.i3dm
+TEST_F(TilesetF, i3dm) {
+    auto ws = create_ws();
+
+    TileInstances instances;
+    instances.rtc_center = {1000.0, 2000.0, 0.0};
+    instances.add({0, 0, 0});
+    instances.add({10, 0, 0}, {2, 2, 2});
+    instances.add({0, 10, 0}, {1, 1, 3}, {-1, 0, 0}, {0, 1, 0}, 0); // turned 90 degrees, the same feature as #0
+    EXPECT_EQ(2u, instances.batch_length());
+
+    TilesetExporter::options_t options;
+    options.threads = 2;
+    {
+        TilesetExporter exporter(ws, options);
+        TilesetExporter::batch_t batch;
+        batch.strings = {{"kind", {"pole", "tree"}}};
+        exporter.add_tile(TilesetExporter::npos, 0.0, make_triangles(1, aiVector3D()), instances, batch);
+        exporter.finish();
+    }
+
+    TileTree tree = TilesetReader::load((ws / "tileset.json").string());
+    ASSERT_EQ(1u, tree.size());
+    EXPECT_EQ("tiles/0.i3dm", tree.uri(0));
+    // the triangle is (0 .. 1, 0 .. 1) in the Y-up model, i.e. x 0 .. 1, z 0 .. 1 in the tile frame
+    auto box = std::get_if<TileTree::box_t>(&tree[0].boundingVolume);
+    ASSERT_TRUE(box);
+    EXPECT_DOUBLE_EQ(1000.0 + 6.0, box->box[0]); // #1 spans x 10 .. 12
+    EXPECT_DOUBLE_EQ(2000.0 + 5.5, box->box[1]); // #2: the model x goes to y 10 .. 11
+    EXPECT_DOUBLE_EQ(1.5, box->box[2]);          // #2: the forward axis (z) is scaled by 3
+
+    TileContent tile;
+    ASSERT_TRUE(tile.open(ws / "tiles/0.i3dm")) << tile.error();
+    EXPECT_EQ(TileHeader::I3DM, tile.format());
+    EXPECT_EQ(1u, tile.header().gltfFormat);
+    EXPECT_EQ(0u, tile.data().size % 8);
+    EXPECT_FALSE(tile.glb().empty());
+    EXPECT_EQ(R"({"kind":["pole","tree"]})", tile.batch_table_json().str());
+
+    TileInstances actual;
+    std::string error;
+    ASSERT_TRUE(actual.parse(tile, error)) << error;
+    ASSERT_EQ(3u, actual.size());
+    EXPECT_EQ(instances.rtc_center, actual.rtc_center);
+    EXPECT_EQ(instances.positions, actual.positions);
+    EXPECT_EQ(instances.scales, actual.scales);
+    EXPECT_EQ(instances.normal_up, actual.normal_up);
+    EXPECT_EQ(instances.normal_right, actual.normal_right);
+    EXPECT_EQ(instances.batch_ids, actual.batch_ids);
+
+    // only the positions when the rest are the defaults
+    TileInstances plain;
+    plain.add({1, 2, 3});
+    plain.add({4, 5, 6});
+    std::string json, binary;
+    plain.write_feature_table(json, binary, 32);
+    EXPECT_EQ(0u, (32 + json.size()) % 8);
+    EXPECT_EQ(R"({"INSTANCES_LENGTH":2,"POSITION":{"byteOffset":0}})", json.substr(0, json.find_last_not_of(' ') + 1));
+    EXPECT_EQ(24u, binary.size());
+}
+
+/// @param --gtest_filter=TilesetF.composite
+TEST_F(TilesetF, composite) {
+    auto ws = create_ws();
+
+    size_t tile_size = 0;
+    {
+        // the size of a leaf
+        TilesetExporter::options_t options;
+        options.threads = 1;
+        TilesetExporter exporter(ws / "one", options);
+        exporter.add_tile(TilesetExporter::npos, 0.0, make_triangles(2, aiVector3D()));
+        auto tree = TilesetReader::load(exporter.finish().string());
+        tile_size = fs::file_size(ws / "one" / std::string(tree.uri(0)));
+    }
+
+    TilesetExporter::options_t options;
+    options.threads = 2;
+    options.composite_bytes = 3 * tile_size + 16;
+    {
+        TilesetExporter exporter(ws, options);
+        auto root = exporter.add_tile(TilesetExporter::npos, 100.0);
+        for (int k = 0; k != 7; ++k)
+            exporter.add_tile(root, 0.0, make_triangles(2, aiVector3D(10.0f * k, 0, 0)));
+        auto inner = exporter.add_tile(root, 10.0); // not a leaf
+        exporter.add_tile(inner, 0.0, make_triangles(2, aiVector3D(0, 0, 50)));
+        exporter.finish();
+    }
+
+    // 7 leaves -> 3 + 3 + 1, the inner tile and its only child as is
+    TileTree tree = TilesetReader::load((ws / "tileset.json").string());
+    ASSERT_EQ(1u + 3 + 1 + 1, tree.size());
+    std::vector<std::string> uris;
+    tree.for_each_child(tree.root(), [&](TileTree::index_t c) { uris.push_back(std::string(tree.uri(c))); });
+    EXPECT_EQ((std::vector<std::string>{"tiles/1_3.cmpt", "tiles/4_3.cmpt", "tiles/7.b3dm", ""}), uris);
+    EXPECT_FALSE(fs::exists(ws / "tiles/1.b3dm"));
+
+    auto box = std::get_if<TileTree::box_t>(&tree[tree[tree.root()].first_child].boundingVolume);
+    ASSERT_TRUE(box);
+    EXPECT_DOUBLE_EQ(10.5, box->box[0]); // x 0 .. 21
+    EXPECT_DOUBLE_EQ(10.5, box->box[3]);
+
+    auto report = TilesetValidator::validate((ws / "tileset.json").string());
+    EXPECT_TRUE(report.ok()) << TilesetValidator::report_to_string(report, tree);
+
+    TileComposite cmpt;
+    ASSERT_TRUE(cmpt.open(ws / "tiles/1_3.cmpt")) << cmpt.error();
+    ASSERT_EQ(3u, cmpt.size());
+    for (size_t i = 0; i != cmpt.size(); ++i) {
+        EXPECT_EQ(0u, cmpt[i].size % 8);
+        TileContent inner;
+        ASSERT_TRUE(cmpt.content(i, inner)) << inner.error();
+        EXPECT_EQ(TileHeader::B3DM, inner.format());
+        EXPECT_EQ(R"({"BATCH_LENGTH":2})", inner.feature_table_json().str());
+        EXPECT_FALSE(inner.glb().empty());
+    }
+
+    // nested and damaged
+    std::string nested = TileComposite::pack({cmpt.data().str(), cmpt[1].str()});
+    TileComposite outer;
+    ASSERT_TRUE(outer.parse(nested.data(), nested.size())) << outer.error();
+    TileComposite again;
+    EXPECT_TRUE(again.parse(outer[0].data, outer[0].size)) << again.error();
+    nested[16 + 8] += 8; // the first inner byteLength
+    EXPECT_FALSE(outer.parse(nested.data(), nested.size()));
+    CONSOLE_EVAL(outer.error());
+}
+
+/// @param --gtest_filter=TilesetF.bounding_sphere
+TEST_F(TilesetF, bounding_sphere) {
+    auto contains = [](TileSphere::sphere_t const &s, std::vector<float> const &xyz, size_t stride) {
+        for (size_t i = 0; i + 3 <= xyz.size(); i += stride) {
+            double dx = xyz[i] - s[0], dy = xyz[i + 1] - s[1], dz = xyz[i + 2] - s[2];
+            if (std::sqrt(dx * dx + dy * dy + dz * dz) > s[3])
+                return false;
+        }
+        return true;
+    };
+
+    // the degenerate sets: one point, a segment, collinear, the corners of a square
+    std::vector<float> one{1, 2, 3};
+    EXPECT_EQ((TileSphere::sphere_t{1, 2, 3, 0}), TileSphere::of_points(one.data(), 1, 12, TileSphere::EXACT));
+    std::vector<float> line{0, 0, 0, 1, 0, 0, 2, 0, 0, 4, 0, 0, 3, 0, 0};
+    std::vector<float> square{0, 0, 0, 2, 0, 0, 2, 2, 0, 0, 2, 0, 1, 1, 0};
+    for (auto quality : {TileSphere::FAST, TileSphere::BALANCED, TileSphere::EXACT}) {
+        auto s = TileSphere::of_points(line.data(), 5, 12, quality);
+        EXPECT_NEAR(2.0, s[0], 1e-6);
+        EXPECT_NEAR(2.0, s[3], 1e-6);
+        s = TileSphere::of_points(square.data(), 5, 12, quality);
+        EXPECT_NEAR(1.0, s[1], 1e-6);
+        EXPECT_NEAR(std::sqrt(2.0), s[3], 1e-6);
+    }
+
+    // the exact sphere of a tetrahedron with a point inside, vs. the circumsphere
+    std::vector<float> tetra{1, 1, 1, 1, -1, -1, -1, 1, -1, -1, -1, 1, 0.1f, 0.2f, 0.3f};
+    auto t = TileSphere::of_points(tetra.data(), 5, 12, TileSphere::EXACT);
+    EXPECT_NEAR(0.0, std::abs(t[0]) + std::abs(t[1]) + std::abs(t[2]), 1e-6);
+    EXPECT_NEAR(std::sqrt(3.0), t[3], 1e-6);
+
+    // the points of a sphere (and some inside) at the UTM scale, 6 floats per vertex
+    double const center[3] = {500000.0, 4420783.0, 250.0}, radius = 100.0;
+    std::mt19937 rng(5);
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    size_t const n = 1 << 18;
+    std::vector<float> xyz(6 * n);
+    for (size_t i = 0; i != n; ++i) {
+        double v[3] = {normal(rng), normal(rng), normal(rng)};
+        double l = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        double r = i % 2 ? radius : radius * uniform(rng);
+        for (int a = 0; a != 3; ++a) {
+            xyz[6 * i + a] = float(center[a] + v[a] / l * r);
+            xyz[6 * i + 3 + a] = float(v[a] / l); // a normal, skipped by the stride
+        }
+    }
+    double radii[3];
+    for (auto quality : {TileSphere::FAST, TileSphere::BALANCED, TileSphere::EXACT}) {
+        auto start = std::chrono::steady_clock::now();
+        auto s = TileSphere::of_points(xyz.data(), n, 6 * sizeof(float), quality);
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        CONSOLE("quality " << quality << ": radius " << s[3] << " in " << ms << " ms");
+        EXPECT_TRUE(contains(s, xyz, 6));
+        radii[quality] = s[3];
+    }
+    EXPECT_NEAR(radius, radii[TileSphere::EXACT], 0.5); // the float spacing is 0.5 at y 4420783
+    EXPECT_LE(radii[TileSphere::EXACT], radii[TileSphere::BALANCED]);
+    EXPECT_LE(radii[TileSphere::BALANCED], 1.05 * radius);
+    EXPECT_LE(radii[TileSphere::FAST], 1.25 * radius);
+
+    // the vertices of a mesh, as for the tile bounding volumes
+    aiVector3D vertices[4] = {{0, 0, 0}, {10, 0, 0}, {0, 10, 0}, {0, 0, 10}};
+    auto s = TileSphere::of_points(&vertices[0].x, 4, sizeof(aiVector3D), TileSphere::EXACT);
+    EXPECT_NEAR(10.0 / 3, s[0], 1e-5); // the circle of the far triangle, not the circumsphere (5, 5, 5)
+    EXPECT_NEAR(10.0 / 3 * std::sqrt(6.0), s[3], 1e-5);
+}
@@ -1,6 +1,9 @@
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -94,6 +97,11 @@ struct TileNode {
     }
 };
 
+// Tile content format
+//  PNTS - legacy 3D Tiles 1.0 point cloud
+//  GLB  - glTF 2.0 POINTS primitive (3D Tiles 1.1 content)
+enum class ContentFormat { PNTS, GLB };
+
 // Point Cloud to 3D Tiles Converter
 class PointCloudTo3DTiles {
 private:
@@ -103,12 +111,26 @@ private:
     int max_depth;
     std::string output_directory;
     Point3D rtc_center;
+    ContentFormat content_format;
+    bool quantize_positions;
+    bool write_intensity;
 
 public:
     PointCloudTo3DTiles(size_t max_points = 50000, int max_depth = 10,
-                        const std::string &output_dir = "./3dtiles/")
+                        const std::string &output_dir = "./3dtiles/",
+                        ContentFormat format = ContentFormat::PNTS)
         : max_points_per_tile(max_points), max_depth(max_depth),
-          output_directory(output_dir) {}
+          output_directory(output_dir), content_format(format),
+          quantize_positions(false), write_intensity(false) {}
+
+    void setContentFormat(ContentFormat format) { content_format = format; }
+
+    // GLB only: store positions as uint16 (KHR_mesh_quantization)
+    void setQuantizePositions(bool q) { quantize_positions = q; }
+
+    // GLB only: emit the per-point intensity as a property attribute
+    // (EXT_mesh_features + EXT_structural_metadata)
+    void setWriteIntensity(bool w) { write_intensity = w; }
 
     // Load point cloud from various formats
     bool loadFromPLY(const std::string &filename) {
@@ -369,7 +391,10 @@ private:
 
         file << "{\n";
         file << "  \"asset\": {\n";
-        file << "    \"version\": \"1.0\",\n";
+        // glTF content requires 3D Tiles 1.1
+        file << "    \"version\": \""
+             << (content_format == ContentFormat::GLB ? "1.1" : "1.0")
+             << "\",\n";
         file << "    \"generator\": \"Custom Point Cloud to 3D Tiles "
                 "Converter\"\n";
         file << "  },\n";
@@ -408,7 +433,8 @@ private:
 
         if (tile->isLeaf() && !tile->points.empty()) {
             file << ind << "\"content\": {\n";
-            file << ind << "  \"uri\": \"" << tile->tile_id << ".pnts\"\n";
+            file << ind << "  \"uri\": \"" << tile->tile_id
+                 << contentExtension() << "\"\n";
             file << ind << "}";
         } else {
             file << ind << "\"refine\": \"REPLACE\"";
@@ -430,9 +456,16 @@ private:
         }
     }
 
+    const char *contentExtension() const {
+        return content_format == ContentFormat::GLB ? ".glb" : ".pnts";
+    }
+
     void generateTileFiles(std::shared_ptr<TileNode> tile) const {
         if (tile->isLeaf() && !tile->points.empty()) {
-            generatePntsFile(tile);
+            if (content_format == ContentFormat::GLB)
+                generateGlbFile(tile);
+            else
+                generatePntsFile(tile);
         }
 
         for (const auto &child : tile->children) {
@@ -520,6 +553,203 @@ private:
         file.close();
     }
 
+    static void appendBytes(std::vector<uint8_t> &buffer, const void *p,
+                            size_t size) {
+        auto b = static_cast<const uint8_t *>(p);
+        buffer.insert(buffer.end(), b, b + size);
+    }
+
+    // glTF 2.0 POINTS content: one interleaved vertex buffer per tile
+    //
+    //  POSITION    float32 x 3 (or uint16 x 3 + 2 bytes padding if quantized)
+    //  COLOR_0     uint8 x 4 normalized
+    //  _INTENSITY  float32 (optional)
+    //
+    // glTF is Y-up; Cesium rotates glTF content to Z-up, so the positions are
+    // stored as (x, z, -y) relative to the tile center (or the tile minimum
+    // corner if quantized). The offset and the quantization scale go to the
+    // node matrix.
+    void generateGlbFile(std::shared_ptr<TileNode> tile) const {
+        std::string filename = output_directory + tile->tile_id + ".glb";
+        std::ofstream file(filename, std::ios::binary);
+
+        if (!file.is_open()) {
+            std::cerr << "Cannot create GLB file: " << filename << std::endl;
+            return;
+        }
+
+        const auto &points = tile->points;
+        const uint32_t point_count = static_cast<uint32_t>(points.size());
+        const BoundingBox &bounds = tile->bounds;
+
+        // Y-up tile local frame
+        double lo[3] = {bounds.min_x, bounds.min_z, -bounds.max_y};
+        double hi[3] = {bounds.max_x, bounds.max_z, -bounds.min_y};
+
+        double offset[3], scale[3] = {1, 1, 1};
+        for (int k = 0; k < 3; ++k) {
+            if (quantize_positions) {
+                offset[k] = lo[k];
+                scale[k] = hi[k] > lo[k] ? (hi[k] - lo[k]) / 65535.0 : 1.0;
+            } else {
+                offset[k] = (lo[k] + hi[k]) / 2;
+            }
+        }
+
+        const uint32_t position_size = quantize_positions ? 8 : 12;
+        const uint32_t color_offset = position_size;
+        const uint32_t intensity_offset = color_offset + 4;
+        const uint32_t stride = intensity_offset + (write_intensity ? 4 : 0);
+
+        std::vector<uint8_t> bin;
+        bin.reserve(size_t(stride) * point_count);
+
+        float pmin[3] = {1e30f, 1e30f, 1e30f};
+        float pmax[3] = {-1e30f, -1e30f, -1e30f};
+
+        for (const auto &point : points) {
+            double p[3] = {point.x, point.z, -point.y};
+            if (quantize_positions) {
+                uint16_t q[4] = {};
+                for (int k = 0; k < 3; ++k) {
+                    double v = std::round((p[k] - offset[k]) / scale[k]);
+                    q[k] = static_cast<uint16_t>(std::clamp(v, 0.0, 65535.0));
+                    pmin[k] = std::min(pmin[k], float(q[k]));
+                    pmax[k] = std::max(pmax[k], float(q[k]));
+                }
+                appendBytes(bin, q, 8);
+            } else {
+                float f[3];
+                for (int k = 0; k < 3; ++k) {
+                    f[k] = static_cast<float>(p[k] - offset[k]);
+                    pmin[k] = std::min(pmin[k], f[k]);
+                    pmax[k] = std::max(pmax[k], f[k]);
+                }
+                appendBytes(bin, f, 12);
+            }
+            uint8_t color[4] = {point.r, point.g, point.b, 255};
+            appendBytes(bin, color, 4);
+            if (write_intensity) {
+                float intensity = static_cast<float>(point.intensity);
+                appendBytes(bin, &intensity, 4);
+            }
+        }
+
+        const uint32_t bin_length = static_cast<uint32_t>(bin.size());
+        bin.resize((bin.size() + 3) & ~size_t(3), 0);
+
+        // column-major node matrix: scale, then translate
+        // clang-format off
+        double matrix[16] = {
+            scale[0], 0, 0, 0,
+            0, scale[1], 0, 0,
+            0, 0, scale[2], 0,
+            offset[0], offset[1], offset[2], 1
+        };
+        // clang-format on
+
+        std::ostringstream json;
+        json << std::setprecision(17);
+        json << "{\"asset\":{\"version\":\"2.0\",\"generator\":"
+                "\"Custom Point Cloud to 3D Tiles Converter\"}";
+
+        std::vector<std::string> extensions;
+        if (quantize_positions)
+            extensions.push_back("KHR_mesh_quantization");
+        if (write_intensity) {
+            extensions.push_back("EXT_mesh_features");
+            extensions.push_back("EXT_structural_metadata");
+        }
+        if (!extensions.empty()) {
+            json << ",\"extensionsUsed\":[";
+            for (size_t i = 0; i < extensions.size(); ++i)
+                json << (i ? "," : "") << "\"" << extensions[i] << "\"";
+            json << "]";
+        }
+        // only the quantization changes how the vertices must be read
+        if (quantize_positions)
+            json << ",\"extensionsRequired\":[\"KHR_mesh_quantization\"]";
+
+        json << ",\"scene\":0,\"scenes\":[{\"nodes\":[0]}]";
+        json << ",\"nodes\":[{\"mesh\":0,\"matrix\":[";
+        for (int i = 0; i < 16; ++i)
+            json << (i ? "," : "") << matrix[i];
+        json << "]}]";
+
+        json << ",\"meshes\":[{\"primitives\":[{\"mode\":0,"
+                "\"attributes\":{\"POSITION\":0,\"COLOR_0\":1";
+        if (write_intensity)
+            json << ",\"_INTENSITY\":2";
+        json << "}";
+        if (write_intensity) {
+            // implicit feature IDs: one feature per point (vertex index)
+            json << ",\"extensions\":{"
+                    "\"EXT_mesh_features\":{\"featureIds\":[{"
+                    "\"featureCount\":"
+                 << point_count
+                 << "}]},"
+                    "\"EXT_structural_metadata\":{"
+                    "\"propertyAttributes\":[0]}}";
+        }
+        json << "}]}]";
+
+        json << ",\"buffers\":[{\"byteLength\":" << bin_length << "}]";
+        json << ",\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,"
+                "\"byteLength\":"
+             << bin_length << ",\"byteStride\":" << stride
+             << ",\"target\":34962}]";
+
+        json << ",\"accessors\":[";
+        json << "{\"bufferView\":0,\"byteOffset\":0,\"componentType\":"
+             << (quantize_positions ? 5123 : 5126) << ",\"count\":"
+             << point_count << ",\"type\":\"VEC3\",\"min\":[" << pmin[0]
+             << "," << pmin[1] << "," << pmin[2] << "],\"max\":[" << pmax[0]
+             << "," << pmax[1] << "," << pmax[2] << "]}";
+        json << ",{\"bufferView\":0,\"byteOffset\":" << color_offset
+             << ",\"componentType\":5121,\"normalized\":true,\"count\":"
+             << point_count << ",\"type\":\"VEC4\"}";
+        if (write_intensity)
+            json << ",{\"bufferView\":0,\"byteOffset\":" << intensity_offset
+                 << ",\"componentType\":5126,\"count\":" << point_count
+                 << ",\"type\":\"SCALAR\"}";
+        json << "]";
+
+        if (write_intensity) {
+            json << ",\"extensions\":{\"EXT_structural_metadata\":{"
+                    "\"schema\":{\"id\":\"pointcloud\",\"classes\":{"
+                    "\"point\":{\"properties\":{\"intensity\":{"
+                    "\"type\":\"SCALAR\",\"componentType\":\"FLOAT32\"}}}}},"
+                    "\"propertyAttributes\":[{\"class\":\"point\","
+                    "\"properties\":{\"intensity\":{"
+                    "\"attribute\":\"_INTENSITY\"}}}]}}";
+        }
+        json << "}";
+
+        std::string json_chunk = json.str();
+        json_chunk.resize((json_chunk.size() + 3) & ~size_t(3), ' ');
+
+        // GLB header + JSON chunk + BIN chunk
+        uint32_t version = 2;
+        uint32_t json_length = static_cast<uint32_t>(json_chunk.size());
+        uint32_t bin_chunk_length = static_cast<uint32_t>(bin.size());
+        uint32_t total_size = 12 + 8 + json_length + 8 + bin_chunk_length;
+        const uint32_t json_type = 0x4E4F534A; // "JSON"
+        const uint32_t bin_type = 0x004E4942;  // "BIN\0"
+
+        file.write("glTF", 4);
+        file.write(reinterpret_cast<const char *>(&version), 4);
+        file.write(reinterpret_cast<const char *>(&total_size), 4);
+        file.write(reinterpret_cast<const char *>(&json_length), 4);
+        file.write(reinterpret_cast<const char *>(&json_type), 4);
+        file.write(json_chunk.data(), json_length);
+        file.write(reinterpret_cast<const char *>(&bin_chunk_length), 4);
+        file.write(reinterpret_cast<const char *>(&bin_type), 4);
+        file.write(reinterpret_cast<const char *>(bin.data()),
+                   bin_chunk_length);
+
+        file.close();
+    }
+
     size_t countTiles(std::shared_ptr<TileNode> tile) const {
         size_t count = 1;
         for (const auto &child : tile->children) {
@@ -538,12 +768,28 @@ private:
 };
 
 // Example usage and demonstration
-int main() {
+//
+//  cmd_cesium_3d_tiles_pointcloud [--glb] [--quantize] [--intensity]
+int main(int argc, char *argv[]) {
     std::cout << "=== CESIUM 3D TILES POINT CLOUD CONVERTER ===\n\n";
 
     // Create converter
     PointCloudTo3DTiles converter(10000, 8, "./output_3dtiles/");
 
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--glb")
+            converter.setContentFormat(ContentFormat::GLB);
+        else if (arg == "--quantize")
+            converter.setQuantizePositions(true);
+        else if (arg == "--intensity")
+            converter.setWriteIntensity(true);
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
     std::cout << "1. LOADING POINT CLOUD DATA\n";
 
     // Option 1: Generate sample data